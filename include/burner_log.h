@@ -0,0 +1,110 @@
+#ifndef BURNER_LOG_H
+#define BURNER_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ============================================================================
+// BURNER LOG DECODER
+// ============================================================================
+//
+// The firmware-stage burner (vendor U-Boot) reports progress, CRC results and
+// errors as plain text on bulk-IN endpoint 0x81. This decoder turns that byte
+// stream into typed events without allocating: bytes are assembled into lines
+// in a fixed buffer and each completed line is classified against a keyword
+// table. Decoded events land in a small per-device ring that the write pacing
+// and error recovery logic can wait on.
+
+#define BURNER_LOG_LINE_MAX      160  // Longer lines are truncated, not split
+#define BURNER_EVENT_QUEUE_SIZE  32   // Must be a power of two
+
+typedef enum {
+    BURNER_EVENT_NONE = 0,
+    BURNER_EVENT_CHUNK_DONE,    // Chunk/policy programmed ("write ret: ok")
+    BURNER_EVENT_WRITE_FAIL,    // Chunk/policy write reported an error
+    BURNER_EVENT_CRC_OK,        // Burner-side CRC check passed
+    BURNER_EVENT_CRC_FAIL,      // Burner-side CRC check failed
+    BURNER_EVENT_ERASE_DONE,    // Erase finished
+    BURNER_EVENT_ACK_ERROR,     // cloner->ack = <negative errno> (e.g. -22)
+    BURNER_EVENT_TRAP,          // CPU trap/exception in the burner
+    BURNER_EVENT_POLICY_DONE,   // "all policy completed"
+    BURNER_EVENT_TYPE_COUNT
+} burner_event_type_t;
+
+#define BURNER_EVENT_MASK(type) (1u << (type))
+
+// Events that mean the current operation cannot succeed
+#define BURNER_EVENT_MASK_FAILURE (BURNER_EVENT_MASK(BURNER_EVENT_WRITE_FAIL) | \
+                                   BURNER_EVENT_MASK(BURNER_EVENT_CRC_FAIL) | \
+                                   BURNER_EVENT_MASK(BURNER_EVENT_ACK_ERROR) | \
+                                   BURNER_EVENT_MASK(BURNER_EVENT_TRAP))
+
+typedef struct {
+    burner_event_type_t type;
+    int32_t value;        // Chunk index or ack code; -1 when not reported
+    uint32_t line_no;     // 1-based line number within the log stream
+} burner_event_t;
+
+typedef struct {
+    char line[BURNER_LOG_LINE_MAX];
+    size_t line_len;
+    uint32_t lines_seen;
+    burner_event_t events[BURNER_EVENT_QUEUE_SIZE];
+    uint32_t head;        // Next slot to pop
+    uint32_t tail;        // Next slot to push
+    uint32_t dropped;     // Events discarded because the queue was full
+    uint32_t stale;       // Events skipped because they named another chunk
+} burner_log_t;
+
+/**
+ * Reset a decoder to its initial state (empty line buffer, empty queue)
+ */
+void burner_log_init(burner_log_t* log);
+
+/**
+ * Feed raw bulk-IN bytes into the decoder
+ *
+ * Bytes may be split at arbitrary points across calls. NUL bytes and carriage
+ * returns are ignored; a newline completes a line.
+ *
+ * @return Number of events queued by this call
+ */
+size_t burner_log_feed(burner_log_t* log, const uint8_t* data, size_t len);
+
+/**
+ * Pop the oldest queued event
+ *
+ * @return true if an event was returned
+ */
+bool burner_log_pop(burner_log_t* log, burner_event_t* event);
+
+/**
+ * Pop the oldest queued event whose type is in mask, discarding any older
+ * events that do not match
+ *
+ * @return true if a matching event was returned
+ */
+bool burner_log_pop_match(burner_log_t* log, uint32_t mask, burner_event_t* event);
+
+/**
+ * Pop the oldest queued event whose type is in mask and that reports on
+ * chunk: same index, or no index at all (burners that do not number their
+ * lines). Older events are discarded; mask events naming another chunk are
+ * stale reports (e.g. one that arrived after its wait gave up) and are
+ * counted in log->stale. Failure events are returned whatever chunk they
+ * name, since a late failure still means flash holds bad data.
+ *
+ * @param chunk Expected chunk index, or -1 to accept any
+ * @return true if a matching event was returned
+ */
+bool burner_log_pop_chunk(burner_log_t* log, uint32_t mask, int32_t chunk, burner_event_t* event);
+
+/**
+ * Number of events currently queued
+ */
+uint32_t burner_log_pending(const burner_log_t* log);
+
+const char* burner_event_type_to_string(burner_event_type_t type);
+
+#endif // BURNER_LOG_H
@@ -0,0 +1,58 @@
+#ifndef CANCEL_H
+#define CANCEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// ============================================================================
+// CANCELLATION TOKENS
+// ============================================================================
+//
+// A token is shared between a job and whoever may want to stop it (Ctrl+C,
+// a failing clone peer). The transfer layer polls it while a bulk transfer
+// is in flight and between control-request attempts, and long sleeps wait
+// on it, so a cancelled job unwinds within one poll tick instead of after
+// its worst-case timeout chain.
+//
+// The token doubles as a watchdog: with watchdog_ms set, a job that reports
+// no progress (a completed transfer) for that long is cancelled the next
+// time it checks the token. Sleeps and retry backoff are not progress; the
+// longest planned wait (erase) polls the device and so keeps the job alive.
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    volatile int cancelled;
+    const char* reason;            // Static string, valid once cancelled
+    uint32_t watchdog_ms;          // 0 = no watchdog
+    uint64_t last_progress_ms;
+} thingino_cancel_t;
+
+void thingino_cancel_init(thingino_cancel_t* token, uint32_t watchdog_ms);
+void thingino_cancel_destroy(thingino_cancel_t* token);
+
+/**
+ * Cancel the job. Safe from any thread; the first reason sticks.
+ */
+void thingino_cancel_request(thingino_cancel_t* token, const char* reason);
+
+/**
+ * Note that the job is alive (resets the watchdog)
+ */
+void thingino_cancel_progress(thingino_cancel_t* token);
+
+/**
+ * @return true if the job should stop (cancelled, or the watchdog expired).
+ *         A NULL token is never cancelled.
+ */
+bool thingino_cancel_check(thingino_cancel_t* token);
+
+/**
+ * Sleep for ms, waking early on cancellation
+ *
+ * @return true if cancelled
+ */
+bool thingino_cancel_sleep(thingino_cancel_t* token, uint32_t ms);
+
+#endif // CANCEL_H
@@ -0,0 +1,77 @@
+#ifndef CAPTURE_DIFF_H
+#define CAPTURE_DIFF_H
+
+#include "usb_capture.h"
+
+// ============================================================================
+// CAPTURE DIFF
+// ============================================================================
+//
+// Lines up two transfer sequences (our trace and a vendor capture) by
+// command: vendor control requests by code, direction, length and
+// handshake contents, bulk transfers by endpoint and length. Control
+// requests that match on code and direction but differ in length or
+// contents are paired as "changed" so their timing is still compared. For every paired step
+// the report gets its duration difference and the difference in time
+// elapsed since the previous pair, which includes host sleeps and any
+// unpaired steps in between, plus the running total.
+
+#define CAPTURE_DIFF_LOOKAHEAD  256     // Steps searched to resynchronize
+
+typedef struct {
+    bool control;                   // Vendor control request, else bulk
+    bool in;
+    uint8_t code;                   // bRequest, or the bulk endpoint
+    uint32_t length;                // wLength, or bytes requested
+    uint32_t digest;                // OUT payload hash for control requests (0 = none)
+    int32_t status;
+    uint64_t submit_us;
+    uint64_t complete_us;
+    uint32_t index;                 // Position among the transfers reported
+} capture_step_t;
+
+typedef struct {
+    capture_step_t* steps;
+    size_t count;
+    size_t capacity;
+    uint32_t seen;                  // Transfers offered to capture_steps_add()
+} capture_steps_t;
+
+typedef enum {
+    CAPTURE_DIFF_MATCH = 0,
+    CAPTURE_DIFF_CHANGED,           // Same request, different length or contents
+    CAPTURE_DIFF_OURS_ONLY,
+    CAPTURE_DIFF_VENDOR_ONLY
+} capture_diff_op_t;
+
+typedef struct {
+    capture_diff_op_t op;
+    const capture_step_t* ours;     // NULL for CAPTURE_DIFF_VENDOR_ONLY
+    const capture_step_t* vendor;   // NULL for CAPTURE_DIFF_OURS_ONLY
+    // Paired steps only; elapsed counts from the previous pair's completion
+    // (the first pair's submit for the first pair), deltas are ours minus vendor
+    uint64_t ours_elapsed_us;
+    uint64_t vendor_elapsed_us;
+    int64_t step_delta_us;          // ours_elapsed_us - vendor_elapsed_us
+    int64_t duration_delta_us;      // This step's own duration
+    int64_t cumulative_delta_us;
+} capture_diff_entry_t;
+
+typedef void (*capture_diff_fn)(void* user_data, const capture_diff_entry_t* entry);
+
+/**
+ * Keep a transfer if it is a protocol step: a vendor control request or a
+ * bulk transfer that moved data or failed (empty log polls are dropped)
+ *
+ * @return 0 on success, -1 out of memory
+ */
+int capture_steps_add(capture_steps_t* steps, const usb_capture_transfer_t* transfer);
+void capture_steps_free(capture_steps_t* steps);
+
+/**
+ * Align the sequences and report every step of both, in order
+ */
+void capture_diff(const capture_steps_t* ours, const capture_steps_t* vendor,
+                  capture_diff_fn fn, void* user_data);
+
+#endif // CAPTURE_DIFF_H
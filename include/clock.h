@@ -0,0 +1,66 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// CLOCK
+// ============================================================================
+//
+// Every wait and timestamp in the library (thingino_sleep_*,
+// thingino_monotonic_*, cancellable sleeps) goes through the process clock.
+// By default that is the real monotonic clock. A test installs a virtual
+// clock instead: sleeps then only move virtual time forward, and a simulated
+// device advances it to model transfer and erase latency, so a full
+// bootstrap and write runs in milliseconds of wall time.
+//
+// The clock is process-wide rather than per context: timestamps taken by
+// different modules (cancel watchdog, metrics, bus scheduler) must agree.
+// Service threads that poll on a tick (log drain, dashboard, exporter) use
+// the thingino_real_* helpers so they do not spin under virtual time.
+
+typedef struct thingino_clock thingino_clock_t;
+
+struct thingino_clock {
+    uint64_t (*now_us)(thingino_clock_t* clock);
+    void (*sleep_us)(thingino_clock_t* clock, uint64_t us);
+};
+
+/**
+ * Install a clock for the whole process
+ *
+ * @param clock Clock to use, NULL to go back to the real clock
+ */
+void thingino_clock_set(thingino_clock_t* clock);
+
+/**
+ * @return the installed clock, NULL for the real one
+ */
+thingino_clock_t* thingino_clock_get(void);
+
+/**
+ * @return true while a clock other than the real one is installed
+ */
+bool thingino_clock_is_virtual(void);
+
+uint64_t thingino_clock_now_us(void);
+void thingino_clock_sleep_us(uint64_t us);
+
+// The real monotonic clock, whatever is installed
+uint64_t thingino_real_now_us(void);
+void thingino_real_sleep_us(uint64_t us);
+
+// ============================================================================
+// VIRTUAL CLOCK
+// ============================================================================
+
+typedef struct {
+    thingino_clock_t base;
+    uint64_t now_us;                // Read and advanced atomically
+} thingino_virtual_clock_t;
+
+void thingino_virtual_clock_init(thingino_virtual_clock_t* clock, uint64_t start_us);
+void thingino_virtual_clock_advance(thingino_virtual_clock_t* clock, uint64_t us);
+
+#endif // CLOCK_H
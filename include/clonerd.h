@@ -0,0 +1,58 @@
+#ifndef CLONERD_H
+#define CLONERD_H
+
+#include "thingino.h"
+
+// ============================================================================
+// SESSION DAEMON (thingino-clonerd)
+// ============================================================================
+//
+// A long-running process that owns the libusb context and keeps devices
+// open in firmware stage between operations, so a read followed by a write
+// bootstraps once instead of twice. Requests arrive as single text lines on
+// a local Unix socket (see clonerd.c for the command set).
+//
+// A session is keyed by the device's physical port and remembers what the
+// burner on the other end has already been told: after bootstrap it is in
+// firmware stage, and after a read or write prepare it holds that mode's
+// flash descriptor and handshake init. Jobs only redo the steps the next
+// operation actually needs.
+
+#define CLONERD_MAX_SESSIONS   16
+#define CLONERD_QUEUE_MAX      32
+#define CLONERD_LINE_MAX       1024
+#define CLONERD_SOCKET_NAME    "thingino-clonerd.sock"
+
+typedef enum {
+    SESSION_MODE_NONE = 0,      // Bootstrapped, no descriptor sent yet
+    SESSION_MODE_READ,          // Read descriptor and handshake init done
+    SESSION_MODE_WRITE          // Write marker, descriptor and handshake init done
+} session_mode_t;
+
+typedef struct {
+    bool used;
+    char port[USB_PORT_STRING_MAX];
+    usb_device_t* device;       // Open, firmware stage
+    session_mode_t mode;
+    bool is_a1;                 // From the last write prepare
+    unsigned jobs;              // Operations served without re-bootstrap
+    uint64_t last_used_ms;
+} clonerd_session_t;
+
+typedef struct {
+    thingino_context_t context;  // libusb session, debug switch
+    bootstrap_config_t bootstrap;
+    uint32_t window_depth;
+    clonerd_session_t sessions[CLONERD_MAX_SESSIONS];
+} clonerd_t;
+
+// Session management (session.c)
+thingino_error_t clonerd_session_acquire(clonerd_t* daemon, const char* spec,
+                                         clonerd_session_t** out, char* err, size_t err_size);
+thingino_error_t clonerd_session_set_mode(clonerd_session_t* session, session_mode_t mode);
+thingino_error_t clonerd_session_reset(clonerd_t* daemon, const char* spec, char* err, size_t err_size);
+void clonerd_session_drop(clonerd_session_t* session);
+void clonerd_session_drop_all(clonerd_t* daemon);
+const char* clonerd_session_mode_name(session_mode_t mode);
+
+#endif // CLONERD_H
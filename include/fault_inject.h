@@ -0,0 +1,50 @@
+#ifndef FAULT_INJECT_H
+#define FAULT_INJECT_H
+
+#include "thingino.h"
+#include "fault_profile.h"
+
+// ============================================================================
+// FAULT-INJECTION TRANSPORT
+// ============================================================================
+//
+// A usb_transport_t decorator that applies a fault profile (fault_profile.h)
+// to the transport underneath it, so retry and recovery paths can be run on
+// demand. Waits (lost transfers, late acks, re-enumeration) go through the
+// clock, so under a virtual clock they cost no wall time.
+
+typedef struct {
+    const usb_transport_t* inner;
+    void* inner_data;
+    fault_state_t state;
+    bool disconnected;
+    uint64_t reconnect_at_us;       // Back on the bus from then on
+} fault_inject_t;
+
+extern const usb_transport_t fault_inject_transport;
+
+/**
+ * Put fault injection between device and its current transport
+ */
+thingino_error_t fault_inject_attach(fault_inject_t* fi, usb_device_t* device,
+                                     const fault_profile_t* profile, uint64_t seed_offset);
+
+// ============================================================================
+// FAULT BENCHMARK (fault_bench.c)
+// ============================================================================
+//
+// Runs simulated bootstrap + write jobs in virtual time under each profile
+// and reports mean and tail job time, failures and silent corruption.
+
+#define FAULT_BENCH_JOBS        20
+#define FAULT_BENCH_IMAGE_SIZE  (1024 * 1024)
+#define FAULT_BENCH_MAX_PROFILES 16
+
+/**
+ * @param specs Profile specs; NULL (or count 0) runs every built-in profile
+ * @return THINGINO_ERROR_PROTOCOL if any job reported success with wrong
+ *         flash contents (a Bad job)
+ */
+thingino_error_t fault_bench_run(const char* const* specs, int count, uint32_t jobs);
+
+#endif // FAULT_INJECT_H
@@ -0,0 +1,99 @@
+#ifndef FAULT_PROFILE_H
+#define FAULT_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// FAULT PROFILES
+// ============================================================================
+//
+// What the fault-injection transport does to the transfers passing through
+// it. A profile is a spec string of comma-separated settings, optionally
+// starting with a built-in profile name:
+//
+//   stall=P          Transfer fails with a STALL (LIBUSB_ERROR_PIPE)
+//   timeout=P        Transfer is lost; the host waits out its timeout
+//   late=P           Device gets the transfer but the ack is lost (timeout)
+//   short=P          Bulk transfer moves half its bytes, then times out
+//   disconnect=P     Device drops off the bus (LIBUSB_ERROR_NO_DEVICE)
+//                    and re-enumerates after reconnect ms
+//   reconnect=MS     Re-enumeration time (default 1000)
+//   seed=N           Random seed (default 1)
+//   on=control|bulk|all   Transfers faults apply to (default all)
+//   req=0xNN         Only control transfers with this bRequest
+//   at=N:kind        Scripted: the Nth eligible transfer gets kind
+//
+// P is a per-transfer probability (0..1). Scripted faults win over random
+// ones, e.g. "req=0x12,at=3:late" loses the ack of the third VR_WRITE.
+
+#define FAULT_NAME_MAX     32
+#define FAULT_SCRIPT_MAX   32
+#define FAULT_RECONNECT_MS 1000
+
+typedef enum {
+    FAULT_NONE = 0,
+    FAULT_STALL,
+    FAULT_TIMEOUT,
+    FAULT_LATE,
+    FAULT_SHORT,
+    FAULT_DISCONNECT,
+    FAULT_KINDS
+} fault_kind_t;
+
+#define FAULT_ON_CONTROL  0x1u
+#define FAULT_ON_BULK     0x2u
+
+typedef struct {
+    uint32_t op;                    // 1-based eligible transfer number
+    fault_kind_t kind;
+} fault_script_entry_t;
+
+typedef struct {
+    char name[FAULT_NAME_MAX];
+    double probability[FAULT_KINDS];
+    uint32_t on;                    // FAULT_ON_* mask
+    int request;                    // bRequest filter, -1 = any
+    uint32_t reconnect_ms;
+    uint64_t seed;
+    fault_script_entry_t script[FAULT_SCRIPT_MAX];
+    uint32_t script_count;
+} fault_profile_t;
+
+// Per-device injection state
+typedef struct {
+    fault_profile_t profile;
+    uint64_t rng;
+    uint32_t eligible;              // Eligible transfers seen so far
+    uint32_t injected[FAULT_KINDS];
+} fault_state_t;
+
+/**
+ * Parse a profile spec (see above)
+ *
+ * @param error Receives a message on failure (may be NULL)
+ * @return 0 on success, -1 on a bad spec
+ */
+int fault_profile_parse(const char* spec, fault_profile_t* profile, char* error, size_t error_size);
+
+/**
+ * @return the name of built-in profile index, or NULL past the last one
+ */
+const char* fault_profile_builtin(size_t index);
+
+const char* fault_kind_name(fault_kind_t kind);
+
+/**
+ * @param seed_offset Added to the profile's seed (e.g. a job number)
+ */
+void fault_state_init(fault_state_t* state, const fault_profile_t* profile, uint64_t seed_offset);
+
+/**
+ * Decide the fault for the next transfer
+ *
+ * @param request bRequest of a control transfer (ignored for bulk)
+ */
+fault_kind_t fault_next(fault_state_t* state, bool bulk, uint8_t request);
+
+#endif // FAULT_PROFILE_H
@@ -0,0 +1,41 @@
+#ifndef IMAGE_FILE_H
+#define IMAGE_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ============================================================================
+// FIRMWARE IMAGE INPUT
+// ============================================================================
+//
+// Read-only view of a firmware image file. The file is memory-mapped where
+// the platform allows it (mmap + MADV_SEQUENTIAL on POSIX, a file mapping
+// on Windows) so bulk OUT transfers are fed straight from the page cache:
+// concurrent writers of the same image share one copy and the first chunk
+// goes out without waiting for the whole file to be read. If mapping fails
+// the file is read into a heap buffer instead.
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    bool mapped;        // data points into a file mapping rather than the heap
+#ifdef _WIN32
+    void* mapping;      // HANDLE of the file mapping object
+#endif
+} firmware_image_t;
+
+/**
+ * Open a firmware image read-only
+ *
+ * @return 0 on success, -1 if the file cannot be opened, is empty or does
+ *         not fit in memory
+ */
+int firmware_image_open(const char* path, firmware_image_t* image);
+
+/**
+ * Release the mapping or buffer. Safe to call on a zeroed image.
+ */
+void firmware_image_close(firmware_image_t* image);
+
+#endif // IMAGE_FILE_H
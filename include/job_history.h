@@ -0,0 +1,104 @@
+#ifndef JOB_HISTORY_H
+#define JOB_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "metrics.h"
+
+// ============================================================================
+// JOB HISTORY
+// ============================================================================
+//
+// Every finished device job appends one fixed-size record to a local,
+// append-only binary log. Records are written in completion order, so the
+// file is sorted by time and the record number is its own index: a query
+// binary-searches its start time instead of scanning years of history.
+//
+// Record layout (JOB_HISTORY_RECORD_SIZE bytes, little-endian):
+//   0  magic "THJ1"      4  result (int32)     8  end time (int64, Unix s)
+//  16  variant[16]      32  cpu magic[8]      40  flash chip[24]
+//  64  port[24]         88  image CRC32       92  phase ms[4] (uint32)
+// 108  retries (uint32) 112 bytes (uint64)   120  reserved
+// Strings are NUL-padded and not necessarily NUL-terminated. A torn record
+// at the end of the file (crash mid-append) is ignored.
+
+#define JOB_HISTORY_RECORD_SIZE   128
+#define JOB_HISTORY_MAGIC         "THJ1"
+#define JOB_HISTORY_VARIANT_MAX   16
+#define JOB_HISTORY_CPU_MAX       8
+#define JOB_HISTORY_CHIP_MAX      24
+#define JOB_HISTORY_PORT_MAX      24
+#define JOB_HISTORY_SLOWER_PCT    20.0   // Median change flagged as a regression
+
+typedef struct {
+    int64_t time;
+    int32_t result;                              // thingino_error_t, 0 = success
+    char variant[JOB_HISTORY_VARIANT_MAX + 1];
+    char cpu_magic[JOB_HISTORY_CPU_MAX + 1];
+    char flash_chip[JOB_HISTORY_CHIP_MAX + 1];
+    char port[JOB_HISTORY_PORT_MAX + 1];
+    uint32_t image_crc;                          // 0 = no image (read, bootstrap)
+    uint32_t phase_ms[METRICS_PHASES];           // 0 = phase did not run
+    uint32_t retries;
+    uint64_t bytes;
+} job_record_t;
+
+// One (period, variant, phase) group of a summary
+typedef struct {
+    int64_t period_start;
+    char variant[JOB_HISTORY_VARIANT_MAX + 1];
+    metrics_phase_t phase;
+    uint32_t ok;                // Successful jobs that ran the phase
+    uint32_t failed;            // Failed jobs that ran the phase
+    uint32_t p50_ms, p90_ms, p99_ms, max_ms;    // Over successful jobs
+    bool has_change;
+    double change_pct;          // Median vs the previous period with data
+} job_history_row_t;
+
+/**
+ * Default log location: $THINGINO_HISTORY_FILE, else
+ * $XDG_DATA_HOME/thingino-cloner/history.bin (~/.local/share/... ), or
+ * %APPDATA%\thingino-cloner\history.bin on Windows
+ *
+ * @return 0 on success, -1 if no location could be determined
+ */
+int job_history_default_path(char* buf, size_t buf_size);
+
+void job_record_encode(const job_record_t* record, uint8_t out[JOB_HISTORY_RECORD_SIZE]);
+
+/**
+ * @return false if the bytes are not a record (bad magic)
+ */
+bool job_record_decode(const uint8_t in[JOB_HISTORY_RECORD_SIZE], job_record_t* record);
+
+/**
+ * Append one record, creating the file and its directory if needed. The
+ * record goes out in a single write, so concurrent appenders (CLI and
+ * daemon) never interleave.
+ *
+ * @return 0 on success, -1 on I/O error
+ */
+int job_history_append(const char* path, const job_record_t* record);
+
+/**
+ * Load every record that ended at or after since (0 = all)
+ *
+ * @param records Receives a malloc'd array (caller frees), NULL if none
+ * @return 0 on success (a missing file is an empty history), -1 on error
+ */
+int job_history_load(const char* path, int64_t since, job_record_t** records, size_t* count);
+
+/**
+ * Group records by period (period_s seconds, aligned to the Unix epoch),
+ * variant and phase, with duration percentiles and the median's change
+ * against the same variant and phase in its previous period. Rows are
+ * ordered by variant, phase, then period.
+ *
+ * @param rows Receives a malloc'd array (caller frees)
+ * @return 0 on success, -1 on allocation failure
+ */
+int job_history_summarize(const job_record_t* records, size_t count, uint32_t period_s,
+                          job_history_row_t** rows, size_t* row_count);
+
+#endif // JOB_HISTORY_H
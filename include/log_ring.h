@@ -0,0 +1,65 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// LOG RING BUFFER
+// ============================================================================
+//
+// Bounded multi-producer, single-consumer queue of formatted log messages.
+// Producers (USB worker threads) claim a slot with one compare-and-swap and
+// never block or take a lock: when the ring is full the message is dropped
+// and counted. A single drain thread pops messages in order and does the
+// terminal I/O, so a slow console cannot stall a transfer and messages from
+// concurrent devices come out whole rather than interleaved mid-line.
+
+#define LOG_RING_DEFAULT_SLOTS 1024
+#define LOG_RING_MSG_MAX       480     // Longer messages are truncated
+
+typedef struct {
+    uint32_t seq;               // Slot sequence (see log_ring.c)
+    uint8_t stream;             // Caller-defined, e.g. 1 = stdout, 2 = stderr
+    uint16_t len;
+    char text[LOG_RING_MSG_MAX];
+} log_ring_slot_t;
+
+typedef struct {
+    log_ring_slot_t* slots;
+    uint32_t mask;              // Slot count - 1 (count is a power of two)
+    uint32_t enqueue_pos;       // Shared by producers
+    uint32_t dequeue_pos;       // Consumer only
+    uint32_t dropped;           // Messages lost to a full ring
+} log_ring_t;
+
+/**
+ * @param slots Slot count, rounded up to a power of two (0 = default)
+ * @return 0 on success, -1 on allocation failure
+ */
+int log_ring_init(log_ring_t* ring, uint32_t slots);
+void log_ring_destroy(log_ring_t* ring);
+
+/**
+ * Queue a message. Safe from any number of threads.
+ *
+ * @return false if the ring was full (message dropped)
+ */
+bool log_ring_push(log_ring_t* ring, uint8_t stream, const char* text, size_t len);
+
+/**
+ * Take the oldest message. Single consumer only.
+ *
+ * @param out Receives the slot's text (not NUL-terminated), at least
+ *            LOG_RING_MSG_MAX bytes
+ * @return false if the ring is empty
+ */
+bool log_ring_pop(log_ring_t* ring, uint8_t* stream, char* out, size_t* len);
+
+/**
+ * Read and reset the dropped-message counter
+ */
+uint32_t log_ring_take_dropped(log_ring_t* ring);
+
+#endif // LOG_RING_H
@@ -0,0 +1,91 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// THROUGHPUT AND LATENCY METRICS
+// ============================================================================
+//
+// Counters and histograms shared by every device thread of a context. Each
+// update is a relaxed atomic add, so recording never takes a lock and never
+// waits on the exporter. A scrape reads the same words atomically; values
+// from different counters may be a few microseconds apart, which is fine for
+// dashboards.
+//
+// Durations are recorded in microseconds and exported in seconds.
+
+#define METRICS_MAX_BUCKETS  12     // Finite bucket bounds per histogram
+#define METRICS_BUSES        256    // Indexed by USB bus number
+#define METRICS_REQUESTS     256    // Indexed by vendor request (VR_*) code
+#define METRICS_ERROR_CODES  16     // thingino_error_t 0 .. -15, by -code
+
+typedef enum {
+    METRICS_READ = 0,
+    METRICS_WRITE,
+    METRICS_DIRECTIONS
+} metrics_direction_t;
+
+typedef enum {
+    METRICS_PHASE_BOOTSTRAP = 0,
+    METRICS_PHASE_READ,
+    METRICS_PHASE_VERIFY,
+    METRICS_PHASE_WRITE,
+    METRICS_PHASES
+} metrics_phase_t;
+
+typedef enum {
+    METRICS_FORMAT_OPENMETRICS = 0, // Scrape endpoint, ends with "# EOF"
+    METRICS_FORMAT_PROMETHEUS       // node_exporter textfile collector
+} metrics_format_t;
+
+typedef struct {
+    const uint64_t* bounds_us;      // Ascending upper bounds, bound_count of them
+    uint32_t bound_count;
+    uint64_t buckets[METRICS_MAX_BUCKETS + 1];  // Per bucket (not cumulative), last = +Inf
+    uint64_t sum_us;
+} metrics_histogram_t;
+
+typedef struct {
+    uint64_t bytes[METRICS_DIRECTIONS][METRICS_BUSES];
+    metrics_histogram_t chunk_latency[METRICS_DIRECTIONS];
+    int64_t jobs_active[METRICS_PHASES];
+    uint64_t jobs[METRICS_PHASES][2];           // [0] = ok, [1] = failed
+    metrics_histogram_t phase_duration[METRICS_PHASES];
+    uint64_t failures[METRICS_PHASES][METRICS_ERROR_CODES];
+    metrics_histogram_t erase_wait;
+    uint64_t retries[METRICS_REQUESTS];
+} metrics_t;
+
+// Turns a (negative) error code into a label value; may be NULL
+typedef const char* (*metrics_error_name_fn)(int code);
+
+void metrics_init(metrics_t* m);
+
+/**
+ * @return the phase for "bootstrap", "read", "verify" or "write", or -1
+ */
+int metrics_phase_from_name(const char* name);
+const char* metrics_phase_name(metrics_phase_t phase);
+
+void metrics_chunk(metrics_t* m, metrics_direction_t dir, uint8_t bus, uint32_t bytes,
+                   uint64_t latency_us);
+void metrics_phase_begin(metrics_t* m, metrics_phase_t phase);
+
+/**
+ * @param error 0 for success, otherwise a thingino_error_t value
+ */
+void metrics_phase_end(metrics_t* m, metrics_phase_t phase, uint64_t duration_us, int error);
+void metrics_erase(metrics_t* m, uint64_t wait_us);
+void metrics_retry(metrics_t* m, uint8_t request);
+
+/**
+ * Render all metrics as exposition text. Like snprintf, the return value is
+ * the full length even when it did not fit in size bytes.
+ */
+size_t metrics_format(const metrics_t* m, metrics_format_t format, metrics_error_name_fn error_name,
+                      char* out, size_t size);
+
+#endif // METRICS_H
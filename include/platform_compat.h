@@ -3,6 +3,12 @@
 
 #include <stdint.h>
 
+#include "clock.h"
+
+// The platform_* primitives are the real clock behind clock.c. Everything
+// else calls the thingino_sleep_* / thingino_monotonic_* wrappers below,
+// which go through the installed (possibly virtual) clock.
+
 #if defined(_WIN32)
 #ifndef NOMINMAX
 #define NOMINMAX
@@ -13,41 +19,68 @@
 #define THINGINO_USECONDS_T_DEFINED
 typedef unsigned int useconds_t;
 #endif
-static inline void thingino_sleep_seconds(uint32_t seconds) {
-    Sleep(seconds * 1000);
-}
-static inline void thingino_sleep_milliseconds(uint32_t milliseconds) {
-    Sleep(milliseconds);
-}
-static inline void thingino_sleep_microseconds(uint32_t microseconds) {
-    DWORD duration = (microseconds + 999) / 1000;
+static inline void thingino_platform_sleep_us(uint64_t microseconds) {
+    DWORD duration = (DWORD)((microseconds + 999) / 1000);
     if (duration == 0 && microseconds > 0) {
         duration = 1;
     }
     Sleep(duration);
 }
-static inline int usleep(useconds_t microseconds) {
-    thingino_sleep_microseconds((uint32_t)microseconds);
-    return 0;
-}
 static inline int thingino_strcasecmp(const char* a, const char* b) {
     return _stricmp(a, b);
 }
+static inline uint64_t thingino_platform_monotonic_us(void) {
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)(count.QuadPart / frequency.QuadPart) * 1000000u +
+           (uint64_t)(count.QuadPart % frequency.QuadPart) * 1000000u / (uint64_t)frequency.QuadPart;
+}
+static inline int usleep(useconds_t microseconds) {
+    thingino_clock_sleep_us(microseconds);
+    return 0;
+}
 #else
 #include <unistd.h>
 #include <strings.h>
+#include <time.h>
+static inline void thingino_platform_sleep_us(uint64_t microseconds) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(microseconds / 1000000u);
+    ts.tv_nsec = (long)(microseconds % 1000000u) * 1000L;
+    while (nanosleep(&ts, &ts) != 0) {
+        // Interrupted by a signal: sleep the remainder
+    }
+}
+static inline int thingino_strcasecmp(const char* a, const char* b) {
+    return strcasecmp(a, b);
+}
+static inline uint64_t thingino_platform_monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)(ts.tv_nsec / 1000);
+}
+#endif
+
 static inline void thingino_sleep_seconds(uint32_t seconds) {
-    sleep(seconds);
+    thingino_clock_sleep_us((uint64_t)seconds * 1000000u);
 }
 static inline void thingino_sleep_milliseconds(uint32_t milliseconds) {
-    usleep(milliseconds * 1000);
+    thingino_clock_sleep_us((uint64_t)milliseconds * 1000u);
 }
 static inline void thingino_sleep_microseconds(uint32_t microseconds) {
-    usleep(microseconds);
+    thingino_clock_sleep_us(microseconds);
 }
-static inline int thingino_strcasecmp(const char* a, const char* b) {
-    return strcasecmp(a, b);
+static inline uint64_t thingino_monotonic_ms(void) {
+    return thingino_clock_now_us() / 1000u;
+}
+static inline uint64_t thingino_monotonic_us(void) {
+    return thingino_clock_now_us();
+}
+
+// Polling ticks of service threads: always real time
+static inline void thingino_sleep_real_milliseconds(uint32_t milliseconds) {
+    thingino_real_sleep_us((uint64_t)milliseconds * 1000u);
 }
-#endif
 
 #endif
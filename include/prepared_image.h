@@ -0,0 +1,86 @@
+#ifndef PREPARED_IMAGE_H
+#define PREPARED_IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "image_file.h"
+
+// ============================================================================
+// PREPARED (GOLDEN) IMAGES
+// ============================================================================
+//
+// A firmware image plus, per write handshake format, the CRC32 and 40-byte
+// VR_WRITE handshake of every chunk. Building it costs one pass over the
+// image; after that any number of writers (one per device, on any thread)
+// can stream the same image without touching the data on the CPU. Add all
+// layouts before sharing the image: it is read-only from then on and needs
+// no locking.
+
+#define FIRMWARE_WRITE_HANDSHAKE_SIZE  40
+
+typedef enum {
+    WRITE_HANDSHAKE_T31 = 0,    // T31-family NOR writer
+    WRITE_HANDSHAKE_T41N,       // T41N/T41 (XBurst2) NOR writer
+    WRITE_HANDSHAKE_A1,         // A1 writer
+    WRITE_HANDSHAKE_FORMAT_COUNT
+} write_handshake_format_t;
+
+typedef struct {
+    uint32_t chunk_size;        // 0 = layout not prepared
+    uint32_t chunk_count;
+    uint32_t* crcs;             // CRC32 of each chunk
+    uint8_t (*handshakes)[FIRMWARE_WRITE_HANDSHAKE_SIZE];
+} prepared_layout_t;
+
+typedef struct {
+    firmware_image_t image;
+    prepared_layout_t layouts[WRITE_HANDSHAKE_FORMAT_COUNT];
+} prepared_image_t;
+
+/**
+ * Standard (Ethernet/zlib) CRC32 as used in the write handshakes
+ */
+uint32_t firmware_crc32(const uint8_t* data, size_t length);
+
+/**
+ * Format the 40-byte VR_WRITE handshake for one chunk
+ *
+ * @param crc CRC32 of the chunk data (the handshake carries ~crc)
+ */
+void write_handshake_format(write_handshake_format_t format, uint32_t chunk_offset,
+                            uint32_t chunk_size, uint32_t crc,
+                            uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]);
+
+/**
+ * Open the image without any layouts
+ *
+ * @return 0 on success, -1 if the image cannot be opened
+ */
+int prepared_image_open(prepared_image_t* prepared, const char* path);
+
+/**
+ * Precompute CRCs and handshakes for format at chunk_size, replacing any
+ * earlier layout for that format. CRCs are reused from another layout with
+ * the same chunk size.
+ *
+ * @return 0 on success, -1 on invalid arguments or allocation failure
+ */
+int prepared_image_add_layout(prepared_image_t* prepared, write_handshake_format_t format,
+                              uint32_t chunk_size);
+
+/**
+ * Look up the layout for (format, chunk_size)
+ *
+ * @return the layout, or NULL if it was not prepared
+ */
+const prepared_layout_t* prepared_image_layout(const prepared_image_t* prepared,
+                                               write_handshake_format_t format,
+                                               uint32_t chunk_size);
+
+/**
+ * Release the image and all layouts. Safe to call on a zeroed image.
+ */
+void prepared_image_close(prepared_image_t* prepared);
+
+#endif // PREPARED_IMAGE_H
@@ -0,0 +1,83 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// RETRY POLICIES
+// ============================================================================
+//
+// How hard a USB operation tries before giving up. A policy bounds the whole
+// operation by a deadline rather than an attempt count: each attempt gets at
+// most attempt_timeout_ms, clipped to what is left of the budget, and the
+// backoff between attempts grows from backoff_initial_ms to backoff_max_ms.
+// Errors in busy_ok are the device saying "accepted, still working" and end
+// the operation successfully; errors in retry_on are retried while time
+// remains; anything else fails at once.
+//
+// Callers may impose an outer deadline (their own remaining budget), which
+// always wins over the policy's. Time is passed in, so the state machine is
+// pure and can be unit tested without a device.
+
+#define RETRY_ERR_TIMEOUT    (1u << 0)
+#define RETRY_ERR_PIPE       (1u << 1)
+#define RETRY_ERR_NO_DEVICE  (1u << 2)
+#define RETRY_ERR_OTHER      (1u << 3)
+
+// An attempt shorter than this is not worth starting
+#define RETRY_MIN_ATTEMPT_MS 50
+
+typedef struct {
+    const char* name;
+    uint32_t deadline_ms;          // Budget for all attempts (0 = one attempt)
+    uint32_t attempt_timeout_ms;   // Per-attempt transfer timeout
+    uint32_t backoff_initial_ms;   // Sleep after the first failure
+    uint32_t backoff_max_ms;       // Doubling stops here
+    uint32_t retry_on;             // RETRY_ERR_* mask worth another attempt
+    uint32_t busy_ok;              // RETRY_ERR_* mask that counts as success
+} retry_policy_t;
+
+typedef enum {
+    RETRY_OK,           // Treat the operation as done
+    RETRY_AGAIN,        // Sleep *sleep_ms, then attempt again
+    RETRY_GIVE_UP       // Fatal error or budget spent
+} retry_decision_t;
+
+typedef struct {
+    const retry_policy_t* policy;
+    uint64_t deadline_ms;          // Absolute, on the caller's clock
+    uint32_t attempts;
+    uint32_t next_backoff_ms;
+} retry_state_t;
+
+// Generic control request: re-enumeration blips and transient stalls
+extern const retry_policy_t retry_policy_control;
+// Firmware-stage VR_WRITE handshake: a timeout may mean the burner is busy
+extern const retry_policy_t retry_policy_fw_handshake;
+// Firmware-stage VR_SET_DATA_ADDR: may start a chip erase that stalls EP0
+extern const retry_policy_t retry_policy_fw_set_addr;
+
+/**
+ * Start an operation at now_ms. outer_deadline_ms (absolute, 0 = none)
+ * caps the policy's own deadline.
+ */
+void retry_begin(retry_state_t* state, const retry_policy_t* policy,
+                 uint64_t now_ms, uint64_t outer_deadline_ms);
+
+/**
+ * Timeout for the next attempt, clipped to the remaining budget
+ *
+ * @return milliseconds, or 0 if the budget does not allow another attempt
+ */
+uint32_t retry_attempt_timeout(retry_state_t* state, uint64_t now_ms);
+
+/**
+ * Decide what to do after an attempt failed with error_class (RETRY_ERR_*)
+ *
+ * @param sleep_ms Backoff to wait before the next attempt (RETRY_AGAIN only)
+ */
+retry_decision_t retry_after_error(retry_state_t* state, uint32_t error_class,
+                                   uint64_t now_ms, uint32_t* sleep_ms);
+
+#endif // RETRY_POLICY_H
@@ -0,0 +1,99 @@
+#ifndef SIM_DEVICE_H
+#define SIM_DEVICE_H
+
+#include "thingino.h"
+
+// ============================================================================
+// SIMULATED INGENIC DEVICE
+// ============================================================================
+//
+// A protocol-level model of an Ingenic board behind a usb_transport_t: the
+// boot ROM (CPU info, data address/length, bulk loads, PROG_STAGE1/2) and
+// the burner running after U-Boot (flash descriptor, erase status, 40-byte
+// VR_WRITE / VR_FW_WRITE1 chunk handshakes, burner log on bulk-IN 0x81)
+// over a caller-owned flash buffer.
+//
+// With a virtual clock attached, every request advances it by a modelled
+// latency (control round trip, bus rate, chip erase, chunk programming),
+// so jobs see realistic timings while running in milliseconds of wall time.
+//
+// One simulated device is driven by one job thread; it has no locking.
+
+#define SIM_DEVICE_CONTROL_US        250     // One control round trip
+#define SIM_DEVICE_BYTES_PER_MS      20000   // ~20 MB/s bulk
+#define SIM_DEVICE_ERASE_MS          4000    // Chip erase after VR_SET_DATA_LEN
+#define SIM_DEVICE_PROGRAM_MS        60      // Programming one written chunk
+#define SIM_DEVICE_RAM_SIZE          (4 * 1024 * 1024)
+
+typedef enum {
+    SIM_STAGE_BOOTROM = 0,
+    SIM_STAGE_SPL,                  // DDR up, waiting for U-Boot
+    SIM_STAGE_BURNER                // U-Boot burner running
+} sim_stage_t;
+
+typedef enum {
+    SIM_PENDING_NONE = 0,
+    SIM_PENDING_WRITE,              // VR_WRITE seen: next bulk OUT is a chunk
+    SIM_PENDING_READ                // VR_FW_WRITE1 seen: next bulk IN is a chunk
+} sim_pending_t;
+
+typedef struct {
+    // Configuration (set before sim_device_init, or use the defaults)
+    char cpu_magic[8];              // Boot ROM GET_CPU_INFO reply, e.g. "T31V"
+    uint8_t* flash;                 // Caller-owned flash contents
+    uint32_t flash_size;
+    thingino_virtual_clock_t* clock; // Advanced by modelled latency; NULL = none
+    uint32_t bytes_per_ms;
+    uint32_t erase_ms;
+    uint32_t program_ms;
+    bool silent;                    // Burner never writes its log
+
+    // State
+    sim_stage_t stage;
+    uint32_t data_addr;
+    uint32_t data_len;
+    uint8_t* ram;                   // Boot ROM loads land here (SIM_DEVICE_RAM_SIZE)
+    uint32_t ram_loaded;
+    uint64_t erase_done_us;         // Busy until then (virtual clock time)
+    sim_pending_t pending;
+    uint32_t pending_offset;
+    uint32_t pending_size;
+    uint32_t pending_crc;
+    uint32_t write_chunk_size;      // Largest chunk of the current write; numbers log lines
+    char log[512];                  // Burner log text waiting on bulk-IN 0x81
+    size_t log_len;
+
+    // Counters for tests
+    uint32_t control_requests;
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint32_t chunks_written;
+    uint32_t crc_errors;
+    uint32_t reopens;
+} sim_device_t;
+
+extern const usb_transport_t sim_device_transport;
+
+/**
+ * Reset the model to boot ROM stage and fill in unset configuration
+ *
+ * @return THINGINO_ERROR_MEMORY if the RAM image cannot be allocated
+ */
+thingino_error_t sim_device_init(sim_device_t* sim);
+void sim_device_cleanup(sim_device_t* sim);
+
+/**
+ * Open device on the simulator, as if found at bus 1 address 1 in boot ROM
+ * stage with the given variant
+ */
+thingino_error_t sim_device_open(sim_device_t* sim, usb_device_t* device,
+                                 processor_variant_t variant);
+
+/**
+ * Bytes the device expects in its next bulk OUT transfer: the rest of a
+ * boot ROM load or an announced write chunk (an upper bound for the T31
+ * layout, which gives the size in 64KB units). 0 = not known.
+ */
+uint32_t sim_device_next_out_size(const sim_device_t* sim);
+
+#endif // SIM_DEVICE_H
@@ -9,17 +9,76 @@
 #include <stdbool.h>
 #include "platform_compat.h"
 
+// Apart from clonerd.h, sim_device.h and fault_inject.h, which build on this
+// header, the headers in include/ are self-contained modules: neither they
+// nor their .c files include thingino.h or libusb, so the unit tests link
+// them on their own. The ones the library API uses are pulled in here.
+#include "burner_log.h"
+#include "transfer_profile.h"
+#include "retry_policy.h"
+#include "cancel.h"
+#include "image_file.h"
+#include "prepared_image.h"
+#include "metrics.h"
+#include "job_history.h"
+#include "usb_trace.h"
+
 // ============================================================================
-// GLOBAL DEBUG FLAG
+// LOGGING
 // ============================================================================
+//
+// All library output goes through these instead of printf so an embedding
+// application can capture it per context (see thingino_context_t). With no
+// context bound, or no log callback set, output goes to stdout/stderr:
+// through the asynchronous ring logger once thingino_log_async_start() has
+// run, synchronously before that.
 
-extern bool g_debug_enabled;
+typedef enum {
+    THINGINO_LOG_ERROR = 0,
+    THINGINO_LOG_WARN,
+    THINGINO_LOG_INFO,
+    THINGINO_LOG_DEBUG
+} thingino_log_level_t;
+
+// Highest level compiled in (0 = errors only ... 3 = debug); set with
+// -DTHINGINO_LOG_LEVEL_MAX=n. Calls above it are removed by the compiler.
+#ifndef THINGINO_LOG_LEVEL_MAX
+#define THINGINO_LOG_LEVEL_MAX 3
+#endif
+
+#if defined(__GNUC__)
+#define THINGINO_PRINTF_FORMAT(fmt_index, args_index) \
+    __attribute__((format(printf, fmt_index, args_index)))
+#else
+#define THINGINO_PRINTF_FORMAT(fmt_index, args_index)
+#endif
+
+// Debug output enabled on the calling thread's context
+bool thingino_debug_enabled(void);
+
+void thingino_log(thingino_log_level_t level, const char* fmt, ...) THINGINO_PRINTF_FORMAT(2, 3);
+
+// printf replacements; the level is taken from an "[ERROR]"/"[WARN]"-style
+// prefix, defaulting to info (stdout) and error (stderr) respectively
+int thingino_printf(const char* fmt, ...) THINGINO_PRINTF_FORMAT(1, 2);
+int thingino_eprintf(const char* fmt, ...) THINGINO_PRINTF_FORMAT(1, 2);
+
+// Tag prefixed to every line the calling thread logs, e.g. "[station 1-2.4]";
+// NULL clears it. The string must outlive the thread's use of it.
+void thingino_log_set_tag(const char* tag);
+
+#define THINGINO_LOG(level, fmt, ...) \
+    do { \
+        if ((level) <= THINGINO_LOG_LEVEL_MAX) { \
+            thingino_log(level, fmt, ##__VA_ARGS__); \
+        } \
+    } while(0)
 
 // Debug logging macro - only prints if debug is enabled
 #define DEBUG_PRINT(fmt, ...) \
     do { \
-        if (g_debug_enabled) { \
-            printf("[DEBUG] " fmt, ##__VA_ARGS__); \
+        if (THINGINO_LOG_LEVEL_MAX >= THINGINO_LOG_DEBUG && thingino_debug_enabled()) { \
+            thingino_log(THINGINO_LOG_DEBUG, "[DEBUG] " fmt, ##__VA_ARGS__); \
         } \
     } while(0)
 
@@ -85,6 +144,12 @@ typedef struct {
 #define BOOTLOADER_ADDRESS_SDRAM   0x80000000
 #define BOOTSTRAP_TIMEOUT_SECONDS   30
 #define BOOTSTRAP_POLL_INTERVAL_MS  500
+#define REENUMERATION_TIMEOUT_MS    10000  // Deadline for a device to come back after bootstrap
+#define REOPEN_TIMEOUT_MS           3000   // Deadline for usb_device_reopen() to find the device
+#define WRITE_CHUNK_BUDGET_MS       10000  // Control-request budget for one write chunk
+#define WRITE_CHUNK_CONFIRM_MS      1000   // Burner log wait for a chunk whose handshake timed out
+#define WRITE_CHUNK_RESENDS         2      // Resends of a chunk a logging burner never confirmed
+#define READ_BANK_BUDGET_MS         15000  // Control-request budget for one read bank
 #define CRC32_POLYNOMIAL           0xEDB88320
 #define CRC32_INITIAL              0xFFFFFFFF
 
@@ -94,6 +159,12 @@ typedef struct {
 #define ENDPOINT_INT_IN   0x80  // Interrupt IN (EP 0x00 with IN direction)
 #define ENDPOINT_INT_OUT  0x00  // Interrupt OUT (EP 0x00 with OUT direction)
 
+// Firmware-stage write constants (FIRMWARE_WRITE_HANDSHAKE_SIZE: prepared_image.h)
+// Host data the burner may hold ahead of the flash programmer. Its receive
+// area sits behind U-Boot (loaded at 0x80100000); 512KB is a conservative
+// bound that caps the pipelined writer's window depth.
+#define BURNER_RX_BUFFER_BYTES         (512 * 1024)
+
 // Error codes
 #define ACK_SUCCESS    0x00
 #define ACK_ERROR      0x01
@@ -139,10 +210,13 @@ typedef enum {
     THINGINO_ERROR_MEMORY = -7,
     THINGINO_ERROR_FILE_IO = -8,
     THINGINO_ERROR_PROTOCOL = -9,
-    THINGINO_ERROR_TRANSFER_TIMEOUT = -10
+    THINGINO_ERROR_TRANSFER_TIMEOUT = -10,
+    THINGINO_ERROR_CANCELLED = -11
 } thingino_error_t;
 
 // Device information structure
+#define USB_PORT_PATH_MAX 7   // USB 3.0 spec limits hub chains to 7 tiers
+
 typedef struct {
     uint8_t bus;
     uint8_t address;
@@ -150,6 +224,9 @@ typedef struct {
     uint16_t product;
     device_stage_t stage;
     processor_variant_t variant;
+    char flash_chip[TRANSFER_PROFILE_NAME_MAX];  // Transfer profile key ("" = default)
+    uint8_t port_path[USB_PORT_PATH_MAX];        // Hub port chain on the bus
+    uint8_t port_depth;                          // Entries in port_path (0 = unknown)
 } device_info_t;
 
 // CPU information structure
@@ -189,8 +266,32 @@ typedef struct {
     int bank_count;
     flash_bank_t* banks;
     uint32_t block_size;
+    uint32_t bank_delay_ms;   // Pause between bank reads
 } firmware_read_config_t;
 
+// Per-variant firmware write profile
+typedef struct {
+    const char* name;
+    uint32_t chunk_size;         // Bytes per VR_WRITE handshake
+    uint32_t window_depth;       // Default chunks in flight (1 = fully serial)
+    uint32_t max_window_depth;   // BURNER_RX_BUFFER_BYTES / chunk_size, at least 1
+    uint32_t settle_ms;          // Per-chunk program time assumed if the burner stays silent
+} write_profile_t;
+
+// Transfer buffer pool: fixed-size buffers allocated once per session.
+// Buffers come from libusb_dev_mem_alloc() where the backend supports it
+// (usbfs can then DMA straight into them) and fall back to malloc().
+#define USB_BUFFER_POOL_MAX 8
+
+typedef struct {
+    libusb_device_handle* handle;
+    size_t buffer_size;
+    int count;
+    uint8_t* buffers[USB_BUFFER_POOL_MAX];
+    bool dma[USB_BUFFER_POOL_MAX];       // Allocated with libusb_dev_mem_alloc
+    bool in_use[USB_BUFFER_POOL_MAX];
+} usb_buffer_pool_t;
+
 // Firmware files structure
 typedef struct {
     uint8_t* config;
@@ -210,6 +311,7 @@ typedef struct {
     const char* config_file;  // Custom DDR config file path (NULL = use default)
     const char* spl_file;     // Custom SPL file path (NULL = use default)
     const char* uboot_file;   // Custom U-Boot file path (NULL = use default)
+    const firmware_files_t* files;  // Preloaded stage files (NULL = load per device)
 } bootstrap_config_t;
 
 // Bootstrap progress
@@ -220,6 +322,25 @@ typedef struct {
     char description[128];
 } bootstrap_progress_t;
 
+// ============================================================================
+// USB TRANSPORT
+// ============================================================================
+//
+// A device normally talks to libusb through its handle. With a transport
+// set, every transfer goes to the transport instead: the simulated device
+// used by the virtual-time tests, or a decorator around another transport.
+// Calls return libusb codes (byte count or LIBUSB_ERROR_*) so the protocol
+// layers cannot tell the difference.
+
+typedef struct {
+    const char* name;
+    int (*control)(void* data, uint8_t request_type, uint8_t request, uint16_t value,
+                   uint16_t index, uint8_t* buffer, uint16_t length, unsigned int timeout);
+    int (*bulk)(void* data, uint8_t endpoint, uint8_t* buffer, int length, int* transferred,
+                unsigned int timeout);
+    int (*reopen)(void* data);      // After re-enumeration; NULL = nothing to do
+} usb_transport_t;
+
 // USB device structure
 typedef struct {
     libusb_device_handle* handle;
@@ -227,14 +348,281 @@ typedef struct {
     libusb_device* device;
     device_info_t info;
     bool closed;
+    burner_log_t burner_log;  // Decoded firmware-stage log events (bulk-IN 0x81)
+    uint64_t deadline_ms;     // Caller's remaining budget (monotonic, 0 = none)
+    thingino_cancel_t* cancel; // Job's cancel token (NULL = not cancellable)
+    uint64_t event_phase_ms;  // Start of the current phase (event stream)
+    uint64_t event_last_ms;   // Last rate-limited "bytes" event
+    const usb_transport_t* transport;  // NULL = libusb through handle
+    void* transport_data;
+    usb_buffer_pool_t bank_pool;  // See usb_device_bank_buffer()
+    bool probe;               // Opened only to identify the device, not by a job
 } usb_device_t;
 
+// Firmware write session: firmware_write_begin(), firmware_write_chunk() per
+// chunk in order, firmware_write_end()
+typedef struct {
+    usb_device_t* device;
+    write_profile_t profile;        // Variant profile with transfer profile tuning applied
+    bool is_a1;
+    uint32_t flash_base_address;
+    uint32_t total_size;
+    uint32_t bytes_written;
+    uint32_t chunk_num;
+    const char* label;              // Log prefix for concurrent writers (NULL = none)
+} firmware_write_session_t;
+
+// Bus bandwidth scheduler for multi-device modes (see bus_scheduler.c)
+#define BUS_SCHED_MAX_DOMAINS 32
+#define BUS_SCHED_MIN_BYTES   (16 * 1024)  // Smaller transfers are never queued
+#define BUS_SCHED_SLICE_BYTES (256 * 1024) // Most a transfer moves per slot hold
+#define BUS_SCHED_SLICE_MS    500          // Longest a NAKing device holds a slot
+#define BUS_SCHED_CANCELLED   (-2)         // bus_sched_acquire(): job cancelled while queued
+
+typedef struct {
+    uint64_t transfers;         // Slots granted (one per slice)
+    uint64_t bytes;
+    uint64_t busy_ms;           // Time with at least one transfer admitted
+    uint64_t wait_ms;           // Summed time transfers spent queued
+} bus_sched_stats_t;
+
+// Station mode: write every bootrom device that gets plugged in (see station.c)
+#define STATION_MAX_PORTS 32
+
+typedef struct {
+    const char* firmware_file;
+    bool verify;                    // Read back and compare after writing
+    uint32_t window_depth;          // 0 = per-variant default
+    const char* flash_chip;         // Transfer profile key (NULL = default)
+    int bus_slots;                  // Heavy transfers per root port (0 = unscheduled)
+    uint32_t watchdog_ms;           // Cancel a job idle this long (0 = off)
+    bootstrap_config_t bootstrap;   // Custom stage files, DDR options
+} station_config_t;
+
+// Device-to-device clone target (see clone.c)
+#define CLONE_MAX_TARGETS 16
+
+typedef struct {
+    usb_device_t* device;
+    bool is_a1;                     // Filled in while preparing the target
+    thingino_error_t result;        // Per-target outcome
+    char label[24];                 // Log prefix, e.g. "[to 2]"
+} clone_target_t;
+
+// Enumeration snapshot entry: one per device on the bus, kept (and
+// referenced) across refreshes so descriptors are read once per
+// enumeration of the device rather than once per scan
+typedef struct {
+    libusb_device* device;
+    device_info_t info;
+    bool ingenic;               // Supported Ingenic VID/PID
+    bool announced;             // Device event sent for this enumeration
+} usb_snapshot_entry_t;
+
 // USB manager structure
 typedef struct {
     libusb_context* context;
     bool initialized;
+    usb_snapshot_entry_t* snapshot;
+    int snapshot_count;
 } usb_manager_t;
 
+// ============================================================================
+// LIBRARY CONTEXT
+// ============================================================================
+//
+// Everything one caller of libthingino needs: its libusb context, debug
+// switch and output callbacks. A context is bound to the threads that work
+// on its behalf (thingino_context_bind); logging, debug checks and progress
+// reports look it up from there, so independent contexts can drive devices
+// from different threads of one process. Worker threads started by the
+// library bind their parent's context.
+
+typedef void (*thingino_log_fn)(void* user_data, thingino_log_level_t level, const char* text);
+
+// operation is "bootstrap", "read", "write" or "verify"; done/total are
+// bytes (steps for bootstrap)
+typedef void (*thingino_progress_fn)(void* user_data, const char* operation,
+                                     uint64_t done, uint64_t total);
+
+// In-process form of the event stream (see EVENT STREAM below). Strings
+// and the device are only valid during the callback.
+typedef enum {
+    THINGINO_EVENT_DEVICE = 0,      // Device first seen by a scan (info only)
+    THINGINO_EVENT_PHASE_START,     // name = phase
+    THINGINO_EVENT_PHASE_END,       // name = phase, ms, result
+    THINGINO_EVENT_BYTES,           // name = operation, done/total bytes, bps
+    THINGINO_EVENT_STEP,            // name = "bootstrap", done/total steps
+    THINGINO_EVENT_ERASE,           // ms waited
+    THINGINO_EVENT_RETRY            // name = error, request, attempt, ms = delay
+} thingino_event_type_t;
+
+typedef struct {
+    thingino_event_type_t type;
+    uint64_t t_ms;                  // thingino_monotonic_ms()
+    const usb_device_t* device;     // NULL when not tied to an open device
+    const device_info_t* info;      // Device identity, NULL when not tied to one
+    const char* dev;                // Port path or bus:addr ("" without a device)
+    const char* name;
+    uint64_t done;
+    uint64_t total;
+    uint64_t bps;
+    uint64_t ms;
+    thingino_error_t result;
+    uint8_t request;
+    uint32_t attempt;
+} thingino_event_t;
+
+typedef void (*thingino_event_fn)(void* user_data, const thingino_event_t* event);
+
+typedef struct thingino_context {
+    usb_manager_t manager;
+    bool debug;
+    thingino_log_fn log;            // NULL = stdout/stderr
+    thingino_progress_fn progress;  // NULL = no progress reports
+    thingino_event_fn event;        // NULL = no in-process events
+    void* user_data;                // Passed to all callbacks
+    int events_fd;                  // JSON-lines event stream (-1 = off)
+    bool events_owned;              // events_fd was opened by us
+    uint32_t events_dropped;        // Lines lost to a reader that fell behind
+    metrics_t* metrics;             // NULL = not collecting
+    struct thingino_metrics_exporter* metrics_exporter;
+    char* history_path;             // Job history log (NULL = not recording)
+    bool history_warned;            // Append failure already reported
+    usb_trace_t* trace;             // Transfer trace (NULL = not recording)
+} thingino_context_t;
+
+thingino_error_t thingino_context_init(thingino_context_t* ctx);
+void thingino_context_cleanup(thingino_context_t* ctx);
+thingino_context_t* thingino_context_bind(thingino_context_t* ctx);
+thingino_context_t* thingino_context_current(void);
+void thingino_progress(usb_device_t* device, const char* operation, uint64_t done, uint64_t total);
+
+// Move terminal output to a background thread fed by a lock-free ring
+// (see log_ring.h). Stopped and flushed automatically at exit.
+thingino_error_t thingino_log_async_start(void);
+void thingino_log_async_stop(void);
+void thingino_log_flush(void);
+
+// ============================================================================
+// EVENT STREAM (events.c)
+// ============================================================================
+//
+// One compact JSON object per line for station controllers, e.g.
+//   {"t":81234,"ev":"bytes","dev":"1-2.4","op":"write","done":1048576,"total":16777216,"bps":812345}
+// "t" is CLOCK_MONOTONIC milliseconds; the first line ("ev":"start") pairs
+// it with wall-clock time. Events: start, device, phase (state start/end,
+// with ms and ok on end), bytes (at most every EVENTS_BYTES_INTERVAL_MS per
+// device, plus the final one), step (bootstrap), erase, retry and error.
+// "device" is sent once per device enumeration, when a scan first sees it.
+// Every event is a single write(), so lines from concurrent devices never
+// interleave. The stream never blocks a transfer: lines a slow reader has no
+// room for are dropped, and the next line that fits is preceded by
+// {"ev":"dropped","count":N}.
+
+#define EVENTS_BYTES_INTERVAL_MS 250
+#define EVENTS_LINE_MAX          384
+
+// target: a file descriptor number ("3", "fd:3") or a file path (appended)
+thingino_error_t thingino_events_open(thingino_context_t* ctx, const char* target);
+void thingino_events_close(thingino_context_t* ctx);
+
+void thingino_event_device(const device_info_t* info);
+void thingino_event_phase_begin(usb_device_t* device, const char* phase);
+void thingino_event_phase_end(usb_device_t* device, const char* phase, thingino_error_t result);
+void thingino_event_erase(const usb_device_t* device, uint64_t waited_ms);
+void thingino_event_retry(const usb_device_t* device, uint8_t request, const char* error,
+                          uint32_t attempt, uint32_t delay_ms);
+
+// Metrics only: one flash chunk moved (the stream reports bytes through
+// thingino_progress)
+void thingino_event_chunk(const usb_device_t* device, bool write, uint32_t bytes,
+                          uint64_t latency_us);
+
+// ============================================================================
+// TERMINAL DASHBOARD (dashboard.c)
+// ============================================================================
+//
+// One line per device (port, variant, phase, progress bar, MB/s, ETA) kept
+// at the bottom of the terminal and redrawn every DASHBOARD_REDRAW_MS from
+// the context's events, using plain ANSI cursor sequences. While it runs it
+// takes over the context's log and event callbacks: device threads' info
+// chatter is dropped, warnings, errors and everything from the starting
+// thread are printed above the block. When stdout is not a terminal it
+// prints a plain summary of changed devices every DASHBOARD_SUMMARY_MS.
+
+#define DASHBOARD_REDRAW_MS   500
+#define DASHBOARD_SUMMARY_MS  10000
+#define DASHBOARD_MAX_ROWS    32
+
+thingino_error_t thingino_dashboard_start(thingino_context_t* ctx);
+void thingino_dashboard_stop(thingino_context_t* ctx);
+
+// ============================================================================
+// METRICS EXPORT (metrics_export.c)
+// ============================================================================
+//
+// The observation points above also feed the context's metrics (see
+// metrics.h) once collection is started. target selects the exporter:
+//   "unix:<path>"  OpenMetrics endpoint on a Unix socket; a connection gets
+//                  the current text (an HTTP GET gets it with headers)
+//   "<path>"       node_exporter textfile, rewritten atomically every
+//                  METRICS_TEXTFILE_INTERVAL_MS and once more at stop
+
+#define METRICS_TEXTFILE_INTERVAL_MS 5000
+
+thingino_error_t thingino_metrics_start(thingino_context_t* ctx, const char* target);
+void thingino_metrics_stop(thingino_context_t* ctx);
+
+// Current exposition text (caller frees), or NULL if not collecting
+char* thingino_metrics_render(thingino_context_t* ctx, metrics_format_t format, size_t* len);
+
+// ============================================================================
+// JOB HISTORY (history.c)
+// ============================================================================
+//
+// Whoever runs a device job brackets it with thingino_job_begin/end on the
+// thread doing the work; with history open on the context, the end appends
+// one record (see job_history.h). The note hooks are called from the event
+// observation points and the CPU/image code.
+
+thingino_error_t thingino_history_open(thingino_context_t* ctx, const char* path);
+void thingino_history_close(thingino_context_t* ctx);
+
+void thingino_job_begin(const char* port);      // port may be NULL (taken from the device)
+void thingino_job_end(thingino_error_t result);
+
+void thingino_job_note_phase(const usb_device_t* device, const char* phase, uint64_t ms);
+void thingino_job_note_retry(void);
+void thingino_job_note_bytes(uint32_t bytes);
+void thingino_job_note_cpu(const usb_device_t* device, const char* magic);
+void thingino_job_note_image(const uint8_t* data, size_t size);
+
+// ============================================================================
+// TRANSFER TRACE (trace.c)
+// ============================================================================
+//
+// With a trace open on the context, every transfer the raw USB paths make
+// is appended to a usbmon pcap (see usb_trace.h), timed with the library
+// clock. thingino-usbcap --diff lines it up against a vendor capture.
+
+thingino_error_t thingino_trace_open(thingino_context_t* ctx, const char* path);
+void thingino_trace_close(thingino_context_t* ctx);
+
+// Start time for a transfer about to be made, 0 when not tracing
+uint64_t thingino_trace_start(void);
+
+// result: libusb code or byte count, as the transfer returned
+void thingino_trace_control(const usb_device_t* device, uint64_t start_us, uint8_t request_type,
+                            uint8_t request, uint16_t value, uint16_t index, const uint8_t* data,
+                            uint16_t length, int result);
+void thingino_trace_bulk(const usb_device_t* device, uint64_t start_us, uint8_t endpoint,
+                         const uint8_t* data, int length, int transferred, int result);
+
+// Completed asynchronous control or bulk transfer, from its callback
+void thingino_trace_transfer(const usb_device_t* device, uint64_t start_us,
+                             struct libusb_transfer* xfer);
+
 // ============================================================================
 // FUNCTION DECLARATIONS
 // ============================================================================
@@ -246,8 +634,25 @@ thingino_error_t usb_manager_find_devices_fast(usb_manager_t* manager, device_in
 thingino_error_t usb_manager_open_device(usb_manager_t* manager, const device_info_t* info, usb_device_t** device);
 void usb_manager_cleanup(usb_manager_t* manager);
 
+// Hotplug / port identity functions (see hotplug.c)
+#define USB_PORT_STRING_MAX 32  // "bus-p1.p2...p7" plus NUL
+
+bool usb_is_supported_ingenic(uint16_t vendor, uint16_t product);
+void usb_port_path_fill(libusb_device* dev, device_info_t* info);
+bool usb_device_info_same_port(const device_info_t* a, const device_info_t* b);
+bool usb_device_info_may_share_port(const device_info_t* a, const device_info_t* b);
+void usb_port_path_format(const device_info_t* info, char* buffer, size_t size);
+bool usb_port_path_parse(const char* text, device_info_t* info);
+int usb_device_info_find_port(const device_info_t* devices, int count, const char* port);
+thingino_error_t usb_wait_for_arrival(libusb_context* context, const device_info_t* previous,
+                                      int timeout_ms, device_info_t* arrived);
+
 // Device functions
 thingino_error_t usb_device_init(usb_device_t* device, uint8_t bus, uint8_t address);
+thingino_error_t usb_device_open_libusb(usb_device_t* device, libusb_device* dev);
+thingino_error_t usb_device_open_transport(usb_device_t* device, const usb_transport_t* transport,
+    void* transport_data, const device_info_t* info);
+bool usb_device_is_open(const usb_device_t* device);
 thingino_error_t usb_device_close(usb_device_t* device);
 	thingino_error_t usb_device_reopen(usb_device_t* device);
 
@@ -256,6 +661,12 @@ thingino_error_t usb_device_claim_interface(usb_device_t* device);
 thingino_error_t usb_device_release_interface(usb_device_t* device);
 thingino_error_t usb_device_get_cpu_info(usb_device_t* device, cpu_info_t* info);
 
+// Bus scheduler functions
+void bus_sched_configure(int slots_per_domain);
+int bus_sched_acquire(const usb_device_t* device, uint32_t bytes);
+void bus_sched_release(int token, uint32_t bytes);
+void bus_sched_report(void);
+
 // Transfer functions
 thingino_error_t usb_device_control_transfer(usb_device_t* device, uint8_t request_type,
     uint8_t request, uint16_t value, uint16_t index, uint8_t* data, uint16_t length, int* transferred);
@@ -263,6 +674,18 @@ thingino_error_t usb_device_bulk_transfer(usb_device_t* device, uint8_t endpoint
     uint8_t* data, int length, int* transferred, int timeout);
 thingino_error_t usb_device_interrupt_transfer(usb_device_t* device, uint8_t endpoint,
     uint8_t* data, int length, int* transferred, int timeout);
+int usb_device_control_raw(usb_device_t* device, uint8_t request_type, uint8_t request,
+    uint16_t value, uint16_t index, uint8_t* data, uint16_t length, unsigned int timeout);
+int usb_device_bulk_raw(usb_device_t* device, uint8_t endpoint, uint8_t* data,
+    int length, int* transferred, unsigned int timeout);
+thingino_error_t usb_device_sleep(usb_device_t* device, uint32_t ms);
+thingino_error_t usb_device_vendor_request_policy(usb_device_t* device, const retry_policy_t* policy,
+    uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, uint8_t* data,
+    uint16_t length, uint8_t* response, int* response_length);
+const retry_policy_t* usb_vendor_request_policy_for(const usb_device_t* device,
+    uint8_t request_type, uint8_t request);
+uint64_t usb_device_budget_begin(usb_device_t* device, uint32_t budget_ms);
+void usb_device_budget_end(usb_device_t* device, uint64_t saved_deadline);
 thingino_error_t usb_device_vendor_request(usb_device_t* device, uint8_t request_type,
     uint8_t request, uint16_t value, uint16_t index, uint8_t* data, uint16_t length, uint8_t* response, int* response_length);
 
@@ -277,6 +700,19 @@ thingino_error_t protocol_prog_stage2(usb_device_t* device, uint32_t addr);
 thingino_error_t protocol_get_ack(usb_device_t* device, int32_t* status);
 thingino_error_t protocol_init(usb_device_t* device);
 thingino_error_t protocol_nand_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* transferred);
+thingino_error_t protocol_nand_read_into(usb_device_t* device, uint32_t offset, uint32_t size,
+                                         uint8_t* buffer, int* transferred);
+
+// Transfer buffer pool functions
+thingino_error_t usb_buffer_pool_init(usb_buffer_pool_t* pool, usb_device_t* device,
+                                      size_t buffer_size, int count);
+uint8_t* usb_buffer_pool_acquire(usb_buffer_pool_t* pool);
+void usb_buffer_pool_release(usb_buffer_pool_t* pool, uint8_t* buffer);
+void usb_buffer_pool_destroy(usb_buffer_pool_t* pool);
+
+// Bank-sized read buffer owned by the device, kept until close or reopen
+uint8_t* usb_device_bank_buffer(usb_device_t* device, size_t size);
+void usb_device_release_buffers(usb_device_t* device);
 
 // Firmware functions
 thingino_error_t firmware_load(processor_variant_t variant, firmware_files_t* firmware);
@@ -306,6 +742,7 @@ thingino_error_t bootstrap_transfer_data(usb_device_t* device, const uint8_t* da
 
 // Additional protocol functions
 thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t** data, int* actual_len);
+thingino_error_t protocol_fw_read_into(usb_device_t* device, uint8_t* buffer, int data_len, int* actual_len);
 thingino_error_t protocol_fw_handshake(usb_device_t* device);
 thingino_error_t protocol_fw_write_chunk1(usb_device_t* device, const uint8_t* data);
 thingino_error_t protocol_fw_write_chunk2(usb_device_t* device, const uint8_t* data);
@@ -313,6 +750,8 @@ thingino_error_t protocol_traditional_read(usb_device_t* device, int data_len, u
 thingino_error_t protocol_fw_read_operation(usb_device_t* device, uint32_t offset, uint32_t length, uint8_t** data, int* actual_len);
 thingino_error_t protocol_fw_read_status(usb_device_t* device, int status_cmd, uint32_t* status);
 thingino_error_t protocol_vendor_style_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* actual_len);
+thingino_error_t protocol_vendor_style_read_into(usb_device_t* device, uint32_t offset, uint32_t size,
+                                                 uint8_t* buffer, int* actual_len);
 
 // Proper bootloader protocol functions (using code execution pattern)
 thingino_error_t protocol_load_and_execute_code(usb_device_t* device, uint32_t ram_address,
@@ -326,30 +765,87 @@ thingino_error_t protocol_proper_firmware_write(usb_device_t* device, uint32_t f
 thingino_error_t firmware_read_detect_size(usb_device_t* device, uint32_t* size);
 thingino_error_t firmware_read_init(usb_device_t* device, firmware_read_config_t* config);
 thingino_error_t firmware_read_bank(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data);
+thingino_error_t firmware_read_bank_into(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t* buffer);
+thingino_error_t firmware_read_prepare(usb_device_t* device);
 thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32_t* size);
+thingino_error_t firmware_read_full_prepared(usb_device_t* device, uint8_t** data, uint32_t* size);
 thingino_error_t firmware_read_cleanup(firmware_read_config_t* config);
+thingino_error_t firmware_verify(usb_device_t* device, const uint8_t* data, uint32_t size);
+thingino_error_t firmware_verify_prepared(usb_device_t* device, const uint8_t* data, uint32_t size);
 
 // Firmware handshake protocol functions (40-byte chunk transfers)
 thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t chunk_index,
                                                uint32_t chunk_offset, uint32_t chunk_size,
                                                uint8_t** out_data, int* out_len);
+thingino_error_t firmware_handshake_read_chunk_into(usb_device_t* device, uint32_t chunk_index,
+                                                    uint32_t chunk_offset, uint32_t chunk_size,
+                                                    uint8_t* data_buffer, int* out_len);
 thingino_error_t firmware_handshake_write_chunk(usb_device_t* device, uint32_t chunk_index,
                                                 uint32_t chunk_offset, const uint8_t* data,
                                                 uint32_t data_size);
 thingino_error_t firmware_handshake_write_chunk_a1(usb_device_t* device, uint32_t chunk_index,
                                                    uint32_t chunk_offset, const uint8_t* data,
                                                    uint32_t data_size);
+thingino_error_t firmware_handshake_send_chunk(usb_device_t* device, uint32_t chunk_index,
+                                               uint32_t chunk_offset, const uint8_t* data,
+                                               uint32_t data_size,
+                                               const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]);
+thingino_error_t firmware_handshake_send_chunk_a1(usb_device_t* device, uint32_t chunk_index,
+                                                  uint32_t chunk_offset, const uint8_t* data,
+                                                  uint32_t data_size,
+                                                  const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]);
+write_handshake_format_t firmware_write_handshake_format(const usb_device_t* device, bool is_a1_board);
 thingino_error_t firmware_handshake_init(usb_device_t* device);
+void firmware_build_write_handshake(const usb_device_t* device, uint32_t chunk_offset,
+                                    const uint8_t* data, uint32_t data_size,
+                                    uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]);
+thingino_error_t firmware_burner_log_poll(usb_device_t* device, int max_reads);
+thingino_error_t firmware_burner_log_wait(usb_device_t* device, uint32_t mask, int32_t chunk,
+                                          int timeout_ms, burner_event_t* event);
 
 // Firmware writer functions
 thingino_error_t write_firmware_to_device(usb_device_t* device,
                                          const char* firmware_file,
                                          const firmware_binary_t* fw_binary,
                                          bool force_erase,
-                                         bool is_a1_board);
+                                         bool is_a1_board,
+                                         uint32_t window_depth);
+thingino_error_t write_firmware_prepared(usb_device_t* device,
+                                        const prepared_image_t* image,
+                                        const firmware_binary_t* fw_binary,
+                                        bool force_erase,
+                                        bool is_a1_board,
+                                        uint32_t window_depth);
+thingino_error_t firmware_write_prepare(usb_device_t* device, bool* is_a1_board);
+thingino_error_t firmware_write_begin(firmware_write_session_t* session,
+                                      usb_device_t* device,
+                                      const firmware_binary_t* fw_binary,
+                                      bool is_a1_board,
+                                      uint32_t total_size);
+thingino_error_t firmware_write_chunk(firmware_write_session_t* session,
+                                      const uint8_t* data, uint32_t size,
+                                      const uint8_t* handshake);
+thingino_error_t firmware_write_end(firmware_write_session_t* session);
+const write_profile_t* firmware_write_profile_get(const usb_device_t* device, bool is_a1_board);
+const write_profile_t* firmware_write_profile_for_format(write_handshake_format_t format);
 thingino_error_t send_bulk_data(usb_device_t* device, uint8_t endpoint,
                                 const uint8_t* data, uint32_t size);
 
+// Pipelined firmware writer (async libusb, see write_pipeline.c)
+thingino_error_t firmware_write_pipelined(usb_device_t* device, const write_profile_t* profile,
+                                         uint32_t window_depth, const uint8_t* data,
+                                         uint32_t size, const prepared_layout_t* layout,
+                                         uint32_t* bytes_written, uint32_t* chunks_written);
+
+// Station mode (--station)
+thingino_error_t station_run(usb_manager_t* manager, const station_config_t* config);
+
+// Device-to-device clone (--clone-from/--to)
+thingino_error_t firmware_clone(usb_device_t* source, clone_target_t* targets, int target_count);
+
+// Transfer benchmark (--bench)
+thingino_error_t firmware_bench_run(usb_device_t* device, uint32_t bytes_per_point, bool save_profile);
+
 // Utility functions (additional)
 processor_variant_t detect_variant_from_magic(const char* magic);
 
@@ -0,0 +1,73 @@
+#ifndef TRANSFER_PROFILE_H
+#define TRANSFER_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ============================================================================
+// TRANSFER PROFILES
+// ============================================================================
+//
+// Tuned chunk sizes and inter-chunk delays per (SoC variant, flash chip),
+// persisted in a small text file so the reader and writer pick up the best
+// working point found by --bench. One profile per line:
+//
+//   # variant flash key=value...
+//   t31x default read_chunk=1048576 read_delay_ms=0 read_mbps=3.20
+//
+// Unknown keys are ignored, so the format can grow without breaking older
+// builds. The file lives at $THINGINO_PROFILE_FILE if set, otherwise
+// $XDG_CONFIG_HOME/thingino-cloner/profiles (~/.config/... as fallback) or
+// %APPDATA%\thingino-cloner\profiles on Windows.
+
+#define TRANSFER_PROFILE_NAME_MAX  24
+#define TRANSFER_PROFILE_FLASH_DEFAULT "default"
+
+typedef struct {
+    char variant[TRANSFER_PROFILE_NAME_MAX];
+    char flash[TRANSFER_PROFILE_NAME_MAX];
+    uint32_t read_chunk_size;    // 0 = built-in default
+    uint32_t read_delay_ms;
+    uint32_t write_chunk_size;   // 0 = built-in default
+    uint32_t write_settle_ms;    // 0 = built-in default
+    double read_mbps;            // Last measured throughput (informational)
+    double write_mbps;
+} transfer_profile_t;
+
+/**
+ * Resolve the profile file path
+ *
+ * @return 0 on success, -1 if no suitable location could be determined
+ */
+int transfer_profile_path(char* buf, size_t buf_size);
+
+/**
+ * Look up the profile for (variant, flash). If no exact match exists the
+ * variant's "default" flash entry is used.
+ *
+ * @return true if a profile was found
+ */
+bool transfer_profile_lookup(const char* variant, const char* flash, transfer_profile_t* out);
+
+/**
+ * Insert or replace the profile for (profile->variant, profile->flash),
+ * preserving all other lines in the file.
+ *
+ * @return 0 on success, -1 on I/O error
+ */
+int transfer_profile_store(const transfer_profile_t* profile);
+
+/**
+ * Parse one profile line. Exposed for testing.
+ *
+ * @return true if the line holds a profile (not blank or a comment)
+ */
+bool transfer_profile_parse_line(const char* line, transfer_profile_t* out);
+
+/**
+ * Format a profile as one line (without trailing newline)
+ */
+int transfer_profile_format(const transfer_profile_t* profile, char* buf, size_t buf_size);
+
+#endif // TRANSFER_PROFILE_H
@@ -0,0 +1,69 @@
+#ifndef USB_CAPTURE_H
+#define USB_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ============================================================================
+// USB CAPTURE PARSER
+// ============================================================================
+//
+// Streams the transfers out of a Linux usbmon capture (pcap or pcapng,
+// either byte order, LINKTYPE_USB_LINUX or LINKTYPE_USB_LINUX_MMAPPED) held
+// in memory, typically a mapped file. Submit and completion events are
+// paired by URB id; each finished transfer is handed to a callback with its
+// payload pointing into the capture, so nothing is copied and memory use
+// does not grow with the capture.
+
+#define USB_CAPTURE_XFER_ISO        0
+#define USB_CAPTURE_XFER_INTERRUPT  1
+#define USB_CAPTURE_XFER_CONTROL    2
+#define USB_CAPTURE_XFER_BULK       3
+
+#define USB_CAPTURE_PENDING_MAX     4096    // URBs in flight at once
+
+typedef struct {
+    uint64_t urb_id;
+    uint64_t submit_us;             // Capture time, microseconds since the epoch
+    uint64_t complete_us;           // 0 if the capture ends before completion
+    uint16_t bus;
+    uint8_t device;
+    uint8_t endpoint;               // 0x80 set for IN
+    uint8_t type;                   // USB_CAPTURE_XFER_*
+
+    bool has_setup;                 // Control transfer with its setup packet
+    uint8_t request_type;
+    uint8_t request;
+    uint16_t value;
+    uint16_t index;
+    uint16_t length;                // wLength
+
+    int32_t status;                 // 0 or -errno from the completion
+    uint32_t requested;             // Length submitted
+    uint32_t actual;                // Length completed
+    const uint8_t* data;            // OUT: submitted payload, IN: returned payload
+    uint32_t data_len;              // Captured payload bytes (may be < actual)
+} usb_capture_transfer_t;
+
+typedef struct {
+    uint64_t records;               // Packets in the capture
+    uint64_t transfers;             // Reported to the callback
+    uint64_t unmatched;             // Completions without a submit, submits never completed
+    uint64_t skipped;               // Other link types, truncated headers
+} usb_capture_stats_t;
+
+typedef void (*usb_capture_fn)(void* user_data, const usb_capture_transfer_t* transfer);
+
+/**
+ * Parse a capture and report each transfer as it completes. Transfers still
+ * in flight at the end are reported with complete_us 0.
+ *
+ * @param stats Receives counters (may be NULL)
+ * @param error Receives a message on failure (may be NULL)
+ * @return 0 on success, -1 if data is not a usable pcap/pcapng capture
+ */
+int usb_capture_parse(const uint8_t* data, size_t size, usb_capture_fn fn, void* user_data,
+                      usb_capture_stats_t* stats, char* error, size_t error_size);
+
+#endif // USB_CAPTURE_H
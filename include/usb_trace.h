@@ -0,0 +1,54 @@
+#ifndef USB_TRACE_H
+#define USB_TRACE_H
+
+#include "usb_capture.h"
+#include <stdio.h>
+#include <pthread.h>
+
+// ============================================================================
+// USB TRACE WRITER
+// ============================================================================
+//
+// Writes transfers as a usbmon pcap (LINKTYPE_USB_LINUX, one submit and one
+// completion event per transfer), so a trace of our own run reads like a
+// capture of the vendor cloner: usb_capture_parse(), thingino-usbcap and
+// Wireshark all take it. Records from several threads are serialized.
+
+// usbmon status values (negative Linux errno, as captured on any host)
+#define USB_TRACE_STATUS_OK         0
+#define USB_TRACE_STATUS_PIPE       (-32)   // EPIPE: stall
+#define USB_TRACE_STATUS_NODEV      (-19)   // ENODEV
+#define USB_TRACE_STATUS_TIMEOUT    (-110)  // ETIMEDOUT
+#define USB_TRACE_STATUS_OVERFLOW   (-75)   // EOVERFLOW
+#define USB_TRACE_STATUS_UNLINKED   (-104)  // ECONNRESET: cancelled
+#define USB_TRACE_STATUS_PROTO      (-71)   // EPROTO: anything else
+
+typedef struct usb_trace {
+    FILE* file;
+    pthread_mutex_t lock;
+    uint64_t next_id;               // URB ids, unique per trace
+    bool failed;                    // A write failed; later records are dropped
+} usb_trace_t;
+
+/**
+ * Create path and write the pcap header
+ *
+ * @return 0 on success, -1 if the file cannot be created
+ */
+int usb_trace_open(usb_trace_t* trace, const char* path);
+
+/**
+ * Flush and close
+ *
+ * @return 0 if every record reached the file
+ */
+int usb_trace_close(usb_trace_t* trace);
+
+/**
+ * Append one finished transfer. urb_id is assigned here; submit_us and
+ * complete_us are any consistent microsecond clock. For OUT transfers data
+ * is what was sent, for IN transfers what came back (actual bytes).
+ */
+void usb_trace_record(usb_trace_t* trace, const usb_capture_transfer_t* transfer);
+
+#endif // USB_TRACE_H
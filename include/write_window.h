@@ -0,0 +1,108 @@
+#ifndef WRITE_WINDOW_H
+#define WRITE_WINDOW_H
+
+#include "burner_log.h"
+
+// ============================================================================
+// WRITE WINDOW
+// ============================================================================
+//
+// Bookkeeping for the pipelined writer (write_pipeline.c): which chunks are
+// in flight, what the burner log has said about each of them, and when the
+// oldest one may be retired. The libusb side only reports "host transfers
+// for chunk N finished" and feeds decoded log events in; everything else
+// is decided here.
+//
+// Log reports are matched to chunks by index, so a report that arrives
+// before its chunk's host transfers finished is kept on the slot rather
+// than lost, and reports may come out of order. A chunk whose handshake or
+// data transfer timed out was possibly never taken by the burner, so it is
+// only retired once the log confirms it.
+
+#define WRITE_WINDOW_MAX_SLOTS 16
+
+typedef enum {
+    WRITE_SLOT_FREE = 0,
+    WRITE_SLOT_HOST,            // Handshake/data still on the wire
+    WRITE_SLOT_PROGRAMMING      // Host side done, burner programming it
+} write_slot_state_t;
+
+typedef struct {
+    write_slot_state_t state;
+    uint32_t index;             // Chunk number since the start of the write
+    uint32_t offset;
+    uint32_t size;
+    bool acked;                 // Every host transfer completed without a timeout
+    bool received;              // Log reported it (CRC ok or programmed)
+    bool done;                  // Log reported it programmed
+    uint64_t started_us;
+    uint64_t programmed_at_ms;
+} write_window_slot_t;
+
+typedef struct {
+    write_window_slot_t slots[WRITE_WINDOW_MAX_SLOTS];
+    uint32_t head;              // Oldest in-flight chunk
+    uint32_t tail;              // Next chunk to start
+    uint32_t depth;
+    uint32_t settle_ms;         // Retire a silent, acked chunk after this
+    uint32_t confirm_ms;        // Give up on an unconfirmed chunk after this
+    uint32_t stale;             // Reports for chunks outside the window
+} write_window_t;
+
+typedef enum {
+    WRITE_WINDOW_WAIT = 0,      // Nothing to retire yet
+    WRITE_WINDOW_RETIRED,       // *retired holds the chunk just retired
+    WRITE_WINDOW_UNCONFIRMED    // Head timed out on the host and the log never confirmed it
+} write_window_retire_t;
+
+/**
+ * @param depth Chunks in flight, clamped to 1..WRITE_WINDOW_MAX_SLOTS
+ */
+void write_window_init(write_window_t* window, uint32_t depth, uint32_t settle_ms,
+                       uint32_t confirm_ms);
+
+/**
+ * @return true if another chunk fits in the window
+ */
+bool write_window_has_room(const write_window_t* window);
+
+/**
+ * Open the next chunk (index window->tail) for host transfers
+ *
+ * @return the slot, or NULL if the window is full
+ */
+write_window_slot_t* write_window_start(write_window_t* window, uint32_t offset, uint32_t size,
+                                        uint64_t now_us);
+
+/**
+ * The slot holding chunk index, or NULL if it is not in the window
+ */
+write_window_slot_t* write_window_slot(write_window_t* window, uint32_t index);
+
+/**
+ * Host transfers for slot finished; acked is false if any of them timed out
+ */
+void write_window_host_done(write_window_t* window, write_window_slot_t* slot, bool acked,
+                            uint64_t now_ms);
+
+/**
+ * Apply one burner log event. Reports naming a chunk go to that chunk's
+ * slot whatever its state; unnumbered reports go to the oldest chunk not
+ * yet reported. Reports for chunks outside the window count as stale.
+ *
+ * @return false for a failure event (the write cannot succeed)
+ */
+bool write_window_event(write_window_t* window, const burner_event_t* event);
+
+/**
+ * Retire the oldest chunk if the burner is done with it
+ */
+write_window_retire_t write_window_retire(write_window_t* window, uint64_t now_ms,
+                                          write_window_slot_t* retired);
+
+/**
+ * @return true when no chunk is in flight
+ */
+bool write_window_empty(const write_window_t* window);
+
+#endif // WRITE_WINDOW_H
@@ -10,21 +10,27 @@
 // BOOTSTRAP IMPLEMENTATION
 // ============================================================================
 
-thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t* config) {
-    if (!device || !config) {
-        return THINGINO_ERROR_INVALID_PARAMETER;
+// DDR, SPL, SPL run, U-Boot
+#define BOOTSTRAP_PROGRESS_STEPS 4
+
+// Stage files passed in through config->files belong to the caller
+static void bootstrap_release_files(const bootstrap_config_t* config, firmware_files_t* fw) {
+    if (!config->files) {
+        firmware_cleanup(fw);
     }
+}
 
+static thingino_error_t bootstrap_device_run(usb_device_t* device, const bootstrap_config_t* config) {
     // Only bootstrap if device is in bootrom stage
     if (device->info.stage != STAGE_BOOTROM) {
         if (config->verbose) {
-            printf("Device already in firmware stage, skipping bootstrap\n");
+            thingino_printf("Device already in firmware stage, skipping bootstrap\n");
         }
         return THINGINO_SUCCESS;
     }
 
     const char* variant_str = processor_variant_to_string(device->info.variant);
-    printf("Starting bootstrap sequence for %s\n", variant_str);
+    thingino_printf("Starting bootstrap sequence for %s\n", variant_str);
 
     // NOTE: Do NOT reset device - pcap analysis shows vendor tool does not reset
     // Resetting causes device to disconnect and re-enumerate, breaking bootstrap flow
@@ -35,29 +41,29 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
     cpu_info_t cpu_info;
     thingino_error_t result = usb_device_get_cpu_info(device, &cpu_info);
     if (result != THINGINO_SUCCESS) {
-        printf("Warning: failed to get CPU info: %s\n", thingino_error_to_string(result));
-        printf("Continuing with bootstrap anyway - device may not be ready\n");
+        thingino_printf("Warning: failed to get CPU info: %s\n", thingino_error_to_string(result));
+        thingino_printf("Continuing with bootstrap anyway - device may not be ready\n");
         // Don't exit - continue with bootstrap and let it fail gracefully if needed
     } else {
         // Show raw hex bytes for debugging
-        printf("CPU magic (raw hex): ");
+        thingino_printf("CPU magic (raw hex): ");
         for (int i = 0; i < 8; i++) {
-            printf("%02X ", cpu_info.magic[i]);
+            thingino_printf("%02X ", cpu_info.magic[i]);
         }
-        printf("\n");
+        thingino_printf("\n");
 
-        printf("CPU info: stage=%s, magic='%.8s'\n",
+        thingino_printf("CPU info: stage=%s, magic='%.8s'\n",
             device_stage_to_string(cpu_info.stage), cpu_info.magic);
 
         // Detect and display processor variant
         processor_variant_t detected_variant = detect_variant_from_magic(cpu_info.clean_magic);
-        printf("Detected processor variant: %s (from magic: '%s')\n",
+        thingino_printf("Detected processor variant: %s (from magic: '%s')\n",
             processor_variant_to_string(detected_variant), cpu_info.clean_magic);
 
         // Update device stage based on actual CPU info
         if (cpu_info.stage == STAGE_FIRMWARE) {
             device->info.stage = STAGE_FIRMWARE;
-            printf("Device stage updated to firmware based on CPU info\n");
+            thingino_printf("Device stage updated to firmware based on CPU info\n");
         }
     }
 
@@ -66,7 +72,11 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
     firmware_files_t fw;
 
     // Check if custom files are provided
-    if (config->config_file || config->spl_file || config->uboot_file) {
+    if (config->files) {
+        DEBUG_PRINT("Using preloaded firmware files\n");
+        fw = *config->files;
+        result = THINGINO_SUCCESS;
+    } else if (config->config_file || config->spl_file || config->uboot_file) {
         DEBUG_PRINT("Using custom firmware files:\n");
         if (config->config_file) DEBUG_PRINT("  Config: %s\n", config->config_file);
         if (config->spl_file) DEBUG_PRINT("  SPL: %s\n", config->spl_file);
@@ -84,30 +94,32 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
         return result;
     }
 
-    printf("Firmware loaded - Config: %zu bytes, SPL: %zu bytes, U-Boot: %zu bytes\n",
+    thingino_printf("Firmware loaded - Config: %zu bytes, SPL: %zu bytes, U-Boot: %zu bytes\n",
         fw.config_size, fw.spl_size, fw.uboot_size);
 
     // Step 1: Load DDR configuration to memory (NOT executed yet)
     if (!config->skip_ddr) {
-        printf("Loading DDR configuration\n");
+        thingino_printf("Loading DDR configuration\n");
         result = bootstrap_load_data_to_memory(device, fw.config, fw.config_size, 0x80001000);
         if (result != THINGINO_SUCCESS) {
-            firmware_cleanup(&fw);
+            bootstrap_release_files(config, &fw);
             return result;
         }
-        printf("DDR configuration loaded\n");
+        thingino_printf("DDR configuration loaded\n");
     } else {
-        printf("Skipping DDR configuration (SkipDDR flag set)\n");
+        thingino_printf("Skipping DDR configuration (SkipDDR flag set)\n");
     }
+    thingino_progress(device, "bootstrap", 1, BOOTSTRAP_PROGRESS_STEPS);
 
     // Step 2: Load SPL to memory (NOT executed yet)
-    printf("Loading SPL (Stage 1 bootloader)\n");
+    thingino_printf("Loading SPL (Stage 1 bootloader)\n");
     result = bootstrap_load_data_to_memory(device, fw.spl, fw.spl_size, 0x80001800);
     if (result != THINGINO_SUCCESS) {
-        firmware_cleanup(&fw);
+        bootstrap_release_files(config, &fw);
         return result;
     }
-    printf("SPL loaded\n");
+    thingino_printf("SPL loaded\n");
+    thingino_progress(device, "bootstrap", 2, BOOTSTRAP_PROGRESS_STEPS);
 
     // Step 3: Set execution size (d2i_len) and execute SPL
     // This is processor-specific: T20 uses 0x4000, most others use 0x7000
@@ -116,17 +128,17 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
         d2i_len, processor_variant_to_string(device->info.variant));
     result = protocol_set_data_length(device, d2i_len);
     if (result != THINGINO_SUCCESS) {
-        firmware_cleanup(&fw);
+        bootstrap_release_files(config, &fw);
         return result;
     }
 
     DEBUG_PRINT("Executing SPL from entry point 0x80001800\n");
     result = protocol_prog_stage1(device, 0x80001800);
     if (result != THINGINO_SUCCESS) {
-        firmware_cleanup(&fw);
+        bootstrap_release_files(config, &fw);
         return result;
     }
-    printf("SPL execution started\n");
+    thingino_printf("SPL execution started\n");
 
     // IMPORTANT: Unlike T31X, the vendor's T20 implementation does NOT close/reopen the device
     // The USB device address stays the same (verified in pcap: address 106 throughout)
@@ -143,11 +155,9 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
     }
     DEBUG_PRINT("Waiting %d ms for DDR init...\n", wait_ms);
 
-#ifdef _WIN32
-    Sleep(wait_ms);
-#else
-    usleep(wait_ms * 1000);
-#endif
+    if (usb_device_sleep(device, (uint32_t)wait_ms) != THINGINO_SUCCESS) {
+        return THINGINO_ERROR_CANCELLED;
+    }
 
     DEBUG_PRINT("SPL should have completed, device handle remains valid\n");
 
@@ -166,11 +176,7 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
                 spl_ready = true;
                 break;
             }
-#ifdef _WIN32
-            Sleep(20);
-#else
-            usleep(20000);  // 20ms between polls
-#endif
+            thingino_sleep_milliseconds(20);  // 20ms between polls
         }
         if (!spl_ready) {
             DEBUG_PRINT("Warning: GET_CPU_INFO polling after SPL failed for variant %s\n",
@@ -183,22 +189,24 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
         DEBUG_PRINT("Reopening USB device handle after SPL for T31ZX variant\n");
         thingino_error_t reopen_result = usb_device_reopen(device);
         if (reopen_result != THINGINO_SUCCESS) {
-            printf("Error: failed to re-open USB device after SPL: %s\n",
+            thingino_printf("Error: failed to re-open USB device after SPL: %s\n",
                 thingino_error_to_string(reopen_result));
-            firmware_cleanup(&fw);
+            bootstrap_release_files(config, &fw);
             return reopen_result;
         }
     }
 
+    thingino_progress(device, "bootstrap", 3, BOOTSTRAP_PROGRESS_STEPS);
 
     // Step 4: Load and program U-Boot (Stage 2 bootloader)
-    printf("Loading U-Boot (Stage 2 bootloader)\n");
+    thingino_printf("Loading U-Boot (Stage 2 bootloader)\n");
     result = bootstrap_program_stage2(device, fw.uboot, fw.uboot_size);
     if (result != THINGINO_SUCCESS) {
-        firmware_cleanup(&fw);
+        bootstrap_release_files(config, &fw);
         return result;
     }
-    printf("U-Boot loaded\n");
+    thingino_printf("U-Boot loaded\n");
+    thingino_progress(device, "bootstrap", 4, BOOTSTRAP_PROGRESS_STEPS);
 
     // Vendor does GET_CPU_INFO immediately after PROG_START2 (verified in pcap)
     // This might be necessary to "wake up" the device or trigger the transition
@@ -220,12 +228,28 @@ thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t
     // only in the higher-level read/write flows, *after* the 172-byte
     // partition marker and 972-byte flash descriptor have been sent.
 
-    printf("Bootstrap sequence completed successfully\n");
+    thingino_printf("Bootstrap sequence completed successfully\n");
 
-    firmware_cleanup(&fw);
+    bootstrap_release_files(config, &fw);
     return THINGINO_SUCCESS;
 }
 
+thingino_error_t bootstrap_device(usb_device_t* device, const bootstrap_config_t* config) {
+    if (!device || !config) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    // Every control request of the sequence shares the configured budget,
+    // so a wedged bootrom fails at the deadline instead of per-request retries
+    uint64_t saved = config->timeout > 0
+        ? usb_device_budget_begin(device, (uint32_t)config->timeout * 1000u) : device->deadline_ms;
+    thingino_event_phase_begin(device, "bootstrap");
+    thingino_error_t result = bootstrap_device_run(device, config);
+    thingino_event_phase_end(device, "bootstrap", result);
+    usb_device_budget_end(device, saved);
+    return result;
+}
+
 thingino_error_t bootstrap_ensure_bootstrapped(usb_device_t* device, const bootstrap_config_t* config) {
     if (!device || !config) {
         return THINGINO_ERROR_INVALID_PARAMETER;
@@ -303,16 +327,7 @@ thingino_error_t bootstrap_program_stage2(usb_device_t* device,
     // After large U-Boot transfer, give device time to process
     DEBUG_PRINT("Waiting for device to process U-Boot transfer...\n");
 
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(500);
-#else
-#ifdef _WIN32
-    Sleep(500);
-#else
-    usleep(500000);
-#endif
-#endif
+    thingino_sleep_milliseconds(500);
 
     // Step 4: Flush cache before executing U-Boot
     DEBUG_PRINT("Flushing cache before U-Boot execution\n");
@@ -337,12 +352,9 @@ thingino_error_t bootstrap_program_stage2(usb_device_t* device,
     // Instead, it transitions internally from bootrom to firmware stage
     DEBUG_PRINT("ProgStage2 completed - device should now be in firmware stage\n");
 
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(1000);
-#else
-    sleep(1);
-#endif
+    if (usb_device_sleep(device, 1000) != THINGINO_SUCCESS) {
+        return THINGINO_ERROR_CANCELLED;
+    }
 
     return THINGINO_SUCCESS;
 }
@@ -420,12 +432,7 @@ thingino_error_t bootstrap_transfer_data(usb_device_t* device,
                     DEBUG_PRINT("Retrying write after brief delay (attempt %d/%d)\n",
                         retry + 2, max_retries);
 
-                    // Platform-specific sleep
-#ifdef _WIN32
-                    Sleep(50);
-#else
-                    usleep(50000);
-#endif
+                    thingino_sleep_milliseconds(50);
                     continue;
                 }
 
@@ -442,12 +449,7 @@ thingino_error_t bootstrap_transfer_data(usb_device_t* device,
 
         // Small delay between chunks for large transfers to prevent overwhelming device
         if (size > 100 * 1024 && offset < size) {
-            // Platform-specific sleep
-#ifdef _WIN32
-            Sleep(10);
-#else
-            usleep(10000);
-#endif
+            thingino_sleep_milliseconds(10);
         }
     }
 
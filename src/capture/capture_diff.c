@@ -0,0 +1,192 @@
+#include "capture_diff.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// CAPTURE DIFF IMPLEMENTATION
+// ============================================================================
+//
+// Reduces both captures to vendor requests and bulk transfers, then pairs
+// them in order, resynchronizing after a step only one side made.
+
+#define STATUS_TIMEOUT  (-110)  // -ETIMEDOUT in usbmon
+
+static uint32_t payload_digest(const uint8_t* data, uint32_t len) {
+    uint32_t h = 0x811C9DC5u;  // FNV-1a
+    for (uint32_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 0x01000193u;
+    }
+    return h ? h : 1;
+}
+
+int capture_steps_add(capture_steps_t* steps, const usb_capture_transfer_t* t) {
+    uint32_t index = steps->seen++;
+    capture_step_t step;
+    memset(&step, 0, sizeof(step));
+
+    if (t->type == USB_CAPTURE_XFER_CONTROL) {
+        if (!t->has_setup || (t->request_type & 0x60) != 0x40) {
+            return 0;  // Enumeration traffic
+        }
+        step.control = true;
+        step.in = (t->request_type & 0x80) != 0;
+        step.code = t->request;
+        step.length = t->length;
+        if (!step.in && t->data_len > 0) {
+            step.digest = payload_digest(t->data, t->data_len);
+        }
+    } else if (t->type == USB_CAPTURE_XFER_BULK || t->type == USB_CAPTURE_XFER_INTERRUPT) {
+        step.in = (t->endpoint & 0x80) != 0;
+        if (step.in && t->actual == 0 && (t->status == 0 || t->status == STATUS_TIMEOUT)) {
+            return 0;  // Log poll with nothing to say
+        }
+        step.code = t->endpoint;
+        step.length = t->requested;
+    } else {
+        return 0;
+    }
+    step.status = t->status;
+    step.submit_us = t->submit_us;
+    step.complete_us = t->complete_us ? t->complete_us : t->submit_us;
+    step.index = index;
+
+    if (steps->count == steps->capacity) {
+        size_t capacity = steps->capacity ? steps->capacity * 2 : 256;
+        capture_step_t* grown = (capture_step_t*)realloc(steps->steps, capacity * sizeof(*grown));
+        if (!grown) {
+            return -1;
+        }
+        steps->steps = grown;
+        steps->capacity = capacity;
+    }
+    steps->steps[steps->count++] = step;
+    return 0;
+}
+
+void capture_steps_free(capture_steps_t* steps) {
+    free(steps->steps);
+    memset(steps, 0, sizeof(*steps));
+}
+
+// Same command: what resynchronization keys on. A bulk transfer of another
+// size is a different step (another chunk size, a partial read), not a
+// changed one.
+static bool same_command(const capture_step_t* a, const capture_step_t* b) {
+    return a->control == b->control && a->in == b->in && a->code == b->code &&
+           (a->control || a->length == b->length);
+}
+
+static bool same_step(const capture_step_t* a, const capture_step_t* b) {
+    return same_command(a, b) && a->length == b->length && a->digest == b->digest;
+}
+
+typedef struct {
+    capture_diff_fn fn;
+    void* user_data;
+    bool paired;                    // A pair has been seen
+    uint64_t ours_last_us;          // Completion of the previous pair
+    uint64_t vendor_last_us;
+    int64_t cumulative_us;
+} diff_state_t;
+
+// Overlapping transfers (queued bulk) can complete out of order
+static uint64_t elapsed_since(uint64_t complete_us, uint64_t* last_us) {
+    if (complete_us <= *last_us) {
+        return 0;
+    }
+    uint64_t elapsed = complete_us - *last_us;
+    *last_us = complete_us;
+    return elapsed;
+}
+
+static void emit_single(diff_state_t* d, capture_diff_op_t op, const capture_step_t* step) {
+    capture_diff_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = op;
+    if (op == CAPTURE_DIFF_OURS_ONLY) {
+        entry.ours = step;
+    } else {
+        entry.vendor = step;
+    }
+    entry.cumulative_delta_us = d->cumulative_us;
+    d->fn(d->user_data, &entry);
+}
+
+static void emit_pair(diff_state_t* d, const capture_step_t* ours, const capture_step_t* vendor) {
+    if (!d->paired) {
+        d->paired = true;
+        d->ours_last_us = ours->submit_us;
+        d->vendor_last_us = vendor->submit_us;
+    }
+
+    capture_diff_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = same_step(ours, vendor) ? CAPTURE_DIFF_MATCH : CAPTURE_DIFF_CHANGED;
+    entry.ours = ours;
+    entry.vendor = vendor;
+    entry.ours_elapsed_us = elapsed_since(ours->complete_us, &d->ours_last_us);
+    entry.vendor_elapsed_us = elapsed_since(vendor->complete_us, &d->vendor_last_us);
+    entry.step_delta_us = (int64_t)entry.ours_elapsed_us - (int64_t)entry.vendor_elapsed_us;
+    entry.duration_delta_us = ((int64_t)ours->complete_us - (int64_t)ours->submit_us) -
+                              ((int64_t)vendor->complete_us - (int64_t)vendor->submit_us);
+    d->cumulative_us += entry.step_delta_us;
+    entry.cumulative_delta_us = d->cumulative_us;
+    d->fn(d->user_data, &entry);
+}
+
+/**
+ * Nearest resynchronization point after a mismatch: the pair (i + di,
+ * j + dj) with the same command and the smallest di + dj
+ */
+static bool resync(const capture_steps_t* ours, size_t i, const capture_steps_t* vendor, size_t j,
+                   size_t* di, size_t* dj) {
+    for (size_t sum = 1; sum < 2 * CAPTURE_DIFF_LOOKAHEAD; sum++) {
+        for (size_t a = 0; a <= sum; a++) {
+            size_t b = sum - a;
+            if (a >= CAPTURE_DIFF_LOOKAHEAD || b >= CAPTURE_DIFF_LOOKAHEAD ||
+                i + a >= ours->count || j + b >= vendor->count) {
+                continue;
+            }
+            if (same_command(&ours->steps[i + a], &vendor->steps[j + b])) {
+                *di = a;
+                *dj = b;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void capture_diff(const capture_steps_t* ours, const capture_steps_t* vendor,
+                  capture_diff_fn fn, void* user_data) {
+    diff_state_t d;
+    memset(&d, 0, sizeof(d));
+    d.fn = fn;
+    d.user_data = user_data;
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < ours->count && j < vendor->count) {
+        if (same_command(&ours->steps[i], &vendor->steps[j])) {
+            emit_pair(&d, &ours->steps[i++], &vendor->steps[j++]);
+            continue;
+        }
+
+        size_t di = 1;
+        size_t dj = 1;
+        resync(ours, i, vendor, j, &di, &dj);  // Neither found: drop one step each
+        for (size_t k = 0; k < di; k++) {
+            emit_single(&d, CAPTURE_DIFF_OURS_ONLY, &ours->steps[i++]);
+        }
+        for (size_t k = 0; k < dj; k++) {
+            emit_single(&d, CAPTURE_DIFF_VENDOR_ONLY, &vendor->steps[j++]);
+        }
+    }
+    while (i < ours->count) {
+        emit_single(&d, CAPTURE_DIFF_OURS_ONLY, &ours->steps[i++]);
+    }
+    while (j < vendor->count) {
+        emit_single(&d, CAPTURE_DIFF_VENDOR_ONLY, &vendor->steps[j++]);
+    }
+}
@@ -0,0 +1,975 @@
+/**
+ * thingino-usbcap - usbmon capture analyzer for the Ingenic protocol
+ *
+ * Reads a usbmon pcap/pcapng capture (e.g. from tools/capture_usb_traffic.sh)
+ * through a memory mapping and streams over it once:
+ *
+ *   thingino-usbcap capture.pcap                 Sequence report
+ *   thingino-usbcap capture.pcap --summary       Counts and phase timings only
+ *   thingino-usbcap capture.pcap --extract dir   Also save bulk payloads
+ *   thingino-usbcap capture.pcap --binary fw.bin Correlate writes with an image
+ *
+ * Vendor requests and the 40-byte write/read handshakes are decoded with the
+ * constants the cloner itself uses (thingino.h), and every write chunk is
+ * checked against the CRC its handshake announced. Only Ingenic devices
+ * (by descriptor or because they get vendor requests) are reported unless
+ * --all or --device is given.
+ */
+
+#include "thingino.h"
+#include "usb_capture.h"
+#include "capture_diff.h"
+#include "image_file.h"
+#include <errno.h>
+#include <sys/stat.h>
+
+#define USBCAP_MAX_DEVICES      64
+#define USBCAP_WINDOW           32      // Bytes hashed per correlation key
+#define USBCAP_STRIDE           512     // Binary offsets indexed for correlation
+#define USBCAP_PREVIEW          16
+#define USBCAP_MAX_GAPS         8
+#define USBCAP_TOP_LOSSES       10
+
+typedef enum {
+    PHASE_NONE = 0,
+    PHASE_BOOTSTRAP,
+    PHASE_WRITE,
+    PHASE_READ,
+    PHASE_COUNT
+} usbcap_phase_t;
+
+static const char* const phase_names[PHASE_COUNT] = { "Other", "Bootstrap", "Write", "Read" };
+
+typedef struct {
+    uint64_t hash;
+    uint32_t offset;
+} usbcap_slot_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    usbcap_slot_t* slots;
+    size_t slot_mask;
+    uint8_t* covered;               // One flag per USBCAP_STRIDE block
+    uint64_t chunks;
+    uint64_t exact;
+    uint64_t partial;
+    uint64_t unmatched;
+} usbcap_binary_t;
+
+typedef struct {
+    // Options
+    bool summary_only;
+    bool all_devices;
+    int filter_bus;                 // -1 = any
+    int filter_device;
+    const char* extract_dir;
+    usbcap_binary_t* binary;
+
+    // Devices seen to be Ingenic, as bus << 8 | address
+    uint32_t ingenic[USBCAP_MAX_DEVICES];
+    int ingenic_count;
+
+    // Progress
+    uint64_t first_us;
+    uint64_t last_complete_us;
+    usbcap_phase_t phase;
+    uint64_t phase_start_us[PHASE_COUNT];
+    uint64_t phase_us[PHASE_COUNT];
+    uint64_t phase_bytes[PHASE_COUNT];
+    uint64_t control_count;
+    uint64_t bulk_count;
+    uint64_t errors;
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint64_t request_counts[256];
+
+    // Write handshake waiting for its bulk OUT
+    bool write_pending;
+    uint32_t write_offset;
+    uint32_t write_crc;
+    uint64_t crc_ok;
+    uint64_t crc_bad;
+
+    uint32_t extracted_out;
+    uint32_t extracted_in;
+} usbcap_t;
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+static const char* request_name(uint8_t request) {
+    switch (request) {
+        case VR_GET_CPU_INFO:       return "GET_CPU_INFO";
+        case VR_SET_DATA_ADDR:      return "SET_DATA_ADDR";
+        case VR_SET_DATA_LEN:       return "SET_DATA_LEN";
+        case VR_FLUSH_CACHE:        return "FLUSH_CACHE";
+        case VR_PROG_STAGE1:        return "PROG_STAGE1";
+        case VR_PROG_STAGE2:        return "PROG_STAGE2";
+        case VR_NAND_OPS:           return "NAND_OPS";
+        case VR_FW_READ:            return "FW_READ";
+        case VR_FW_HANDSHAKE:       return "FW_HANDSHAKE";
+        case VR_WRITE:              return "WRITE";
+        case VR_FW_WRITE1:          return "FW_WRITE1/READ";
+        case VR_FW_WRITE2:          return "FW_WRITE2";
+        case VR_FW_READ_STATUS1:    return "FW_READ_STATUS1";
+        case VR_FW_READ_STATUS2:    return "FW_READ_STATUS2";
+        case VR_FW_READ_STATUS3:    return "FW_READ_STATUS3";
+        case VR_FW_READ_STATUS4:    return "FW_READ_STATUS4";
+        default:                    return NULL;
+    }
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static bool is_vendor(const usb_capture_transfer_t* t) {
+    return t->has_setup && (t->request_type & 0x60) == 0x40;
+}
+
+/**
+ * Decode a 40-byte VR_WRITE handshake (see write_handshake_format())
+ *
+ * @return false if the layout is not recognised
+ */
+static bool decode_write_handshake(const uint8_t* h, uint32_t* offset, uint32_t* size, uint32_t* crc,
+                                   const char** layout) {
+    if (h[26] == 0x06) {
+        *offset = (uint32_t)le16(&h[10]) << 16;
+        *size = (uint32_t)le16(&h[18]) << 16;
+        *crc = ~le32(&h[28]);
+        *layout = "t31";
+        return true;
+    }
+    if (h[10] == 0x06) {
+        *offset = le32(&h[12]);
+        *size = le32(&h[16]);
+        *crc = ~le32(&h[20]);
+        *layout = "a1";
+        return true;
+    }
+    return false;
+}
+
+static usbcap_phase_t phase_of(const usb_capture_transfer_t* t) {
+    switch (t->request) {
+        case VR_SET_DATA_ADDR:
+        case VR_SET_DATA_LEN:
+        case VR_PROG_STAGE1:
+        case VR_PROG_STAGE2:
+            return PHASE_BOOTSTRAP;
+        case VR_WRITE:
+            return PHASE_WRITE;
+        case VR_FW_WRITE1:
+            return PHASE_READ;
+        default:
+            return PHASE_NONE;  // Status polls and CPU info belong to any phase
+    }
+}
+
+// ============================================================================
+// DEVICE FILTER
+// ============================================================================
+
+static bool device_known(const usbcap_t* cap, uint32_t key) {
+    for (int i = 0; i < cap->ingenic_count; i++) {
+        if (cap->ingenic[i] == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool device_wanted(usbcap_t* cap, const usb_capture_transfer_t* t) {
+    if (cap->filter_bus >= 0) {
+        return t->bus == cap->filter_bus && t->device == cap->filter_device;
+    }
+    if (cap->all_devices) {
+        return true;
+    }
+
+    uint32_t key = ((uint32_t)t->bus << 8) | t->device;
+    bool ingenic = is_vendor(t);
+    // GET_DESCRIPTOR(DEVICE) reply: idVendor at offset 8. Address 0 is
+    // shared by every device while it enumerates, so it does not count.
+    if (t->has_setup && t->request_type == 0x80 && t->request == 0x06 && (t->value >> 8) == 1 &&
+        t->data_len >= 10 && t->device != 0) {
+        uint16_t vid = le16(&t->data[8]);
+        ingenic = vid == VENDOR_ID_INGENIC || vid == VENDOR_ID_INGENIC_ALT;
+    }
+    if (ingenic && !device_known(cap, key) && cap->ingenic_count < USBCAP_MAX_DEVICES) {
+        cap->ingenic[cap->ingenic_count++] = key;
+    }
+    return device_known(cap, key);
+}
+
+// ============================================================================
+// BINARY CORRELATION
+// ============================================================================
+
+static uint64_t window_hash(const uint8_t* p) {
+    uint64_t h = 0xCBF29CE484222325ULL;  // FNV-1a
+    for (int i = 0; i < USBCAP_WINDOW; i++) {
+        h = (h ^ p[i]) * 0x100000001B3ULL;
+    }
+    return h ? h : 1;
+}
+
+static int binary_load(usbcap_binary_t* bin, const firmware_image_t* image) {
+    memset(bin, 0, sizeof(*bin));
+    bin->data = image->data;
+    bin->size = image->size;
+
+    size_t blocks = (image->size + USBCAP_STRIDE - 1) / USBCAP_STRIDE;
+    size_t slots = 16;
+    while (slots < blocks * 2) {
+        slots <<= 1;
+    }
+    bin->slots = (usbcap_slot_t*)calloc(slots, sizeof(usbcap_slot_t));
+    bin->covered = (uint8_t*)calloc(blocks ? blocks : 1, 1);
+    if (!bin->slots || !bin->covered) {
+        return -1;
+    }
+    bin->slot_mask = slots - 1;
+
+    // Index every aligned window; the first occurrence of a value wins
+    for (size_t off = 0; off + USBCAP_WINDOW <= image->size; off += USBCAP_STRIDE) {
+        uint64_t h = window_hash(image->data + off);
+        size_t i = (size_t)h & bin->slot_mask;
+        while (bin->slots[i].hash && bin->slots[i].hash != h) {
+            i = (i + 1) & bin->slot_mask;
+        }
+        if (!bin->slots[i].hash) {
+            bin->slots[i].hash = h;
+            bin->slots[i].offset = (uint32_t)off;
+        }
+    }
+    return 0;
+}
+
+static bool binary_lookup(const usbcap_binary_t* bin, uint64_t h, uint32_t* offset) {
+    size_t i = (size_t)h & bin->slot_mask;
+    while (bin->slots[i].hash) {
+        if (bin->slots[i].hash == h) {
+            *offset = bin->slots[i].offset;
+            return true;
+        }
+        i = (i + 1) & bin->slot_mask;
+    }
+    return false;
+}
+
+static size_t common_prefix(const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Find where a bulk OUT payload sits in the binary. Any payload of at least
+ * USBCAP_STRIDE + USBCAP_WINDOW bytes contains an indexed window, whatever
+ * its alignment in the binary.
+ *
+ * @return bytes matched from the payload start (0 = not found)
+ */
+static size_t binary_find(const usbcap_binary_t* bin, const uint8_t* data, size_t len, uint32_t* at) {
+    size_t best = 0;
+    for (size_t skew = 0; skew < USBCAP_STRIDE && skew + USBCAP_WINDOW <= len; skew++) {
+        uint32_t offset;
+        if (!binary_lookup(bin, window_hash(data + skew), &offset) || offset < skew) {
+            continue;
+        }
+        uint32_t start = offset - (uint32_t)skew;
+        size_t room = bin->size - start < len ? bin->size - start : len;
+        size_t matched = common_prefix(bin->data + start, data, room);
+        if (matched > best) {
+            best = matched;
+            *at = start;
+            if (matched == len) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+static void binary_correlate(usbcap_t* cap, const usb_capture_transfer_t* t, uint64_t rel_us) {
+    usbcap_binary_t* bin = cap->binary;
+    if (t->data_len < USBCAP_WINDOW * 2) {
+        return;  // Markers and descriptors, not image data
+    }
+    bin->chunks++;
+
+    uint32_t at = 0;
+    size_t matched = binary_find(bin, t->data, t->data_len, &at);
+    if (matched == t->data_len) {
+        bin->exact++;
+        for (size_t b = at / USBCAP_STRIDE; b < (at + matched) / USBCAP_STRIDE; b++) {
+            bin->covered[b] = 1;
+        }
+    } else if (matched >= USBCAP_WINDOW) {
+        bin->partial++;
+    } else {
+        bin->unmatched++;
+    }
+
+    if (!cap->summary_only) {
+        if (matched == t->data_len) {
+            printf("%11.6f            bulk OUT %u bytes = binary 0x%08X..0x%08X\n",
+                   rel_us / 1e6, t->data_len, at, at + (uint32_t)matched);
+        } else if (matched >= USBCAP_WINDOW) {
+            printf("%11.6f            bulk OUT %u bytes ~ binary 0x%08X, first %zu bytes match\n",
+                   rel_us / 1e6, t->data_len, at, matched);
+        } else {
+            printf("%11.6f            bulk OUT %u bytes not found in binary\n",
+                   rel_us / 1e6, t->data_len);
+        }
+    }
+}
+
+static void binary_report(const usbcap_binary_t* bin) {
+    size_t blocks = bin->size / USBCAP_STRIDE;
+    size_t covered = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        covered += bin->covered[b];
+    }
+
+    printf("\nBinary correlation (%zu bytes):\n", bin->size);
+    printf("  Payloads: %llu exact, %llu partial, %llu not in binary\n",
+           (unsigned long long)bin->exact, (unsigned long long)bin->partial,
+           (unsigned long long)bin->unmatched);
+    printf("  Coverage: %.1f%% of the binary sent verbatim\n",
+           blocks ? 100.0 * (double)covered / (double)blocks : 0.0);
+
+    int gaps = 0;
+    for (size_t b = 0; b < blocks && gaps < USBCAP_MAX_GAPS; b++) {
+        if (bin->covered[b]) {
+            continue;
+        }
+        size_t end = b;
+        while (end < blocks && !bin->covered[end]) {
+            end++;
+        }
+        printf("  Not sent: 0x%08zX..0x%08zX (%zu bytes)\n",
+               b * USBCAP_STRIDE, end * USBCAP_STRIDE, (end - b) * USBCAP_STRIDE);
+        gaps++;
+        b = end;
+    }
+}
+
+// ============================================================================
+// PAYLOAD EXTRACTION
+// ============================================================================
+
+static void extract_payload(usbcap_t* cap, const usb_capture_transfer_t* t) {
+    bool in = (t->endpoint & 0x80) != 0;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/bulk_%s_%04u_%ubytes.bin", cap->extract_dir, in ? "in" : "out",
+             in ? cap->extracted_in++ : cap->extracted_out++, t->data_len);
+    FILE* f = fopen(path, "wb");
+    if (!f || fwrite(t->data, 1, t->data_len, f) != t->data_len) {
+        printf("[WARN] Cannot write %s\n", path);
+    }
+    if (f) {
+        fclose(f);
+    }
+
+    // DDR parameters travel as FIDB + RDD, 324 bytes
+    const uint8_t* fidb = t->data_len >= 324 ? memchr(t->data, 'F', t->data_len - 323) : NULL;
+    while (fidb && !in) {
+        if (memcmp(fidb, "FIDB", 4) == 0) {
+            snprintf(path, sizeof(path), "%s/ddr_binary.bin", cap->extract_dir);
+            f = fopen(path, "wb");
+            if (f) {
+                fwrite(fidb, 1, 324, f);
+                fclose(f);
+                printf("  DDR binary (FIDB) found -> %s\n", path);
+            }
+            break;
+        }
+        size_t rest = t->data_len - 323 - (size_t)(fidb - t->data) - 1;
+        fidb = rest ? memchr(fidb + 1, 'F', rest) : NULL;
+    }
+}
+
+// ============================================================================
+// SEQUENCE REPORT
+// ============================================================================
+
+static void print_preview(const uint8_t* data, uint32_t len) {
+    for (uint32_t i = 0; i < len && i < USBCAP_PREVIEW; i++) {
+        printf(" %02x", data[i]);
+    }
+    if (len > USBCAP_PREVIEW) {
+        printf(" ...");
+    }
+}
+
+static void enter_phase(usbcap_t* cap, usbcap_phase_t phase, uint64_t now_us) {
+    if (phase == PHASE_NONE || phase == cap->phase) {
+        return;
+    }
+    if (cap->phase != PHASE_NONE) {
+        cap->phase_us[cap->phase] += now_us - cap->phase_start_us[cap->phase];
+    }
+    cap->phase = phase;
+    cap->phase_start_us[phase] = now_us;
+    if (!cap->summary_only) {
+        printf("\n== %s ==\n", phase_names[phase]);
+    }
+}
+
+static void on_control(usbcap_t* cap, const usb_capture_transfer_t* t, uint64_t rel_us, double gap_ms) {
+    cap->control_count++;
+    if (!is_vendor(t)) {
+        return;  // Enumeration traffic
+    }
+    cap->request_counts[t->request]++;
+    enter_phase(cap, phase_of(t), t->submit_us);
+
+    bool in = (t->request_type & 0x80) != 0;
+    const char* name = request_name(t->request);
+    uint32_t offset = 0, size = 0, crc = 0;
+    const char* layout = NULL;
+    bool handshake = !in && t->data_len == FIRMWARE_WRITE_HANDSHAKE_SIZE;
+
+    if (handshake && t->request == VR_WRITE &&
+        decode_write_handshake(t->data, &offset, &size, &crc, &layout)) {
+        cap->write_pending = true;
+        cap->write_offset = offset;
+        cap->write_crc = crc;
+    }
+
+    if (cap->summary_only) {
+        return;
+    }
+    double dur_ms = t->complete_us ? (double)(t->complete_us - t->submit_us) / 1000.0 : 0.0;
+    char unknown[8];
+    if (!name) {
+        snprintf(unknown, sizeof(unknown), "0x%02X", t->request);
+        name = unknown;
+    }
+    printf("%11.6f %8.3f %8.3f %3u.%-3u %-3s %-16s", rel_us / 1e6, gap_ms, dur_ms, t->bus,
+           t->device, in ? "IN" : "OUT", name);
+    printf(" v=%04X i=%04X len=%-5u", t->value, t->index, t->length);
+    if (t->status != 0) {
+        printf(" status=%d", t->status);
+    }
+
+    if (layout) {
+        printf(" [%s write: flash 0x%08X, %u bytes, crc %08X]", layout, offset, size, crc);
+    } else if (handshake && t->request == VR_FW_WRITE1) {
+        printf(" [read: flash 0x%08X, %u bytes]", le32(&t->data[8]), le32(&t->data[16]));
+    } else if (t->request == VR_GET_CPU_INFO && in && t->data_len >= 8) {
+        printf(" [cpu \"%.8s\"]", (const char*)t->data);
+    } else if (t->data_len > 0) {
+        print_preview(t->data, t->data_len);
+    }
+    printf("\n");
+}
+
+static void on_bulk(usbcap_t* cap, const usb_capture_transfer_t* t, uint64_t rel_us, double gap_ms) {
+    bool in = (t->endpoint & 0x80) != 0;
+    cap->bulk_count++;
+    if (in) {
+        cap->bytes_in += t->actual;
+    } else {
+        cap->bytes_out += t->actual;
+    }
+    if (cap->phase != PHASE_NONE) {
+        cap->phase_bytes[cap->phase] += t->actual;
+    }
+
+    const char* crc_note = NULL;
+    if (!in && cap->write_pending && t->data_len > 0) {
+        cap->write_pending = false;
+        if (t->data_len == t->actual) {
+            bool ok = firmware_crc32(t->data, t->data_len) == cap->write_crc;
+            ok ? cap->crc_ok++ : cap->crc_bad++;
+            crc_note = ok ? "crc ok" : "CRC MISMATCH";
+        }
+    }
+
+    if (!cap->summary_only) {
+        double dur_ms = t->complete_us ? (double)(t->complete_us - t->submit_us) / 1000.0 : 0.0;
+        printf("%11.6f %8.3f %8.3f %3u.%-3u %-3s bulk 0x%02X        %u/%u bytes", rel_us / 1e6,
+               gap_ms, dur_ms, t->bus, t->device, in ? "IN" : "OUT", t->endpoint, t->actual,
+               t->requested);
+        if (t->status != 0) {
+            printf(" status=%d", t->status);
+        }
+        if (crc_note) {
+            printf(" [%s]", crc_note);
+        } else if (in && t->data_len > 0 && t->data_len <= 512 && t->endpoint == ENDPOINT_IN) {
+            // Burner log text
+            printf(" \"");
+            for (uint32_t i = 0; i < t->data_len; i++) {
+                char c = (char)t->data[i];
+                putchar(c == '\n' ? '|' : (c >= 32 && c < 127 ? c : '.'));
+            }
+            printf("\"");
+        } else if (t->data_len > 0) {
+            print_preview(t->data, t->data_len);
+        }
+        printf("\n");
+    }
+
+    if (cap->extract_dir && t->data_len > 0) {
+        extract_payload(cap, t);
+    }
+    if (cap->binary && !in && t->data_len > 0) {
+        binary_correlate(cap, t, rel_us);
+    }
+}
+
+static void on_transfer(void* user_data, const usb_capture_transfer_t* t) {
+    usbcap_t* cap = (usbcap_t*)user_data;
+    if (!device_wanted(cap, t)) {
+        return;
+    }
+
+    if (!cap->first_us) {
+        cap->first_us = t->submit_us;
+        cap->last_complete_us = t->submit_us;
+    }
+    uint64_t rel_us = t->submit_us - cap->first_us;
+    // Host time between the previous transfer finishing and this one starting
+    double gap_ms = t->submit_us > cap->last_complete_us
+                        ? (double)(t->submit_us - cap->last_complete_us) / 1000.0 : 0.0;
+    if (t->complete_us > cap->last_complete_us) {
+        cap->last_complete_us = t->complete_us;
+    }
+    if (t->status != 0) {
+        cap->errors++;
+    }
+
+    if (t->type == USB_CAPTURE_XFER_CONTROL) {
+        on_control(cap, t, rel_us, gap_ms);
+    } else if (t->type == USB_CAPTURE_XFER_BULK || t->type == USB_CAPTURE_XFER_INTERRUPT) {
+        on_bulk(cap, t, rel_us, gap_ms);
+    }
+}
+
+static void print_summary(usbcap_t* cap, const usb_capture_stats_t* stats, double parse_s) {
+    if (cap->phase != PHASE_NONE) {
+        cap->phase_us[cap->phase] += cap->last_complete_us - cap->phase_start_us[cap->phase];
+    }
+
+    printf("\nSummary:\n");
+    printf("  Capture: %llu packets, %llu transfers, %llu unpaired, %llu skipped (parsed in %.2f s)\n",
+           (unsigned long long)stats->records, (unsigned long long)stats->transfers,
+           (unsigned long long)stats->unmatched, (unsigned long long)stats->skipped, parse_s);
+    printf("  Devices:");
+    for (int i = 0; i < cap->ingenic_count; i++) {
+        printf(" %u.%u", cap->ingenic[i] >> 8, cap->ingenic[i] & 0xFF);
+    }
+    printf("%s\n", cap->ingenic_count ? "" : " (filter)");
+    printf("  Span: %.3f s, %llu control, %llu bulk, %llu failed\n",
+           (double)(cap->last_complete_us - cap->first_us) / 1e6,
+           (unsigned long long)cap->control_count, (unsigned long long)cap->bulk_count,
+           (unsigned long long)cap->errors);
+    printf("  Bulk: %llu bytes out, %llu bytes in\n",
+           (unsigned long long)cap->bytes_out, (unsigned long long)cap->bytes_in);
+    if (cap->crc_ok || cap->crc_bad) {
+        printf("  Write chunks: %llu match their handshake CRC, %llu do not\n",
+               (unsigned long long)cap->crc_ok, (unsigned long long)cap->crc_bad);
+    }
+
+    for (int p = PHASE_BOOTSTRAP; p < PHASE_COUNT; p++) {
+        if (cap->phase_us[p] == 0) {
+            continue;
+        }
+        double s = (double)cap->phase_us[p] / 1e6;
+        printf("  %-10s %8.3f s  %10llu bytes  %8.1f KB/s\n", phase_names[p], s,
+               (unsigned long long)cap->phase_bytes[p], (double)cap->phase_bytes[p] / 1024.0 / s);
+    }
+
+    printf("  Vendor requests:\n");
+    for (int r = 0; r < 256; r++) {
+        if (cap->request_counts[r]) {
+            const char* name = request_name((uint8_t)r);
+            printf("    0x%02X %-16s %llu\n", r, name ? name : "?",
+                   (unsigned long long)cap->request_counts[r]);
+        }
+    }
+}
+
+// ============================================================================
+// DIFF AGAINST A VENDOR CAPTURE
+// ============================================================================
+
+typedef struct {
+    usbcap_t* filter;
+    capture_steps_t* steps;
+    bool failed;
+} usbcap_collect_t;
+
+typedef struct {
+    int64_t delta_us;
+    uint32_t count;
+    bool control;
+    uint8_t code;
+} usbcap_request_delta_t;
+
+typedef struct {
+    bool summary_only;
+    const capture_steps_t* ours;
+    const capture_steps_t* vendor;
+    uint64_t op_counts[4];
+    uint64_t ours_first_us;
+    uint64_t vendor_first_us;
+    uint64_t ours_last_us;
+    uint64_t vendor_last_us;
+    int64_t total_delta_us;
+    capture_diff_entry_t top[USBCAP_TOP_LOSSES];
+    int top_count;
+    usbcap_request_delta_t requests[2][256];    // [control][code]
+} usbcap_diff_t;
+
+static void collect_step(void* user_data, const usb_capture_transfer_t* t) {
+    usbcap_collect_t* c = (usbcap_collect_t*)user_data;
+    if (!c->failed && device_wanted(c->filter, t) && capture_steps_add(c->steps, t) != 0) {
+        c->failed = true;
+    }
+}
+
+static const char* step_name(const capture_step_t* step, char* buf, size_t size) {
+    const char* name = step->control ? request_name(step->code) : NULL;
+    if (name) {
+        return name;
+    }
+    if (step->control) {
+        snprintf(buf, size, "0x%02X", step->code);
+    } else {
+        snprintf(buf, size, "bulk %s 0x%02X", step->in ? "IN" : "OUT", step->code);
+    }
+    return buf;
+}
+
+static void print_step_detail(const capture_step_t* step) {
+    printf(" len=%u", step->length);
+    if (step->status != 0) {
+        printf(" status=%d", step->status);
+    }
+}
+
+static void on_diff(void* user_data, const capture_diff_entry_t* e) {
+    usbcap_diff_t* diff = (usbcap_diff_t*)user_data;
+    diff->op_counts[e->op]++;
+    const capture_step_t* step = e->ours ? e->ours : e->vendor;
+    char buf[24];
+    const char* name = step_name(step, buf, sizeof(buf));
+
+    if (e->ours && e->vendor) {
+        if (!diff->ours_first_us) {
+            diff->ours_first_us = e->ours->submit_us;
+            diff->vendor_first_us = e->vendor->submit_us;
+        }
+        if (e->ours->complete_us > diff->ours_last_us) {
+            diff->ours_last_us = e->ours->complete_us;
+        }
+        if (e->vendor->complete_us > diff->vendor_last_us) {
+            diff->vendor_last_us = e->vendor->complete_us;
+        }
+        diff->total_delta_us = e->cumulative_delta_us;
+
+        usbcap_request_delta_t* r = &diff->requests[step->control][step->code];
+        r->delta_us += e->step_delta_us;
+        r->count++;
+        r->control = step->control;
+        r->code = step->code;
+
+        // Keep the largest losses, biggest first
+        int pos = diff->top_count;
+        while (pos > 0 && diff->top[pos - 1].step_delta_us < e->step_delta_us) {
+            pos--;
+        }
+        if (pos < USBCAP_TOP_LOSSES && e->step_delta_us > 0) {
+            int last = diff->top_count < USBCAP_TOP_LOSSES ? diff->top_count : USBCAP_TOP_LOSSES - 1;
+            memmove(&diff->top[pos + 1], &diff->top[pos], (size_t)(last - pos) * sizeof(*e));
+            diff->top[pos] = *e;
+            if (diff->top_count < USBCAP_TOP_LOSSES) {
+                diff->top_count++;
+            }
+        }
+    }
+
+    if (diff->summary_only) {
+        return;
+    }
+    static const char ops[] = { '=', '~', '+', '-' };
+    char ours_pos[12] = "", vendor_pos[12] = "";
+    if (e->ours) {
+        snprintf(ours_pos, sizeof(ours_pos), "%zu", (size_t)(e->ours - diff->ours->steps) + 1);
+    }
+    if (e->vendor) {
+        snprintf(vendor_pos, sizeof(vendor_pos), "%zu", (size_t)(e->vendor - diff->vendor->steps) + 1);
+    }
+    printf("%6s %6s %c %-16s", ours_pos, vendor_pos, ops[e->op], name);
+    if (e->ours && e->vendor) {
+        printf(" %9.3f %9.3f %+9.3f %+9.3f %+10.3f", e->ours_elapsed_us / 1000.0,
+               e->vendor_elapsed_us / 1000.0, e->step_delta_us / 1000.0,
+               e->duration_delta_us / 1000.0, e->cumulative_delta_us / 1000.0);
+        if (e->op == CAPTURE_DIFF_CHANGED) {
+            if (e->ours->length != e->vendor->length) {
+                printf("  len %u vs %u", e->ours->length, e->vendor->length);
+            } else {
+                printf("  contents differ");
+            }
+        }
+        if (e->ours->status != e->vendor->status) {
+            printf("  status %d vs %d", e->ours->status, e->vendor->status);
+        }
+    } else {
+        printf(" %s", e->ours ? "only in ours:  " : "only in vendor:");
+        print_step_detail(step);
+    }
+    printf("\n");
+}
+
+static int compare_request_delta(const void* a, const void* b) {
+    int64_t da = ((const usbcap_request_delta_t*)a)->delta_us;
+    int64_t db = ((const usbcap_request_delta_t*)b)->delta_us;
+    return da < db ? 1 : (da > db ? -1 : 0);
+}
+
+static void print_diff_summary(usbcap_diff_t* diff) {
+    printf("\nDiff summary:\n");
+    printf("  Steps: %zu ours, %zu vendor; %llu identical, %llu changed, %llu only in ours, "
+           "%llu only in vendor\n", diff->ours->count, diff->vendor->count,
+           (unsigned long long)diff->op_counts[CAPTURE_DIFF_MATCH],
+           (unsigned long long)diff->op_counts[CAPTURE_DIFF_CHANGED],
+           (unsigned long long)diff->op_counts[CAPTURE_DIFF_OURS_ONLY],
+           (unsigned long long)diff->op_counts[CAPTURE_DIFF_VENDOR_ONLY]);
+    if (!diff->ours_first_us) {
+        printf("  No steps in common\n");
+        return;
+    }
+
+    double ours_s = (double)(diff->ours_last_us - diff->ours_first_us) / 1e6;
+    double vendor_s = (double)(diff->vendor_last_us - diff->vendor_first_us) / 1e6;
+    printf("  Paired span: ours %.3f s, vendor %.3f s (%+.3f s", ours_s, vendor_s,
+           diff->total_delta_us / 1e6);
+    if (vendor_s > 0) {
+        printf(", %+.1f%%", 100.0 * (ours_s - vendor_s) / vendor_s);
+    }
+    printf(")\n");
+
+    if (diff->top_count > 0) {
+        printf("  Largest losses (time since the previous paired step, ours - vendor):\n");
+        for (int i = 0; i < diff->top_count; i++) {
+            const capture_diff_entry_t* e = &diff->top[i];
+            char buf[24];
+            printf("    %6zu/%-6zu %-16s %+9.3f ms  (before the transfer %+9.3f ms, transfer %+9.3f ms)\n",
+                   (size_t)(e->ours - diff->ours->steps) + 1,
+                   (size_t)(e->vendor - diff->vendor->steps) + 1,
+                   step_name(e->ours, buf, sizeof(buf)), e->step_delta_us / 1000.0,
+                   (e->step_delta_us - e->duration_delta_us) / 1000.0,
+                   e->duration_delta_us / 1000.0);
+        }
+    }
+
+    usbcap_request_delta_t sorted[512];
+    size_t n = 0;
+    for (int c = 0; c < 2; c++) {
+        for (int code = 0; code < 256; code++) {
+            if (diff->requests[c][code].count) {
+                sorted[n++] = diff->requests[c][code];
+            }
+        }
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_request_delta);
+    printf("  By step (summed, ours - vendor):\n");
+    for (size_t i = 0; i < n; i++) {
+        capture_step_t step;
+        memset(&step, 0, sizeof(step));
+        step.control = sorted[i].control;
+        step.code = sorted[i].code;
+        step.in = !step.control && (step.code & 0x80) != 0;
+        char buf[24];
+        printf("    %-16s x%-6u %+10.3f ms\n", step_name(&step, buf, sizeof(buf)), sorted[i].count,
+               sorted[i].delta_us / 1000.0);
+    }
+}
+
+static int load_steps(const char* path, usbcap_t* filter, capture_steps_t* steps) {
+    firmware_image_t capture;
+    if (firmware_image_open(path, &capture) != 0) {
+        printf("[ERROR] Cannot open capture %s\n", path);
+        return -1;
+    }
+    usbcap_collect_t collect = { filter, steps, false };
+    char error[128];
+    int result = usb_capture_parse(capture.data, capture.size, collect_step, &collect, NULL,
+                                   error, sizeof(error));
+    firmware_image_close(&capture);
+    if (result != 0) {
+        printf("[ERROR] %s: %s\n", path, error);
+        return -1;
+    }
+    if (collect.failed) {
+        printf("[ERROR] %s: out of memory\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * --diff: align our trace (the main capture) with a vendor capture
+ */
+static int run_diff(usbcap_t* ours_filter, const char* ours_path, const char* vendor_path) {
+    usbcap_t vendor_filter;
+    memset(&vendor_filter, 0, sizeof(vendor_filter));
+    vendor_filter.filter_bus = -1;
+    vendor_filter.all_devices = ours_filter->all_devices;
+
+    capture_steps_t ours, vendor;
+    memset(&ours, 0, sizeof(ours));
+    memset(&vendor, 0, sizeof(vendor));
+    int exit_code = 1;
+    if (load_steps(ours_path, ours_filter, &ours) == 0 &&
+        load_steps(vendor_path, &vendor_filter, &vendor) == 0) {
+        usbcap_diff_t* diff = (usbcap_diff_t*)calloc(1, sizeof(usbcap_diff_t));
+        if (diff) {
+            diff->summary_only = ours_filter->summary_only;
+            diff->ours = &ours;
+            diff->vendor = &vendor;
+            if (!diff->summary_only) {
+                printf("%6s %6s %c %-16s %9s %9s %9s %9s %10s\n", "Ours", "Vendor", ' ', "Step",
+                       "Ours(ms)", "Vend(ms)", "Delta", "DurDelta", "Total");
+            }
+            capture_diff(&ours, &vendor, on_diff, diff);
+            print_diff_summary(diff);
+            free(diff);
+            exit_code = 0;
+        }
+    }
+    capture_steps_free(&ours);
+    capture_steps_free(&vendor);
+    return exit_code;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void print_usage(const char* program_name) {
+    printf("thingino-usbcap - decode Ingenic USB traffic from a usbmon capture\n");
+    printf("Usage: %s <capture.pcap|pcapng> [options]\n\n", program_name);
+    printf("Options:\n");
+    printf("      --summary           Counts, phase timings and throughput only\n");
+    printf("      --extract <dir>     Save every bulk payload (and any DDR binary) to dir\n");
+    printf("      --binary <file>     Locate each bulk OUT payload in the image written\n");
+    printf("      --device <bus.dev>  Only this device (default: every Ingenic device)\n");
+    printf("      --all               Every device on the bus\n");
+    printf("      --diff <vendor>     Align this capture (e.g. thingino-cloner --trace) with a\n");
+    printf("                          vendor capture: divergences and per-step timing deltas\n");
+    printf("  -h, --help              Show this help\n\n");
+    printf("Columns: time since first transfer (s), host gap before submit (ms), duration (ms)\n");
+}
+
+int main(int argc, char* argv[]) {
+    usbcap_t cap;
+    memset(&cap, 0, sizeof(cap));
+    cap.filter_bus = -1;
+    const char* capture_path = NULL;
+    const char* binary_path = NULL;
+    const char* diff_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            cap.summary_only = true;
+        } else if (strcmp(argv[i], "--all") == 0) {
+            cap.all_devices = true;
+        } else if (strcmp(argv[i], "--extract") == 0 && has_value) {
+            cap.extract_dir = argv[++i];
+        } else if (strcmp(argv[i], "--binary") == 0 && has_value) {
+            binary_path = argv[++i];
+        } else if (strcmp(argv[i], "--diff") == 0 && has_value) {
+            diff_path = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && has_value) {
+            unsigned bus, dev;
+            if (sscanf(argv[++i], "%u.%u", &bus, &dev) != 2 || bus > 0xFFFF || dev > 0xFF) {
+                printf("Error: --device takes bus.address, e.g. 3.12\n");
+                return 1;
+            }
+            cap.filter_bus = (int)bus;
+            cap.filter_device = (int)dev;
+        } else if (argv[i][0] != '-' && !capture_path) {
+            capture_path = argv[i];
+        } else {
+            printf("Error: unknown or incomplete option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!capture_path) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (diff_path) {
+        return run_diff(&cap, capture_path, diff_path);
+    }
+
+    firmware_image_t capture;
+    if (firmware_image_open(capture_path, &capture) != 0) {
+        printf("[ERROR] Cannot open capture %s\n", capture_path);
+        return 1;
+    }
+
+    firmware_image_t binary_image;
+    memset(&binary_image, 0, sizeof(binary_image));
+    usbcap_binary_t binary;
+    memset(&binary, 0, sizeof(binary));
+    int exit_code = 0;
+    if (binary_path) {
+        if (firmware_image_open(binary_path, &binary_image) != 0 ||
+            binary_load(&binary, &binary_image) != 0) {
+            printf("[ERROR] Cannot load binary %s\n", binary_path);
+            exit_code = 1;
+            goto out;
+        }
+        cap.binary = &binary;
+    }
+    if (cap.extract_dir && mkdir(cap.extract_dir, 0755) != 0 && errno != EEXIST) {
+        printf("[ERROR] Cannot create %s: %s\n", cap.extract_dir, strerror(errno));
+        exit_code = 1;
+        goto out;
+    }
+
+    if (!cap.summary_only) {
+        printf("%11s %8s %8s %-7s %-3s %-16s\n", "Time(s)", "Gap(ms)", "Dur(ms)", "Dev", "Dir", "Request");
+    }
+    usb_capture_stats_t stats;
+    char error[128];
+    uint64_t start = thingino_real_now_us();
+    if (usb_capture_parse(capture.data, capture.size, on_transfer, &cap, &stats, error,
+                          sizeof(error)) != 0) {
+        printf("[ERROR] %s: %s\n", capture_path, error);
+        exit_code = 1;
+        goto out;
+    }
+    print_summary(&cap, &stats, (double)(thingino_real_now_us() - start) / 1e6);
+    if (cap.binary) {
+        binary_report(&binary);
+    }
+
+out:
+    free(binary.slots);
+    free(binary.covered);
+    firmware_image_close(&binary_image);
+    firmware_image_close(&capture);
+    return exit_code;
+}
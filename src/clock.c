@@ -0,0 +1,78 @@
+#include "clock.h"
+#include "platform_compat.h"
+
+#include <stddef.h>
+
+// ============================================================================
+// CLOCK IMPLEMENTATION
+// ============================================================================
+//
+// Dispatch between an installed virtual clock and the platform monotonic
+// clock; the virtual clock itself is further down.
+
+static thingino_clock_t* active_clock = NULL;
+
+void thingino_clock_set(thingino_clock_t* clock) {
+    __atomic_store_n(&active_clock, clock, __ATOMIC_RELEASE);
+}
+
+thingino_clock_t* thingino_clock_get(void) {
+    return __atomic_load_n(&active_clock, __ATOMIC_ACQUIRE);
+}
+
+bool thingino_clock_is_virtual(void) {
+    return __atomic_load_n(&active_clock, __ATOMIC_ACQUIRE) != NULL;
+}
+
+uint64_t thingino_clock_now_us(void) {
+    thingino_clock_t* clock = __atomic_load_n(&active_clock, __ATOMIC_ACQUIRE);
+    return clock ? clock->now_us(clock) : thingino_platform_monotonic_us();
+}
+
+void thingino_clock_sleep_us(uint64_t us) {
+    thingino_clock_t* clock = __atomic_load_n(&active_clock, __ATOMIC_ACQUIRE);
+    if (clock) {
+        clock->sleep_us(clock, us);
+    } else if (us) {
+        thingino_platform_sleep_us(us);
+    }
+}
+
+uint64_t thingino_real_now_us(void) {
+    return thingino_platform_monotonic_us();
+}
+
+void thingino_real_sleep_us(uint64_t us) {
+    if (us) {
+        thingino_platform_sleep_us(us);
+    }
+}
+
+// ============================================================================
+// VIRTUAL CLOCK
+// ============================================================================
+
+static uint64_t virtual_now_us(thingino_clock_t* clock) {
+    thingino_virtual_clock_t* vc = (thingino_virtual_clock_t*)clock;
+    return __atomic_load_n(&vc->now_us, __ATOMIC_ACQUIRE);
+}
+
+// A sleep is time passing: nothing else has to happen
+static void virtual_sleep_us(thingino_clock_t* clock, uint64_t us) {
+    thingino_virtual_clock_advance((thingino_virtual_clock_t*)clock, us);
+}
+
+void thingino_virtual_clock_init(thingino_virtual_clock_t* clock, uint64_t start_us) {
+    if (!clock) {
+        return;
+    }
+    clock->base.now_us = virtual_now_us;
+    clock->base.sleep_us = virtual_sleep_us;
+    clock->now_us = start_us;
+}
+
+void thingino_virtual_clock_advance(thingino_virtual_clock_t* clock, uint64_t us) {
+    if (clock) {
+        __atomic_fetch_add(&clock->now_us, us, __ATOMIC_ACQ_REL);
+    }
+}
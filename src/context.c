@@ -0,0 +1,294 @@
+#include "thingino.h"
+#include "log_ring.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdarg.h>
+
+// ============================================================================
+// LIBRARY CONTEXT IMPLEMENTATION
+// ============================================================================
+
+#define LOG_LINE_MAX 1024
+
+static pthread_key_t context_key;
+static pthread_once_t context_key_once = PTHREAD_ONCE_INIT;
+
+static void context_key_create(void) {
+    pthread_key_create(&context_key, NULL);
+}
+
+/**
+ * Initialize a context and its libusb session. Callbacks and the debug
+ * switch are plain fields; set them before binding the context.
+ */
+thingino_error_t thingino_context_init(thingino_context_t* ctx) {
+    if (!ctx) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->events_fd = -1;
+    return usb_manager_init(&ctx->manager);
+}
+
+void thingino_context_cleanup(thingino_context_t* ctx) {
+    if (!ctx) {
+        return;
+    }
+    if (thingino_context_current() == ctx) {
+        thingino_context_bind(NULL);
+    }
+    thingino_dashboard_stop(ctx);
+    thingino_metrics_stop(ctx);
+    thingino_events_close(ctx);
+    thingino_history_close(ctx);
+    thingino_trace_close(ctx);
+    usb_manager_cleanup(&ctx->manager);
+}
+
+/**
+ * Make ctx the calling thread's context
+ *
+ * @return The previously bound context (NULL if none)
+ */
+thingino_context_t* thingino_context_bind(thingino_context_t* ctx) {
+    pthread_once(&context_key_once, context_key_create);
+    thingino_context_t* previous = (thingino_context_t*)pthread_getspecific(context_key);
+    pthread_setspecific(context_key, ctx);
+    return previous;
+}
+
+thingino_context_t* thingino_context_current(void) {
+    pthread_once(&context_key_once, context_key_create);
+    return (thingino_context_t*)pthread_getspecific(context_key);
+}
+
+bool thingino_debug_enabled(void) {
+    thingino_context_t* ctx = thingino_context_current();
+    return ctx && ctx->debug;
+}
+
+// ============================================================================
+// ASYNCHRONOUS TERMINAL OUTPUT
+// ============================================================================
+//
+// The terminal is a process-wide resource, so is its drain thread. The ring
+// stays allocated once started: a late producer can never touch freed slots.
+
+#define LOG_STREAM_STDOUT   1
+#define LOG_STREAM_STDERR   2
+#define LOG_DRAIN_TICK_MS   5
+
+static struct {
+    log_ring_t ring;
+    pthread_t thread;
+    pthread_mutex_t drain_lock;     // One consumer at a time (thread or flush)
+    volatile int running;
+    volatile int stopping;
+    bool allocated;
+} log_async = { .drain_lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void log_drain_locked(void) {
+    char text[LOG_RING_MSG_MAX];
+    size_t len;
+    uint8_t stream;
+    FILE* last = NULL;
+
+    while (log_ring_pop(&log_async.ring, &stream, text, &len)) {
+        FILE* out = stream == LOG_STREAM_STDERR ? stderr : stdout;
+        if (last && last != out) {
+            fflush(last);  // Keep stdout/stderr in emission order
+        }
+        fwrite(text, 1, len, out);
+        last = out;
+    }
+
+    uint32_t dropped = log_ring_take_dropped(&log_async.ring);
+    if (dropped) {
+        if (last == stdout) {
+            fflush(stdout);
+        }
+        fprintf(stderr, "[WARN] %u log message(s) dropped (output too slow)\n", dropped);
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
+
+static void* log_drain_thread(void* arg) {
+    (void)arg;
+    while (!log_async.stopping) {
+        pthread_mutex_lock(&log_async.drain_lock);
+        log_drain_locked();
+        pthread_mutex_unlock(&log_async.drain_lock);
+        thingino_sleep_real_milliseconds(LOG_DRAIN_TICK_MS);
+    }
+    return NULL;
+}
+
+thingino_error_t thingino_log_async_start(void) {
+    static bool exit_hook = false;
+    if (log_async.running) {
+        return THINGINO_SUCCESS;
+    }
+    if (!log_async.allocated) {
+        if (log_ring_init(&log_async.ring, LOG_RING_DEFAULT_SLOTS) != 0) {
+            return THINGINO_ERROR_MEMORY;
+        }
+        log_async.allocated = true;
+    }
+
+    log_async.stopping = 0;
+    if (pthread_create(&log_async.thread, NULL, log_drain_thread, NULL) != 0) {
+        return THINGINO_ERROR_INIT_FAILED;
+    }
+    log_async.running = 1;
+    if (!exit_hook) {
+        atexit(thingino_log_async_stop);
+        exit_hook = true;
+    }
+    return THINGINO_SUCCESS;
+}
+
+void thingino_log_async_stop(void) {
+    if (!log_async.running) {
+        return;
+    }
+    log_async.running = 0;  // New messages go straight to the terminal
+    log_async.stopping = 1;
+    pthread_join(log_async.thread, NULL);
+    thingino_log_flush();
+}
+
+void thingino_log_flush(void) {
+    if (!log_async.allocated) {
+        fflush(stdout);
+        return;
+    }
+    pthread_mutex_lock(&log_async.drain_lock);
+    log_drain_locked();
+    pthread_mutex_unlock(&log_async.drain_lock);
+}
+
+// ============================================================================
+// LOGGING
+// ============================================================================
+
+// Per-thread tag and whether the thread's last message ended mid-line
+typedef struct {
+    const char* tag;
+    bool mid_line;
+} log_thread_t;
+
+static pthread_key_t log_thread_key;
+static pthread_once_t log_thread_key_once = PTHREAD_ONCE_INIT;
+
+static void log_thread_key_create(void) {
+    pthread_key_create(&log_thread_key, free);
+}
+
+static log_thread_t* log_thread_state(void) {
+    pthread_once(&log_thread_key_once, log_thread_key_create);
+    log_thread_t* state = (log_thread_t*)pthread_getspecific(log_thread_key);
+    if (!state) {
+        state = (log_thread_t*)calloc(1, sizeof(log_thread_t));
+        if (state) {
+            pthread_setspecific(log_thread_key, state);
+        }
+    }
+    return state;
+}
+
+void thingino_log_set_tag(const char* tag) {
+    log_thread_t* state = log_thread_state();
+    if (state) {
+        state->tag = tag;
+        state->mid_line = false;
+    }
+}
+
+static bool log_prefix(const char* text, const char* word) {
+    for (; *word; text++, word++) {
+        if (tolower((unsigned char)*text) != *word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Level from the message's own prefix ("[ERROR]", "Error:", "  [WARN]" ...)
+static thingino_log_level_t log_classify(const char* fmt, thingino_log_level_t fallback) {
+    while (*fmt == ' ' || *fmt == '\n' || *fmt == '\r' || *fmt == '\t') {
+        fmt++;
+    }
+    if (*fmt == '[') {
+        fmt++;
+    }
+    if (log_prefix(fmt, "error")) {
+        return THINGINO_LOG_ERROR;
+    }
+    if (log_prefix(fmt, "warn")) {
+        return THINGINO_LOG_WARN;
+    }
+    if (log_prefix(fmt, "debug")) {
+        return THINGINO_LOG_DEBUG;
+    }
+    return fallback;
+}
+
+static int log_emit(thingino_log_level_t level, FILE* stream, const char* fmt, va_list args) {
+    // Format on the caller's thread; only whole messages cross threads
+    char text[LOG_LINE_MAX];
+    int len = 0;
+    log_thread_t* state = log_thread_state();
+    if (state && state->tag && !state->mid_line) {
+        len = snprintf(text, sizeof(text), "%s ", state->tag);
+    }
+    int body = vsnprintf(text + len, sizeof(text) - (size_t)len, fmt, args);
+    if (body < 0) {
+        return body;
+    }
+    len += body;
+    if (len >= (int)sizeof(text)) {
+        len = (int)sizeof(text) - 1;
+    }
+    if (state && len > 0) {
+        state->mid_line = text[len - 1] != '\n';
+    }
+
+    thingino_context_t* ctx = thingino_context_current();
+    if (ctx && ctx->log) {
+        ctx->log(ctx->user_data, level, text);
+    } else if (log_async.running) {
+        uint8_t id = stream == stderr ? LOG_STREAM_STDERR : LOG_STREAM_STDOUT;
+        for (int off = 0; off < len; off += LOG_RING_MSG_MAX) {
+            size_t part = (size_t)(len - off) < LOG_RING_MSG_MAX ? (size_t)(len - off) : LOG_RING_MSG_MAX;
+            log_ring_push(&log_async.ring, id, text + off, part);
+        }
+    } else {
+        fwrite(text, 1, (size_t)len, stream);
+    }
+    return body;
+}
+
+void thingino_log(thingino_log_level_t level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_emit(level, stdout, fmt, args);
+    va_end(args);
+}
+
+int thingino_printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = log_emit(log_classify(fmt, THINGINO_LOG_INFO), stdout, fmt, args);
+    va_end(args);
+    return len;
+}
+
+int thingino_eprintf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = log_emit(log_classify(fmt, THINGINO_LOG_ERROR), stderr, fmt, args);
+    va_end(args);
+    return len;
+}
@@ -0,0 +1,724 @@
+/**
+ * thingino-clonerd - session daemon
+ *
+ * Owns the libusb context and keeps bootstrapped devices open so that
+ * back-to-back operations skip bootstrap and redundant burner setup.
+ * Clients connect to a Unix socket, send one command line and read the
+ * reply until a final "OK ..." or "ERR ..." line. Jobs run one at a time,
+ * in arrival order.
+ *
+ * Commands (<dev> is a device index from "list" or a port path like 1-2.4;
+ * file paths must not contain spaces and are resolved by the daemon, so
+ * send absolute paths):
+ *
+ *   list                        Devices and their sessions
+ *   read <dev> <file>           Dump the flash to file
+ *   write <dev> <file> [verify] Write file to flash, optionally read back
+ *   verify <dev> <file>         Compare flash against file
+ *   reset <dev>                 USB-reset the device and forget its session
+ *   shutdown                    Close all sessions and exit
+ *
+ * "thingino-clonerd -c <command...>" sends one command and prints the
+ * reply, making relative file paths absolute on the way.
+ */
+
+#include "clonerd.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define CLONERD_ACCEPT_TICK_MS 200
+#define CLONERD_RECV_TIMEOUT_S 5
+
+typedef struct {
+    int fd;
+    char line[CLONERD_LINE_MAX];
+} clonerd_job_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    clonerd_job_t jobs[CLONERD_QUEUE_MAX];
+    int head;
+    int count;
+    int readers;                // Connections whose request is still being read
+} queue = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+static volatile sig_atomic_t clonerd_stop = 0;
+
+static void clonerd_handle_signal(int sig) {
+    (void)sig;
+    clonerd_stop = 1;
+}
+
+// ============================================================================
+// REPLIES
+// ============================================================================
+
+static void reply(int fd, const char* fmt, ...) {
+    char buffer[CLONERD_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buffer, sizeof(buffer) - 1, fmt, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    if (len > (int)sizeof(buffer) - 2) {
+        len = (int)sizeof(buffer) - 2;
+    }
+    buffer[len++] = '\n';
+
+    // A client that went away only loses its reply
+    for (int off = 0; off < len;) {
+        ssize_t n = write(fd, buffer + off, (size_t)(len - off));
+        if (n <= 0) {
+            return;
+        }
+        off += (int)n;
+    }
+}
+
+static void reply_result(int fd, thingino_error_t result, const char* what) {
+    if (result == THINGINO_SUCCESS) {
+        reply(fd, "OK %s", what);
+    } else {
+        reply(fd, "ERR %s: %s", what, thingino_error_to_string(result));
+    }
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+static void cmd_list(clonerd_t* daemon, int fd) {
+    device_info_t* devices = NULL;
+    int count = 0;
+    thingino_error_t result = usb_manager_find_devices(&daemon->context.manager, &devices, &count);
+    if (result != THINGINO_SUCCESS) {
+        reply_result(fd, result, "list");
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char port[USB_PORT_STRING_MAX];
+        usb_port_path_format(&devices[i], port, sizeof(port));
+
+        const clonerd_session_t* session = NULL;
+        for (int s = 0; s < CLONERD_MAX_SESSIONS; s++) {
+            if (daemon->sessions[s].used && strcmp(daemon->sessions[s].port, port) == 0) {
+                session = &daemon->sessions[s];
+                break;
+            }
+        }
+
+        if (session) {
+            reply(fd, "%d %s %04x:%04x %s %s session=%s jobs=%u", i, port,
+                  devices[i].vendor, devices[i].product,
+                  device_stage_to_string(devices[i].stage),
+                  processor_variant_to_string(session->device->info.variant),
+                  clonerd_session_mode_name(session->mode), session->jobs);
+        } else {
+            reply(fd, "%d %s %04x:%04x %s %s session=none", i, port,
+                  devices[i].vendor, devices[i].product,
+                  device_stage_to_string(devices[i].stage),
+                  processor_variant_to_string(devices[i].variant));
+        }
+    }
+    free(devices);
+    reply(fd, "OK %d device(s)", count);
+}
+
+static thingino_error_t cmd_read(clonerd_t* daemon, int fd, const char* spec, const char* path) {
+    char err[256];
+    clonerd_session_t* session = NULL;
+    thingino_error_t result = clonerd_session_acquire(daemon, spec, &session, err, sizeof(err));
+    if (result != THINGINO_SUCCESS) {
+        reply(fd, "ERR %s", err);
+        return result;
+    }
+
+    uint8_t* data = NULL;
+    uint32_t size = 0;
+    result = clonerd_session_set_mode(session, SESSION_MODE_READ);
+    if (result == THINGINO_SUCCESS) {
+        result = firmware_read_full_prepared(session->device, &data, &size);
+    }
+    if (result != THINGINO_SUCCESS) {
+        session->mode = SESSION_MODE_NONE;
+        reply_result(fd, result, "read");
+        return result;
+    }
+
+    FILE* file = fopen(path, "wb");
+    size_t written = file ? fwrite(data, 1, size, file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    free(data);
+
+    if (written != size) {
+        reply(fd, "ERR cannot write %s", path);
+        return THINGINO_ERROR_FILE_IO;
+    }
+    reply(fd, "OK read %u bytes to %s", size, path);
+    return THINGINO_SUCCESS;
+}
+
+static thingino_error_t verify_image(clonerd_session_t* session, const char* path) {
+    firmware_image_t image;
+    if (firmware_image_open(path, &image) != 0) {
+        return THINGINO_ERROR_FILE_IO;
+    }
+    if (image.size > UINT32_MAX) {
+        firmware_image_close(&image);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    thingino_error_t result = clonerd_session_set_mode(session, SESSION_MODE_READ);
+    if (result == THINGINO_SUCCESS) {
+        result = firmware_verify_prepared(session->device, image.data, (uint32_t)image.size);
+    }
+    firmware_image_close(&image);
+    return result;
+}
+
+static thingino_error_t cmd_write(clonerd_t* daemon, int fd, const char* spec, const char* path, bool verify) {
+    char err[256];
+    clonerd_session_t* session = NULL;
+    thingino_error_t result = clonerd_session_acquire(daemon, spec, &session, err, sizeof(err));
+    if (result != THINGINO_SUCCESS) {
+        reply(fd, "ERR %s", err);
+        return result;
+    }
+
+    result = clonerd_session_set_mode(session, SESSION_MODE_WRITE);
+    if (result == THINGINO_SUCCESS) {
+        result = write_firmware_to_device(session->device, path, NULL, false, session->is_a1,
+                                          daemon->window_depth);
+    }
+    if (result != THINGINO_SUCCESS) {
+        session->mode = SESSION_MODE_NONE;
+        reply_result(fd, result, "write");
+        return result;
+    }
+
+    if (verify) {
+        result = verify_image(session, path);
+        if (result != THINGINO_SUCCESS) {
+            session->mode = SESSION_MODE_NONE;
+            reply_result(fd, result, "verify");
+            return result;
+        }
+    }
+    reply(fd, "OK wrote %s%s", path, verify ? " (verified)" : "");
+    return THINGINO_SUCCESS;
+}
+
+static thingino_error_t cmd_verify(clonerd_t* daemon, int fd, const char* spec, const char* path) {
+    char err[256];
+    clonerd_session_t* session = NULL;
+    thingino_error_t result = clonerd_session_acquire(daemon, spec, &session, err, sizeof(err));
+    if (result != THINGINO_SUCCESS) {
+        reply(fd, "ERR %s", err);
+        return result;
+    }
+
+    result = verify_image(session, path);
+    if (result != THINGINO_SUCCESS) {
+        session->mode = SESSION_MODE_NONE;
+    }
+    reply_result(fd, result, "verify");
+    return result;
+}
+
+static void cmd_reset(clonerd_t* daemon, int fd, const char* spec) {
+    char err[256];
+    if (clonerd_session_reset(daemon, spec, err, sizeof(err)) != THINGINO_SUCCESS) {
+        reply(fd, "ERR %s", err);
+        return;
+    }
+    reply(fd, "OK reset");
+}
+
+// @return false when the daemon should exit
+static bool clonerd_execute(clonerd_t* daemon, int fd, char* line) {
+    char* argv[4] = { NULL };
+    int argc = 0;
+    for (char* tok = strtok(line, " \t\r\n"); tok && argc < 4; tok = strtok(NULL, " \t\r\n")) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        reply(fd, "ERR empty command");
+        return true;
+    }
+
+    thingino_printf("[clonerd] > %s%s%s%s%s%s%s\n", argv[0], argc > 1 ? " " : "", argc > 1 ? argv[1] : "",
+           argc > 2 ? " " : "", argc > 2 ? argv[2] : "", argc > 3 ? " " : "", argc > 3 ? argv[3] : "");
+
+    if (strcmp(argv[0], "list") == 0) {
+        cmd_list(daemon, fd);
+    } else if (strcmp(argv[0], "read") == 0 && argc == 3) {
+        thingino_job_begin(NULL);
+        thingino_job_end(cmd_read(daemon, fd, argv[1], argv[2]));
+    } else if (strcmp(argv[0], "write") == 0 && (argc == 3 || argc == 4)) {
+        if (argc == 4 && strcmp(argv[3], "verify") != 0) {
+            reply(fd, "ERR unknown write option '%s'", argv[3]);
+        } else {
+            thingino_job_begin(NULL);
+            thingino_job_end(cmd_write(daemon, fd, argv[1], argv[2], argc == 4));
+        }
+    } else if (strcmp(argv[0], "verify") == 0 && argc == 3) {
+        thingino_job_begin(NULL);
+        thingino_job_end(cmd_verify(daemon, fd, argv[1], argv[2]));
+    } else if (strcmp(argv[0], "reset") == 0 && argc == 2) {
+        cmd_reset(daemon, fd, argv[1]);
+    } else if (strcmp(argv[0], "shutdown") == 0) {
+        reply(fd, "OK shutting down");
+        return false;
+    } else {
+        reply(fd, "ERR unknown command or wrong arguments: %s", argv[0]);
+    }
+    return true;
+}
+
+// ============================================================================
+// SERVER
+// ============================================================================
+
+// Read one command line from a fresh connection
+static bool clonerd_read_line(int fd, char* line, size_t size) {
+    struct timeval tv = { CLONERD_RECV_TIMEOUT_S, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    size_t len = 0;
+    while (len + 1 < size) {
+        ssize_t n = read(fd, line + len, 1);
+        if (n <= 0) {
+            break;
+        }
+        if (line[len] == '\n') {
+            break;
+        }
+        len++;
+    }
+    line[len] = '\0';
+    return len > 0;
+}
+
+static void* clonerd_worker(void* arg) {
+    clonerd_t* daemon = (clonerd_t*)arg;
+    thingino_context_bind(&daemon->context);
+
+    for (;;) {
+        pthread_mutex_lock(&queue.lock);
+        while (queue.count == 0 && !clonerd_stop) {
+            pthread_cond_wait(&queue.cond, &queue.lock);
+        }
+        if (queue.count == 0) {
+            pthread_mutex_unlock(&queue.lock);
+            break;
+        }
+        clonerd_job_t job = queue.jobs[queue.head];
+        queue.head = (queue.head + 1) % CLONERD_QUEUE_MAX;
+        queue.count--;
+        pthread_mutex_unlock(&queue.lock);
+
+        bool keep_running = clonerd_execute(daemon, job.fd, job.line);
+        close(job.fd);
+        if (!keep_running) {
+            clonerd_stop = 1;
+        }
+    }
+    return NULL;
+}
+
+static void clonerd_enqueue(const clonerd_job_t* job) {
+    int fd = job->fd;
+    pthread_mutex_lock(&queue.lock);
+    if (clonerd_stop) {
+        pthread_mutex_unlock(&queue.lock);
+        reply(fd, "ERR daemon shutting down");
+        close(fd);
+        return;
+    }
+    if (queue.count >= CLONERD_QUEUE_MAX) {
+        pthread_mutex_unlock(&queue.lock);
+        reply(fd, "ERR queue full");
+        close(fd);
+        return;
+    }
+    queue.jobs[(queue.head + queue.count) % CLONERD_QUEUE_MAX] = *job;
+    queue.count++;
+    if (queue.count > 1) {
+        reply(fd, "queued behind %d job(s)", queue.count - 1);
+    }
+    pthread_cond_signal(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+}
+
+// Reads the request off the accept thread, so a slow client cannot hold up
+// the connections behind it; only complete requests join the job queue
+static void* clonerd_reader(void* arg) {
+    clonerd_job_t* job = (clonerd_job_t*)arg;
+    if (clonerd_read_line(job->fd, job->line, sizeof(job->line))) {
+        clonerd_enqueue(job);
+    } else {
+        close(job->fd);
+    }
+    free(job);
+
+    pthread_mutex_lock(&queue.lock);
+    queue.readers--;
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+    return NULL;
+}
+
+static void clonerd_accept(int fd) {
+    pthread_mutex_lock(&queue.lock);
+    bool full = queue.readers >= CLONERD_QUEUE_MAX;
+    if (!full) {
+        queue.readers++;
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    clonerd_job_t* job = full ? NULL : (clonerd_job_t*)calloc(1, sizeof(*job));
+    pthread_t reader;
+    if (job) {
+        job->fd = fd;
+        if (pthread_create(&reader, NULL, clonerd_reader, job) == 0) {
+            pthread_detach(reader);
+            return;
+        }
+        free(job);
+    }
+
+    if (!full) {
+        pthread_mutex_lock(&queue.lock);
+        queue.readers--;
+        pthread_mutex_unlock(&queue.lock);
+    }
+    reply(fd, "ERR too many connections");
+    close(fd);
+}
+
+static void clonerd_default_socket(char* path, size_t size) {
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0]) {
+        snprintf(path, size, "%s/%s", runtime, CLONERD_SOCKET_NAME);
+    } else {
+        snprintf(path, size, "/tmp/thingino-clonerd-%u.sock", (unsigned)getuid());
+    }
+}
+
+static int clonerd_socket_address(const char* path, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        thingino_printf("[ERROR] Socket path too long: %s\n", path);
+        return -1;
+    }
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s", path);
+    return 0;
+}
+
+// @return true if socket_path must not be replaced (another daemon, or not ours to remove)
+static bool clonerd_socket_in_use(const char* socket_path, const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(socket_path, &st) != 0) {
+        return false;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        thingino_printf("[ERROR] %s exists and is not a socket\n", socket_path);
+        return true;
+    }
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        thingino_printf("[ERROR] socket: %s\n", strerror(errno));
+        return true;
+    }
+    int rc = connect(probe, (const struct sockaddr*)addr, sizeof(*addr));
+    int connect_errno = errno;
+    close(probe);
+
+    if (rc == 0) {
+        thingino_printf("[ERROR] Another thingino-clonerd is listening on %s\n", socket_path);
+        return true;
+    }
+    if (connect_errno != ECONNREFUSED && connect_errno != ENOENT) {
+        thingino_printf("[ERROR] Cannot probe %s: %s\n", socket_path, strerror(connect_errno));
+        return true;
+    }
+    unlink(socket_path);
+    return false;
+}
+
+static int clonerd_serve(clonerd_t* daemon, const char* socket_path) {
+    struct sockaddr_un addr;
+    if (clonerd_socket_address(socket_path, &addr) != 0) {
+        return 1;
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        thingino_printf("[ERROR] socket: %s\n", strerror(errno));
+        return 1;
+    }
+
+    // A stale socket from a crashed daemon would make bind fail. Only
+    // remove it once nobody answers on it: a running daemon keeps its socket
+    if (clonerd_socket_in_use(socket_path, &addr)) {
+        close(listen_fd);
+        return 1;
+    }
+    mode_t old_mask = umask(0077);  // Owner only: the socket drives hardware
+    int rc = bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+    if (rc != 0 || listen(listen_fd, CLONERD_QUEUE_MAX) != 0) {
+        thingino_printf("[ERROR] Cannot listen on %s: %s\n", socket_path, strerror(errno));
+        close(listen_fd);
+        return 1;
+    }
+
+    pthread_t worker;
+    if (pthread_create(&worker, NULL, clonerd_worker, daemon) != 0) {
+        thingino_printf("[ERROR] Failed to start worker thread\n");
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    thingino_printf("thingino-clonerd listening on %s\n", socket_path);
+
+    while (!clonerd_stop) {
+        struct pollfd pfd = { listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, CLONERD_ACCEPT_TICK_MS) <= 0) {
+            continue;
+        }
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd >= 0) {
+            clonerd_accept(fd);
+        }
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+
+    // Let the worker finish its current job; queued ones are dropped, and
+    // readers still waiting on a request (at most the receive timeout) turn
+    // theirs away
+    pthread_mutex_lock(&queue.lock);
+    while (queue.readers > 0) {
+        pthread_cond_wait(&queue.cond, &queue.lock);
+    }
+    while (queue.count > 0) {
+        clonerd_job_t* job = &queue.jobs[queue.head];
+        reply(job->fd, "ERR daemon shutting down");
+        close(job->fd);
+        queue.head = (queue.head + 1) % CLONERD_QUEUE_MAX;
+        queue.count--;
+    }
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+    pthread_join(worker, NULL);
+
+    thingino_printf("thingino-clonerd stopped\n");
+    return 0;
+}
+
+// ============================================================================
+// CLIENT
+// ============================================================================
+
+static int clonerd_client(const char* socket_path, int argc, char* argv[]) {
+    char line[CLONERD_LINE_MAX];
+    size_t len = 0;
+    bool takes_file = argc >= 3 && (strcmp(argv[0], "read") == 0 ||
+                                    strcmp(argv[0], "write") == 0 ||
+                                    strcmp(argv[0], "verify") == 0);
+
+    for (int i = 0; i < argc && len < sizeof(line); i++) {
+        char absolute[PATH_MAX + 2];
+        const char* word = argv[i];
+        if (i == 2 && takes_file && word[0] != '/') {
+            char cwd[PATH_MAX];
+            if (getcwd(cwd, sizeof(cwd))) {
+                snprintf(absolute, sizeof(absolute), "%s/%s", cwd, word);
+                word = absolute;
+            }
+        }
+        len += (size_t)snprintf(line + len, sizeof(line) - len, "%s%s", i ? " " : "", word);
+    }
+    if (len >= sizeof(line) - 1) {
+        printf("Error: command too long\n");
+        return 1;
+    }
+    line[len++] = '\n';
+
+    struct sockaddr_un addr;
+    if (clonerd_socket_address(socket_path, &addr) != 0) {
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("Error: cannot connect to %s: %s\n", socket_path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    if (write(fd, line, len) != (ssize_t)len) {
+        printf("Error: failed to send command\n");
+        close(fd);
+        return 1;
+    }
+
+    // Echo the reply; the exit status follows the final line
+    char buffer[CLONERD_LINE_MAX];
+    char current[CLONERD_LINE_MAX];
+    size_t current_len = 0;
+    bool ok = false;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, (size_t)n, stdout);
+        for (ssize_t i = 0; i < n; i++) {
+            if (buffer[i] == '\n') {
+                ok = current_len >= 2 && strncmp(current, "OK", 2) == 0;
+                current_len = 0;
+            } else if (current_len < sizeof(current)) {
+                current[current_len++] = buffer[i];
+            }
+        }
+    }
+    close(fd);
+
+    return ok ? 0 : 1;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void print_usage(const char* program_name) {
+    printf("thingino-clonerd - keeps Ingenic devices bootstrapped between operations\n");
+    printf("Usage: %s [options]\n", program_name);
+    printf("       %s [-s <socket>] -c <command...>\n\n", program_name);
+    printf("Options:\n");
+    printf("  -s, --socket <path>   Unix socket (default: $XDG_RUNTIME_DIR/%s)\n", CLONERD_SOCKET_NAME);
+    printf("  -c, --command ...     Send the rest of the line as a command and print the reply\n");
+    printf("      --window <n>      Chunks kept in flight while writing (default: 1)\n");
+    printf("      --metrics <dst>   Export metrics: unix:<path> (OpenMetrics socket) or a .prom textfile\n");
+    printf("      --history-file <f> Job history log (default: ~/.local/share/thingino-cloner/history.bin)\n");
+    printf("      --no-history      Do not record jobs\n");
+    printf("      --config <file>   Custom DDR configuration file\n");
+    printf("      --spl <file>      Custom SPL file\n");
+    printf("      --uboot <file>    Custom U-Boot file\n");
+    printf("  -v, --verbose         Verbose bootstrap output\n");
+    printf("  -d, --debug           Debug output\n");
+    printf("  -h, --help            Show this help\n\n");
+    printf("Commands: list | read <dev> <file> | write <dev> <file> [verify] |\n");
+    printf("          verify <dev> <file> | reset <dev> | shutdown\n");
+    printf("<dev> is an index from 'list' or a port path such as 1-2.4\n");
+}
+
+int main(int argc, char* argv[]) {
+    char socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    clonerd_default_socket(socket_path, sizeof(socket_path));
+
+    clonerd_t* daemon = (clonerd_t*)calloc(1, sizeof(clonerd_t));
+    if (!daemon) {
+        return 1;
+    }
+    daemon->bootstrap.sdram_address = BOOTLOADER_ADDRESS_SDRAM;
+    daemon->bootstrap.timeout = BOOTSTRAP_TIMEOUT_SECONDS;
+    bool debug = false;
+    const char* metrics = NULL;
+    const char* history_file = NULL;
+    bool history = true;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            free(daemon);
+            return 0;
+        } else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--socket") == 0) && has_value) {
+            snprintf(socket_path, sizeof(socket_path), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--command") == 0) {
+            if (!has_value) {
+                printf("Error: %s requires a command\n", argv[i]);
+                free(daemon);
+                return 1;
+            }
+            free(daemon);
+            return clonerd_client(socket_path, argc - i - 1, argv + i + 1);
+        } else if (strcmp(argv[i], "--window") == 0 && has_value) {
+            int depth = atoi(argv[++i]);
+            if (depth < 1) {
+                printf("Error: window depth must be >= 1\n");
+                free(daemon);
+                return 1;
+            }
+            daemon->window_depth = (uint32_t)depth;
+        } else if (strcmp(argv[i], "--metrics") == 0 && has_value) {
+            metrics = argv[++i];
+        } else if (strcmp(argv[i], "--history-file") == 0 && has_value) {
+            history_file = argv[++i];
+        } else if (strcmp(argv[i], "--no-history") == 0) {
+            history = false;
+        } else if (strcmp(argv[i], "--config") == 0 && has_value) {
+            daemon->bootstrap.config_file = argv[++i];
+        } else if (strcmp(argv[i], "--spl") == 0 && has_value) {
+            daemon->bootstrap.spl_file = argv[++i];
+        } else if (strcmp(argv[i], "--uboot") == 0 && has_value) {
+            daemon->bootstrap.uboot_file = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            daemon->bootstrap.verbose = true;
+        } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
+            debug = true;
+        } else {
+            printf("Error: unknown or incomplete option %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(daemon);
+            return 1;
+        }
+    }
+
+    thingino_error_t result = thingino_context_init(&daemon->context);
+    if (result != THINGINO_SUCCESS) {
+        thingino_printf("[ERROR] Failed to initialize USB: %s\n", thingino_error_to_string(result));
+        free(daemon);
+        return 1;
+    }
+    daemon->context.debug = debug;
+    thingino_context_bind(&daemon->context);
+    thingino_log_async_start();
+    if (metrics && thingino_metrics_start(&daemon->context, metrics) != THINGINO_SUCCESS) {
+        thingino_context_cleanup(&daemon->context);
+        free(daemon);
+        return 1;
+    }
+    if (history) {
+        thingino_history_open(&daemon->context, history_file);  // Best effort
+    }
+
+    signal(SIGINT, clonerd_handle_signal);
+    signal(SIGTERM, clonerd_handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int exit_code = clonerd_serve(daemon, socket_path);
+
+    clonerd_session_drop_all(daemon);
+    thingino_context_cleanup(&daemon->context);
+    free(daemon);
+    return exit_code;
+}
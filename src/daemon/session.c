@@ -0,0 +1,286 @@
+#include "clonerd.h"
+
+// ============================================================================
+// DAEMON SESSIONS
+// ============================================================================
+
+const char* clonerd_session_mode_name(session_mode_t mode) {
+    switch (mode) {
+        case SESSION_MODE_READ:  return "read";
+        case SESSION_MODE_WRITE: return "write";
+        default:                 return "idle";
+    }
+}
+
+void clonerd_session_drop(clonerd_session_t* session) {
+    if (!session || !session->used) {
+        return;
+    }
+    if (session->device) {
+        usb_device_close(session->device);
+        free(session->device);
+    }
+    memset(session, 0, sizeof(*session));
+}
+
+void clonerd_session_drop_all(clonerd_t* daemon) {
+    for (int i = 0; i < CLONERD_MAX_SESSIONS; i++) {
+        clonerd_session_drop(&daemon->sessions[i]);
+    }
+}
+
+// "1-2.4" for a known port, "bus:addr" otherwise (not stable across re-enumeration)
+static void session_port_key(const device_info_t* info, char* buffer, size_t size) {
+    if (info->port_depth) {
+        usb_port_path_format(info, buffer, size);
+    } else {
+        snprintf(buffer, size, "%03d:%03d", info->bus, info->address);
+    }
+}
+
+// Device list index or port path
+static int session_resolve_spec(const device_info_t* devices, int count, const char* spec) {
+    if (strchr(spec, '-')) {
+        return usb_device_info_find_port(devices, count, spec);
+    }
+
+    char* end = NULL;
+    long index = strtol(spec, &end, 10);
+    if (end == spec || *end != '\0' || index < 0 || index >= count) {
+        return -1;
+    }
+    return (int)index;
+}
+
+// Is the session's handle still talking to a burner?
+static bool session_alive(clonerd_session_t* session, const device_info_t* current) {
+    if (!session->device || session->device->info.address != current->address ||
+        session->device->info.bus != current->bus) {
+        return false;  // Replugged or re-enumerated behind our back
+    }
+
+    cpu_info_t cpu_info;
+    return usb_device_get_cpu_info(session->device, &cpu_info) == THINGINO_SUCCESS &&
+           cpu_info.stage == STAGE_FIRMWARE;
+}
+
+// Open the device and bring it to firmware stage
+static thingino_error_t session_open_firmware(clonerd_t* daemon, const device_info_t* info,
+                                              usb_device_t** out, char* err, size_t err_size) {
+    usb_device_t* device = NULL;
+    thingino_error_t result = usb_manager_open_device(&daemon->context.manager, info, &device);
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "cannot open device: %s", thingino_error_to_string(result));
+        return result;
+    }
+
+    cpu_info_t cpu_info;
+    result = usb_device_get_cpu_info(device, &cpu_info);
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "no CPU info: %s", thingino_error_to_string(result));
+        usb_device_close(device);
+        free(device);
+        return result;
+    }
+    device->info.variant = detect_variant_from_magic(cpu_info.clean_magic);
+    device->info.stage = cpu_info.stage;
+
+    if (device->info.stage == STAGE_FIRMWARE) {
+        *out = device;
+        return THINGINO_SUCCESS;
+    }
+
+    thingino_printf("[clonerd] Bootstrapping %s device\n", processor_variant_to_string(device->info.variant));
+    result = bootstrap_device(device, &daemon->bootstrap);
+    device_info_t before = device->info;
+    usb_device_close(device);
+    free(device);
+    device = NULL;
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "bootstrap failed: %s", thingino_error_to_string(result));
+        return result;
+    }
+
+    device_info_t arrived;
+    if (usb_wait_for_arrival(daemon->context.manager.context, &before, REENUMERATION_TIMEOUT_MS,
+                             &arrived) != THINGINO_SUCCESS) {
+        arrived = before;  // Kept its address
+    }
+    arrived.variant = before.variant;
+    thingino_sleep_milliseconds(50);  // Let udev apply permissions
+
+    result = usb_manager_open_device(&daemon->context.manager, &arrived, &device);
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "cannot reopen after bootstrap: %s", thingino_error_to_string(result));
+        return result;
+    }
+    if (usb_device_get_cpu_info(device, &cpu_info) != THINGINO_SUCCESS ||
+        cpu_info.stage != STAGE_FIRMWARE) {
+        snprintf(err, err_size, "device not in firmware stage after bootstrap");
+        usb_device_close(device);
+        free(device);
+        return THINGINO_ERROR_PROTOCOL;
+    }
+    device->info.stage = STAGE_FIRMWARE;
+
+    *out = device;
+    return THINGINO_SUCCESS;
+}
+
+// Enumerate and pick the device spec names, with its session key
+static thingino_error_t session_find_device(clonerd_t* daemon, const char* spec, device_info_t* info,
+                                            char* port, size_t port_size, char* err, size_t err_size) {
+    device_info_t* devices = NULL;
+    int count = 0;
+    thingino_error_t result = usb_manager_find_devices(&daemon->context.manager, &devices, &count);
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "enumeration failed: %s", thingino_error_to_string(result));
+        return result;
+    }
+
+    int index = session_resolve_spec(devices, count, spec);
+    if (index < 0) {
+        snprintf(err, err_size, "no device '%s' (%d found)", spec, count);
+        free(devices);
+        return THINGINO_ERROR_DEVICE_NOT_FOUND;
+    }
+    *info = devices[index];
+    free(devices);
+
+    session_port_key(info, port, port_size);
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Find or create the session for spec (device index or port path)
+ *
+ * A live session is reused as is; a stale one (unplugged, reset, burner
+ * gone) is dropped and the device bootstrapped again.
+ */
+thingino_error_t clonerd_session_acquire(clonerd_t* daemon, const char* spec,
+                                         clonerd_session_t** out, char* err, size_t err_size) {
+    device_info_t info;
+    char port[USB_PORT_STRING_MAX];
+    thingino_error_t result = session_find_device(daemon, spec, &info, port, sizeof(port),
+                                                  err, err_size);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    clonerd_session_t* session = NULL;
+    clonerd_session_t* free_slot = NULL;
+    for (int i = 0; i < CLONERD_MAX_SESSIONS; i++) {
+        clonerd_session_t* s = &daemon->sessions[i];
+        if (s->used && strcmp(s->port, port) == 0) {
+            session = s;
+            break;
+        }
+        if (!s->used && !free_slot) {
+            free_slot = s;
+        }
+    }
+
+    if (session && session_alive(session, &info)) {
+        session->jobs++;
+        session->last_used_ms = thingino_monotonic_ms();
+        *out = session;
+        return THINGINO_SUCCESS;
+    }
+    if (session) {
+        thingino_printf("[clonerd] Session on %s is stale, starting over\n", port);
+        clonerd_session_drop(session);
+        free_slot = session;
+    }
+    if (!free_slot) {
+        snprintf(err, err_size, "too many sessions (max %d)", CLONERD_MAX_SESSIONS);
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    usb_device_t* device = NULL;
+    result = session_open_firmware(daemon, &info, &device, err, err_size);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    memset(free_slot, 0, sizeof(*free_slot));
+    free_slot->used = true;
+    snprintf(free_slot->port, sizeof(free_slot->port), "%s", port);
+    free_slot->device = device;
+    free_slot->mode = SESSION_MODE_NONE;
+    free_slot->jobs = 1;
+    free_slot->last_used_ms = thingino_monotonic_ms();
+    thingino_printf("[clonerd] Session on %s ready (%s, firmware stage)\n", port,
+           processor_variant_to_string(device->info.variant));
+
+    *out = free_slot;
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * USB-reset the device spec names and forget its session
+ *
+ * Goes through the session's handle when it still matches the device, and
+ * otherwise opens the device as it is: a reset never bootstraps.
+ */
+thingino_error_t clonerd_session_reset(clonerd_t* daemon, const char* spec, char* err, size_t err_size) {
+    device_info_t info;
+    char port[USB_PORT_STRING_MAX];
+    thingino_error_t result = session_find_device(daemon, spec, &info, port, sizeof(port),
+                                                  err, err_size);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    clonerd_session_t* session = NULL;
+    for (int i = 0; i < CLONERD_MAX_SESSIONS; i++) {
+        if (daemon->sessions[i].used && strcmp(daemon->sessions[i].port, port) == 0) {
+            session = &daemon->sessions[i];
+            break;
+        }
+    }
+
+    if (session && session->device && session->device->info.bus == info.bus &&
+        session->device->info.address == info.address) {
+        result = usb_device_reset(session->device);
+        clonerd_session_drop(session);
+    } else {
+        clonerd_session_drop(session);  // Stale: its handle points at a gone device
+
+        usb_device_t* device = NULL;
+        result = usb_manager_open_device(&daemon->context.manager, &info, &device);
+        if (result == THINGINO_SUCCESS) {
+            result = usb_device_reset(device);
+            usb_device_close(device);
+            free(device);
+        }
+    }
+
+    if (result != THINGINO_SUCCESS) {
+        snprintf(err, err_size, "reset: %s", thingino_error_to_string(result));
+    }
+    return result;
+}
+
+/**
+ * Put the burner into read or write mode unless it already is
+ */
+thingino_error_t clonerd_session_set_mode(clonerd_session_t* session, session_mode_t mode) {
+    if (!session || !session->device) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    if (session->mode == mode) {
+        DEBUG_PRINT("Session %s already in %s mode\n", session->port, clonerd_session_mode_name(mode));
+        return THINGINO_SUCCESS;
+    }
+
+    thingino_error_t result = THINGINO_SUCCESS;
+    if (mode == SESSION_MODE_READ) {
+        result = firmware_read_prepare(session->device);
+    } else if (mode == SESSION_MODE_WRITE) {
+        result = firmware_write_prepare(session->device, &session->is_a1);
+    }
+
+    // A failed prepare leaves the burner in an unknown mode
+    session->mode = result == THINGINO_SUCCESS ? mode : SESSION_MODE_NONE;
+    return result;
+}
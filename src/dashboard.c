@@ -0,0 +1,416 @@
+#include "thingino.h"
+
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// TERMINAL DASHBOARD IMPLEMENTATION
+// ============================================================================
+//
+// Device threads only update their row under the lock, a few times a second
+// each thanks to the bytes event rate limit. The dashboard thread formats
+// the whole frame (held log lines, then the block) into one buffer and
+// writes it outside the lock, so drawing costs one short write per redraw
+// however many devices are running. Without a terminal there is nothing to
+// draw around: log output keeps its normal path and the dashboard only adds
+// periodic [status] lines.
+
+#define DASHBOARD_TICK_MS      50       // Stop latency of the dashboard thread
+#define DASHBOARD_PENDING_MAX  8192     // Log text held for the next redraw
+#define DASHBOARD_LINE_MAX     256
+#define DASHBOARD_BAR_WIDTH    16
+#define DASHBOARD_FRAME_MAX    (DASHBOARD_PENDING_MAX + (DASHBOARD_MAX_ROWS + 1) * (DASHBOARD_LINE_MAX + 16) + 64)
+
+typedef struct {
+    char dev[USB_PORT_STRING_MAX];
+    char variant[16];
+    char phase[16];
+    uint64_t done;
+    uint64_t total;
+    uint64_t bps;
+    uint64_t ms;                // Duration of the last finished phase
+    uint64_t updated_ms;
+    uint32_t retries;           // In the current phase
+    bool steps;                 // done/total count bootstrap steps, not bytes
+    bool running;               // Phase in progress
+    thingino_error_t result;    // Of the last finished phase
+    bool changed;               // Since the last plain summary
+} dashboard_row_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_t thread;
+    thingino_context_t* ctx;        // NULL = not running
+    volatile bool stopping;
+    bool tty;
+    thingino_log_fn saved_log;
+    thingino_event_fn saved_event;
+    dashboard_row_t rows[DASHBOARD_MAX_ROWS];
+    int row_count;
+    int drawn;                      // Block lines currently above the cursor
+    char pending[DASHBOARD_PENDING_MAX];
+    size_t pending_len;
+    uint32_t dropped;
+} dashboard = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static char dashboard_frame[DASHBOARD_FRAME_MAX];  // Dashboard thread (or stop) only
+
+// ============================================================================
+// ROWS
+// ============================================================================
+
+// Called with the lock held. A full table reuses the idle row untouched
+// longest; NULL when every row is busy.
+static dashboard_row_t* dashboard_row(const char* dev) {
+    dashboard_row_t* oldest = NULL;
+    for (int i = 0; i < dashboard.row_count; i++) {
+        dashboard_row_t* row = &dashboard.rows[i];
+        if (strcmp(row->dev, dev) == 0) {
+            return row;
+        }
+        if (!row->running && (!oldest || row->updated_ms < oldest->updated_ms)) {
+            oldest = row;
+        }
+    }
+    dashboard_row_t* row = dashboard.row_count < DASHBOARD_MAX_ROWS
+                               ? &dashboard.rows[dashboard.row_count++] : oldest;
+    if (row) {
+        memset(row, 0, sizeof(*row));
+        snprintf(row->dev, sizeof(row->dev), "%s", dev);
+    }
+    return row;
+}
+
+static void dashboard_event(void* user_data, const thingino_event_t* event) {
+    (void)user_data;
+    if (!event->info) {
+        return;  // Rows are per device
+    }
+    pthread_mutex_lock(&dashboard.lock);
+    dashboard_row_t* row = dashboard_row(event->dev);
+    if (!row) {
+        pthread_mutex_unlock(&dashboard.lock);
+        return;
+    }
+    snprintf(row->variant, sizeof(row->variant), "%s",
+             processor_variant_to_string(event->info->variant));
+
+    switch (event->type) {
+    case THINGINO_EVENT_DEVICE:
+        if (!row->running) {
+            snprintf(row->phase, sizeof(row->phase), "%s",
+                     device_stage_to_string(event->info->stage));
+            row->ms = 0;
+            row->result = THINGINO_SUCCESS;
+        }
+        break;
+    case THINGINO_EVENT_PHASE_START:
+        snprintf(row->phase, sizeof(row->phase), "%s", event->name);
+        row->done = row->total = row->bps = 0;
+        row->retries = 0;
+        row->running = true;
+        break;
+    case THINGINO_EVENT_PHASE_END:
+        row->running = false;
+        row->ms = event->ms ? event->ms : 1;  // 0 means "no phase finished yet"
+        row->result = event->result;
+        break;
+    case THINGINO_EVENT_BYTES:
+    case THINGINO_EVENT_STEP:
+        if (!row->running) {  // Progress outside a bracketed phase
+            snprintf(row->phase, sizeof(row->phase), "%s", event->name);
+            row->running = true;
+        }
+        row->done = event->done;
+        row->total = event->total;
+        row->bps = event->bps;
+        row->steps = event->type == THINGINO_EVENT_STEP;
+        break;
+    case THINGINO_EVENT_RETRY:
+        row->retries++;
+        break;
+    default:
+        break;
+    }
+    row->updated_ms = event->t_ms;
+    row->changed = true;
+    pthread_mutex_unlock(&dashboard.lock);
+}
+
+// ============================================================================
+// FORMATTING
+// ============================================================================
+
+static void format_duration(uint64_t seconds, char* out, size_t size) {
+    if (seconds >= 3600) {
+        snprintf(out, size, "%llu:%02llu:%02llu", (unsigned long long)(seconds / 3600),
+                 (unsigned long long)(seconds / 60 % 60), (unsigned long long)(seconds % 60));
+    } else {
+        snprintf(out, size, "%llu:%02llu", (unsigned long long)(seconds / 60),
+                 (unsigned long long)(seconds % 60));
+    }
+}
+
+// One device line without a newline; bar = false for plain summaries
+static void format_row(const dashboard_row_t* row, bool bar, char* out, size_t size) {
+    char elapsed[16];
+    int len = snprintf(out, size, "%-12s %-8s %-9s ", row->dev, row->variant, row->phase);
+
+    if (!row->running) {
+        format_duration(row->ms / 1000, elapsed, sizeof(elapsed));
+        if (!row->ms) {
+            len += snprintf(out + len, size - (size_t)len, "waiting");
+        } else if (row->result == THINGINO_SUCCESS) {
+            len += snprintf(out + len, size - (size_t)len, "done in %s", elapsed);
+        } else {
+            len += snprintf(out + len, size - (size_t)len, "FAILED after %s: %s", elapsed,
+                            thingino_error_to_string(row->result));
+        }
+    } else if (!row->total) {
+        len += snprintf(out + len, size - (size_t)len, "starting");
+    } else {
+        uint64_t done = row->done < row->total ? row->done : row->total;
+        unsigned percent = (unsigned)(done * 100 / row->total);
+        if (bar) {
+            char cells[DASHBOARD_BAR_WIDTH + 1];
+            int filled = (int)(done * DASHBOARD_BAR_WIDTH / row->total);
+            for (int i = 0; i < DASHBOARD_BAR_WIDTH; i++) {
+                cells[i] = i < filled ? '#' : '-';
+            }
+            cells[DASHBOARD_BAR_WIDTH] = '\0';
+            len += snprintf(out + len, size - (size_t)len, "[%s] ", cells);
+        }
+        len += snprintf(out + len, size - (size_t)len, "%3u%%", percent);
+        if (row->steps) {
+            len += snprintf(out + len, size - (size_t)len, "  step %llu/%llu",
+                            (unsigned long long)done, (unsigned long long)row->total);
+        } else if (row->bps) {
+            format_duration((row->total - done) / row->bps, elapsed, sizeof(elapsed));
+            len += snprintf(out + len, size - (size_t)len, "  %5.1f MB/s ETA %s",
+                            row->bps / (1024.0 * 1024.0), elapsed);
+        }
+    }
+    if (row->retries && len > 0 && (size_t)len < size) {
+        snprintf(out + len, size - (size_t)len, "  (%u retr%s)", row->retries,
+                 row->retries == 1 ? "y" : "ies");
+    }
+}
+
+static int terminal_width(void) {
+#ifndef _WIN32
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        return ws.ws_col;
+    }
+#endif
+    return 80;
+}
+
+static size_t frame_append(size_t len, const char* text, size_t text_len) {
+    if (len + text_len > sizeof(dashboard_frame)) {
+        text_len = sizeof(dashboard_frame) - len;
+    }
+    memcpy(dashboard_frame + len, text, text_len);
+    return len + text_len;
+}
+
+// Builds the next frame with the lock held. On a terminal: back up over the
+// old block, print held log lines in its place, then the new block. Lines
+// are cut to the terminal width so the block never wraps and the cursor-up
+// count stays right.
+static size_t dashboard_frame_build(bool final) {
+    char line[DASHBOARD_LINE_MAX + 16];
+    size_t len = 0;
+
+    if (dashboard.drawn) {
+        int n = snprintf(line, sizeof(line), "\x1b[%dA\r\x1b[J", dashboard.drawn);
+        len = frame_append(len, line, (size_t)n);
+    }
+    len = frame_append(len, dashboard.pending, dashboard.pending_len);
+    if (dashboard.pending_len && dashboard.pending[dashboard.pending_len - 1] != '\n') {
+        len = frame_append(len, "\n", 1);
+    }
+    dashboard.pending_len = 0;
+    if (dashboard.dropped) {
+        int n = snprintf(line, sizeof(line), "[WARN] %u log message(s) dropped (output too slow)\n",
+                         dashboard.dropped);
+        len = frame_append(len, line, (size_t)n);
+        dashboard.dropped = 0;
+    }
+
+    int width = terminal_width() - 1;
+    if (width > DASHBOARD_LINE_MAX - 1) {
+        width = DASHBOARD_LINE_MAX - 1;
+    }
+    dashboard.drawn = 0;
+    for (int i = 0; i < dashboard.row_count; i++) {
+        format_row(&dashboard.rows[i], true, line, DASHBOARD_LINE_MAX);
+        size_t n = strlen(line);
+        if (n > (size_t)width) {
+            n = (size_t)width;
+        }
+        line[n++] = '\n';
+        len = frame_append(len, line, n);
+        dashboard.drawn++;
+    }
+    if (final) {
+        dashboard.drawn = 0;  // Leave the last state on screen
+    }
+    return len;
+}
+
+// Plain mode: one line per device changed since the last summary
+static size_t dashboard_summary_build(void) {
+    char line[DASHBOARD_LINE_MAX];
+    size_t len = 0;
+    for (int i = 0; i < dashboard.row_count; i++) {
+        dashboard_row_t* row = &dashboard.rows[i];
+        if (!row->changed) {
+            continue;
+        }
+        row->changed = false;
+        format_row(row, false, line, sizeof(line));
+        len = frame_append(len, "[status] ", 9);
+        len = frame_append(len, line, strlen(line));
+        len = frame_append(len, "\n", 1);
+    }
+    return len;
+}
+
+static void dashboard_write(size_t len) {
+    if (!len) {
+        return;
+    }
+    if (dashboard.tty) {
+        fwrite(dashboard_frame, 1, len, stdout);
+        fflush(stdout);
+        return;
+    }
+    // Summaries are ordinary log lines, in order with everything else
+    for (size_t start = 0; start < len;) {
+        const char* end = memchr(dashboard_frame + start, '\n', len - start);
+        size_t n = end ? (size_t)(end - dashboard_frame) - start : len - start;
+        thingino_printf("%.*s\n", (int)n, dashboard_frame + start);
+        start += n + 1;
+    }
+}
+
+// ============================================================================
+// LOG CAPTURE
+// ============================================================================
+
+// Terminal mode only. Every thread's lines are held and printed above the
+// block on the next redraw, where they scroll up like normal output
+static void dashboard_log(void* user_data, thingino_log_level_t level, const char* text) {
+    (void)user_data;
+    (void)level;
+    size_t len = strlen(text);
+    pthread_mutex_lock(&dashboard.lock);
+    if (dashboard.pending_len + len <= sizeof(dashboard.pending)) {
+        memcpy(dashboard.pending + dashboard.pending_len, text, len);
+        dashboard.pending_len += len;
+    } else {
+        dashboard.dropped++;
+    }
+    pthread_mutex_unlock(&dashboard.lock);
+}
+
+static void* dashboard_thread(void* arg) {
+    thingino_context_bind((thingino_context_t*)arg);  // Plain summaries log through it
+    uint32_t interval = dashboard.tty ? DASHBOARD_REDRAW_MS : DASHBOARD_SUMMARY_MS;
+    uint32_t waited = 0;
+    while (!dashboard.stopping) {
+        thingino_sleep_real_milliseconds(DASHBOARD_TICK_MS);
+        waited += DASHBOARD_TICK_MS;
+        if (waited < interval) {
+            continue;
+        }
+        waited = 0;
+        pthread_mutex_lock(&dashboard.lock);
+        size_t len = dashboard.tty ? dashboard_frame_build(false) : dashboard_summary_build();
+        pthread_mutex_unlock(&dashboard.lock);
+        dashboard_write(len);
+    }
+    return NULL;
+}
+
+static bool stdout_is_terminal(void) {
+#ifdef _WIN32
+    if (!_isatty(_fileno(stdout))) {
+        return false;
+    }
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    return GetConsoleMode(console, &mode) &&
+           SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#else
+    const char* term = getenv("TERM");
+    return isatty(STDOUT_FILENO) && !(term && strcmp(term, "dumb") == 0);
+#endif
+}
+
+// ============================================================================
+// START / STOP
+// ============================================================================
+
+/**
+ * Show the dashboard for ctx until thingino_dashboard_stop(). Only one
+ * dashboard runs per process (there is one terminal).
+ */
+thingino_error_t thingino_dashboard_start(thingino_context_t* ctx) {
+    if (!ctx) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    if (dashboard.ctx) {
+        return dashboard.ctx == ctx ? THINGINO_SUCCESS : THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    thingino_log_flush();  // Earlier output stays above the block
+
+    dashboard.tty = stdout_is_terminal();
+    dashboard.stopping = false;
+    dashboard.row_count = 0;
+    dashboard.drawn = 0;
+    dashboard.pending_len = 0;
+    dashboard.dropped = 0;
+    dashboard.saved_log = ctx->log;
+    dashboard.saved_event = ctx->event;
+    if (pthread_create(&dashboard.thread, NULL, dashboard_thread, ctx) != 0) {
+        return THINGINO_ERROR_MEMORY;
+    }
+    dashboard.ctx = ctx;
+    ctx->event = dashboard_event;
+    if (dashboard.tty) {
+        ctx->log = dashboard_log;
+    }
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Draw the final state (or summary), then hand output back to the context's
+ * previous callbacks. No-op when ctx has no dashboard.
+ */
+void thingino_dashboard_stop(thingino_context_t* ctx) {
+    if (!ctx || dashboard.ctx != ctx) {
+        return;
+    }
+    dashboard.stopping = true;
+    pthread_join(dashboard.thread, NULL);
+
+    pthread_mutex_lock(&dashboard.lock);
+    ctx->event = dashboard.saved_event;
+    ctx->log = dashboard.saved_log;
+    dashboard.ctx = NULL;
+    size_t len = dashboard.tty ? dashboard_frame_build(true) : dashboard_summary_build();
+    pthread_mutex_unlock(&dashboard.lock);
+    dashboard_write(len);
+}
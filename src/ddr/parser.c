@@ -1,4 +1,5 @@
 #include "thingino.h"
+#include <pthread.h>
 
 // ============================================================================
 // DDR CONFIGURATION PARSER IMPLEMENTATION
@@ -9,8 +10,9 @@
 static uint8_t* extracted_ddr_binary = NULL;
 static size_t extracted_ddr_size = 0;
 static bool init_once = false;
+static pthread_mutex_t extracted_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards the three above
 
-thingino_error_t load_extracted_binary(void) {
+static thingino_error_t load_extracted_binary_locked(void) {
     if (init_once) {
         return THINGINO_SUCCESS;
     }
@@ -66,7 +68,7 @@ thingino_error_t load_extracted_binary(void) {
     }
     
     // If we can't find the extracted binary, create a minimal valid one
-    printf("Warning: Could not find extracted DDR binary, creating minimal one\n");
+    thingino_printf("Warning: Could not find extracted DDR binary, creating minimal one\n");
     return create_minimal_ddr_binary();
 }
 
@@ -98,27 +100,34 @@ thingino_error_t create_minimal_ddr_binary(void) {
     return THINGINO_SUCCESS;
 }
 
+thingino_error_t load_extracted_binary(void) {
+    pthread_mutex_lock(&extracted_lock);
+    thingino_error_t result = load_extracted_binary_locked();
+    pthread_mutex_unlock(&extracted_lock);
+    return result;
+}
+
 thingino_error_t ddr_parse_config(const char* config_path, uint8_t** binary, size_t* size) {
     if (!binary || !size) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
     (void)config_path; // Suppress unused parameter warning
     
-    thingino_error_t result = load_extracted_binary();
-    if (result != THINGINO_SUCCESS) {
-        return result;
-    }
-    
-    // Return a copy of the extracted binary
-    *binary = (uint8_t*)malloc(extracted_ddr_size);
-    if (!*binary) {
-        return THINGINO_ERROR_MEMORY;
+    pthread_mutex_lock(&extracted_lock);
+    thingino_error_t result = load_extracted_binary_locked();
+    if (result == THINGINO_SUCCESS) {
+        // Return a copy of the extracted binary
+        *binary = (uint8_t*)malloc(extracted_ddr_size);
+        if (*binary) {
+            memcpy(*binary, extracted_ddr_binary, extracted_ddr_size);
+            *size = extracted_ddr_size;
+        } else {
+            result = THINGINO_ERROR_MEMORY;
+        }
     }
-    
-    memcpy(*binary, extracted_ddr_binary, extracted_ddr_size);
-    *size = extracted_ddr_size;
-    
-    return THINGINO_SUCCESS;
+    pthread_mutex_unlock(&extracted_lock);
+
+    return result;
 }
 
 thingino_error_t ddr_parse_config_bytes(const char* config_text, uint8_t** binary, size_t* size) {
@@ -171,12 +180,14 @@ thingino_error_t ddr_parse_text_to_binary(const char* config_text, uint8_t** bin
 }
 
 void ddr_cleanup(void) {
+    pthread_mutex_lock(&extracted_lock);
     if (extracted_ddr_binary) {
         free(extracted_ddr_binary);
         extracted_ddr_binary = NULL;
         extracted_ddr_size = 0;
         init_once = false;
     }
+    pthread_mutex_unlock(&extracted_lock);
 }
 
 // Helper function to print DDR binary info for debugging
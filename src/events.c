@@ -0,0 +1,335 @@
+#include "thingino.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// EVENT STREAM IMPLEMENTATION
+// ============================================================================
+//
+// Events go to the calling thread's context: its event callback, its
+// JSON-lines stream, its metrics when collecting, and the thread's job
+// history record. A JSON line is formatted into one stack buffer and written
+// with a single write() call. Strings placed in events are identifiers, port
+// paths and thingino/libusb error names, none of which need JSON escaping.
+//
+// The stream is written from transfer threads, so its descriptor is put in
+// non-blocking mode: a controller that stops reading costs lines, never a
+// stalled transfer. Lines are shorter than PIPE_BUF, so a pipe takes each
+// one whole or not at all.
+
+static thingino_context_t* events_context(void) {
+    thingino_context_t* ctx = thingino_context_current();
+    return ctx && (ctx->events_fd >= 0 || ctx->event) ? ctx : NULL;
+}
+
+static metrics_t* events_metrics(void) {
+    thingino_context_t* ctx = thingino_context_current();
+    return ctx ? ctx->metrics : NULL;
+}
+
+static void events_write(thingino_context_t* ctx, char* line, int len) {
+    if (len < 0) {
+        return;
+    }
+    if (len > EVENTS_LINE_MAX - 2) {
+        len = EVENTS_LINE_MAX - 2;  // Cut, but still one line of JSON-ish text
+    }
+    line[len++] = '\n';
+
+    if (ctx->events_dropped) {
+        char note[64];
+        int n = snprintf(note, sizeof(note), "{\"t\":%llu,\"ev\":\"dropped\",\"count\":%u}\n",
+                         (unsigned long long)thingino_monotonic_ms(), ctx->events_dropped);
+        if (write(ctx->events_fd, note, (size_t)n) < 0) {
+            if (errno == EPIPE) {
+                ctx->events_fd = -1;
+            } else {
+                ctx->events_dropped++;
+            }
+            return;
+        }
+        ctx->events_dropped = 0;
+    }
+
+    // A controller that went away must not take the transfer with it
+    if (write(ctx->events_fd, line, (size_t)len) < 0) {
+        if (errno == EPIPE) {
+            ctx->events_fd = -1;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            ctx->events_dropped++;
+        }
+    }
+}
+
+static void events_set_nonblocking(int fd) {
+#ifndef _WIN32
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+// {"t":...,"ev":"...","dev":"..." (no closing brace)
+static int events_header(char* line, const char* ev, const thingino_event_t* event) {
+    int len = snprintf(line, EVENTS_LINE_MAX, "{\"t\":%llu,\"ev\":\"%s\"",
+                       (unsigned long long)event->t_ms, ev);
+    if (event->info) {
+        len += snprintf(line + len, EVENTS_LINE_MAX - (size_t)len, ",\"dev\":\"%s\"", event->dev);
+    }
+    return len;
+}
+
+static void events_json(thingino_context_t* ctx, const thingino_event_t* event) {
+    char line[EVENTS_LINE_MAX];
+    size_t size = sizeof(line);
+    int len;
+    switch (event->type) {
+    case THINGINO_EVENT_DEVICE:
+        len = events_header(line, "device", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"vid\":\"%04x\",\"pid\":\"%04x\",\"stage\":\"%s\"}",
+                        event->info->vendor, event->info->product,
+                        device_stage_to_string(event->info->stage));
+        break;
+    case THINGINO_EVENT_PHASE_START:
+        len = events_header(line, "phase", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"phase\":\"%s\",\"state\":\"start\"}", event->name);
+        break;
+    case THINGINO_EVENT_PHASE_END:
+        len = events_header(line, "phase", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"phase\":\"%s\",\"state\":\"end\",\"ms\":%llu,\"ok\":%s}",
+                        event->name, (unsigned long long)event->ms,
+                        event->result == THINGINO_SUCCESS ? "true" : "false");
+        if (event->result != THINGINO_SUCCESS) {
+            events_write(ctx, line, len);
+            len = events_header(line, "error", event);
+            len += snprintf(line + len, size - (size_t)len,
+                            ",\"phase\":\"%s\",\"code\":%d,\"error\":\"%s\"}",
+                            event->name, (int)event->result, thingino_error_to_string(event->result));
+        }
+        break;
+    case THINGINO_EVENT_BYTES:
+        len = events_header(line, "bytes", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"op\":\"%s\",\"done\":%llu,\"total\":%llu,\"bps\":%llu}", event->name,
+                        (unsigned long long)event->done, (unsigned long long)event->total,
+                        (unsigned long long)event->bps);
+        break;
+    case THINGINO_EVENT_STEP:
+        len = events_header(line, "step", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"op\":\"%s\",\"done\":%llu,\"total\":%llu}", event->name,
+                        (unsigned long long)event->done, (unsigned long long)event->total);
+        break;
+    case THINGINO_EVENT_ERASE:
+        len = events_header(line, "erase", event);
+        len += snprintf(line + len, size - (size_t)len, ",\"ms\":%llu}",
+                        (unsigned long long)event->ms);
+        break;
+    case THINGINO_EVENT_RETRY:
+        len = events_header(line, "retry", event);
+        len += snprintf(line + len, size - (size_t)len,
+                        ",\"request\":\"0x%02x\",\"error\":\"%s\",\"attempt\":%u,\"delay_ms\":%llu}",
+                        event->request, event->name ? event->name : "", event->attempt,
+                        (unsigned long long)event->ms);
+        break;
+    default:
+        return;
+    }
+    events_write(ctx, line, len);
+}
+
+// Fills in time and port, then hands the event to every consumer
+static void events_dispatch(thingino_context_t* ctx, thingino_event_t* event) {
+    char dev[USB_PORT_STRING_MAX] = "";
+    if (event->device) {
+        event->info = &event->device->info;
+    }
+    if (event->info) {
+        if (event->info->port_depth) {
+            usb_port_path_format(event->info, dev, sizeof(dev));
+        } else {
+            snprintf(dev, sizeof(dev), "%03d:%03d", event->info->bus, event->info->address);
+        }
+    }
+    event->dev = dev;
+    event->t_ms = thingino_monotonic_ms();
+
+    if (ctx->event) {
+        ctx->event(ctx->user_data, event);
+    }
+    if (ctx->events_fd >= 0) {
+        events_json(ctx, event);
+    }
+}
+
+thingino_error_t thingino_events_open(thingino_context_t* ctx, const char* target) {
+    if (!ctx || !target || !target[0]) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    thingino_events_close(ctx);
+
+    const char* number = strncmp(target, "fd:", 3) == 0 ? target + 3 : target;
+    char* end = NULL;
+    long fd = strtol(number, &end, 10);
+    if (end != number && *end == '\0') {
+        if (fd < 0) {
+            return THINGINO_ERROR_INVALID_PARAMETER;
+        }
+        ctx->events_fd = (int)fd;
+        ctx->events_owned = false;
+    } else {
+        int opened = open(target, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (opened < 0) {
+            thingino_printf("[ERROR] Cannot open event stream %s: %s\n", target, strerror(errno));
+            return THINGINO_ERROR_FILE_IO;
+        }
+        ctx->events_fd = opened;
+        ctx->events_owned = true;
+    }
+    ctx->events_dropped = 0;
+    events_set_nonblocking(ctx->events_fd);
+
+    char line[EVENTS_LINE_MAX];
+    int len = snprintf(line, sizeof(line), "{\"t\":%llu,\"ev\":\"start\",\"wall\":%lld}",
+                       (unsigned long long)thingino_monotonic_ms(), (long long)time(NULL));
+    events_write(ctx, line, len);
+    return THINGINO_SUCCESS;
+}
+
+void thingino_events_close(thingino_context_t* ctx) {
+    if (!ctx) {
+        return;
+    }
+    if (ctx->events_owned && ctx->events_fd >= 0) {
+        close(ctx->events_fd);
+    }
+    ctx->events_fd = -1;
+    ctx->events_owned = false;
+}
+
+void thingino_event_device(const device_info_t* info) {
+    thingino_context_t* ctx = events_context();
+    if (!ctx || !info) {
+        return;
+    }
+    thingino_event_t event = { .type = THINGINO_EVENT_DEVICE, .info = info };
+    events_dispatch(ctx, &event);
+}
+
+void thingino_event_phase_begin(usb_device_t* device, const char* phase) {
+    if (device) {
+        device->event_phase_ms = thingino_monotonic_ms();
+        device->event_last_ms = 0;
+    }
+    int metrics_phase = metrics_phase_from_name(phase);
+    if (metrics_phase >= 0) {
+        metrics_phase_begin(events_metrics(), (metrics_phase_t)metrics_phase);
+    }
+    thingino_context_t* ctx = events_context();
+    if (!ctx) {
+        return;
+    }
+    thingino_event_t event = { .type = THINGINO_EVENT_PHASE_START, .device = device, .name = phase };
+    events_dispatch(ctx, &event);
+}
+
+void thingino_event_phase_end(usb_device_t* device, const char* phase, thingino_error_t result) {
+    uint64_t ms = device && device->event_phase_ms ? thingino_monotonic_ms() - device->event_phase_ms : 0;
+    int metrics_phase = metrics_phase_from_name(phase);
+    if (metrics_phase >= 0) {
+        metrics_phase_end(events_metrics(), (metrics_phase_t)metrics_phase, ms * 1000, (int)result);
+    }
+    thingino_job_note_phase(device, phase, ms);
+
+    thingino_context_t* ctx = events_context();
+    if (!ctx) {
+        return;
+    }
+    thingino_event_t event = {
+        .type = THINGINO_EVENT_PHASE_END, .device = device, .name = phase, .ms = ms, .result = result
+    };
+    events_dispatch(ctx, &event);
+}
+
+void thingino_event_erase(const usb_device_t* device, uint64_t waited_ms) {
+    metrics_erase(events_metrics(), waited_ms * 1000);
+    thingino_context_t* ctx = events_context();
+    if (!ctx) {
+        return;
+    }
+    thingino_event_t event = { .type = THINGINO_EVENT_ERASE, .device = device, .ms = waited_ms };
+    events_dispatch(ctx, &event);
+}
+
+void thingino_event_retry(const usb_device_t* device, uint8_t request, const char* error,
+                          uint32_t attempt, uint32_t delay_ms) {
+    metrics_retry(events_metrics(), request);
+    thingino_job_note_retry();
+    thingino_context_t* ctx = events_context();
+    if (!ctx) {
+        return;
+    }
+    thingino_event_t event = {
+        .type = THINGINO_EVENT_RETRY, .device = device, .name = error, .request = request,
+        .attempt = attempt, .ms = delay_ms
+    };
+    events_dispatch(ctx, &event);
+}
+
+void thingino_event_chunk(const usb_device_t* device, bool write, uint32_t bytes,
+                          uint64_t latency_us) {
+    metrics_chunk(events_metrics(), write ? METRICS_WRITE : METRICS_READ,
+                  device ? device->info.bus : 0, bytes, latency_us);
+    thingino_job_note_bytes(bytes);
+}
+
+/**
+ * Report progress to the context's callback and, rate-limited, as events.
+ * For "bootstrap" done/total are steps, otherwise bytes.
+ */
+void thingino_progress(usb_device_t* device, const char* operation, uint64_t done, uint64_t total) {
+    thingino_context_t* ctx = thingino_context_current();
+    if (!ctx) {
+        return;
+    }
+    if (ctx->progress) {
+        ctx->progress(ctx->user_data, operation, done, total);
+    }
+    if (ctx->events_fd < 0 && !ctx->event) {
+        return;
+    }
+
+    thingino_event_t event = { .device = device, .name = operation, .done = done, .total = total };
+    if (strcmp(operation, "bootstrap") == 0) {
+        event.type = THINGINO_EVENT_STEP;
+        events_dispatch(ctx, &event);
+        return;
+    }
+
+    uint64_t now = thingino_monotonic_ms();
+    if (device && done < total && device->event_last_ms &&
+        now - device->event_last_ms < EVENTS_BYTES_INTERVAL_MS) {
+        return;
+    }
+    uint64_t elapsed = device && device->event_phase_ms ? now - device->event_phase_ms : 0;
+    if (device) {
+        device->event_last_ms = now;
+    }
+    event.type = THINGINO_EVENT_BYTES;
+    event.bps = elapsed ? done * 1000 / elapsed : 0;
+    events_dispatch(ctx, &event);
+}
@@ -0,0 +1,224 @@
+/**
+ * Fault Benchmark (--fault-bench)
+ *
+ * Runs simulated T31ZX bootstrap + write jobs under each fault profile and
+ * reports how long they take, how often they fail and whether any of them
+ * "succeeded" with the wrong data in flash. Everything runs against the
+ * simulated device in virtual time, so a few hundred jobs take seconds and
+ * the numbers do not depend on the host's load.
+ */
+
+#include "fault_inject.h"
+#include "sim_device.h"
+
+#define FAULT_BENCH_FLASH_SIZE  (2 * FAULT_BENCH_IMAGE_SIZE)
+#define FAULT_BENCH_TOP_ERRORS  16      // thingino_error_t 0 .. -15
+
+typedef struct {
+    uint32_t ok;
+    uint32_t failed;
+    uint32_t corrupt;               // Reported success, flash differs
+    uint64_t faults;
+    uint32_t errors[FAULT_BENCH_TOP_ERRORS];
+    uint64_t* job_us;
+} fault_bench_result_t;
+
+// Jobs run on the caller's thread under this context: their output would
+// drown the report, and they must not land in the real job history
+static void fault_bench_log(void* user_data, thingino_log_level_t level, const char* text) {
+    (void)user_data;
+    (void)level;
+    (void)text;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentile of a sorted array
+static uint64_t percentile(const uint64_t* sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static void fault_bench_job(const fault_profile_t* profile, uint32_t job, sim_device_t* sim,
+                            const firmware_files_t* files, const prepared_image_t* image,
+                            fault_bench_result_t* result) {
+    usb_device_t device;
+    fault_inject_t fi;
+    memset(sim->flash, 0xFF, sim->flash_size);
+    sim_device_init(sim);
+    sim_device_open(sim, &device, VARIANT_T31ZX);
+    fault_inject_attach(&fi, &device, profile, job);
+
+    bootstrap_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.sdram_address = BOOTLOADER_ADDRESS_SDRAM;
+    config.timeout = BOOTSTRAP_TIMEOUT_SECONDS;
+    config.files = files;
+
+    uint64_t start = thingino_monotonic_us();
+    thingino_error_t status = bootstrap_device(&device, &config);
+    if (status == THINGINO_SUCCESS) {
+        status = write_firmware_prepared(&device, image, NULL, false, false, 0);
+    }
+    result->job_us[job] = thingino_monotonic_us() - start;
+    usb_device_close(&device);
+
+    for (int k = FAULT_STALL; k < FAULT_KINDS; k++) {
+        result->faults += fi.state.injected[k];
+    }
+    if (status != THINGINO_SUCCESS) {
+        result->failed++;
+        int slot = -status < FAULT_BENCH_TOP_ERRORS ? -status : FAULT_BENCH_TOP_ERRORS - 1;
+        result->errors[slot]++;
+    } else if (memcmp(sim->flash, image->image.data, image->image.size) != 0) {
+        result->corrupt++;
+    } else {
+        result->ok++;
+    }
+}
+
+static void fault_bench_report(const char* name, uint32_t jobs, fault_bench_result_t* result) {
+    qsort(result->job_us, jobs, sizeof(uint64_t), compare_u64);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < jobs; i++) {
+        sum += result->job_us[i];
+    }
+
+    int top = 0;
+    for (int slot = 1; slot < FAULT_BENCH_TOP_ERRORS; slot++) {
+        if (result->errors[slot] > result->errors[top]) {
+            top = slot;
+        }
+    }
+
+    thingino_printf("%-16.16s %4u %5u %4u %7.1fs %7.1fs %7.1fs %7.1fs %7.1fs %7llu  %s\n",
+           name, result->ok, result->failed, result->corrupt,
+           (double)sum / jobs / 1e6,
+           percentile(result->job_us, jobs, 50) / 1e6,
+           percentile(result->job_us, jobs, 90) / 1e6,
+           percentile(result->job_us, jobs, 99) / 1e6,
+           result->job_us[jobs - 1] / 1e6,
+           (unsigned long long)result->faults,
+           top ? thingino_error_to_string((thingino_error_t)-top) : "-");
+}
+
+thingino_error_t fault_bench_run(const char* const* specs, int count, uint32_t jobs) {
+    if (jobs == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    // Parse everything first: a typo should not cost a long run
+    int profile_count = 0;
+    if (!specs || count <= 0) {
+        while (fault_profile_builtin((size_t)profile_count)) {
+            profile_count++;
+        }
+    } else {
+        profile_count = count;
+    }
+    fault_profile_t* profiles = (fault_profile_t*)calloc((size_t)profile_count, sizeof(fault_profile_t));
+    if (!profiles) {
+        return THINGINO_ERROR_MEMORY;
+    }
+    for (int i = 0; i < profile_count; i++) {
+        const char* spec = specs && count > 0 ? specs[i] : fault_profile_builtin((size_t)i);
+        char error[128];
+        if (fault_profile_parse(spec, &profiles[i], error, sizeof(error)) != 0) {
+            thingino_printf("[ERROR] Bad fault profile: %s\n", error);
+            free(profiles);
+            return THINGINO_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    thingino_context_t quiet;
+    memset(&quiet, 0, sizeof(quiet));
+    quiet.log = fault_bench_log;
+    quiet.events_fd = -1;
+
+    firmware_files_t files;
+    thingino_context_t* saved_ctx = thingino_context_bind(&quiet);
+    thingino_error_t status = firmware_load(VARIANT_T31ZX, &files);
+    thingino_context_bind(saved_ctx);
+    if (status != THINGINO_SUCCESS) {
+        free(profiles);
+        return status;
+    }
+
+    sim_device_t sim;
+    memset(&sim, 0, sizeof(sim));
+    uint8_t* image_data = (uint8_t*)malloc(FAULT_BENCH_IMAGE_SIZE);
+    sim.flash = (uint8_t*)malloc(FAULT_BENCH_FLASH_SIZE);
+    sim.flash_size = FAULT_BENCH_FLASH_SIZE;
+    fault_bench_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.job_us = (uint64_t*)calloc(jobs, sizeof(uint64_t));
+    if (!image_data || !sim.flash || !result.job_us || sim_device_init(&sim) != THINGINO_SUCCESS) {
+        status = THINGINO_ERROR_MEMORY;
+        goto out;
+    }
+
+    uint32_t seed = 0x2545F491;
+    for (uint32_t i = 0; i < FAULT_BENCH_IMAGE_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        image_data[i] = (uint8_t)(seed >> 16);
+    }
+    // Heap image borrowed for the run; never closed
+    prepared_image_t image;
+    memset(&image, 0, sizeof(image));
+    image.image.data = image_data;
+    image.image.size = FAULT_BENCH_IMAGE_SIZE;
+
+    thingino_printf("Fault benchmark: %u simulated t31zx jobs per profile "
+                    "(bootstrap + %u KB write), virtual time\n\n",
+                    jobs, FAULT_BENCH_IMAGE_SIZE / 1024);
+    thingino_printf("%-16s %4s %5s %4s %8s %8s %8s %8s %8s %7s  %s\n", "Profile", "OK", "Fail",
+                    "Bad", "Mean", "p50", "p90", "p99", "Max", "Faults", "Top error");
+
+    thingino_virtual_clock_t clock;
+    thingino_virtual_clock_init(&clock, 0);
+    sim.clock = &clock;
+    thingino_clock_t* saved_clock = thingino_clock_get();
+    uint64_t wall_start = thingino_real_now_us();
+    uint32_t corrupt = 0;
+
+    for (int p = 0; p < profile_count; p++) {
+        memset(result.errors, 0, sizeof(result.errors));
+        result.ok = result.failed = result.corrupt = 0;
+        result.faults = 0;
+
+        saved_ctx = thingino_context_bind(&quiet);
+        thingino_clock_set(&clock.base);
+        for (uint32_t job = 0; job < jobs; job++) {
+            fault_bench_job(&profiles[p], job, &sim, &files, &image, &result);
+        }
+        thingino_clock_set(saved_clock);
+        thingino_context_bind(saved_ctx);
+
+        fault_bench_report(profiles[p].name, jobs, &result);
+        corrupt += result.corrupt;
+    }
+
+    thingino_printf("\nBad = reported success with wrong flash contents. "
+                    "%u jobs in %.1f s wall time.\n", jobs * (uint32_t)profile_count,
+                    (thingino_real_now_us() - wall_start) / 1e6);
+
+    // Failing under faults is expected; silent corruption never is
+    status = THINGINO_SUCCESS;
+    if (corrupt > 0) {
+        thingino_printf("[ERROR] %u job(s) reported success with wrong flash contents\n", corrupt);
+        status = THINGINO_ERROR_PROTOCOL;
+    }
+
+out:
+    sim_device_cleanup(&sim);
+    free(result.job_us);
+    free(sim.flash);
+    free(image_data);
+    firmware_cleanup(&files);
+    free(profiles);
+    return status;
+}
@@ -0,0 +1,153 @@
+/**
+ * Transfer Benchmark (--bench)
+ *
+ * Sweeps read chunk sizes and inter-chunk delays against a firmware-stage
+ * device, reports throughput and error rate for each working point and
+ * stores the fastest error-free point as the transfer profile for the
+ * device's (variant, flash chip). The reader picks that profile up
+ * automatically on the next run.
+ *
+ * Only the read path is swept: it is non-destructive, and write chunking is
+ * bounded by the burner's receive buffer rather than by link throughput.
+ * Write chunk size and settle time keep their built-in defaults, or
+ * whatever a stored profile already holds for them.
+ */
+
+#include "thingino.h"
+
+#define BENCH_MAX_ERRORS 3
+
+static const uint32_t bench_chunk_sizes[] = {
+    64 * 1024, 128 * 1024, 256 * 1024, 512 * 1024, 1024 * 1024
+};
+
+static const uint32_t bench_delays_ms[] = { 0, 20, 50 };
+
+typedef struct {
+    uint32_t chunk_size;
+    uint32_t delay_ms;
+    uint32_t bytes_ok;
+    uint32_t attempts;
+    uint32_t errors;
+    double mbps;
+} bench_point_t;
+
+static void bench_run_point(usb_device_t* device, uint8_t* buffer, uint32_t bytes_per_point,
+                            bench_point_t* pt) {
+    uint64_t start = thingino_monotonic_ms();
+
+    for (uint32_t offset = 0; offset + pt->chunk_size <= bytes_per_point; offset += pt->chunk_size) {
+        pt->attempts++;
+        thingino_error_t result = firmware_read_bank_into(device, offset, pt->chunk_size, buffer);
+
+        if (result != THINGINO_SUCCESS) {
+            pt->errors++;
+            if (pt->errors >= BENCH_MAX_ERRORS) {
+                break;
+            }
+        } else {
+            pt->bytes_ok += pt->chunk_size;
+        }
+
+        if (pt->delay_ms > 0) {
+            thingino_sleep_milliseconds(pt->delay_ms);
+        }
+    }
+
+    uint64_t elapsed_ms = thingino_monotonic_ms() - start;
+    pt->mbps = elapsed_ms > 0 ? (pt->bytes_ok / (1024.0 * 1024.0)) / (elapsed_ms / 1000.0) : 0.0;
+}
+
+/**
+ * Run the chunk-size/delay sweep. bytes_per_point is read from flash offset
+ * 0 for every working point and must be at least 1MB.
+ */
+thingino_error_t firmware_bench_run(usb_device_t* device, uint32_t bytes_per_point, bool save_profile) {
+    if (!device || bytes_per_point < 1024 * 1024) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    const char* variant = processor_variant_to_string(device->info.variant);
+    const char* flash = device->info.flash_chip[0] ? device->info.flash_chip
+                                                   : TRANSFER_PROFILE_FLASH_DEFAULT;
+
+    thingino_printf("Benchmarking read path for %s/%s (%u KB per point)...\n",
+           variant, flash, bytes_per_point / 1024);
+
+    thingino_error_t result = firmware_read_prepare(device);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    size_t n_chunks = sizeof(bench_chunk_sizes) / sizeof(bench_chunk_sizes[0]);
+    size_t n_delays = sizeof(bench_delays_ms) / sizeof(bench_delays_ms[0]);
+
+    // One receive buffer sized for the largest chunk, reused for every read
+    // so allocation stays out of the measured loop
+    usb_buffer_pool_t pool;
+    result = usb_buffer_pool_init(&pool, device, bench_chunk_sizes[n_chunks - 1], 1);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+    uint8_t* buffer = usb_buffer_pool_acquire(&pool);
+
+    const bench_point_t* best = NULL;
+    bench_point_t points[sizeof(bench_chunk_sizes) / sizeof(bench_chunk_sizes[0]) *
+                         sizeof(bench_delays_ms) / sizeof(bench_delays_ms[0])];
+
+    thingino_printf("\n%10s %8s %10s %8s\n", "Chunk", "Delay", "MB/s", "Errors");
+    thingino_printf("%10s %8s %10s %8s\n", "----------", "--------", "----------", "--------");
+
+    for (size_t c = 0; c < n_chunks; c++) {
+        for (size_t d = 0; d < n_delays; d++) {
+            bench_point_t* pt = &points[c * n_delays + d];
+            memset(pt, 0, sizeof(*pt));
+            pt->chunk_size = bench_chunk_sizes[c];
+            pt->delay_ms = bench_delays_ms[d];
+
+            bench_run_point(device, buffer, bytes_per_point, pt);
+
+            thingino_printf("%8u K %6u ms %10.2f %4u/%-3u\n", pt->chunk_size / 1024, pt->delay_ms,
+                   pt->mbps, pt->errors, pt->attempts);
+
+            if (pt->errors == 0 && pt->attempts > 0 && (!best || pt->mbps > best->mbps)) {
+                best = pt;
+            }
+        }
+    }
+
+    usb_buffer_pool_release(&pool, buffer);
+    usb_buffer_pool_destroy(&pool);
+
+    if (!best) {
+        thingino_printf("\n[ERROR] No working point completed without errors\n");
+        return THINGINO_ERROR_TRANSFER_FAILED;
+    }
+
+    thingino_printf("\nBest working point: %u KB chunks, %u ms delay, %.2f MB/s\n",
+           best->chunk_size / 1024, best->delay_ms, best->mbps);
+
+    if (!save_profile) {
+        return THINGINO_SUCCESS;
+    }
+
+    // Keep any write tuning already stored for this (variant, flash)
+    transfer_profile_t tp;
+    if (!transfer_profile_lookup(variant, flash, &tp) || strcmp(tp.flash, flash) != 0) {
+        memset(&tp, 0, sizeof(tp));
+    }
+    snprintf(tp.variant, sizeof(tp.variant), "%s", variant);
+    snprintf(tp.flash, sizeof(tp.flash), "%s", flash);
+    tp.read_chunk_size = best->chunk_size;
+    tp.read_delay_ms = best->delay_ms;
+    tp.read_mbps = best->mbps;
+
+    char path[512];
+    if (transfer_profile_store(&tp) != 0 || transfer_profile_path(path, sizeof(path)) != 0) {
+        thingino_printf("[ERROR] Failed to save transfer profile\n");
+        return THINGINO_ERROR_FILE_IO;
+    }
+
+    thingino_printf("Saved transfer profile to %s\n", path);
+    return THINGINO_SUCCESS;
+}
@@ -0,0 +1,278 @@
+#include "burner_log.h"
+
+#include <ctype.h>
+#include <string.h>
+
+// ============================================================================
+// BURNER LOG DECODER IMPLEMENTATION
+// ============================================================================
+//
+// Deliberately self-contained (no thingino.h) so that it can be unit tested
+// without libusb. Classification is keyword based because the burner text is
+// not a stable format across vendor U-Boot releases; every rule requires a
+// subject keyword plus an outcome keyword so ordinary chatter is ignored.
+
+static const char* const burner_fail_words[] = {
+    "fail", "failed", "failure", "error", "err", "mismatch", "bad", NULL
+};
+
+static const char* const burner_ok_words[] = {
+    "ok", "okay", "pass", "passed", "done", "success", "successful",
+    "finish", "finished", "complete", "completed", NULL
+};
+
+static int is_word_char(char c) {
+    return isalpha((unsigned char)c);
+}
+
+// Find word in a lower-case line. A word must not be glued to other letters,
+// but digits are allowed on either side ("policy0", "crc32").
+static const char* find_word(const char* line, const char* word) {
+    size_t word_len = strlen(word);
+    const char* p = line;
+
+    while ((p = strstr(p, word)) != NULL) {
+        bool start_ok = (p == line) || !is_word_char(p[-1]);
+        bool end_ok = !is_word_char(p[word_len]);
+        if (start_ok && end_ok) {
+            return p;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+static bool has_any_word(const char* line, const char* const* words) {
+    for (size_t i = 0; words[i]; i++) {
+        if (find_word(line, words[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse a signed decimal or 0x-prefixed hex number after skipping separators.
+// Returns false if no number follows within a few characters.
+static bool parse_number_after(const char* p, int32_t* value) {
+    int skipped = 0;
+    while (*p && (*p == ' ' || *p == '=' || *p == ':' || *p == '#' || *p == '\t') && skipped < 8) {
+        p++;
+        skipped++;
+    }
+
+    bool negative = false;
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+
+    int base = 10;
+    if (p[0] == '0' && p[1] == 'x') {
+        base = 16;
+        p += 2;
+    }
+
+    if (!isxdigit((unsigned char)*p) || (base == 10 && !isdigit((unsigned char)*p))) {
+        return false;
+    }
+
+    int64_t acc = 0;
+    while (*p) {
+        int digit;
+        if (isdigit((unsigned char)*p)) {
+            digit = *p - '0';
+        } else if (base == 16 && *p >= 'a' && *p <= 'f') {
+            digit = *p - 'a' + 10;
+        } else {
+            break;
+        }
+        acc = acc * base + digit;
+        if (acc > INT32_MAX) {
+            acc = INT32_MAX;
+        }
+        p++;
+    }
+
+    *value = (int32_t)(negative ? -acc : acc);
+    return true;
+}
+
+// Pick up "chunk N" / "policyN" style indices for write/program lines
+static int32_t parse_chunk_index(const char* line) {
+    static const char* const index_words[] = { "chunk", "block", "policy", NULL };
+    int32_t value;
+
+    for (size_t i = 0; index_words[i]; i++) {
+        const char* p = strstr(line, index_words[i]);
+        if (p && parse_number_after(p + strlen(index_words[i]), &value) && value >= 0) {
+            return value;
+        }
+    }
+
+    return -1;
+}
+
+static bool burner_log_push(burner_log_t* log, burner_event_type_t type, int32_t value) {
+    if (log->tail - log->head >= BURNER_EVENT_QUEUE_SIZE) {
+        log->dropped++;
+        return false;
+    }
+
+    burner_event_t* ev = &log->events[log->tail & (BURNER_EVENT_QUEUE_SIZE - 1)];
+    ev->type = type;
+    ev->value = value;
+    ev->line_no = log->lines_seen;
+    log->tail++;
+    return true;
+}
+
+// Classify one complete, lower-cased line. Rule order matters: hard failures
+// (trap, ack error) win over anything else reported on the same line.
+static size_t burner_log_classify(burner_log_t* log, const char* line) {
+    if (find_word(line, "trap") || find_word(line, "exception")) {
+        return burner_log_push(log, BURNER_EVENT_TRAP, -1) ? 1 : 0;
+    }
+
+    const char* ack = find_word(line, "ack");
+    if (ack) {
+        int32_t code;
+        if (parse_number_after(ack + 3, &code) && code < 0) {
+            return burner_log_push(log, BURNER_EVENT_ACK_ERROR, code) ? 1 : 0;
+        }
+    }
+
+    if (find_word(line, "crc")) {
+        if (has_any_word(line, burner_fail_words)) {
+            return burner_log_push(log, BURNER_EVENT_CRC_FAIL, parse_chunk_index(line)) ? 1 : 0;
+        }
+        if (has_any_word(line, burner_ok_words)) {
+            return burner_log_push(log, BURNER_EVENT_CRC_OK, parse_chunk_index(line)) ? 1 : 0;
+        }
+    }
+
+    if (find_word(line, "erase") && has_any_word(line, burner_ok_words) &&
+        !has_any_word(line, burner_fail_words)) {
+        return burner_log_push(log, BURNER_EVENT_ERASE_DONE, -1) ? 1 : 0;
+    }
+
+    if (strstr(line, "all policy completed")) {
+        return burner_log_push(log, BURNER_EVENT_POLICY_DONE, -1) ? 1 : 0;
+    }
+
+    if (find_word(line, "write") || find_word(line, "program") || find_word(line, "programmed")) {
+        if (has_any_word(line, burner_fail_words)) {
+            return burner_log_push(log, BURNER_EVENT_WRITE_FAIL, parse_chunk_index(line)) ? 1 : 0;
+        }
+        if (has_any_word(line, burner_ok_words) || find_word(line, "programmed")) {
+            return burner_log_push(log, BURNER_EVENT_CHUNK_DONE, parse_chunk_index(line)) ? 1 : 0;
+        }
+    }
+
+    return 0;
+}
+
+void burner_log_init(burner_log_t* log) {
+    if (!log) {
+        return;
+    }
+    memset(log, 0, sizeof(*log));
+}
+
+size_t burner_log_feed(burner_log_t* log, const uint8_t* data, size_t len) {
+    if (!log || !data) {
+        return 0;
+    }
+
+    size_t events = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+
+        if (c == '\0' || c == '\r') {
+            continue;
+        }
+
+        if (c == '\n') {
+            if (log->line_len > 0) {
+                log->line[log->line_len] = '\0';
+                log->lines_seen++;
+                events += burner_log_classify(log, log->line);
+            }
+            log->line_len = 0;
+            continue;
+        }
+
+        // Keep the head of over-long lines; the keywords we care about are
+        // always near the start.
+        if (log->line_len < BURNER_LOG_LINE_MAX - 1) {
+            log->line[log->line_len++] = (char)tolower((unsigned char)c);
+        }
+    }
+
+    return events;
+}
+
+bool burner_log_pop(burner_log_t* log, burner_event_t* event) {
+    if (!log || log->head == log->tail) {
+        return false;
+    }
+
+    burner_event_t* ev = &log->events[log->head & (BURNER_EVENT_QUEUE_SIZE - 1)];
+    if (event) {
+        *event = *ev;
+    }
+    log->head++;
+    return true;
+}
+
+bool burner_log_pop_match(burner_log_t* log, uint32_t mask, burner_event_t* event) {
+    burner_event_t ev;
+
+    while (burner_log_pop(log, &ev)) {
+        if (mask & BURNER_EVENT_MASK(ev.type)) {
+            if (event) {
+                *event = ev;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool burner_log_pop_chunk(burner_log_t* log, uint32_t mask, int32_t chunk, burner_event_t* event) {
+    burner_event_t ev;
+
+    while (burner_log_pop_match(log, mask, &ev)) {
+        bool failure = (BURNER_EVENT_MASK(ev.type) & BURNER_EVENT_MASK_FAILURE) != 0;
+        if (failure || chunk < 0 || ev.value < 0 || ev.value == chunk) {
+            if (event) {
+                *event = ev;
+            }
+            return true;
+        }
+        log->stale++;
+    }
+
+    return false;
+}
+
+uint32_t burner_log_pending(const burner_log_t* log) {
+    return log ? log->tail - log->head : 0;
+}
+
+const char* burner_event_type_to_string(burner_event_type_t type) {
+    switch (type) {
+        case BURNER_EVENT_NONE:        return "none";
+        case BURNER_EVENT_CHUNK_DONE:  return "chunk-done";
+        case BURNER_EVENT_WRITE_FAIL:  return "write-fail";
+        case BURNER_EVENT_CRC_OK:      return "crc-ok";
+        case BURNER_EVENT_CRC_FAIL:    return "crc-fail";
+        case BURNER_EVENT_ERASE_DONE:  return "erase-done";
+        case BURNER_EVENT_ACK_ERROR:   return "ack-error";
+        case BURNER_EVENT_TRAP:        return "trap";
+        case BURNER_EVENT_POLICY_DONE: return "policy-done";
+        default:                       return "unknown";
+    }
+}
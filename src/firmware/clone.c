@@ -0,0 +1,329 @@
+/**
+ * Device-to-Device Clone (--clone-from / --to)
+ *
+ * Reads the source device's flash bank by bank into a small ring of shared
+ * buffers and streams every bank to all target devices at once, without an
+ * intermediate file. The source read runs on the calling thread and each
+ * target gets its own writer thread, so reading bank N+1 overlaps with the
+ * targets programming bank N, and the targets program in parallel. Cloning
+ * one unit onto a batch costs roughly one read plus one write.
+ *
+ * A bank stays in the ring until every target has consumed it, which bounds
+ * memory to CLONE_RING_SLOTS banks and paces the source to the slowest
+ * target. A target that fails keeps draining the ring without writing so
+ * the others are not held up.
+ */
+
+#include "thingino.h"
+#include <pthread.h>
+
+#define CLONE_RING_SLOTS 4
+
+typedef struct {
+    uint8_t* data;
+    uint32_t size;
+    uint32_t seq;           // Bank sequence number held in this slot
+    int pending;            // Targets that have not consumed it yet
+    bool filled;
+} clone_slot_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    clone_slot_t slots[CLONE_RING_SLOTS];
+    uint32_t bank_count;
+    uint32_t total_size;
+    int target_count;
+    int writers_alive;      // Targets still writing (not failed or finished)
+    thingino_error_t source_error;
+} clone_ring_t;
+
+typedef struct {
+    clone_ring_t* ring;
+    clone_target_t* target;
+    thingino_context_t* context;    // Caller's, bound in the writer thread
+} clone_worker_t;
+
+// Wait for bank seq to be published; NULL if the source failed
+static const clone_slot_t* clone_ring_wait(clone_ring_t* ring, uint32_t seq) {
+    clone_slot_t* slot = &ring->slots[seq % CLONE_RING_SLOTS];
+
+    pthread_mutex_lock(&ring->lock);
+    while (!(slot->filled && slot->seq == seq) && ring->source_error == THINGINO_SUCCESS) {
+        pthread_cond_wait(&ring->cond, &ring->lock);
+    }
+    bool ok = slot->filled && slot->seq == seq;
+    pthread_mutex_unlock(&ring->lock);
+
+    return ok ? slot : NULL;
+}
+
+static void clone_ring_release(clone_ring_t* ring, uint32_t seq) {
+    clone_slot_t* slot = &ring->slots[seq % CLONE_RING_SLOTS];
+
+    pthread_mutex_lock(&ring->lock);
+    if (--slot->pending == 0) {
+        slot->filled = false;
+        pthread_cond_broadcast(&ring->cond);
+    }
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void clone_writer_failed(clone_worker_t* w, thingino_error_t result) {
+    thingino_printf("[ERROR] %s\n", thingino_error_to_string(result));
+    w->target->result = result;
+
+    pthread_mutex_lock(&w->ring->lock);
+    w->ring->writers_alive--;
+    pthread_cond_broadcast(&w->ring->cond);
+    pthread_mutex_unlock(&w->ring->lock);
+}
+
+static void* clone_writer_thread(void* arg) {
+    clone_worker_t* w = (clone_worker_t*)arg;
+    thingino_context_bind(w->context);
+    clone_ring_t* ring = w->ring;
+    clone_target_t* target = w->target;
+    thingino_log_set_tag(target->label);
+    thingino_job_begin(NULL);
+    thingino_event_phase_begin(target->device, "write");
+    uint8_t* staging = NULL;
+    uint32_t staged = 0;
+    bool writing = true;
+
+    firmware_write_session_t session = { .label = NULL };  // The thread tag names the target
+    thingino_error_t result = firmware_write_begin(&session, target->device, NULL,
+                                                   target->is_a1, ring->total_size);
+    if (result == THINGINO_SUCCESS) {
+        // Write chunks that straddle two banks are assembled here
+        staging = (uint8_t*)malloc(session.profile.chunk_size);
+        if (!staging) {
+            result = THINGINO_ERROR_MEMORY;
+        }
+    }
+    if (result != THINGINO_SUCCESS) {
+        clone_writer_failed(w, result);
+        writing = false;
+    }
+
+    for (uint32_t seq = 0; seq < ring->bank_count; seq++) {
+        const clone_slot_t* slot = clone_ring_wait(ring, seq);
+        if (!slot) {
+            if (writing) {
+                target->result = ring->source_error;
+                writing = false;
+            }
+            break;
+        }
+
+        uint32_t pos = 0;
+        while (writing && pos < slot->size) {
+            uint32_t chunk = session.profile.chunk_size;
+            if (session.bytes_written + chunk > ring->total_size) {
+                chunk = ring->total_size - session.bytes_written;
+            }
+
+            if (staged == 0 && slot->size - pos >= chunk) {
+                result = firmware_write_chunk(&session, slot->data + pos, chunk, NULL);
+                pos += chunk;
+            } else {
+                uint32_t take = chunk - staged;
+                if (take > slot->size - pos) {
+                    take = slot->size - pos;
+                }
+                memcpy(staging + staged, slot->data + pos, take);
+                staged += take;
+                pos += take;
+                if (staged < chunk) {
+                    continue;
+                }
+                result = firmware_write_chunk(&session, staging, chunk, NULL);
+                staged = 0;
+            }
+
+            if (result != THINGINO_SUCCESS) {
+                clone_writer_failed(w, result);
+                writing = false;
+            }
+        }
+
+        clone_ring_release(ring, seq);
+    }
+
+    if (writing) {
+        target->result = firmware_write_end(&session);
+        pthread_mutex_lock(&ring->lock);
+        ring->writers_alive--;
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    thingino_event_phase_end(target->device, "write", target->result);
+    thingino_job_end(target->result);
+    free(staging);
+    return NULL;
+}
+
+/**
+ * Clone the source device's flash onto every target. All devices must be in
+ * firmware stage; the source is put into read mode and the targets into
+ * write mode here. Per-target outcomes are left in targets[i].result.
+ *
+ * @return THINGINO_SUCCESS if every target was written
+ */
+thingino_error_t firmware_clone(usb_device_t* source, clone_target_t* targets, int target_count) {
+    if (!source || !targets || target_count <= 0 || target_count > CLONE_MAX_TARGETS) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    // Nothing has been written until a writer finishes
+    for (int i = 0; i < target_count; i++) {
+        targets[i].result = THINGINO_ERROR_TRANSFER_FAILED;
+    }
+
+    thingino_printf("Preparing source for reading...\n");
+    thingino_error_t result = firmware_read_prepare(source);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    firmware_read_config_t config;
+    result = firmware_read_init(source, &config);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    int ready = 0;
+    for (int i = 0; i < target_count; i++) {
+        thingino_printf("Preparing %s for writing...\n", targets[i].label);
+        targets[i].result = firmware_write_prepare(targets[i].device, &targets[i].is_a1);
+        if (targets[i].result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] %s: %s\n", targets[i].label, thingino_error_to_string(targets[i].result));
+        } else {
+            ready++;
+        }
+    }
+    if (ready == 0) {
+        firmware_read_cleanup(&config);
+        return THINGINO_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    clone_ring_t ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.bank_count = (uint32_t)config.bank_count;
+    ring.total_size = config.total_size;
+    ring.target_count = ready;
+    ring.writers_alive = ready;
+
+    uint32_t bank_size = config.banks[0].size;
+    usb_buffer_pool_t pool;
+    result = usb_buffer_pool_init(&pool, source, bank_size, CLONE_RING_SLOTS);
+    if (result != THINGINO_SUCCESS) {
+        firmware_read_cleanup(&config);
+        return result;
+    }
+    for (int i = 0; i < CLONE_RING_SLOTS; i++) {
+        ring.slots[i].data = usb_buffer_pool_acquire(&pool);
+    }
+
+    pthread_mutex_init(&ring.lock, NULL);
+    pthread_cond_init(&ring.cond, NULL);
+
+    thingino_printf("Cloning %u bytes onto %d target(s) (%u KB banks, %d in flight)...\n",
+           config.total_size, ready, bank_size / 1024, CLONE_RING_SLOTS);
+
+    clone_worker_t workers[CLONE_MAX_TARGETS];
+    pthread_t threads[CLONE_MAX_TARGETS];
+    bool started[CLONE_MAX_TARGETS] = { false };
+
+    for (int i = 0; i < target_count; i++) {
+        if (targets[i].result != THINGINO_SUCCESS) {
+            continue;
+        }
+        workers[i].ring = &ring;
+        workers[i].target = &targets[i];
+        workers[i].context = thingino_context_current();
+        if (pthread_create(&threads[i], NULL, clone_writer_thread, &workers[i]) != 0) {
+            targets[i].result = THINGINO_ERROR_MEMORY;
+            pthread_mutex_lock(&ring.lock);
+            ring.target_count--;
+            ring.writers_alive--;
+            pthread_mutex_unlock(&ring.lock);
+            continue;
+        }
+        started[i] = true;
+    }
+
+    uint64_t start_ms = thingino_monotonic_ms();
+
+    for (uint32_t seq = 0; seq < ring.bank_count; seq++) {
+        clone_slot_t* slot = &ring.slots[seq % CLONE_RING_SLOTS];
+        flash_bank_t* bank = &config.banks[seq];
+
+        // Wait for the slot to drain (or for every writer to give up)
+        pthread_mutex_lock(&ring.lock);
+        while (slot->filled && ring.writers_alive > 0) {
+            pthread_cond_wait(&ring.cond, &ring.lock);
+        }
+        bool abandon = ring.writers_alive == 0;
+        if (abandon) {
+            // Failed writers are still draining the ring; release them
+            ring.source_error = THINGINO_ERROR_TRANSFER_FAILED;
+            pthread_cond_broadcast(&ring.cond);
+        }
+        pthread_mutex_unlock(&ring.lock);
+        if (abandon) {
+            thingino_printf("[ERROR] All targets failed, stopping source read\n");
+            result = THINGINO_ERROR_TRANSFER_FAILED;
+            break;
+        }
+
+        // The slot is not published, so no writer touches it while reading
+        result = firmware_read_bank_into(source, bank->offset, bank->size, slot->data);
+
+        pthread_mutex_lock(&ring.lock);
+        if (result != THINGINO_SUCCESS) {
+            ring.source_error = result;
+        } else {
+            slot->size = bank->size;
+            slot->seq = seq;
+            slot->pending = ring.target_count;
+            slot->filled = true;
+        }
+        pthread_cond_broadcast(&ring.cond);
+        pthread_mutex_unlock(&ring.lock);
+
+        if (result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] Source read failed at bank %u: %s\n", seq, thingino_error_to_string(result));
+            break;
+        }
+
+        thingino_printf("Source: read bank %u/%u\n", seq + 1, ring.bank_count);
+
+        if (config.bank_delay_ms > 0) {
+            thingino_sleep_milliseconds(config.bank_delay_ms);
+        }
+    }
+
+    for (int i = 0; i < target_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    uint64_t elapsed_ms = thingino_monotonic_ms() - start_ms;
+
+    pthread_cond_destroy(&ring.cond);
+    pthread_mutex_destroy(&ring.lock);
+    usb_buffer_pool_destroy(&pool);
+    firmware_read_cleanup(&config);
+
+    thingino_error_t overall = result;
+    for (int i = 0; i < target_count; i++) {
+        if (targets[i].result != THINGINO_SUCCESS && overall == THINGINO_SUCCESS) {
+            overall = targets[i].result;
+        }
+    }
+
+    thingino_printf("\nClone finished in %.1f s\n", elapsed_ms / 1000.0);
+    return overall;
+}
@@ -8,6 +8,7 @@
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 // Firmware registry table
 typedef struct {
@@ -34,17 +35,28 @@ static const firmware_registry_entry_t firmware_registry[] = {
     {"t41", firmware_t41_get_spl, firmware_t41_get_uboot},
 };
 
+#define FIRMWARE_COUNT (sizeof(firmware_registry) / sizeof(firmware_registry[0]))
+
+// Resolved once, read-only afterwards: safe to share between threads
+static firmware_binary_t firmware_table[FIRMWARE_COUNT];
+static pthread_once_t firmware_table_once = PTHREAD_ONCE_INIT;
+
+static void firmware_table_build(void) {
+    for (size_t i = 0; i < FIRMWARE_COUNT; i++) {
+        firmware_table[i].processor = firmware_registry[i].processor;
+        firmware_table[i].spl_data = firmware_registry[i].get_spl(&firmware_table[i].spl_size);
+        firmware_table[i].uboot_data = firmware_registry[i].get_uboot(&firmware_table[i].uboot_size);
+    }
+}
+
 const firmware_binary_t* firmware_get(const char *processor) {
     if (!processor) return NULL;
 
-    static firmware_binary_t result;
+    pthread_once(&firmware_table_once, firmware_table_build);
 
-    for (size_t i = 0; i < sizeof(firmware_registry) / sizeof(firmware_registry[0]); i++) {
-        if (strcasecmp(firmware_registry[i].processor, processor) == 0) {
-            result.processor = firmware_registry[i].processor;
-            result.spl_data = firmware_registry[i].get_spl(&result.spl_size);
-            result.uboot_data = firmware_registry[i].get_uboot(&result.uboot_size);
-            return &result;
+    for (size_t i = 0; i < FIRMWARE_COUNT; i++) {
+        if (strcasecmp(firmware_table[i].processor, processor) == 0) {
+            return &firmware_table[i];
         }
     }
 
@@ -53,25 +65,11 @@ const firmware_binary_t* firmware_get(const char *processor) {
 
 const firmware_binary_t* firmware_list(size_t *count) {
     if (count) {
-        *count = sizeof(firmware_registry) / sizeof(firmware_registry[0]);
-    }
-
-    // Build array of firmware_binary_t on first call
-    static firmware_binary_t *list = NULL;
-    static size_t list_size = 0;
-
-    if (!list) {
-        list_size = sizeof(firmware_registry) / sizeof(firmware_registry[0]);
-        list = malloc(list_size * sizeof(firmware_binary_t));
-
-        for (size_t i = 0; i < list_size; i++) {
-            list[i].processor = firmware_registry[i].processor;
-            list[i].spl_data = firmware_registry[i].get_spl(&list[i].spl_size);
-            list[i].uboot_data = firmware_registry[i].get_uboot(&list[i].uboot_size);
-        }
+        *count = FIRMWARE_COUNT;
     }
 
-    return list;
+    pthread_once(&firmware_table_once, firmware_table_build);
+    return firmware_table;
 }
 
 int firmware_available(const char *processor) {
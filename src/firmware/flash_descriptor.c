@@ -155,7 +155,7 @@ thingino_error_t flash_partition_marker_send(usb_device_t *device) {
 
     uint8_t descriptor[FLASH_DESCRIPTOR_SIZE];
     if (flash_descriptor_create_t31x_writer_full(descriptor) != 0) {
-        printf("[ERROR] Failed to load T31x writer_full descriptor for partition marker\n");
+        thingino_printf("[ERROR] Failed to load T31x writer_full descriptor for partition marker\n");
         return THINGINO_ERROR_FILE_IO;
     }
 
@@ -167,8 +167,8 @@ thingino_error_t flash_partition_marker_send(usb_device_t *device) {
     DEBUG_PRINT("Sending partition marker (ILOP, %zu bytes)...\n", marker_size);
 
     int transferred = 0;
-    int result = libusb_bulk_transfer(
-        device->handle,
+    int result = usb_device_bulk_raw(
+        device,
         0x01, // Endpoint OUT 0x01 (same as vendor capture)
         (unsigned char*)(descriptor + marker_offset),
         (int)marker_size,
@@ -177,19 +177,19 @@ thingino_error_t flash_partition_marker_send(usb_device_t *device) {
     );
 
     if (result != 0) {
-        printf("[ERROR] Partition marker bulk transfer failed: %d (%s)\n",
+        thingino_printf("[ERROR] Partition marker bulk transfer failed: %d (%s)\n",
                result, libusb_error_name(result));
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     if (transferred != (int)marker_size) {
-        printf("[ERROR] Partition marker transfer incomplete: %d/%zu bytes\n",
+        thingino_printf("[ERROR] Partition marker transfer incomplete: %d/%zu bytes\n",
                transferred, marker_size);
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     // Short delay to let burner process the marker
-    usleep(100000); // 100ms
+    thingino_sleep_milliseconds(100); // 100ms
 
     DEBUG_PRINT("Partition marker sent successfully\n");
 
@@ -241,8 +241,8 @@ int flash_descriptor_create_t31x_writer_full(uint8_t *buffer) {
     }
 
     if (!f) {
-        printf("[ERROR] T31x writer_full descriptor file not found.\n");
-        printf("        Expected at tools/extracted_write_analysis/"
+        thingino_printf("[ERROR] T31x writer_full descriptor file not found.\n");
+        thingino_printf("        Expected at tools/extracted_write_analysis/"
                "bulk_out_0004_frame1623_972bytes.bin (relative to CWD).\n");
         return -1;
     }
@@ -251,7 +251,7 @@ int flash_descriptor_create_t31x_writer_full(uint8_t *buffer) {
     fclose(f);
 
     if (n != FLASH_DESCRIPTOR_SIZE) {
-        printf("[ERROR] Failed to read T31x writer_full descriptor from %s: "
+        thingino_printf("[ERROR] Failed to read T31x writer_full descriptor from %s: "
                "got %zu bytes, expected %d\n",
                path_used ? path_used : "(unknown)", n, FLASH_DESCRIPTOR_SIZE);
         return -1;
@@ -293,8 +293,8 @@ int flash_descriptor_create_a1_writer_full(uint8_t *buffer) {
     }
 
     if (!f) {
-        printf("[ERROR] A1 writer_full descriptor file not found.\n");
-        printf("        Expected at tools/usb_captures/a1_full_write_extracted/"
+        thingino_printf("[ERROR] A1 writer_full descriptor file not found.\n");
+        thingino_printf("        Expected at tools/usb_captures/a1_full_write_extracted/"
                "bulk_out_0004_frame1813_992bytes.bin (relative to CWD).\n");
         return -1;
     }
@@ -303,7 +303,7 @@ int flash_descriptor_create_a1_writer_full(uint8_t *buffer) {
     fclose(f);
 
     if (n != FLASH_DESCRIPTOR_SIZE) {
-        printf("[ERROR] Failed to read A1 writer_full descriptor from %s: "
+        thingino_printf("[ERROR] Failed to read A1 writer_full descriptor from %s: "
                "got %zu bytes, expected %d\n",
                path_used ? path_used : "(unknown)", n, FLASH_DESCRIPTOR_SIZE);
         return -1;
@@ -326,8 +326,8 @@ thingino_error_t flash_descriptor_send(usb_device_t *device, const uint8_t *desc
 
     // Step 1: Send control transfer with 40-byte header (bRequest=0x14)
     DEBUG_PRINT("Step 1: Sending control transfer (bRequest=0x14, 40 bytes)...\n");
-    int result = libusb_control_transfer(
-        device->handle,
+    int result = usb_device_control_raw(
+        device,
         0x40,           // bmRequestType: Host-to-device, Vendor, Device
         0x14,           // bRequest: 20 (0x14)
         0,              // wValue
@@ -338,20 +338,20 @@ thingino_error_t flash_descriptor_send(usb_device_t *device, const uint8_t *desc
     );
 
     if (result != 0x28) {
-        printf("[ERROR] Control transfer failed: %d (%s)\n", result, libusb_error_name(result));
+        thingino_printf("[ERROR] Control transfer failed: %d (%s)\n", result, libusb_error_name(result));
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     DEBUG_PRINT("Control transfer successful\n");
 
     // Step 2: Wait 100ms for device to process
-    usleep(100000);
+    thingino_sleep_milliseconds(100);
 
     // Step 3: Send full 972-byte structure via bulk OUT to endpoint 0x01
     DEBUG_PRINT("Step 2: Sending bulk OUT transfer (972 bytes to endpoint 0x01)...\n");
     int transferred = 0;
-    result = libusb_bulk_transfer(
-        device->handle,
+    result = usb_device_bulk_raw(
+        device,
         0x01,           // endpoint: 0x01 (OUT)
         (unsigned char*)descriptor,
         FLASH_DESCRIPTOR_SIZE,  // 972 bytes
@@ -360,19 +360,19 @@ thingino_error_t flash_descriptor_send(usb_device_t *device, const uint8_t *desc
     );
 
     if (result != 0) {
-        printf("[ERROR] Bulk transfer failed: %d (%s)\n", result, libusb_error_name(result));
+        thingino_printf("[ERROR] Bulk transfer failed: %d (%s)\n", result, libusb_error_name(result));
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     if (transferred != FLASH_DESCRIPTOR_SIZE) {
-        printf("[ERROR] Bulk transfer incomplete: %d/%d bytes\n", transferred, FLASH_DESCRIPTOR_SIZE);
+        thingino_printf("[ERROR] Bulk transfer incomplete: %d/%d bytes\n", transferred, FLASH_DESCRIPTOR_SIZE);
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     DEBUG_PRINT("Bulk transfer successful: %d bytes\n", transferred);
 
     // Step 4: Wait for device to process the descriptor
-    usleep(100000);
+    thingino_sleep_milliseconds(100);
 
     DEBUG_PRINT("Flash descriptor sent successfully\n");
 
@@ -32,56 +32,120 @@ static uint32_t parse_handshake_result(const firmware_handshake_t* hs) {
     return (uint32_t)hs->result_low | ((uint32_t)hs->result_high << 16);
 }
 
-// Compute CRC32 over a buffer (matches standard Ethernet CRC32)
-static uint32_t firmware_crc32(const uint8_t* data, uint32_t length) {
-    if (!data || length == 0) {
-        return 0;
+// ============================================================================
+// BURNER LOG EVENTS (bulk-IN 0x81)
+// ============================================================================
+
+/**
+ * Poll the burner log endpoint and feed whatever arrives into the device's
+ * log decoder. Each read uses a very short timeout, so this returns quickly
+ * when the burner has nothing to say.
+ *
+ * Returns THINGINO_ERROR_DEVICE_NOT_FOUND once the device is gone.
+ */
+thingino_error_t firmware_burner_log_poll(usb_device_t* device, int max_reads) {
+    if (!usb_device_is_open(device)) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    uint32_t crc = CRC32_INITIAL;
+    uint8_t buf[512];
+    int total = 0;
 
-    for (uint32_t i = 0; i < length; ++i) {
-        crc ^= data[i];
-        for (int bit = 0; bit < 8; ++bit) {
-            if (crc & 1) {
-                crc = (crc >> 1) ^ CRC32_POLYNOMIAL;
-            } else {
-                crc >>= 1;
-            }
+    for (int i = 0; i < max_reads; ++i) {
+        int transferred = 0;
+        uint64_t trace_start = thingino_trace_start();
+        int res = device->transport
+            ? device->transport->bulk(device->transport_data, ENDPOINT_IN, buf, sizeof(buf),
+                                      &transferred, 5)
+            : libusb_bulk_transfer(device->handle, ENDPOINT_IN, buf, sizeof(buf), &transferred, 5);
+        thingino_trace_bulk(device, trace_start, ENDPOINT_IN, buf, sizeof(buf), transferred, res);
+
+        // A timeout can still deliver a partial buffer
+        if (transferred > 0) {
+            burner_log_feed(&device->burner_log, buf, (size_t)transferred);
+            total += transferred;
+        }
+
+        if (res == LIBUSB_ERROR_NO_DEVICE) {
+            return THINGINO_ERROR_DEVICE_NOT_FOUND;
+        }
+        if (res != LIBUSB_SUCCESS && res != LIBUSB_ERROR_TIMEOUT && transferred <= 0) {
+            // Failed at once (e.g. a stalled log pipe): take the time a
+            // quiet read would, so callers waiting on the log cannot spin
+            thingino_sleep_milliseconds(5);
+        }
+        if (res != LIBUSB_SUCCESS || transferred <= 0) {
+            break;
         }
     }
 
-    return crc ^ 0xFFFFFFFF;
+    if (total > 0) {
+        DEBUG_PRINT("FW log: %d bytes, %u events pending\n",
+                    total, burner_log_pending(&device->burner_log));
+    }
+
+    return THINGINO_SUCCESS;
 }
 
-// Drain log messages from bulk IN endpoint(s) after a write chunk.
-// Vendor tool issues many IN transfers on 0x81/0x82 between chunks; we
-// approximate this by reading small chunks with short timeouts and
-// ignoring the contents.
-__attribute__((unused))
-static void firmware_drain_logs(usb_device_t* device, uint8_t endpoint, int max_reads)
-{
+/**
+ * Wait until the burner reports an event in mask for chunk (or any failure
+ * event), or until timeout_ms elapses. Older events that match neither, and
+ * mask events naming another chunk, are discarded. chunk -1 accepts any.
+ *
+ * Returns THINGINO_SUCCESS for a mask event, THINGINO_ERROR_PROTOCOL for a
+ * failure event and THINGINO_ERROR_TIMEOUT if the burner stayed silent.
+ * Burners that do not log at all therefore degrade to a plain timed wait.
+ */
+thingino_error_t firmware_burner_log_wait(usb_device_t* device, uint32_t mask, int32_t chunk,
+                                          int timeout_ms, burner_event_t* event) {
     if (!device) {
-        return;
+        return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    uint8_t buf[512];
-    int transferred = 0;
+    uint32_t wanted = mask | BURNER_EVENT_MASK_FAILURE;
+    uint64_t deadline = thingino_monotonic_ms() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0);
+    burner_event_t ev;
 
-    for (int i = 0; i < max_reads; ++i) {
-        thingino_error_t res = usb_device_bulk_transfer(device, endpoint,
-                                                        buf, sizeof(buf),
-                                                        &transferred, 10);
-        if (res != THINGINO_SUCCESS || transferred <= 0) {
-            break;
+    for (;;) {
+        uint32_t stale = device->burner_log.stale;
+        while (burner_log_pop_chunk(&device->burner_log, wanted, chunk, &ev)) {
+            if (event) {
+                *event = ev;
+            }
+
+            if (BURNER_EVENT_MASK(ev.type) & BURNER_EVENT_MASK_FAILURE) {
+                if (chunk >= 0 && ev.value >= 0 && ev.value != chunk) {
+                    thingino_printf("[ERROR] Burner reported %s for chunk %d while writing chunk %d (log line %u)\n",
+                           burner_event_type_to_string(ev.type), ev.value, chunk, ev.line_no);
+                } else {
+                    thingino_printf("[ERROR] Burner reported %s (value=%d, log line %u)\n",
+                           burner_event_type_to_string(ev.type), ev.value, ev.line_no);
+                }
+                return THINGINO_ERROR_PROTOCOL;
+            }
+
+            DEBUG_PRINT("Burner event: %s (value=%d)\n",
+                        burner_event_type_to_string(ev.type), ev.value);
+            if (BURNER_EVENT_MASK(ev.type) & mask) {
+                return THINGINO_SUCCESS;
+            }
+        }
+        if (device->burner_log.stale != stale) {
+            DEBUG_PRINT("Skipped %u burner report(s) for other chunks while waiting for chunk %d\n",
+                        device->burner_log.stale - stale, chunk);
         }
 
-        DEBUG_PRINT("FW log: ep=0x%02X, %d bytes\n", endpoint, transferred);
+        if (thingino_monotonic_ms() >= deadline) {
+            return THINGINO_ERROR_TIMEOUT;
+        }
+
+        thingino_error_t res = firmware_burner_log_poll(device, 4);
+        if (res != THINGINO_SUCCESS) {
+            return res;
+        }
     }
 }
 
-
-
 /**
  * Firmware read with 40-byte handshake protocol
  * This implements the proper vendor protocol for reading firmware in chunks
@@ -92,10 +156,10 @@ static void firmware_drain_logs(usb_device_t* device, uint8_t endpoint, int max_
  * 3. Perform bulk-in transfer for data
  * 4. Repeat with VR_FW_WRITE2 (0x14) for next chunk
  */
-thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t chunk_index,
-                                               uint32_t chunk_offset, uint32_t chunk_size,
-                                               uint8_t** out_data, int* out_len) {
-    if (!device || !out_data || !out_len || chunk_size == 0) {
+thingino_error_t firmware_handshake_read_chunk_into(usb_device_t* device, uint32_t chunk_index,
+                                                    uint32_t chunk_offset, uint32_t chunk_size,
+                                                    uint8_t* data_buffer, int* out_len) {
+    if (!device || !data_buffer || !out_len || chunk_size == 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -171,7 +235,7 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
     DEBUG_PRINT("Handshake command sent, waiting for status...\n");
 
     // Small delay to allow device to process
-    usleep(50000); // 50ms
+    thingino_sleep_milliseconds(50); // 50ms
 
     // Read status handshake from device (8 bytes)
     uint8_t status_buffer[8] = {0};
@@ -207,16 +271,11 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
     }
 
     // Wait for device to prepare data for bulk transfer
-    usleep(50000); // 50ms delay for device to prepare bulk data
+    thingino_sleep_milliseconds(50); // 50ms delay for device to prepare bulk data
 
     // Now perform bulk-in transfer to read the actual data
     DEBUG_PRINT("Reading %u bytes of data via bulk-in...\n", chunk_size);
 
-    uint8_t* data_buffer = (uint8_t*)malloc(chunk_size);
-    if (!data_buffer) {
-        return THINGINO_ERROR_MEMORY;
-    }
-
     int transferred = 0;
     int timeout = 10000; // 10 seconds for bulk transfer
 
@@ -224,7 +283,6 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
 
     if (result != THINGINO_SUCCESS) {
         DEBUG_PRINT("Bulk-in transfer failed: %s\n", thingino_error_to_string(result));
-        free(data_buffer);
         return result;
     }
 
@@ -248,7 +306,7 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
     uint8_t final_status[4] = {0};
     int final_status_len = 0;
 
-    int ctrl_result = libusb_control_transfer(device->handle,
+    int ctrl_result = usb_device_control_raw(device,
         REQUEST_TYPE_VENDOR, VR_FW_READ, 0, 0,
         final_status, sizeof(final_status), 5000);
 
@@ -265,7 +323,6 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
 
     DEBUG_PRINT("DEBUG: transferred value before assignment = %d\n", transferred);
 
-    *out_data = data_buffer;
     *out_len = transferred;
 
     DEBUG_PRINT("firmware_handshake_read_chunk returning: transferred=%d, *out_len=%d\n", transferred, *out_len);
@@ -273,6 +330,60 @@ thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t ch
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Allocating wrapper around firmware_handshake_read_chunk_into(). The caller
+ * frees *out_data.
+ */
+thingino_error_t firmware_handshake_read_chunk(usb_device_t* device, uint32_t chunk_index,
+                                               uint32_t chunk_offset, uint32_t chunk_size,
+                                               uint8_t** out_data, int* out_len) {
+    if (!device || !out_data || !out_len || chunk_size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* data_buffer = (uint8_t*)malloc(chunk_size);
+    if (!data_buffer) {
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    thingino_error_t result = firmware_handshake_read_chunk_into(device, chunk_index, chunk_offset,
+                                                                 chunk_size, data_buffer, out_len);
+    if (result != THINGINO_SUCCESS) {
+        free(data_buffer);
+        return result;
+    }
+
+    *out_data = data_buffer;
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Pick the VR_WRITE handshake layout for the device's writer: T31-family,
+ * T41N/T41 (XBurst2) or A1.
+ */
+write_handshake_format_t firmware_write_handshake_format(const usb_device_t* device, bool is_a1_board) {
+    if (is_a1_board) {
+        return WRITE_HANDSHAKE_A1;
+    }
+    if (device && device->info.stage == STAGE_FIRMWARE &&
+        device->info.variant == VARIANT_T41) {
+        return WRITE_HANDSHAKE_T41N;
+    }
+    return WRITE_HANDSHAKE_T31;
+}
+
+/**
+ * Build the 40-byte VR_WRITE handshake for a T31/T41-family write chunk.
+ * Shared by the synchronous chunk writer and the pipelined writer; see
+ * write_handshake_format() for the layout.
+ */
+void firmware_build_write_handshake(const usb_device_t* device, uint32_t chunk_offset,
+                                    const uint8_t* data, uint32_t data_size,
+                                    uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]) {
+    write_handshake_format(firmware_write_handshake_format(device, false), chunk_offset,
+                           data_size, firmware_crc32(data, data_size), handshake_cmd);
+}
+
 /**
  * Firmware write with 40-byte handshake protocol
  *
@@ -290,81 +401,23 @@ thingino_error_t firmware_handshake_write_chunk(usb_device_t* device, uint32_t c
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    DEBUG_PRINT("FirmwareHandshakeWriteChunk: index=%u, offset=0x%08X, size=%u\n",
-           chunk_index, chunk_offset, data_size);
+    uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE];
+    firmware_build_write_handshake(device, chunk_offset, data, data_size, handshake_cmd);
 
-    // Build 40-byte handshake command for write
-    // Layout derived from vendor T31 write capture vendor_write_real_20251118_122703.pcap
-    // and extended with T41N/T41 (XBurst2) trailer from t41_full_write_20251119_185651.pcap:
-    //   Bytes  0-9 : zeros
-    //   Bytes 10-11: Chunk offset in 64KB units (little-endian)
-    //   Bytes 12-17: zeros
-    //   Bytes 18-19: Chunk size in 64KB units (for 128KB: 0x0002, for 64KB: 0x0001)
-    //   Bytes 20-23: zeros
-    //   Bytes 24-27: 0x00000600 (00 00 06 00)
-    //   Bytes 28-31: ~CRC32(chunk_data) (little-endian)
-    //   Bytes 32-39: Constant trailer (T31: 20 FB 00 08 A2 77 00 00,
-    //                                   T41N: F0 17 00 44 70 7A 00 00)
-    //
-    // Verified pattern from complete capture with 128 chunks on T31 and
-    // from t41_full_write_20251119_185651.pcap on T41N.
-    uint8_t handshake_cmd[40] = {0};
-
-    // Bytes 10-11: chunk offset in 64KB units (little-endian).
-    // For offset=0x00000000 (chunk 0) this is 0x0000; for offset=0x00020000
-    // (chunk 1) this is 0x0002, matching vendor handshake #2.
-    uint32_t chunk_units = (chunk_offset >> 16);  // offset / 0x10000 (64KB)
-    handshake_cmd[10] = (chunk_units >> 0) & 0xFF;
-    handshake_cmd[11] = (chunk_units >> 8) & 0xFF;
-
-    // Bytes 18-19: chunk size in 64KB units (little-endian).
-    // Vendor writes 0x0002 here for 128KB chunks on T31 and 0x0001 for 64KB
-    // chunks on T41N.
-    uint32_t size_units = (data_size + 0xFFFF) >> 16;  // ceil(size / 64KB)
-    handshake_cmd[18] = (size_units >> 0) & 0xFF;
-    handshake_cmd[19] = (size_units >> 8) & 0xFF;
-
-    // Bytes 24-27: Constant pattern 0x00000600
-    handshake_cmd[24] = 0x00;
-    handshake_cmd[25] = 0x00;
-    handshake_cmd[26] = 0x06;
-    handshake_cmd[27] = 0x00;
-
-    // Bytes 28-31: Inverted CRC32 of chunk data (little-endian)
-    // Vendor captures show this equals ~crc32(chunk_data)
-    uint32_t crc = firmware_crc32(data, data_size);
-    uint32_t crc_inv = ~crc;
-
-    handshake_cmd[28] = (crc_inv >> 0) & 0xFF;
-    handshake_cmd[29] = (crc_inv >> 8) & 0xFF;
-    handshake_cmd[30] = (crc_inv >> 16) & 0xFF;
-    handshake_cmd[31] = (crc_inv >> 24) & 0xFF;
+    return firmware_handshake_send_chunk(device, chunk_index, chunk_offset, data, data_size,
+                                         handshake_cmd);
+}
 
-    // Bytes 32-39: Constant trailer observed in vendor write handshakes.
-    // T31-family uses 20 FB 00 08 A2 77 00 00 while T41N/T41 uses
-    // F0 17 00 44 70 7A 00 00.
-    if (device->info.stage == STAGE_FIRMWARE &&
-        device->info.variant == VARIANT_T41) {
-        // T41N/T41 (XBurst2) trailer from t41_full_write_20251119_185651.pcap
-        handshake_cmd[32] = 0xF0;
-        handshake_cmd[33] = 0x17;
-        handshake_cmd[34] = 0x00;
-        handshake_cmd[35] = 0x44;
-        handshake_cmd[36] = 0x70;
-        handshake_cmd[37] = 0x7A;
-        handshake_cmd[38] = 0x00;
-        handshake_cmd[39] = 0x00;
-    } else {
-        // Default T31-family trailer
-        handshake_cmd[32] = 0x20;
-        handshake_cmd[33] = 0xFB;
-        handshake_cmd[34] = 0x00;
-        handshake_cmd[35] = 0x08;
-        handshake_cmd[36] = 0xA2;
-        handshake_cmd[37] = 0x77;
-        handshake_cmd[38] = 0x00;
-        handshake_cmd[39] = 0x00;
-    }
+// One handshake + data transfer. *acked is false when the handshake's status
+// stage timed out: the fw-handshake policy lets that through because a busy
+// burner still takes the chunk, but a dropped handshake looks the same.
+static thingino_error_t firmware_handshake_send_chunk_once(usb_device_t* device, uint32_t chunk_index,
+                                                           uint32_t chunk_offset, const uint8_t* data,
+                                                           uint32_t data_size,
+                                                           const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE],
+                                                           bool* acked) {
+    DEBUG_PRINT("FirmwareHandshakeWriteChunk: index=%u, offset=0x%08X, size=%u\n",
+           chunk_index, chunk_offset, data_size);
 
     // Send handshake using VR_WRITE (0x12), as seen in vendor write capture
     // VR_FW_WRITE1/2 (0x13/0x14) are used for other initialization commands
@@ -372,26 +425,27 @@ thingino_error_t firmware_handshake_write_chunk(usb_device_t* device, uint32_t c
 
     DEBUG_PRINT("Sending write handshake with command 0x%02X...\n", handshake_cmd_code);
 
-    // Debug: dump handshake bytes for analysis
-    DEBUG_PRINT("Handshake bytes:");
-    for (int i = 0; i < 40; i++) {
-        if (i % 8 == 0) {
-            DEBUG_PRINT("\n  ");
+    // Debug: dump handshake bytes for analysis (one message per row)
+    if (thingino_debug_enabled()) {
+        for (int row = 0; row < 40; row += 8) {
+            const uint8_t* b = handshake_cmd + row;
+            DEBUG_PRINT("Handshake[%2d]: %02X %02X %02X %02X %02X %02X %02X %02X\n",
+                        row, b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
         }
-        fprintf(stderr, "%02X ", handshake_cmd[i]);
     }
-    fprintf(stderr, "\n");
 
     int response_len = 0;
     thingino_error_t result = usb_device_vendor_request(device, REQUEST_TYPE_OUT,
-        handshake_cmd_code, 0, 0, handshake_cmd, 40, NULL, &response_len);
+        handshake_cmd_code, 0, 0, (uint8_t*)handshake_cmd, 40, NULL, &response_len);
 
     if (result != THINGINO_SUCCESS) {
         DEBUG_PRINT("Failed to send write handshake: %s\n", thingino_error_to_string(result));
         return result;
     }
+    // A busy-but-accepted timeout reports no bytes
+    *acked = response_len == FIRMWARE_WRITE_HANDSHAKE_SIZE;
 
-    usleep(50000); // 50ms delay
+    thingino_sleep_milliseconds(50); // 50ms delay
 
     // Send actual data via bulk-out
     DEBUG_PRINT("Sending %u bytes of data via bulk-out...\n", data_size);
@@ -414,7 +468,7 @@ thingino_error_t firmware_handshake_write_chunk(usb_device_t* device, uint32_t c
 
     // Give device time to start processing the chunk
     DEBUG_PRINT("Waiting 100ms for device to start processing chunk...\n");
-    usleep(100000); // 100ms delay
+    thingino_sleep_milliseconds(100); // 100ms delay
 
     // For T41-family firmware-stage writes, the vendor T41N capture shows a
     // VR_FW_READ (0x10) after each chunk. On T31 this times out and breaks the
@@ -425,59 +479,118 @@ thingino_error_t firmware_handshake_write_chunk(usb_device_t* device, uint32_t c
         DEBUG_PRINT("Sending per-chunk VR_FW_READ (0x10) for T41...\n");
 
         // For T41/T41N, vendor traces show a 4-byte VR_FW_READ (0x10) after
-        // each write chunk. We issue this directly via libusb to avoid the
-        // generic usb_device_vendor_request() retry logic, which can turn a
-        // simple timeout into a long sequence of retries.
+        // each write chunk. It is informational, so one short attempt: the
+        // generic control policy would turn a timeout into retries.
+        static const retry_policy_t t41_chunk_status_policy = {
+            .name = "t41-chunk-status",
+            .attempt_timeout_ms = 1000,
+        };
         uint8_t status[4] = {0};
-        int ctrl_result = libusb_control_transfer(device->handle,
-            REQUEST_TYPE_VENDOR, VR_FW_READ, 0, 0,
-            status, sizeof(status), 1000);
+        int status_len = 0;
+        thingino_error_t status_result = usb_device_vendor_request_policy(device,
+            &t41_chunk_status_policy, REQUEST_TYPE_VENDOR, VR_FW_READ, 0, 0,
+            NULL, sizeof(status), status, &status_len);
 
-        if (ctrl_result < 0) {
+        if (status_result != THINGINO_SUCCESS) {
             DEBUG_PRINT("Warning: per-chunk VR_FW_READ for T41 failed: %s\n",
-                        libusb_error_name(ctrl_result));
+                        thingino_error_to_string(status_result));
             // Don't fail the operation here; the data chunk was already sent.
         } else {
             DEBUG_PRINT("Per-chunk VR_FW_READ status: len=%d, bytes=%02X %02X %02X %02X\n",
-                        ctrl_result,
+                        status_len,
                         status[0], status[1], status[2], status[3]);
         }
     }
 
-    // Drain log traffic from bulk-IN endpoint 0x81
-    // The vendor capture shows many bulk-IN transfers happen after status check
-    DEBUG_PRINT("Draining logs from bulk-IN endpoint 0x81...\n");
+    return THINGINO_SUCCESS;
+}
 
-    int total_drained = 0;
-    // Limit to a small number of quick polls to avoid slowing down the write
-    for (int i = 0; i < 16; i++) {
-        uint8_t log_buf[512];
-        int log_transferred = 0;
+// Has this session's burner written anything to its log? Only then can a
+// missing report mean a lost chunk rather than a burner that never logs.
+static bool firmware_burner_logs(const usb_device_t* device) {
+    return device->burner_log.lines_seen > 0;
+}
 
-        int log_result = libusb_bulk_transfer(device->handle, ENDPOINT_IN,
-            log_buf, sizeof(log_buf), &log_transferred, 5);  // 5ms timeout
+/**
+ * Wait for the burner log to report chunk_index after its data went out.
+ * The burner reports per-chunk progress and CRC results as text on bulk-IN
+ * 0x81; waiting for that replaces a fixed sleep.
+ *
+ * A handshake timeout is taken as accepted, as it always was for silent
+ * T31x burners. Only when this burner has been logging and then says
+ * nothing about an unacknowledged chunk is it reported lost.
+ *
+ * Returns THINGINO_ERROR_TIMEOUT when the chunk must be sent again.
+ */
+static thingino_error_t firmware_handshake_confirm_chunk(usb_device_t* device, uint32_t chunk_index,
+                                                         uint32_t chunk_offset, bool acked,
+                                                         int wait_ms) {
+    if (!acked && !firmware_burner_logs(device)) {
+        wait_ms = 300;
+    }
 
-        if (log_result == LIBUSB_ERROR_TIMEOUT || log_transferred == 0) {
-            break;
-        }
+    burner_event_t ev;
+    thingino_error_t result = firmware_burner_log_wait(device,
+        BURNER_EVENT_MASK(BURNER_EVENT_CHUNK_DONE) | BURNER_EVENT_MASK(BURNER_EVENT_CRC_OK),
+        (int32_t)chunk_index, wait_ms, &ev);
 
-        if (log_result == 0 && log_transferred > 0) {
-            total_drained += log_transferred;
-        }
+    if (result == THINGINO_ERROR_PROTOCOL) {
+        thingino_printf("[ERROR] Chunk %u at offset 0x%08X rejected by burner\n", chunk_index, chunk_offset);
+        return result;
     }
 
-    if (total_drained > 0) {
-        DEBUG_PRINT("Drained %d bytes of logs\n", total_drained);
+    if (result == THINGINO_SUCCESS) {
+        DEBUG_PRINT("Chunk %u acknowledged by burner log (%s)\n",
+                    chunk_index, burner_event_type_to_string(ev.type));
+        return THINGINO_SUCCESS;
+    }
+    if (result != THINGINO_ERROR_TIMEOUT) {
+        return result;
     }
 
-    // Give device more time to finish processing chunk before next handshake
-    // Tightened from 1000ms to 300ms to speed up full-image writes while
-    // still giving firmware time to progress internal state.
-    DEBUG_PRINT("Waiting 300ms for device to finish processing chunk...\n");
-    usleep(300000); // 300ms delay
+    if (!acked && firmware_burner_logs(device)) {
+        thingino_printf("[WARN] Chunk %u: handshake timed out and the burner did not confirm the chunk\n",
+                        chunk_index);
+        return THINGINO_ERROR_TIMEOUT;
+    }
 
+    DEBUG_PRINT("No burner log report for chunk %u within %d ms\n", chunk_index, wait_ms);
     return THINGINO_SUCCESS;
+}
+
+/**
+ * Send one T31/T41-family write chunk using a prebuilt handshake (e.g. from
+ * a prepared image layout). Repeating an identical VR_WRITE is avoided: a
+ * chunk is resent (up to WRITE_CHUNK_RESENDS times) only when its handshake
+ * timed out and a burner known to log did not report it.
+ */
+thingino_error_t firmware_handshake_send_chunk(usb_device_t* device, uint32_t chunk_index,
+                                               uint32_t chunk_offset, const uint8_t* data,
+                                               uint32_t data_size,
+                                               const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]) {
+    if (!device || !data || data_size == 0 || !handshake_cmd) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
 
+    for (int attempt = 0; attempt <= WRITE_CHUNK_RESENDS; attempt++) {
+        bool acked = false;
+        thingino_error_t result = firmware_handshake_send_chunk_once(device, chunk_index, chunk_offset,
+                                                                     data, data_size, handshake_cmd, &acked);
+        if (result != THINGINO_SUCCESS) {
+            return result;
+        }
+
+        // 300ms remains the upper bound for burners that stay silent
+        result = firmware_handshake_confirm_chunk(device, chunk_index, chunk_offset, acked,
+                                                  acked ? 300 : WRITE_CHUNK_CONFIRM_MS);
+        if (result != THINGINO_ERROR_TIMEOUT) {
+            return result;
+        }
+    }
+
+    thingino_printf("[ERROR] Chunk %u at offset 0x%08X unconfirmed after %d resends\n",
+                    chunk_index, chunk_offset, WRITE_CHUNK_RESENDS);
+    return THINGINO_ERROR_TRANSFER_FAILED;
 }
 
 
@@ -501,86 +614,48 @@ thingino_error_t firmware_handshake_write_chunk_a1(usb_device_t* device, uint32_
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    DEBUG_PRINT("FirmwareHandshakeWriteChunkA1: index=%u, offset=0x%08X, size=%u\n",
-           chunk_index, chunk_offset, data_size);
+    uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE];
+    write_handshake_format(WRITE_HANDSHAKE_A1, chunk_offset, data_size,
+                           firmware_crc32(data, data_size), handshake_cmd);
 
-    // Build 40-byte handshake command for write (A1-specific layout)
-    // Pattern from a1_full_write_20251119_221121.pcap showing 1MB chunks:
-    //   Bytes  0-7 : zeros
-    //   Bytes  8-11: Constant 0x00000600 (00 00 06 00)
-    //   Bytes 12-15: Chunk offset in bytes (little-endian)
-    //   Bytes 16-19: Chunk size 0x00100000 (00 00 10 00) = 1MB
-    //   Bytes 20-23: ~CRC32(chunk_data) (little-endian)
-    //   Bytes 24-31: zeros
-    //   Bytes 32-39: A1 trailer (30 24 00 D4 02 75 00 00)
-    uint8_t handshake_cmd[40] = {0};
+    return firmware_handshake_send_chunk_a1(device, chunk_index, chunk_offset, data, data_size,
+                                            handshake_cmd);
+}
 
-    // Bytes 8-11: Constant pattern 0x00000600
-    handshake_cmd[8] = 0x00;
-    handshake_cmd[9] = 0x00;
-    handshake_cmd[10] = 0x06;
-    handshake_cmd[11] = 0x00;
-
-    // Bytes 12-15: Chunk offset in bytes (little-endian)
-    handshake_cmd[12] = (chunk_offset >> 0) & 0xFF;
-    handshake_cmd[13] = (chunk_offset >> 8) & 0xFF;
-    handshake_cmd[14] = (chunk_offset >> 16) & 0xFF;
-    handshake_cmd[15] = (chunk_offset >> 24) & 0xFF;
-
-    // Bytes 16-19: Chunk size in bytes (little-endian)
-    // A1 uses 1MB (0x100000) chunks
-    handshake_cmd[16] = (data_size >> 0) & 0xFF;
-    handshake_cmd[17] = (data_size >> 8) & 0xFF;
-    handshake_cmd[18] = (data_size >> 16) & 0xFF;
-    handshake_cmd[19] = (data_size >> 24) & 0xFF;
-
-    // Compute inverted CRC32 of chunk data
-    uint32_t crc = firmware_crc32(data, data_size);
-    uint32_t crc_inv = ~crc;
-
-    // Bytes 20-23: Inverted CRC32 of chunk data (little-endian)
-    handshake_cmd[20] = (crc_inv >> 0) & 0xFF;
-    handshake_cmd[21] = (crc_inv >> 8) & 0xFF;
-    handshake_cmd[22] = (crc_inv >> 16) & 0xFF;
-    handshake_cmd[23] = (crc_inv >> 24) & 0xFF;
-
-    // Bytes 24-31: zeros (already initialized)
-
-    // Bytes 32-39: A1-specific trailer from vendor capture
-    handshake_cmd[32] = 0x30;
-    handshake_cmd[33] = 0x24;
-    handshake_cmd[34] = 0x00;
-    handshake_cmd[35] = 0xD4;
-    handshake_cmd[36] = 0x02;
-    handshake_cmd[37] = 0x75;
-    handshake_cmd[38] = 0x00;
-    handshake_cmd[39] = 0x00;
+// One A1 handshake + data transfer; *acked as for the T31 family
+static thingino_error_t firmware_handshake_send_chunk_a1_once(usb_device_t* device, uint32_t chunk_index,
+                                                              uint32_t chunk_offset, const uint8_t* data,
+                                                              uint32_t data_size,
+                                                              const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE],
+                                                              bool* acked) {
+    DEBUG_PRINT("FirmwareHandshakeWriteChunkA1: index=%u, offset=0x%08X, size=%u\n",
+           chunk_index, chunk_offset, data_size);
 
     // Send handshake using VR_WRITE (0x12)
     uint8_t handshake_cmd_code = VR_WRITE;
 
     DEBUG_PRINT("Sending A1 write handshake with command 0x%02X...\n", handshake_cmd_code);
 
-    // Debug: dump handshake bytes for analysis
-    DEBUG_PRINT("A1 Handshake bytes:");
-    for (int i = 0; i < 40; i++) {
-        if (i % 8 == 0) {
-            DEBUG_PRINT("\n  ");
+    // Debug: dump handshake bytes for analysis (one message per row)
+    if (thingino_debug_enabled()) {
+        for (int row = 0; row < 40; row += 8) {
+            const uint8_t* b = handshake_cmd + row;
+            DEBUG_PRINT("A1 handshake[%2d]: %02X %02X %02X %02X %02X %02X %02X %02X\n",
+                        row, b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
         }
-        fprintf(stderr, "%02X ", handshake_cmd[i]);
     }
-    fprintf(stderr, "\n");
 
     int response_len = 0;
     thingino_error_t result = usb_device_vendor_request(device, REQUEST_TYPE_OUT,
-        handshake_cmd_code, 0, 0, handshake_cmd, 40, NULL, &response_len);
+        handshake_cmd_code, 0, 0, (uint8_t*)handshake_cmd, 40, NULL, &response_len);
 
     if (result != THINGINO_SUCCESS) {
         DEBUG_PRINT("Failed to send A1 write handshake: %s\n", thingino_error_to_string(result));
         return result;
     }
+    *acked = response_len == FIRMWARE_WRITE_HANDSHAKE_SIZE;
 
-    usleep(50000); // 50ms delay
+    thingino_sleep_milliseconds(50); // 50ms delay
 
     // Send actual data via bulk-out
     DEBUG_PRINT("[A1] Sending %u bytes of data via bulk-out...\n", data_size);
@@ -598,11 +673,44 @@ thingino_error_t firmware_handshake_write_chunk_a1(usb_device_t* device, uint32_
 
     // Give device time to start and finish processing the chunk.
     DEBUG_PRINT("[A1] Waiting 300ms for device to process chunk...\n");
-    usleep(300000); // 300ms delay
+    thingino_sleep_milliseconds(300); // 300ms delay
 
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Send one A1 write chunk using a prebuilt handshake. The A1 burner is given
+ * a fixed 300ms per chunk; a chunk whose handshake timed out is resent only
+ * as on the T31 family.
+ */
+thingino_error_t firmware_handshake_send_chunk_a1(usb_device_t* device, uint32_t chunk_index,
+                                                  uint32_t chunk_offset, const uint8_t* data,
+                                                  uint32_t data_size,
+                                                  const uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]) {
+    if (!device || !data || data_size == 0 || !handshake_cmd) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    for (int attempt = 0; attempt <= WRITE_CHUNK_RESENDS; attempt++) {
+        bool acked = false;
+        thingino_error_t result = firmware_handshake_send_chunk_a1_once(device, chunk_index, chunk_offset,
+                                                                        data, data_size, handshake_cmd, &acked);
+        if (result != THINGINO_SUCCESS || acked) {
+            return result;
+        }
+
+        result = firmware_handshake_confirm_chunk(device, chunk_index, chunk_offset, false,
+                                                  WRITE_CHUNK_CONFIRM_MS);
+        if (result != THINGINO_ERROR_TIMEOUT) {
+            return result;
+        }
+    }
+
+    thingino_printf("[ERROR] A1 chunk %u at offset 0x%08X unconfirmed after %d resends\n",
+                    chunk_index, chunk_offset, WRITE_CHUNK_RESENDS);
+    return THINGINO_ERROR_TRANSFER_FAILED;
+}
+
 /**
  * Initialize firmware stage with handshake protocol
  */
@@ -620,7 +728,13 @@ thingino_error_t firmware_handshake_init(usb_device_t* device) {
         return result;
     }
 
-    usleep(100000); // 100ms delay for device to prepare
+    // Give the device up to 100ms to prepare, bailing out early if the
+    // burner rejects the handshake (e.g. cloner->ack = -22)
+    burner_event_t ev;
+    result = firmware_burner_log_wait(device, 0, -1, 100, &ev);
+    if (result == THINGINO_ERROR_PROTOCOL) {
+        return result;
+    }
 
     return THINGINO_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "image_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// FIRMWARE IMAGE INPUT IMPLEMENTATION
+// ============================================================================
+//
+// Maps the image read-only where the platform allows it and falls back to
+// reading it into the heap.
+
+// Fallback: read the whole file into a heap buffer
+static int image_read_heap(const char* path, firmware_image_t* image) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return -1;
+    }
+    long size = ftell(file);
+    if (size <= 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    uint8_t* buffer = (uint8_t*)malloc((size_t)size);
+    if (!buffer) {
+        fclose(file);
+        return -1;
+    }
+
+    size_t bytes_read = fread(buffer, 1, (size_t)size, file);
+    fclose(file);
+    if (bytes_read != (size_t)size) {
+        free(buffer);
+        return -1;
+    }
+
+    image->data = buffer;
+    image->size = (size_t)size;
+    image->mapped = false;
+    return 0;
+}
+
+#ifdef _WIN32
+
+static int image_map(const char* path, firmware_image_t* image) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+        (unsigned long long)size.QuadPart > (unsigned long long)SIZE_MAX) {
+        CloseHandle(file);
+        return -1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return -1;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    image->data = (const uint8_t*)view;
+    image->size = (size_t)size.QuadPart;
+    image->mapped = true;
+    image->mapping = mapping;
+    return 0;
+}
+
+#else
+
+static int image_map(const char* path, firmware_image_t* image) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (unsigned long long)st.st_size > (unsigned long long)SIZE_MAX) {
+        close(fd);
+        return -1;
+    }
+
+    void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+
+    // Chunks are consumed front to back exactly once: read ahead
+    // aggressively and let pages behind the writer be reclaimed
+    madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    image->data = (const uint8_t*)addr;
+    image->size = (size_t)st.st_size;
+    image->mapped = true;
+    return 0;
+}
+
+#endif
+
+int firmware_image_open(const char* path, firmware_image_t* image) {
+    if (!path || !image) {
+        return -1;
+    }
+
+    memset(image, 0, sizeof(*image));
+
+    if (image_map(path, image) == 0) {
+        return 0;
+    }
+    return image_read_heap(path, image);
+}
+
+void firmware_image_close(firmware_image_t* image) {
+    if (!image || !image->data) {
+        return;
+    }
+
+    if (image->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile((LPCVOID)image->data);
+        CloseHandle((HANDLE)image->mapping);
+#else
+        munmap((void*)image->data, image->size);
+#endif
+    } else {
+        free((void*)image->data);
+    }
+
+    memset(image, 0, sizeof(*image));
+}
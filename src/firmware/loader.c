@@ -53,7 +53,7 @@ static thingino_error_t firmware_generate_ddr_config(processor_variant_t variant
 
         *config_buffer = (uint8_t*)malloc(vendor_ddr_t20_bin_len);
         if (!*config_buffer) {
-            fprintf(stderr, "ERROR: Failed to allocate DDR buffer\n");
+            thingino_eprintf("ERROR: Failed to allocate DDR buffer\n");
             return THINGINO_ERROR_MEMORY;
         }
 
@@ -67,7 +67,7 @@ static thingino_error_t firmware_generate_ddr_config(processor_variant_t variant
     // Get platform configuration based on processor variant
     platform_config_t platform_cfg;
     if (ddr_get_platform_config_by_variant(variant, &platform_cfg) != 0) {
-        fprintf(stderr, "ERROR: Unsupported processor variant for DDR generation: %d\n", variant);
+        thingino_eprintf("ERROR: Unsupported processor variant for DDR generation: %d\n", variant);
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -79,7 +79,7 @@ static thingino_error_t firmware_generate_ddr_config(processor_variant_t variant
     const char *platform_name = processor_variant_to_string(variant);
     const ddr_chip_config_t *chip_cfg = ddr_chip_config_get_default(platform_name);
     if (!chip_cfg) {
-        fprintf(stderr, "ERROR: No default DDR chip found for platform: %s\n", platform_name);
+        thingino_eprintf("ERROR: No default DDR chip found for platform: %s\n", platform_name);
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -112,7 +112,7 @@ static thingino_error_t firmware_generate_ddr_config(processor_variant_t variant
     // Allocate buffer for DDR binary (324 bytes)
     *config_buffer = (uint8_t*)malloc(DDR_BINARY_SIZE);
     if (!*config_buffer) {
-        fprintf(stderr, "ERROR: Failed to allocate DDR buffer\n");
+        thingino_eprintf("ERROR: Failed to allocate DDR buffer\n");
         return THINGINO_ERROR_MEMORY;
     }
 
@@ -120,7 +120,7 @@ static thingino_error_t firmware_generate_ddr_config(processor_variant_t variant
     DEBUG_PRINT("Generating 324-byte DDR binary (FIDB + RDD format)\n");
     size_t generated_size = ddr_build_binary(&platform_cfg, &phy_params, *config_buffer);
     if (generated_size == 0) {
-        fprintf(stderr, "ERROR: Failed to generate DDR binary\n");
+        thingino_eprintf("ERROR: Failed to generate DDR binary\n");
         free(*config_buffer);
         *config_buffer = NULL;
         return THINGINO_ERROR_PROTOCOL;
@@ -186,11 +186,11 @@ thingino_error_t firmware_load_t31x(firmware_files_t* firmware) {
         &firmware->config, &firmware->config_size);
     
     if (gen_result == THINGINO_SUCCESS) {
-        printf("✓ DDR configuration generated dynamically: %zu bytes\n", firmware->config_size);
+        thingino_printf("✓ DDR configuration generated dynamically: %zu bytes\n", firmware->config_size);
     } else {
         // Fall back to reference binary
         DEBUG_PRINT("Dynamic generation failed, falling back to reference binary\n");
-        printf("Note: Using reference binary for DDR configuration\n");
+        thingino_printf("Note: Using reference binary for DDR configuration\n");
         
         const char* config_paths[] = {
             "./references/ddr_extracted.bin",
@@ -205,15 +205,15 @@ thingino_error_t firmware_load_t31x(firmware_files_t* firmware) {
             result = load_file(config_paths[i], &firmware->config, &firmware->config_size);
             if (result == THINGINO_SUCCESS) {
                 DEBUG_PRINT("Loaded DDR config: %zu bytes\n", firmware->config_size);
-                printf("✓ DDR configuration loaded from reference binary: %zu bytes\n", firmware->config_size);
+                thingino_printf("✓ DDR configuration loaded from reference binary: %zu bytes\n", firmware->config_size);
                 break;
             }
         }
         
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "ERROR: Could not generate DDR or load reference binary\n");
-            fprintf(stderr, "  Generation issue: %s\n", thingino_error_to_string(gen_result));
-            fprintf(stderr, "  Reference binary expected at: ./references/ddr_extracted.bin\n");
+            thingino_eprintf("ERROR: Could not generate DDR or load reference binary\n");
+            thingino_eprintf("  Generation issue: %s\n", thingino_error_to_string(gen_result));
+            thingino_eprintf("  Reference binary expected at: ./references/ddr_extracted.bin\n");
             return result;
         }
     }
@@ -243,8 +243,8 @@ thingino_error_t firmware_load_t31x(firmware_files_t* firmware) {
     }
     
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "ERROR: Failed to load SPL file\n");
-        fprintf(stderr, "  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/spl.bin\n");
+        thingino_eprintf("ERROR: Failed to load SPL file\n");
+        thingino_eprintf("  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/spl.bin\n");
         firmware_cleanup(firmware);
         return result;
     }
@@ -261,8 +261,8 @@ thingino_error_t firmware_load_t31x(firmware_files_t* firmware) {
     }
     
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "ERROR: Failed to load U-Boot file\n");
-        fprintf(stderr, "  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/uboot.bin\n");
+        thingino_eprintf("ERROR: Failed to load U-Boot file\n");
+        thingino_eprintf("  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/uboot.bin\n");
         firmware_cleanup(firmware);
         return result;
     }
@@ -285,11 +285,11 @@ thingino_error_t firmware_load_t20(firmware_files_t* firmware) {
         &firmware->config, &firmware->config_size);
 
     if (gen_result == THINGINO_SUCCESS) {
-        printf("✓ DDR configuration generated dynamically: %zu bytes\n", firmware->config_size);
+        thingino_printf("✓ DDR configuration generated dynamically: %zu bytes\n", firmware->config_size);
     } else {
         // Fall back to reference binary
         DEBUG_PRINT("Dynamic generation failed, falling back to reference binary\n");
-        printf("Note: Using reference binary for DDR configuration\n");
+        thingino_printf("Note: Using reference binary for DDR configuration\n");
 
         const char* config_paths[] = {
             "./references/ddr_extracted.bin",
@@ -309,7 +309,7 @@ thingino_error_t firmware_load_t20(firmware_files_t* firmware) {
         }
 
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "ERROR: Failed to load or generate DDR configuration\n");
+            thingino_eprintf("ERROR: Failed to load or generate DDR configuration\n");
             return result;
         }
     }
@@ -318,7 +318,7 @@ thingino_error_t firmware_load_t20(firmware_files_t* firmware) {
     DEBUG_PRINT("Loading embedded T20 firmware from database\n");
     const firmware_binary_t* fw = firmware_get("t20");
     if (!fw) {
-        fprintf(stderr, "ERROR: T20 firmware not found in database\n");
+        thingino_eprintf("ERROR: T20 firmware not found in database\n");
         firmware_cleanup(firmware);
         return THINGINO_ERROR_FILE_IO;
     }
@@ -399,7 +399,7 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             return result;
         }
         DEBUG_PRINT("Loaded custom DDR config from: %s (%zu bytes)\n", config_file, firmware->config_size);
-        printf("✓ Loaded custom DDR config: %s (%zu bytes)\n", config_file, firmware->config_size);
+        thingino_printf("✓ Loaded custom DDR config: %s (%zu bytes)\n", config_file, firmware->config_size);
     } else {
         // No custom config provided - try dynamic generation, fall back to reference
         DEBUG_PRINT("No custom DDR config provided, attempting dynamic generation for variant %d\n", variant);
@@ -407,7 +407,7 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             &firmware->config, &firmware->config_size);
         
         if (gen_result == THINGINO_SUCCESS) {
-            printf("✓ Generated DDR configuration dynamically: %zu bytes\n", firmware->config_size);
+            thingino_printf("✓ Generated DDR configuration dynamically: %zu bytes\n", firmware->config_size);
         } else {
             // Generation failed - try reference binary fallback
             DEBUG_PRINT("Dynamic generation failed, attempting reference binary fallback\n");
@@ -429,7 +429,7 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             return result;
         }
         DEBUG_PRINT("Loaded custom SPL from: %s (%zu bytes)\n", spl_file, firmware->spl_size);
-        printf("✓ Loaded custom SPL: %s (%zu bytes)\n", spl_file, firmware->spl_size);
+        thingino_printf("✓ Loaded custom SPL: %s (%zu bytes)\n", spl_file, firmware->spl_size);
     } else {
         // No custom SPL provided - load default based on variant
         DEBUG_PRINT("No custom SPL provided, loading default for variant %d\n", variant);
@@ -445,14 +445,14 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             result = load_file(spl_paths[i], &firmware->spl, &firmware->spl_size);
             if (result == THINGINO_SUCCESS) {
                 DEBUG_PRINT("Loaded default SPL: %zu bytes\n", firmware->spl_size);
-                printf("✓ Loaded default SPL: %zu bytes\n", firmware->spl_size);
+                thingino_printf("✓ Loaded default SPL: %zu bytes\n", firmware->spl_size);
                 break;
             }
         }
 
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "ERROR: Failed to load SPL file\n");
-            fprintf(stderr, "  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/spl.bin\n");
+            thingino_eprintf("ERROR: Failed to load SPL file\n");
+            thingino_eprintf("  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/spl.bin\n");
             firmware_cleanup(firmware);
             return result;
         }
@@ -467,7 +467,7 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             return result;
         }
         DEBUG_PRINT("Loaded custom U-Boot from: %s (%zu bytes)\n", uboot_file, firmware->uboot_size);
-        printf("✓ Loaded custom U-Boot: %s (%zu bytes)\n", uboot_file, firmware->uboot_size);
+        thingino_printf("✓ Loaded custom U-Boot: %s (%zu bytes)\n", uboot_file, firmware->uboot_size);
     } else {
         // No custom U-Boot provided - load default based on variant
         DEBUG_PRINT("No custom U-Boot provided, loading default for variant %d\n", variant);
@@ -483,14 +483,14 @@ thingino_error_t firmware_load_from_files(processor_variant_t variant,
             result = load_file(uboot_paths[i], &firmware->uboot, &firmware->uboot_size);
             if (result == THINGINO_SUCCESS) {
                 DEBUG_PRINT("Loaded default U-Boot: %zu bytes\n", firmware->uboot_size);
-                printf("✓ Loaded default U-Boot: %zu bytes\n", firmware->uboot_size);
+                thingino_printf("✓ Loaded default U-Boot: %zu bytes\n", firmware->uboot_size);
                 break;
             }
         }
 
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "ERROR: Failed to load U-Boot file\n");
-            fprintf(stderr, "  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/uboot.bin\n");
+            thingino_eprintf("ERROR: Failed to load U-Boot file\n");
+            thingino_eprintf("  Expected at: ./references/cloner-2.5.43-ubuntu_thingino/firmwares/t31x/uboot.bin\n");
             firmware_cleanup(firmware);
             return result;
         }
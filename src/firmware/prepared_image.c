@@ -0,0 +1,167 @@
+#include "prepared_image.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// PREPARED IMAGE IMPLEMENTATION
+// ============================================================================
+//
+// CRC32, the VR_WRITE handshake encodings, and the per-format chunk tables
+// built once when an image is prepared.
+
+static uint32_t crc32_table[256];
+static pthread_once_t crc32_table_once = PTHREAD_ONCE_INIT;
+
+static void crc32_init_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : (c >> 1);
+        }
+        crc32_table[i] = c;
+    }
+}
+
+uint32_t firmware_crc32(const uint8_t* data, size_t length) {
+    if (!data || length == 0) {
+        return 0;
+    }
+
+    pthread_once(&crc32_table_once, crc32_init_table);
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc = crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 0);
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Constant trailers observed in the vendor write captures
+static const uint8_t trailer_t31[8]  = { 0x20, 0xFB, 0x00, 0x08, 0xA2, 0x77, 0x00, 0x00 };
+static const uint8_t trailer_t41n[8] = { 0xF0, 0x17, 0x00, 0x44, 0x70, 0x7A, 0x00, 0x00 };
+static const uint8_t trailer_a1[8]   = { 0x30, 0x24, 0x00, 0xD4, 0x02, 0x75, 0x00, 0x00 };
+
+void write_handshake_format(write_handshake_format_t format, uint32_t chunk_offset,
+                            uint32_t chunk_size, uint32_t crc,
+                            uint8_t handshake_cmd[FIRMWARE_WRITE_HANDSHAKE_SIZE]) {
+    memset(handshake_cmd, 0, FIRMWARE_WRITE_HANDSHAKE_SIZE);
+
+    if (format == WRITE_HANDSHAKE_A1) {
+        // a1_full_write_20251119_221121.pcap:
+        //   Bytes  8-11: 0x00000600, 12-15: offset in bytes,
+        //   16-19: size in bytes, 20-23: ~CRC32, 32-39: A1 trailer
+        handshake_cmd[10] = 0x06;
+        put_le32(&handshake_cmd[12], chunk_offset);
+        put_le32(&handshake_cmd[16], chunk_size);
+        put_le32(&handshake_cmd[20], ~crc);
+        memcpy(&handshake_cmd[32], trailer_a1, sizeof(trailer_a1));
+        return;
+    }
+
+    // T31 (vendor_write_real_20251118_122703.pcap) and T41N
+    // (t41_full_write_20251119_185651.pcap):
+    //   Bytes 10-11: offset in 64KB units, 18-19: size in 64KB units
+    //   (rounded up), 24-27: 0x00000600, 28-31: ~CRC32, 32-39: trailer
+    uint32_t chunk_units = chunk_offset >> 16;
+    uint32_t size_units = (chunk_size + 0xFFFF) >> 16;
+    handshake_cmd[10] = (uint8_t)(chunk_units >> 0);
+    handshake_cmd[11] = (uint8_t)(chunk_units >> 8);
+    handshake_cmd[18] = (uint8_t)(size_units >> 0);
+    handshake_cmd[19] = (uint8_t)(size_units >> 8);
+    handshake_cmd[26] = 0x06;
+    put_le32(&handshake_cmd[28], ~crc);
+    memcpy(&handshake_cmd[32],
+           format == WRITE_HANDSHAKE_T41N ? trailer_t41n : trailer_t31, 8);
+}
+
+int prepared_image_open(prepared_image_t* prepared, const char* path) {
+    if (!prepared || !path) {
+        return -1;
+    }
+
+    memset(prepared, 0, sizeof(*prepared));
+    return firmware_image_open(path, &prepared->image);
+}
+
+static void prepared_layout_free(prepared_layout_t* layout) {
+    free(layout->crcs);
+    free(layout->handshakes);
+    memset(layout, 0, sizeof(*layout));
+}
+
+int prepared_image_add_layout(prepared_image_t* prepared, write_handshake_format_t format,
+                              uint32_t chunk_size) {
+    if (!prepared || !prepared->image.data ||
+        (unsigned)format >= WRITE_HANDSHAKE_FORMAT_COUNT || chunk_size == 0) {
+        return -1;
+    }
+
+    size_t image_size = prepared->image.size;
+    uint32_t count = (uint32_t)((image_size + chunk_size - 1) / chunk_size);
+
+    prepared_layout_t layout;
+    layout.chunk_size = chunk_size;
+    layout.chunk_count = count;
+    layout.crcs = (uint32_t*)malloc(count * sizeof(uint32_t));
+    layout.handshakes = malloc(count * sizeof(*layout.handshakes));
+    if (!layout.crcs || !layout.handshakes) {
+        prepared_layout_free(&layout);
+        return -1;
+    }
+
+    // T31 and T41N frequently share a chunk size; don't hash the image twice
+    const prepared_layout_t* same = NULL;
+    for (int f = 0; f < WRITE_HANDSHAKE_FORMAT_COUNT; f++) {
+        if (f != (int)format && prepared->layouts[f].chunk_size == chunk_size) {
+            same = &prepared->layouts[f];
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t offset = i * chunk_size;
+        uint32_t size = chunk_size;
+        if ((size_t)offset + size > image_size) {
+            size = (uint32_t)(image_size - offset);
+        }
+
+        layout.crcs[i] = same ? same->crcs[i]
+                              : firmware_crc32(prepared->image.data + offset, size);
+        write_handshake_format(format, offset, size, layout.crcs[i], layout.handshakes[i]);
+    }
+
+    prepared_layout_free(&prepared->layouts[format]);
+    prepared->layouts[format] = layout;
+    return 0;
+}
+
+const prepared_layout_t* prepared_image_layout(const prepared_image_t* prepared,
+                                               write_handshake_format_t format,
+                                               uint32_t chunk_size) {
+    if (!prepared || (unsigned)format >= WRITE_HANDSHAKE_FORMAT_COUNT) {
+        return NULL;
+    }
+
+    const prepared_layout_t* layout = &prepared->layouts[format];
+    return (layout->chunk_size != 0 && layout->chunk_size == chunk_size) ? layout : NULL;
+}
+
+void prepared_image_close(prepared_image_t* prepared) {
+    if (!prepared) {
+        return;
+    }
+
+    for (int f = 0; f < WRITE_HANDSHAKE_FORMAT_COUNT; f++) {
+        prepared_layout_free(&prepared->layouts[f]);
+    }
+    firmware_image_close(&prepared->image);
+}
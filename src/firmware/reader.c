@@ -31,113 +31,83 @@
  */
 
 /**
- * Read firmware chunk using handshake protocol
- * This is the protocol used by the factory tool
+ * Read a firmware bank straight into a caller-owned buffer of at least size
+ * bytes using the handshake protocol (one chunk per bank)
  */
-static thingino_error_t firmware_read_chunk_with_handshake(usb_device_t* device,
-                                                            uint32_t chunk_index,
-                                                            uint32_t chunk_offset,
-                                                            uint32_t chunk_size,
-                                                            uint8_t** out_data,
-                                                            int* out_len) {
-    if (!device || !out_data || !out_len || chunk_size == 0) {
+thingino_error_t firmware_read_bank_into(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t* buffer) {
+    if (!device || !buffer || size == 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    DEBUG_PRINT("firmware_read_chunk_with_handshake: index=%u, offset=0x%08X, size=%u\n",
-           chunk_index, chunk_offset, chunk_size);
-
-    // Use the handshake protocol from handshake.c
-    uint8_t* data_buffer = NULL;
-    int transferred = 0;
+    DEBUG_PRINT("firmware_read_bank: offset=0x%08X, size=%u bytes\n", offset, size);
 
-    thingino_error_t result = firmware_handshake_read_chunk(device, chunk_index,
-                                                            chunk_offset, chunk_size,
-                                                            &data_buffer, &transferred);
+    // Calculate chunk index (bank number)
+    uint32_t chunk_index = offset / (1024 * 1024);  // 1MB banks
+    int chunk_len = 0;
 
+    uint64_t started_us = thingino_monotonic_us();
+    uint64_t saved_deadline = usb_device_budget_begin(device, READ_BANK_BUDGET_MS);
+    thingino_error_t result = firmware_handshake_read_chunk_into(device, chunk_index,
+                                                                 offset, size,
+                                                                 buffer, &chunk_len);
+    usb_device_budget_end(device, saved_deadline);
     if (result != THINGINO_SUCCESS) {
-        DEBUG_PRINT("Handshake read failed: %s\n", thingino_error_to_string(result));
+        thingino_printf("[ERROR] Failed to read bank at offset 0x%08X: %s\n",
+               offset, thingino_error_to_string(result));
         return result;
     }
+    thingino_event_chunk(device, false, (uint32_t)chunk_len, thingino_monotonic_us() - started_us);
 
-    DEBUG_PRINT("Handshake read successful: %d/%u bytes\n", transferred, chunk_size);
-
-    *out_data = data_buffer;
-    *out_len = transferred;
+    if ((uint32_t)chunk_len != size) {
+        thingino_printf("[WARNING] Bank read at 0x%08X: Expected %u bytes, got %d bytes\n",
+               offset, size, chunk_len);
+    }
 
+    DEBUG_PRINT("Bank read complete: %d bytes\n", chunk_len);
     return THINGINO_SUCCESS;
 }
 
 /**
- * Read a firmware bank (1MB chunk) using 1MB sub-chunks with proper handshake
+ * Read a firmware bank into a freshly allocated buffer (caller frees *data)
  */
 thingino_error_t firmware_read_bank(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data) {
     if (!device || !data || size == 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
-    DEBUG_PRINT("firmware_read_bank: offset=0x%08X, size=%u bytes\n", offset, size);
 
-    // Allocate buffer for full bank
     uint8_t* bank_buffer = (uint8_t*)malloc(size);
     if (!bank_buffer) {
-        printf("[ERROR] Failed to allocate %u bytes for bank buffer\n", size);
+        thingino_printf("[ERROR] Failed to allocate %u bytes for bank buffer\n", size);
         return THINGINO_ERROR_MEMORY;
     }
 
-    uint32_t total_read = 0;
-    
-    // Use handshake protocol for reading from flash (factory tool protocol)
-    uint8_t* chunk_data = NULL;
-    int chunk_len = 0;
-
-    // Calculate chunk index (bank number)
-    uint32_t chunk_index = offset / (1024 * 1024);  // 1MB banks
-
-    thingino_error_t result = firmware_read_chunk_with_handshake(device, chunk_index,
-                                                                  offset, size,
-                                                                  &chunk_data, &chunk_len);
-    
+    thingino_error_t result = firmware_read_bank_into(device, offset, size, bank_buffer);
     if (result != THINGINO_SUCCESS) {
-        printf("[ERROR] Failed to read bank at offset 0x%08X: %s\n", 
-               offset, thingino_error_to_string(result));
         free(bank_buffer);
         return result;
     }
-    
-    if (chunk_data && chunk_len > 0) {
-        // Copy chunk data to bank buffer
-        memcpy(bank_buffer, chunk_data, chunk_len);
-        total_read = chunk_len;
-        free(chunk_data);
-    }
-    
-    if ((uint32_t)chunk_len != size) {
-        printf("[WARNING] Bank read at 0x%08X: Expected %u bytes, got %d bytes\n", 
-               offset, size, chunk_len);
-    }
-    
-    DEBUG_PRINT("Bank read complete: %u bytes\n", total_read);
+
     *data = bank_buffer;
     return THINGINO_SUCCESS;
 }
 
 /**
- * Read entire firmware (all 16MB in 1MB banks)
+ * Bring a freshly bootstrapped device into read mode: let it settle, send
+ * the flash descriptor and initialize the handshake protocol
  */
-thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32_t* size) {
-    if (!device || !data || !size) {
+thingino_error_t firmware_read_prepare(usb_device_t* device) {
+    if (!device) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
-    DEBUG_PRINT("firmware_read_full: Reading full firmware from device\n");
 
     // PHASE 0: Device stabilization
-    DEBUG_PRINT("firmware_read_full: PHASE 0 - Stabilizing device after bootstrap\n");
+    DEBUG_PRINT("firmware_read_prepare: PHASE 0 - Stabilizing device after bootstrap\n");
 
     // Extended delay to let device stabilize after bootstrap
     DEBUG_PRINT("Waiting for device to stabilize after bootstrap...\n");
-    usleep(2000000); // 2 second delay for device to fully settle
+    if (usb_device_sleep(device, 2000) != THINGINO_SUCCESS) { // 2 seconds for device to fully settle
+        return THINGINO_ERROR_CANCELLED;
+    }
 
     DEBUG_PRINT("Device should now be ready for firmware read\n");
 
@@ -145,38 +115,64 @@ thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32
 
     // CRITICAL: Send flash descriptor BEFORE any read operations
     // This tells the device what flash chip is installed and how to read it
-    DEBUG_PRINT("firmware_read_full: PHASE 1 - Sending flash descriptor...\n");
+    DEBUG_PRINT("firmware_read_prepare: PHASE 1 - Sending flash descriptor...\n");
 
     uint8_t flash_descriptor[FLASH_DESCRIPTOR_SIZE];
     if (flash_descriptor_create_win25q128(flash_descriptor) != 0) {
-        printf("[ERROR] Failed to create flash descriptor\n");
+        thingino_printf("[ERROR] Failed to create flash descriptor\n");
         return THINGINO_ERROR_MEMORY;
     }
 
     result = flash_descriptor_send(device, flash_descriptor);
     if (result != THINGINO_SUCCESS) {
-        printf("[ERROR] Failed to send flash descriptor: %s\n", thingino_error_to_string(result));
+        thingino_printf("[ERROR] Failed to send flash descriptor: %s\n", thingino_error_to_string(result));
         return result;
     }
     DEBUG_PRINT("Flash descriptor sent successfully\n");
 
     // Wait for device to process the descriptor
     DEBUG_PRINT("Waiting for device to process flash descriptor...\n");
-    usleep(500000); // 500ms delay
+    thingino_sleep_milliseconds(500); // 500ms delay
 
     // Initialize firmware handshake protocol (VR_FW_HANDSHAKE 0x11)
-    DEBUG_PRINT("firmware_read_full: PHASE 2 - Initializing handshake protocol...\n");
+    DEBUG_PRINT("firmware_read_prepare: PHASE 2 - Initializing handshake protocol...\n");
     result = firmware_handshake_init(device);
     if (result != THINGINO_SUCCESS) {
-        printf("[ERROR] Failed to initialize handshake protocol: %s\n", thingino_error_to_string(result));
+        thingino_printf("[ERROR] Failed to initialize handshake protocol: %s\n", thingino_error_to_string(result));
         return result;
     }
     DEBUG_PRINT("Handshake protocol initialized successfully\n");
 
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Read entire firmware (16MB in banks sized by the transfer profile)
+ */
+thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32_t* size) {
+    if (!device || !data || !size) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    DEBUG_PRINT("firmware_read_full: Reading full firmware from device\n");
+
+    thingino_error_t result = firmware_read_prepare(device);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    return firmware_read_full_prepared(device, data, size);
+}
+
+static thingino_error_t read_full_prepared_run(usb_device_t* device, uint8_t** data, uint32_t* size) {
+    if (!device || !data || !size) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
     // Initialize read configuration for main firmware
-    DEBUG_PRINT("firmware_read_full: Reading main firmware (16MB in 1MB banks)\n");
+    DEBUG_PRINT("firmware_read_full: Reading main firmware\n");
     firmware_read_config_t config;
-    result = firmware_read_init(device, &config);
+    thingino_error_t result = firmware_read_init(device, &config);
     if (result != THINGINO_SUCCESS) {
         return result;
     }
@@ -201,29 +197,26 @@ thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32
         DEBUG_PRINT("Reading bank %d/%d (%s) at offset=0x%08X using handshake protocol...\n", 
                i + 1, config.bank_count, bank->label, bank->offset);
         
-        uint8_t* bank_data = NULL;
-        
-        // Read bank with proper handshake protocol
-        result = firmware_read_bank(device, bank->offset, bank->size, &bank_data);
+        // Read bank with proper handshake protocol, straight into its slot
+        // of the image buffer (no per-bank allocation or copy)
+        result = firmware_read_bank_into(device, bank->offset, bank->size,
+                                         firmware_buffer + bank->offset);
         if (result != THINGINO_SUCCESS) {
-            printf("[ERROR] Failed to read bank %d: %s\n", i, thingino_error_to_string(result));
+            thingino_printf("[ERROR] Failed to read bank %d: %s\n", i, thingino_error_to_string(result));
             free(firmware_buffer);
             firmware_read_cleanup(&config);
             return result;
         }
-        
-        // Copy bank data to main firmware buffer
-        if (bank_data) {
-            memcpy(firmware_buffer + bank->offset, bank_data, bank->size);
-            total_read += bank->size;
-            free(bank_data);
-        }
+        total_read += bank->size;
+        thingino_progress(device, "read", total_read, config.total_size);
         
         DEBUG_PRINT("Bank %d read successfully (total: %u/%u bytes, %d%%)\n",
             i, total_read, config.total_size, (total_read * 100) / config.total_size);
         
         // Small delay between banks to let device stabilize
-        usleep(50000); // 50ms between banks
+        if (config.bank_delay_ms > 0) {
+            thingino_sleep_milliseconds(config.bank_delay_ms);
+        }
     }
     
     DEBUG_PRINT("firmware_read_full: Completed reading %u bytes\n", total_read);
@@ -235,6 +228,98 @@ thingino_error_t firmware_read_full(usb_device_t* device, uint8_t** data, uint32
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Read the entire firmware from a device already in read mode
+ * (firmware_read_prepare() done earlier on this burner instance)
+ */
+thingino_error_t firmware_read_full_prepared(usb_device_t* device, uint8_t** data, uint32_t* size) {
+    thingino_event_phase_begin(device, "read");
+    thingino_error_t result = read_full_prepared_run(device, data, size);
+    thingino_event_phase_end(device, "read", result);
+    return result;
+}
+
+/**
+ * Verify flash contents against an image by reading it back bank by bank
+ *
+ * Only the first size bytes of flash are compared, through the device's
+ * bank buffer (reused across verifies on the same handle).
+ */
+thingino_error_t firmware_verify(usb_device_t* device, const uint8_t* data, uint32_t size) {
+    if (!device || !data || size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    thingino_error_t result = firmware_read_prepare(device);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    return firmware_verify_prepared(device, data, size);
+}
+
+static thingino_error_t verify_prepared_run(usb_device_t* device, const uint8_t* data, uint32_t size) {
+    if (!device || !data || size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    firmware_read_config_t config;
+    thingino_error_t result = firmware_read_init(device, &config);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+
+    if (size > config.total_size) {
+        thingino_printf("[ERROR] Image is %u bytes but flash is only %u bytes\n", size, config.total_size);
+        firmware_read_cleanup(&config);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* buffer = usb_device_bank_buffer(device, config.banks[0].size);
+    if (!buffer) {
+        firmware_read_cleanup(&config);
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    for (int i = 0; i < config.bank_count && config.banks[i].offset < size; i++) {
+        flash_bank_t* bank = &config.banks[i];
+        result = firmware_read_bank_into(device, bank->offset, bank->size, buffer);
+        if (result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] Failed to read bank %d for verify: %s\n", i, thingino_error_to_string(result));
+            break;
+        }
+
+        uint32_t compare = size - bank->offset < bank->size ? size - bank->offset : bank->size;
+        if (memcmp(buffer, data + bank->offset, compare) != 0) {
+            uint32_t at = 0;
+            while (at < compare && buffer[at] == data[bank->offset + at]) {
+                at++;
+            }
+            thingino_printf("[ERROR] Verify mismatch at 0x%08X\n", bank->offset + at);
+            result = THINGINO_ERROR_PROTOCOL;
+            break;
+        }
+        thingino_progress(device, "verify", (uint64_t)bank->offset + compare, size);
+
+        if (config.bank_delay_ms > 0) {
+            thingino_sleep_milliseconds(config.bank_delay_ms);
+        }
+    }
+
+    firmware_read_cleanup(&config);
+    return result;
+}
+
+/**
+ * Verify against an image on a device already in read mode
+ */
+thingino_error_t firmware_verify_prepared(usb_device_t* device, const uint8_t* data, uint32_t size) {
+    thingino_event_phase_begin(device, "verify");
+    thingino_error_t result = verify_prepared_run(device, data, size);
+    thingino_event_phase_end(device, "verify", result);
+    return result;
+}
+
 /**
  * Detect firmware flash size (16MB for T31X)
  */
@@ -275,7 +360,9 @@ thingino_error_t firmware_read_detect_size(usb_device_t* device, uint32_t* size)
  */
 
 /**
- * Initialize firmware read configuration (16 banks of 1MB each)
+ * Initialize firmware read configuration. Defaults to 16 banks of 1MB with a
+ * 50ms pause between banks; a stored transfer profile for the device's
+ * variant and flash chip overrides both.
  */
 thingino_error_t firmware_read_init(usb_device_t* device, firmware_read_config_t* config) {
     if (!device || !config) {
@@ -291,8 +378,29 @@ thingino_error_t firmware_read_init(usb_device_t* device, firmware_read_config_t
     }
     
     // For 16MB flash, use 16 banks of 1MB each
-    config->bank_count = 16;
+    uint32_t bank_size = 1024 * 1024;
+    config->bank_delay_ms = 50;
     config->block_size = 65536; // 64KB blocks (common for SPI NOR flash)
+
+    transfer_profile_t tp;
+    if (transfer_profile_lookup(processor_variant_to_string(device->info.variant),
+                                device->info.flash_chip, &tp)) {
+        // Bank size must be whole flash blocks and divide the flash evenly
+        if (tp.read_chunk_size >= config->block_size &&
+            tp.read_chunk_size <= config->total_size &&
+            tp.read_chunk_size % config->block_size == 0 &&
+            config->total_size % tp.read_chunk_size == 0) {
+            bank_size = tp.read_chunk_size;
+        } else if (tp.read_chunk_size != 0) {
+            thingino_printf("[WARNING] Ignoring transfer profile read chunk of %u bytes\n",
+                   tp.read_chunk_size);
+        }
+        config->bank_delay_ms = tp.read_delay_ms;
+        DEBUG_PRINT("Using transfer profile %s/%s: bank=%u bytes, delay=%u ms\n",
+                    tp.variant, tp.flash, bank_size, config->bank_delay_ms);
+    }
+
+    config->bank_count = (int)(config->total_size / bank_size);
     
     // Allocate banks array
     config->banks = (flash_bank_t*)malloc(config->bank_count * sizeof(flash_bank_t));
@@ -300,11 +408,11 @@ thingino_error_t firmware_read_init(usb_device_t* device, firmware_read_config_t
         return THINGINO_ERROR_MEMORY;
     }
     
-    // Initialize bank configuration (16 banks of 1MB each)
+    // Initialize bank configuration
     for (int i = 0; i < config->bank_count; i++) {
         flash_bank_t* bank = &config->banks[i];
-        bank->offset = i * 1024 * 1024; // i * 1MB
-        bank->size = 1024 * 1024; // 1MB per bank
+        bank->offset = (uint32_t)i * bank_size;
+        bank->size = bank_size;
         snprintf(bank->label, sizeof(bank->label), "FW%d", i);
         bank->enabled = true;
         
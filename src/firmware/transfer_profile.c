@@ -0,0 +1,287 @@
+#include "transfer_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define profile_mkdir(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define profile_mkdir(path) mkdir(path, 0755)
+#endif
+
+// ============================================================================
+// TRANSFER PROFILE STORE IMPLEMENTATION
+// ============================================================================
+//
+// Lookup reads the profile file line by line; a store rewrites it through
+// a temporary file so a crash never leaves it half written.
+
+#define PROFILE_LINE_MAX  512
+#define PROFILE_MAX_LINES 256
+
+int transfer_profile_path(char* buf, size_t buf_size) {
+    if (!buf || buf_size == 0) {
+        return -1;
+    }
+
+    const char* override = getenv("THINGINO_PROFILE_FILE");
+    if (override && override[0]) {
+        return snprintf(buf, buf_size, "%s", override) < (int)buf_size ? 0 : -1;
+    }
+
+#ifdef _WIN32
+    const char* base = getenv("APPDATA");
+    if (!base || !base[0]) {
+        return -1;
+    }
+    return snprintf(buf, buf_size, "%s\\thingino-cloner\\profiles", base) < (int)buf_size ? 0 : -1;
+#else
+    const char* xdg = getenv("XDG_CONFIG_HOME");
+    if (xdg && xdg[0]) {
+        return snprintf(buf, buf_size, "%s/thingino-cloner/profiles", xdg) < (int)buf_size ? 0 : -1;
+    }
+    const char* home = getenv("HOME");
+    if (!home || !home[0]) {
+        return -1;
+    }
+    return snprintf(buf, buf_size, "%s/.config/thingino-cloner/profiles", home) < (int)buf_size ? 0 : -1;
+#endif
+}
+
+// Split off the next whitespace-delimited token (strtok_r is not portable
+// to all Windows toolchains we build with)
+static char* profile_next_token(char** cursor) {
+    char* p = *cursor;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    if (*p == '\0') {
+        *cursor = p;
+        return NULL;
+    }
+
+    char* start = p;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        p++;
+    }
+    if (*p) {
+        *p++ = '\0';
+    }
+    *cursor = p;
+    return start;
+}
+
+bool transfer_profile_parse_line(const char* line, transfer_profile_t* out) {
+    if (!line || !out) {
+        return false;
+    }
+
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if (*line == '\0' || *line == '\n' || *line == '#') {
+        return false;
+    }
+
+    char copy[PROFILE_LINE_MAX];
+    snprintf(copy, sizeof(copy), "%s", line);
+
+    memset(out, 0, sizeof(*out));
+
+    char* cursor = copy;
+    char* variant = profile_next_token(&cursor);
+    char* flash = profile_next_token(&cursor);
+    if (!variant || !flash) {
+        return false;
+    }
+
+    snprintf(out->variant, sizeof(out->variant), "%s", variant);
+    snprintf(out->flash, sizeof(out->flash), "%s", flash);
+
+    char* tok;
+    while ((tok = profile_next_token(&cursor)) != NULL) {
+        char* eq = strchr(tok, '=');
+        if (!eq) {
+            continue;
+        }
+        *eq = '\0';
+        const char* key = tok;
+        const char* value = eq + 1;
+
+        if (strcmp(key, "read_chunk") == 0) {
+            out->read_chunk_size = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(key, "read_delay_ms") == 0) {
+            out->read_delay_ms = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(key, "write_chunk") == 0) {
+            out->write_chunk_size = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(key, "write_settle_ms") == 0) {
+            out->write_settle_ms = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(key, "read_mbps") == 0) {
+            out->read_mbps = strtod(value, NULL);
+        } else if (strcmp(key, "write_mbps") == 0) {
+            out->write_mbps = strtod(value, NULL);
+        }
+    }
+
+    return true;
+}
+
+int transfer_profile_format(const transfer_profile_t* profile, char* buf, size_t buf_size) {
+    if (!profile || !buf) {
+        return -1;
+    }
+
+    int n = snprintf(buf, buf_size,
+                     "%s %s read_chunk=%u read_delay_ms=%u write_chunk=%u write_settle_ms=%u "
+                     "read_mbps=%.2f write_mbps=%.2f",
+                     profile->variant,
+                     profile->flash[0] ? profile->flash : TRANSFER_PROFILE_FLASH_DEFAULT,
+                     profile->read_chunk_size, profile->read_delay_ms,
+                     profile->write_chunk_size, profile->write_settle_ms,
+                     profile->read_mbps, profile->write_mbps);
+
+    return (n > 0 && (size_t)n < buf_size) ? 0 : -1;
+}
+
+bool transfer_profile_lookup(const char* variant, const char* flash, transfer_profile_t* out) {
+    if (!variant || !out) {
+        return false;
+    }
+    if (!flash || !flash[0]) {
+        flash = TRANSFER_PROFILE_FLASH_DEFAULT;
+    }
+
+    char path[512];
+    if (transfer_profile_path(path, sizeof(path)) != 0) {
+        return false;
+    }
+
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    bool found_exact = false;
+    bool found_default = false;
+    transfer_profile_t fallback;
+    char line[PROFILE_LINE_MAX];
+    transfer_profile_t entry;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (!transfer_profile_parse_line(line, &entry) || strcmp(entry.variant, variant) != 0) {
+            continue;
+        }
+        if (strcmp(entry.flash, flash) == 0) {
+            *out = entry;
+            found_exact = true;
+            break;
+        }
+        if (strcmp(entry.flash, TRANSFER_PROFILE_FLASH_DEFAULT) == 0) {
+            fallback = entry;
+            found_default = true;
+        }
+    }
+
+    fclose(f);
+
+    if (!found_exact && found_default) {
+        *out = fallback;
+    }
+    return found_exact || found_default;
+}
+
+// Create the parent directories of path (best effort)
+static void profile_make_parent_dirs(const char* path) {
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+
+    for (char* p = dir + 1; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            char sep = *p;
+            *p = '\0';
+            if (profile_mkdir(dir) != 0 && errno != EEXIST) {
+                return;
+            }
+            *p = sep;
+        }
+    }
+}
+
+int transfer_profile_store(const transfer_profile_t* profile) {
+    if (!profile || !profile->variant[0]) {
+        return -1;
+    }
+
+    const char* flash = profile->flash[0] ? profile->flash : TRANSFER_PROFILE_FLASH_DEFAULT;
+
+    char path[512];
+    char tmp_path[520];
+    if (transfer_profile_path(path, sizeof(path)) != 0) {
+        return -1;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    profile_make_parent_dirs(path);
+
+    FILE* out = fopen(tmp_path, "w");
+    if (!out) {
+        return -1;
+    }
+
+    char new_line[PROFILE_LINE_MAX];
+    if (transfer_profile_format(profile, new_line, sizeof(new_line)) != 0) {
+        fclose(out);
+        remove(tmp_path);
+        return -1;
+    }
+
+    bool replaced = false;
+    FILE* in = fopen(path, "r");
+    if (in) {
+        char line[PROFILE_LINE_MAX];
+        transfer_profile_t entry;
+        int lines = 0;
+
+        while (fgets(line, sizeof(line), in) && lines++ < PROFILE_MAX_LINES) {
+            if (transfer_profile_parse_line(line, &entry) &&
+                strcmp(entry.variant, profile->variant) == 0 &&
+                strcmp(entry.flash, flash) == 0) {
+                if (!replaced) {
+                    fprintf(out, "%s\n", new_line);
+                    replaced = true;
+                }
+                continue;
+            }
+            fputs(line, out);
+            if (line[0] && line[strlen(line) - 1] != '\n') {
+                fputc('\n', out);
+            }
+        }
+        fclose(in);
+    } else {
+        fprintf(out, "# thingino-cloner transfer profiles (written by --bench)\n");
+    }
+
+    if (!replaced) {
+        fprintf(out, "%s\n", new_line);
+    }
+
+    if (fclose(out) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,571 @@
+/**
+ * Pipelined Firmware Writer
+ *
+ * The serial writer sends chunk N (handshake + bulk OUT) and then waits for
+ * the burner to program it before touching chunk N+1, so USB transfer time
+ * adds to flash program time. This writer uses asynchronous libusb transfers
+ * to keep up to window_depth chunks in flight: while the burner programs
+ * chunk N, the handshake and data for chunk N+1 are already on the wire.
+ *
+ * Ordering rules kept from the vendor protocol:
+ * - Host-side transfers are strictly sequential: a chunk's bulk OUT is only
+ *   submitted once its VR_WRITE handshake completed, and the next chunk's
+ *   handshake only after the previous bulk OUT (and T41 VR_FW_READ) finished.
+ * - A chunk stays "in flight" until the burner log reports it programmed, or
+ *   until the profile's settle time has elapsed for silent burners. A chunk
+ *   whose handshake or data timed out waits for the log to confirm it.
+ * - The window depth is capped by the profile (burner receive buffer size).
+ * - A chunk's bulk OUT goes out in BUS_SCHED_SLICE_BYTES slices, each holding
+ *   a bus scheduler slot (bus_scheduler.c) from submission to completion,
+ *   as usb_device_bulk_raw does for synchronous transfers.
+ *
+ * Which chunk may retire when is decided by the write window (write_window.c);
+ * this file only drives the transfers. Devices on a transport (the
+ * simulator) have no libusb event loop; their transfers run synchronously
+ * from the pipeline's event pass instead, see TRANSPORT TRANSFERS below.
+ */
+
+#include "thingino.h"
+#include "write_window.h"
+
+#define PIPELINE_POLL_MS        10
+#define PIPELINE_DRAIN_WARN_MS  2000
+#define PIPELINE_LOG_BUF_SIZE   512
+#define PIPELINE_QUEUE_SIZE     (WRITE_WINDOW_MAX_SLOTS + 1)    // Every slot plus the log read
+
+typedef enum {
+    SLOT_IDLE,
+    SLOT_HANDSHAKE,     // VR_WRITE control OUT submitted
+    SLOT_BUS_WAIT,      // Next bulk OUT slice waiting for a bus slot
+    SLOT_DATA,          // Bulk OUT slice submitted
+    SLOT_STATUS         // T41 per-chunk VR_FW_READ submitted
+} pipeline_slot_state_t;
+
+struct write_pipeline;
+
+// Host-transfer side of one window slot (same index modulo the slot count)
+typedef struct {
+    struct write_pipeline* pl;
+    pipeline_slot_state_t state;
+    write_window_slot_t* chunk;
+    const uint8_t* data;
+    bool timed_out;     // Handshake or data transfer timed out
+    struct libusb_transfer* xfer;
+    uint64_t trace_us;  // Submit time of xfer, 0 when not tracing
+    uint32_t sent;      // Bulk OUT bytes of the chunk already transferred
+    int bus_token;      // Bus scheduler slot held by the bulk OUT slice, -1 = none
+    uint8_t ctrl_buf[LIBUSB_CONTROL_SETUP_SIZE + FIRMWARE_WRITE_HANDSHAKE_SIZE];
+} pipeline_slot_t;
+
+typedef struct write_pipeline {
+    usb_device_t* device;
+    const write_profile_t* profile;
+    const prepared_layout_t* layout;    // Precomputed handshakes, may be NULL
+    pipeline_slot_t slots[WRITE_WINDOW_MAX_SLOTS];
+    write_window_t window;
+    uint32_t total_size;    // Image bytes, for progress reports
+    bool host_busy;         // A slot has a transfer on the wire
+    bool stopping;
+    thingino_error_t error;
+    struct libusb_transfer* log_xfer;
+    uint64_t log_trace_us;
+    uint8_t log_buf[PIPELINE_LOG_BUF_SIZE];
+    bool log_active;
+    pipeline_slot_t* bus_wait;      // Slot whose bulk OUT waits for the bus
+    struct libusb_transfer* queued[PIPELINE_QUEUE_SIZE];  // Transport transfers
+    uint32_t queued_count;
+} write_pipeline_t;
+
+static bool pipeline_is_t41(const write_pipeline_t* pl) {
+    return pl->device->info.stage == STAGE_FIRMWARE &&
+           pl->device->info.variant == VARIANT_T41;
+}
+
+static void pipeline_fail(write_pipeline_t* pl, thingino_error_t error) {
+    if (pl->error == THINGINO_SUCCESS) {
+        pl->error = error;
+    }
+}
+
+static void pipeline_mark_programming(pipeline_slot_t* slot) {
+    slot->state = SLOT_IDLE;
+    write_window_host_done(&slot->pl->window, slot->chunk, !slot->timed_out, thingino_monotonic_ms());
+    slot->pl->host_busy = false;
+}
+
+static void pipeline_release_bus(pipeline_slot_t* slot, uint32_t bytes) {
+    bus_sched_release(slot->bus_token, bytes);
+    slot->bus_token = -1;
+}
+
+// The slot's host transfer failed outright; the chunk never reaches the burner
+static void pipeline_abort_slot(pipeline_slot_t* slot, thingino_error_t error) {
+    slot->state = SLOT_IDLE;
+    slot->pl->host_busy = false;
+    pipeline_fail(slot->pl, error);
+}
+
+// ============================================================================
+// TRANSPORT TRANSFERS
+// ============================================================================
+//
+// A transport only offers synchronous calls. Its "submitted" transfers are
+// queued and run in submission order by pipeline_poll(), which fills in
+// status and actual_length and calls the callback as libusb would. A log
+// read with no timeout waits one poll interval instead.
+
+static enum libusb_transfer_status pipeline_transport_status(int result) {
+    switch (result) {
+        case LIBUSB_SUCCESS:            return LIBUSB_TRANSFER_COMPLETED;
+        case LIBUSB_ERROR_TIMEOUT:      return LIBUSB_TRANSFER_TIMED_OUT;
+        case LIBUSB_ERROR_PIPE:         return LIBUSB_TRANSFER_STALL;
+        case LIBUSB_ERROR_NO_DEVICE:    return LIBUSB_TRANSFER_NO_DEVICE;
+        case LIBUSB_ERROR_OVERFLOW:     return LIBUSB_TRANSFER_OVERFLOW;
+        case LIBUSB_ERROR_INTERRUPTED:  return LIBUSB_TRANSFER_CANCELLED;
+        default:                        return LIBUSB_TRANSFER_ERROR;
+    }
+}
+
+static void pipeline_transport_run(write_pipeline_t* pl, struct libusb_transfer* xfer) {
+    const usb_transport_t* transport = pl->device->transport;
+    void* data = pl->device->transport_data;
+
+    xfer->actual_length = 0;
+    if (pl->stopping) {
+        xfer->status = LIBUSB_TRANSFER_CANCELLED;
+    } else if (xfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+        struct libusb_control_setup* setup = libusb_control_transfer_get_setup(xfer);
+        int result = transport->control(data, setup->bmRequestType, setup->bRequest,
+                                        libusb_le16_to_cpu(setup->wValue),
+                                        libusb_le16_to_cpu(setup->wIndex),
+                                        libusb_control_transfer_get_data(xfer),
+                                        libusb_le16_to_cpu(setup->wLength), xfer->timeout);
+        xfer->actual_length = result > 0 ? result : 0;
+        xfer->status = pipeline_transport_status(result < 0 ? result : LIBUSB_SUCCESS);
+    } else {
+        int transferred = 0;
+        int result = transport->bulk(data, xfer->endpoint, xfer->buffer, xfer->length, &transferred,
+                                     xfer->timeout ? xfer->timeout : PIPELINE_POLL_MS);
+        xfer->actual_length = transferred;
+        xfer->status = pipeline_transport_status(result);
+    }
+    xfer->callback(xfer);
+}
+
+// Submit with the start time kept for the transfer trace; each callback
+// records its transfer before reusing it
+static int pipeline_submit(write_pipeline_t* pl, struct libusb_transfer* xfer, uint64_t* trace_us) {
+    *trace_us = thingino_trace_start();
+    if (!pl->device->transport) {
+        return libusb_submit_transfer(xfer);
+    }
+    if (pl->queued_count >= PIPELINE_QUEUE_SIZE) {
+        return LIBUSB_ERROR_BUSY;
+    }
+    pl->queued[pl->queued_count++] = xfer;
+    return LIBUSB_SUCCESS;
+}
+
+static void pipeline_cancel(write_pipeline_t* pl, struct libusb_transfer* xfer) {
+    if (!pl->device->transport) {
+        libusb_cancel_transfer(xfer);
+    }
+    // Queued transport transfers complete as cancelled once stopping is set
+}
+
+// Wait up to one poll interval for completions and run their callbacks
+static int pipeline_poll(write_pipeline_t* pl) {
+    if (!pl->device->transport) {
+        struct timeval tv = { 0, PIPELINE_POLL_MS * 1000 };
+        return libusb_handle_events_timeout_completed(pl->device->context, &tv, NULL);
+    }
+
+    // Callbacks queue follow-up transfers; those run on the next pass
+    uint32_t count = pl->queued_count;
+    struct libusb_transfer* batch[PIPELINE_QUEUE_SIZE];
+    memcpy(batch, pl->queued, count * sizeof(batch[0]));
+    pl->queued_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        pipeline_transport_run(pl, batch[i]);
+    }
+    if (count == 0) {
+        thingino_sleep_milliseconds(PIPELINE_POLL_MS);
+    }
+    return LIBUSB_SUCCESS;
+}
+
+// ============================================================================
+// TRANSFER CALLBACKS
+// ============================================================================
+
+static void LIBUSB_CALL pipeline_status_cb(struct libusb_transfer* xfer) {
+    pipeline_slot_t* slot = (pipeline_slot_t*)xfer->user_data;
+    thingino_trace_transfer(slot->pl->device, slot->trace_us, xfer);
+
+    // Like the serial writer, a failed per-chunk VR_FW_READ is not fatal:
+    // the data for this chunk is already with the burner.
+    if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+        DEBUG_PRINT("Pipeline: VR_FW_READ after chunk %u: status %d\n",
+                    slot->chunk->index, xfer->status);
+    }
+
+    pipeline_mark_programming(slot);
+}
+
+static void LIBUSB_CALL pipeline_data_cb(struct libusb_transfer* xfer) {
+    pipeline_slot_t* slot = (pipeline_slot_t*)xfer->user_data;
+    write_pipeline_t* pl = slot->pl;
+    thingino_trace_transfer(pl->device, slot->trace_us, xfer);
+    pipeline_release_bus(slot, (uint32_t)xfer->actual_length);
+
+    // A timeout with the full slice transferred still delivered the data
+    // (see usb_device_bulk_transfer), but the chunk then needs the burner
+    // log to confirm it before it retires
+    bool complete = xfer->actual_length == xfer->length &&
+                    (xfer->status == LIBUSB_TRANSFER_COMPLETED ||
+                     xfer->status == LIBUSB_TRANSFER_TIMED_OUT);
+
+    if (!complete) {
+        DEBUG_PRINT("Pipeline: bulk OUT for chunk %u failed: status %d, %d/%d bytes\n",
+                    slot->chunk->index, xfer->status, xfer->actual_length, xfer->length);
+        pipeline_abort_slot(slot, xfer->status == LIBUSB_TRANSFER_TIMED_OUT
+                                      ? THINGINO_ERROR_TRANSFER_TIMEOUT : THINGINO_ERROR_TRANSFER_FAILED);
+        return;
+    }
+    if (xfer->status == LIBUSB_TRANSFER_TIMED_OUT) {
+        slot->timed_out = true;
+    }
+
+    slot->sent += (uint32_t)xfer->actual_length;
+    if (slot->sent < slot->chunk->size && !pl->stopping) {
+        slot->state = SLOT_BUS_WAIT;
+        pl->bus_wait = slot;
+        return;
+    }
+
+    if (!pipeline_is_t41(pl) || pl->stopping) {
+        pipeline_mark_programming(slot);
+        return;
+    }
+
+    // T41N captures show a 4-byte VR_FW_READ (0x10) after every chunk
+    libusb_fill_control_setup(slot->ctrl_buf, REQUEST_TYPE_VENDOR, VR_FW_READ, 0, 0, 4);
+    libusb_fill_control_transfer(xfer, pl->device->handle, slot->ctrl_buf,
+                                 pipeline_status_cb, slot, 1000);
+    slot->state = SLOT_STATUS;
+
+    if (pipeline_submit(pl, xfer, &slot->trace_us) != LIBUSB_SUCCESS) {
+        pipeline_mark_programming(slot);
+    }
+}
+
+static void LIBUSB_CALL pipeline_handshake_cb(struct libusb_transfer* xfer) {
+    pipeline_slot_t* slot = (pipeline_slot_t*)xfer->user_data;
+    write_pipeline_t* pl = slot->pl;
+    thingino_trace_transfer(pl->device, slot->trace_us, xfer);
+
+    // Firmware-stage VR_WRITE may time out while the burner is still busy
+    // even though the handshake was accepted (see retry_policy_fw_handshake).
+    // A dropped handshake looks the same, so such a chunk is only retired
+    // once the burner log confirms it.
+    if ((xfer->status != LIBUSB_TRANSFER_COMPLETED &&
+         xfer->status != LIBUSB_TRANSFER_TIMED_OUT) || pl->stopping) {
+        DEBUG_PRINT("Pipeline: VR_WRITE for chunk %u failed: status %d\n",
+                    slot->chunk->index, xfer->status);
+        pipeline_abort_slot(slot, THINGINO_ERROR_TRANSFER_FAILED);
+        return;
+    }
+    if (xfer->status == LIBUSB_TRANSFER_TIMED_OUT) {
+        slot->timed_out = true;
+    }
+
+    // The bulk OUT goes out from the pipeline loop, which may have to wait
+    // for the bus; waiting here would stall every other completion
+    slot->state = SLOT_BUS_WAIT;
+    pl->bus_wait = slot;
+}
+
+static void LIBUSB_CALL pipeline_log_cb(struct libusb_transfer* xfer) {
+    write_pipeline_t* pl = (write_pipeline_t*)xfer->user_data;
+    thingino_trace_transfer(pl->device, pl->log_trace_us, xfer);
+
+    if (xfer->actual_length > 0) {
+        burner_log_feed(&pl->device->burner_log, xfer->buffer, (size_t)xfer->actual_length);
+    }
+
+    if (pl->stopping ||
+        (xfer->status != LIBUSB_TRANSFER_COMPLETED && xfer->status != LIBUSB_TRANSFER_TIMED_OUT) ||
+        pipeline_submit(pl, xfer, &pl->log_trace_us) != LIBUSB_SUCCESS) {
+        pl->log_active = false;
+    }
+}
+
+// ============================================================================
+// PIPELINE CONTROL
+// ============================================================================
+
+static thingino_error_t pipeline_start_chunk(write_pipeline_t* pl, const uint8_t* data,
+                                             uint32_t offset, uint32_t size) {
+    write_window_slot_t* chunk = write_window_start(&pl->window, offset, size, thingino_monotonic_us());
+    if (!chunk) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    pipeline_slot_t* slot = &pl->slots[chunk->index % WRITE_WINDOW_MAX_SLOTS];
+
+    slot->chunk = chunk;
+    slot->data = data;
+    slot->timed_out = false;
+    slot->sent = 0;
+    slot->bus_token = -1;
+
+    libusb_fill_control_setup(slot->ctrl_buf, REQUEST_TYPE_OUT, VR_WRITE, 0, 0,
+                              FIRMWARE_WRITE_HANDSHAKE_SIZE);
+    if (pl->layout && chunk->index < pl->layout->chunk_count) {
+        memcpy(slot->ctrl_buf + LIBUSB_CONTROL_SETUP_SIZE, pl->layout->handshakes[chunk->index],
+               FIRMWARE_WRITE_HANDSHAKE_SIZE);
+    } else {
+        firmware_build_write_handshake(pl->device, offset, data, size,
+                                       slot->ctrl_buf + LIBUSB_CONTROL_SETUP_SIZE);
+    }
+    // Same per-attempt timeout as a synchronous VR_WRITE
+    const retry_policy_t* policy = usb_vendor_request_policy_for(pl->device, REQUEST_TYPE_OUT,
+                                                                 VR_WRITE);
+    libusb_fill_control_transfer(slot->xfer, pl->device->handle, slot->ctrl_buf,
+                                 pipeline_handshake_cb, slot, policy->attempt_timeout_ms);
+
+    int rc = pipeline_submit(pl, slot->xfer, &slot->trace_us);
+    if (rc != LIBUSB_SUCCESS) {
+        DEBUG_PRINT("Pipeline: submit VR_WRITE for chunk %u failed: %s\n",
+                    chunk->index, libusb_error_name(rc));
+        return THINGINO_ERROR_TRANSFER_FAILED;
+    }
+
+    slot->state = SLOT_HANDSHAKE;
+    pl->host_busy = true;
+    return THINGINO_SUCCESS;
+}
+
+// Take a bus slot and send the next slice of the waiting chunk's data
+static void pipeline_send_slice(write_pipeline_t* pl) {
+    pipeline_slot_t* slot = pl->bus_wait;
+    pl->bus_wait = NULL;
+
+    uint32_t length = slot->chunk->size - slot->sent;
+    if (length > BUS_SCHED_SLICE_BYTES) {
+        length = BUS_SCHED_SLICE_BYTES;
+    }
+
+    slot->bus_token = bus_sched_acquire(pl->device, length);
+    if (slot->bus_token == BUS_SCHED_CANCELLED) {
+        slot->bus_token = -1;
+        pipeline_abort_slot(slot, THINGINO_ERROR_CANCELLED);
+        return;
+    }
+
+    libusb_fill_bulk_transfer(slot->xfer, pl->device->handle, ENDPOINT_OUT,
+                              (uint8_t*)slot->data + slot->sent, (int)length,
+                              pipeline_data_cb, slot, 6000);
+    slot->state = SLOT_DATA;
+
+    if (pipeline_submit(pl, slot->xfer, &slot->trace_us) != LIBUSB_SUCCESS) {
+        pipeline_release_bus(slot, 0);
+        pipeline_abort_slot(slot, THINGINO_ERROR_TRANSFER_FAILED);
+    }
+}
+
+// Feed burner log events to the window and retire every chunk it allows
+static void pipeline_process_log(write_pipeline_t* pl) {
+    burner_event_t ev;
+
+    while (burner_log_pop(&pl->device->burner_log, &ev)) {
+        if (!write_window_event(&pl->window, &ev)) {
+            thingino_printf("[ERROR] Burner reported %s during pipelined write (value=%d)\n",
+                   burner_event_type_to_string(ev.type), ev.value);
+            pipeline_fail(pl, THINGINO_ERROR_PROTOCOL);
+            return;
+        }
+    }
+
+    write_window_slot_t retired;
+    write_window_retire_t outcome;
+    while ((outcome = write_window_retire(&pl->window, thingino_monotonic_ms(), &retired)) ==
+           WRITE_WINDOW_RETIRED) {
+        DEBUG_PRINT("Pipeline: chunk %u retired after %llu ms%s\n", retired.index,
+                    (unsigned long long)(thingino_monotonic_ms() - retired.programmed_at_ms),
+                    retired.done ? "" : " (settled)");
+        thingino_cancel_progress(pl->device->cancel);
+        thingino_event_chunk(pl->device, true, retired.size, thingino_monotonic_us() - retired.started_us);
+        thingino_progress(pl->device, "write", (uint64_t)retired.offset + retired.size, pl->total_size);
+    }
+
+    if (outcome == WRITE_WINDOW_UNCONFIRMED) {
+        thingino_printf("[WARN] Chunk %u: host transfer timed out and the burner did not confirm the chunk\n",
+                        pl->window.head);
+        pipeline_fail(pl, THINGINO_ERROR_TIMEOUT);
+    }
+}
+
+static void pipeline_handle_events(write_pipeline_t* pl) {
+    int rc = pipeline_poll(pl);
+    if (rc != LIBUSB_SUCCESS && rc != LIBUSB_ERROR_INTERRUPTED) {
+        pipeline_fail(pl, THINGINO_ERROR_TRANSFER_FAILED);
+    }
+    // The drain cancels whatever is still on the wire
+    if (thingino_cancel_check(pl->device->cancel)) {
+        pipeline_fail(pl, THINGINO_ERROR_CANCELLED);
+    }
+}
+
+// Cancel everything still on the wire and wait for the callbacks to run.
+// libusb owns a submitted transfer until its callback ran, so this does not
+// give up: freeing one earlier would be a use-after-free.
+static void pipeline_drain(write_pipeline_t* pl) {
+    pl->stopping = true;
+
+    // Nothing is on the wire for a chunk still waiting for the bus
+    if (pl->bus_wait) {
+        pipeline_abort_slot(pl->bus_wait, THINGINO_ERROR_CANCELLED);
+        pl->bus_wait = NULL;
+    }
+    for (uint32_t i = 0; i < WRITE_WINDOW_MAX_SLOTS; i++) {
+        pipeline_slot_t* slot = &pl->slots[i];
+        if (slot->state != SLOT_IDLE) {
+            pipeline_cancel(pl, slot->xfer);
+        }
+    }
+    if (pl->log_active) {
+        pipeline_cancel(pl, pl->log_xfer);
+    }
+
+    uint64_t warn_at = thingino_monotonic_ms() + PIPELINE_DRAIN_WARN_MS;
+    bool warned = false;
+    while (pl->host_busy || pl->log_active) {
+        pipeline_poll(pl);
+        if (!warned && thingino_monotonic_ms() >= warn_at) {
+            thingino_printf("[WARN] Pipelined writer: waiting for cancelled transfers to complete\n");
+            warned = true;
+        }
+    }
+}
+
+/**
+ * Write a firmware image using a window of up to window_depth chunks in
+ * flight. Expects the same device state as the serial T31/T41 writer loop
+ * (address/length set, erase complete). Handshakes are taken from layout
+ * when it matches the profile's chunk size.
+ *
+ * Returns THINGINO_ERROR_TIMEOUT when a chunk whose host transfer timed out
+ * was never confirmed by the burner; *bytes_written is then the confirmed
+ * prefix and the caller can resend from there.
+ */
+thingino_error_t firmware_write_pipelined(usb_device_t* device, const write_profile_t* profile,
+                                         uint32_t window_depth, const uint8_t* data,
+                                         uint32_t size, const prepared_layout_t* layout,
+                                         uint32_t* bytes_written, uint32_t* chunks_written) {
+    if (!device || !(device->handle || device->transport) || !profile || !data || size == 0 ||
+        profile->chunk_size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    write_pipeline_t* pl = (write_pipeline_t*)calloc(1, sizeof(write_pipeline_t));
+    if (!pl) {
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    pl->device = device;
+    pl->profile = profile;
+    pl->layout = (layout && layout->chunk_size == profile->chunk_size) ? layout : NULL;
+    pl->total_size = size;
+    uint32_t depth = window_depth;
+    if (depth > profile->max_window_depth) depth = profile->max_window_depth;
+    write_window_init(&pl->window, depth, profile->settle_ms, WRITE_CHUNK_CONFIRM_MS);
+
+    thingino_error_t result = THINGINO_SUCCESS;
+
+    for (uint32_t i = 0; i < WRITE_WINDOW_MAX_SLOTS; i++) {
+        pl->slots[i].pl = pl;
+        pl->slots[i].bus_token = -1;
+        pl->slots[i].xfer = libusb_alloc_transfer(0);
+        if (!pl->slots[i].xfer) {
+            result = THINGINO_ERROR_MEMORY;
+        }
+    }
+    pl->log_xfer = libusb_alloc_transfer(0);
+    if (!pl->log_xfer) {
+        result = THINGINO_ERROR_MEMORY;
+    }
+
+    DEBUG_PRINT("Pipelined write: %u bytes, %s profile, chunk=%u, window=%u\n",
+                size, profile->name, profile->chunk_size, pl->window.depth);
+
+    // Discard events left over from metadata/erase; keep the log reader
+    // running for the whole write so completion reports arrive promptly.
+    while (burner_log_pop(&device->burner_log, NULL)) {
+    }
+
+    if (result == THINGINO_SUCCESS) {
+        libusb_fill_bulk_transfer(pl->log_xfer, device->handle, ENDPOINT_IN,
+                                  pl->log_buf, sizeof(pl->log_buf),
+                                  pipeline_log_cb, pl, 0);
+        pl->log_active = pipeline_submit(pl, pl->log_xfer, &pl->log_trace_us) == LIBUSB_SUCCESS;
+    }
+
+    uint32_t next_offset = 0;
+    uint32_t started = 0;
+
+    while (result == THINGINO_SUCCESS && pl->error == THINGINO_SUCCESS &&
+           (next_offset < size || !write_window_empty(&pl->window))) {
+        pipeline_process_log(pl);
+        if (pl->error != THINGINO_SUCCESS) {
+            break;
+        }
+
+        if (pl->bus_wait) {
+            pipeline_send_slice(pl);
+        }
+
+        if (!pl->host_busy && next_offset < size && write_window_has_room(&pl->window)) {
+            uint32_t chunk_size = profile->chunk_size;
+            if (next_offset + chunk_size > size) {
+                chunk_size = size - next_offset;
+            }
+
+            THINGINO_LOG(THINGINO_LOG_INFO, "  Chunk %u: Writing %u bytes at offset 0x%08X (%.1f%%, %u in flight)...\n",
+                   started + 1, chunk_size, next_offset,
+                   (next_offset + chunk_size) * 100.0 / size,
+                   pl->window.tail - pl->window.head + 1);
+
+            result = pipeline_start_chunk(pl, data + next_offset, next_offset, chunk_size);
+            if (result != THINGINO_SUCCESS) {
+                break;
+            }
+            next_offset += chunk_size;
+            started++;
+        }
+
+        pipeline_handle_events(pl);
+    }
+
+    if (result == THINGINO_SUCCESS) {
+        result = pl->error;
+    }
+
+    pipeline_drain(pl);
+
+    if (bytes_written) {
+        // Only chunks confirmed by the burner (or settled) count as written
+        uint64_t done = (uint64_t)pl->window.head * profile->chunk_size;
+        *bytes_written = done < size ? (uint32_t)done : size;
+    }
+    if (chunks_written) {
+        *chunks_written = pl->window.head;
+    }
+
+    for (uint32_t i = 0; i < WRITE_WINDOW_MAX_SLOTS; i++) {
+        libusb_free_transfer(pl->slots[i].xfer);
+    }
+    libusb_free_transfer(pl->log_xfer);
+    free(pl);
+
+    return result;
+}
@@ -0,0 +1,132 @@
+#include "write_window.h"
+
+#include <string.h>
+
+// ============================================================================
+// WRITE WINDOW IMPLEMENTATION
+// ============================================================================
+//
+// Time is passed in by the caller, like the retry policies.
+
+void write_window_init(write_window_t* window, uint32_t depth, uint32_t settle_ms,
+                       uint32_t confirm_ms) {
+    if (!window) {
+        return;
+    }
+
+    memset(window, 0, sizeof(*window));
+    if (depth < 1) depth = 1;
+    if (depth > WRITE_WINDOW_MAX_SLOTS) depth = WRITE_WINDOW_MAX_SLOTS;
+    window->depth = depth;
+    window->settle_ms = settle_ms;
+    window->confirm_ms = confirm_ms;
+}
+
+bool write_window_has_room(const write_window_t* window) {
+    return window && window->tail - window->head < window->depth;
+}
+
+bool write_window_empty(const write_window_t* window) {
+    return !window || window->head == window->tail;
+}
+
+write_window_slot_t* write_window_start(write_window_t* window, uint32_t offset, uint32_t size,
+                                        uint64_t now_us) {
+    if (!write_window_has_room(window)) {
+        return NULL;
+    }
+
+    write_window_slot_t* slot = &window->slots[window->tail % WRITE_WINDOW_MAX_SLOTS];
+    memset(slot, 0, sizeof(*slot));
+    slot->state = WRITE_SLOT_HOST;
+    slot->index = window->tail;
+    slot->offset = offset;
+    slot->size = size;
+    slot->started_us = now_us;
+    window->tail++;
+    return slot;
+}
+
+write_window_slot_t* write_window_slot(write_window_t* window, uint32_t index) {
+    if (!window || index - window->head >= window->tail - window->head) {
+        return NULL;
+    }
+    return &window->slots[index % WRITE_WINDOW_MAX_SLOTS];
+}
+
+void write_window_host_done(write_window_t* window, write_window_slot_t* slot, bool acked,
+                            uint64_t now_ms) {
+    if (!window || !slot || slot->state != WRITE_SLOT_HOST) {
+        return;
+    }
+    slot->state = WRITE_SLOT_PROGRAMMING;
+    slot->acked = acked;
+    slot->programmed_at_ms = now_ms;
+}
+
+// Oldest chunk in the window without this report yet
+static write_window_slot_t* write_window_oldest_unreported(write_window_t* window, bool done) {
+    for (uint32_t i = window->head; i != window->tail; i++) {
+        write_window_slot_t* slot = &window->slots[i % WRITE_WINDOW_MAX_SLOTS];
+        if (done ? !slot->done : !slot->received) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+bool write_window_event(write_window_t* window, const burner_event_t* event) {
+    if (!window || !event) {
+        return true;
+    }
+    if (BURNER_EVENT_MASK(event->type) & BURNER_EVENT_MASK_FAILURE) {
+        return false;
+    }
+
+    bool done = event->type == BURNER_EVENT_CHUNK_DONE;
+    if (!done && event->type != BURNER_EVENT_CRC_OK) {
+        return true;
+    }
+
+    write_window_slot_t* slot = event->value >= 0
+        ? write_window_slot(window, (uint32_t)event->value)
+        : write_window_oldest_unreported(window, done);
+    if (!slot) {
+        window->stale++;
+        return true;
+    }
+
+    slot->received = true;
+    if (done) {
+        slot->done = true;
+    }
+    return true;
+}
+
+write_window_retire_t write_window_retire(write_window_t* window, uint64_t now_ms,
+                                          write_window_slot_t* retired) {
+    if (write_window_empty(window)) {
+        return WRITE_WINDOW_WAIT;
+    }
+
+    write_window_slot_t* slot = &window->slots[window->head % WRITE_WINDOW_MAX_SLOTS];
+    if (slot->state != WRITE_SLOT_PROGRAMMING) {
+        return WRITE_WINDOW_WAIT;
+    }
+
+    uint64_t waited = now_ms - slot->programmed_at_ms;
+    bool trusted = slot->acked || slot->received;
+    if (!slot->done && !(trusted && waited >= window->settle_ms)) {
+        // Silent burners fall back to the settle time, but only for chunks
+        // the host saw go through cleanly
+        return !trusted && waited >= window->confirm_ms ? WRITE_WINDOW_UNCONFIRMED
+                                                        : WRITE_WINDOW_WAIT;
+    }
+
+    if (retired) {
+        *retired = *slot;
+    }
+    slot->state = WRITE_SLOT_FREE;
+    window->head++;
+    return WRITE_WINDOW_RETIRED;
+}
@@ -14,6 +14,7 @@
 
 #include "thingino.h"
 #include "firmware_database.h"
+#include "flash_descriptor.h"
 #include <unistd.h>
 #include <string.h>
 
@@ -22,6 +23,50 @@
 #define CHUNK_SIZE_1MB   (1024 * 1024)
 #define ENDPOINT_OUT 0x01
 
+// ============================================================================
+// WRITE PROFILES
+// ============================================================================
+
+// Chunk sizes match the vendor captures for each family. Window depth
+// defaults to 1 (serial writes, the behavior verified against the vendor
+// pcaps); deeper windows are opt-in via --window and are capped at what the
+// burner can buffer. A1 writes 1MB chunks, which already exceeds half of
+// BURNER_RX_BUFFER_BYTES, so it stays serial.
+#define WRITE_PROFILE_MAX_DEPTH(chunk) \
+    ((BURNER_RX_BUFFER_BYTES / (chunk)) > 0 ? (BURNER_RX_BUFFER_BYTES / (chunk)) : 1)
+
+static const write_profile_t write_profiles[] = {
+    { "t31", CHUNK_SIZE_128KB, 1, WRITE_PROFILE_MAX_DEPTH(CHUNK_SIZE_128KB), 300 },
+    { "t41", CHUNK_SIZE_64KB,  1, WRITE_PROFILE_MAX_DEPTH(CHUNK_SIZE_64KB),  300 },
+    { "a1",  CHUNK_SIZE_1MB,   1, 1,                                          300 },
+};
+
+/**
+ * Select the write profile for a firmware-stage device
+ */
+const write_profile_t* firmware_write_profile_get(const usb_device_t* device, bool is_a1_board) {
+    if (is_a1_board) {
+        return &write_profiles[2];
+    }
+    if (device && device->info.stage == STAGE_FIRMWARE &&
+        device->info.variant == VARIANT_T41) {
+        return &write_profiles[1];
+    }
+    return &write_profiles[0];
+}
+
+/**
+ * Default write profile for a handshake format (profiles are listed in
+ * write_handshake_format_t order), e.g. to prepare image layouts before
+ * any device is attached
+ */
+const write_profile_t* firmware_write_profile_for_format(write_handshake_format_t format) {
+    if ((unsigned)format >= WRITE_HANDSHAKE_FORMAT_COUNT) {
+        return NULL;
+    }
+    return &write_profiles[format];
+}
+
 // Wait for NOR erase to complete in firmware stage using VR_FW_READ_STATUS2.
 //
 // The vendor T31x write flow issues status checks (0x16/0x19/0x25/0x26) while
@@ -37,16 +82,18 @@
 //     few polls or when max_wait_ms is reached.
 //   - Any protocol errors are treated as "device busy"; we keep waiting up to
 //     max_wait_ms but do not fail the write purely due to status polling.
+//     The wait is measured on the clock: a failing status read can spend
+//     seconds in its retry policy, far longer than the poll interval.
 //
 // This mirrors the vendor behavior ("wait on status before writes") without
 // depending on undocumented status bit semantics.
-static void firmware_wait_for_erase_ready(usb_device_t* device,
-                                          int min_wait_ms,
-                                          int max_wait_ms) {
+static thingino_error_t firmware_wait_for_erase_ready(usb_device_t* device,
+                                                      int min_wait_ms,
+                                                      int max_wait_ms) {
     const int poll_interval_ms = 500;  // 0.5s between polls
 
     if (!device) {
-        return;
+        return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
     // Only do firmware-stage polling for T31-family variants. For other
@@ -56,15 +103,15 @@ static void firmware_wait_for_erase_ready(usb_device_t* device,
           device->info.variant == VARIANT_T31X ||
           device->info.variant == VARIANT_T31ZX ||
           device->info.variant == VARIANT_T41)) {
-        usleep((useconds_t)min_wait_ms * 1000);
-        return;
+        return usb_device_sleep(device, (uint32_t)min_wait_ms);
     }
 
     if (min_wait_ms < 0) min_wait_ms = 0;
     if (max_wait_ms < min_wait_ms) max_wait_ms = min_wait_ms;
 
-    printf("Waiting for device to prepare flash (erase) using status polling...\n");
+    thingino_printf("Waiting for device to prepare flash (erase) using status polling...\n");
 
+    uint64_t started_ms = thingino_monotonic_ms();
     int elapsed_ms = 0;
     uint32_t last_status = 0;
     int stable_count = 0;
@@ -103,19 +150,24 @@ static void firmware_wait_for_erase_ready(usb_device_t* device,
                     break;
                 }
             }
+        } else if (st == THINGINO_ERROR_CANCELLED) {
+            return st;
         } else {
             DEBUG_PRINT("Erase status poll error at %d ms: %s\n",
                         elapsed_ms, thingino_error_to_string(st));
         }
 
-        usleep((useconds_t)poll_interval_ms * 1000);
-        elapsed_ms += poll_interval_ms;
+        if (usb_device_sleep(device, (uint32_t)poll_interval_ms) != THINGINO_SUCCESS) {
+            return THINGINO_ERROR_CANCELLED;
+        }
+        elapsed_ms = (int)(thingino_monotonic_ms() - started_ms);
     }
 
     if (elapsed_ms >= max_wait_ms) {
-        printf("[WARN] Timed out waiting for firmware erase status after %d ms; "
+        thingino_printf("[WARN] Timed out waiting for firmware erase status after %d ms; "
                "continuing with write anyway.\n", elapsed_ms);
     }
+    return THINGINO_SUCCESS;
 }
 
 // T41N/XBurst2 firmware write path: simple 64KB bulk chunks without VR_WRITE
@@ -144,7 +196,7 @@ static __attribute__((unused)) thingino_error_t write_firmware_t41n_simple(usb_d
         chunk_num++;
         uint32_t current_flash_addr = flash_base_address + bytes_written;
 
-        printf("  [T41N] Chunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
+        THINGINO_LOG(THINGINO_LOG_INFO, "  [T41N] Chunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
                chunk_num, chunk_size, current_flash_addr,
                (bytes_written + chunk_size) * 100.0 / firmware_size);
 
@@ -169,7 +221,7 @@ static __attribute__((unused)) thingino_error_t write_firmware_t41n_simple(usb_d
         bytes_written += (uint32_t)transferred;
 
         DEBUG_PRINT("T41N: waiting 100ms after chunk %u\n", chunk_num);
-        usleep(100000); // 100ms between chunks
+        thingino_sleep_milliseconds(100); // 100ms between chunks
     }
 
     *bytes_written_out = bytes_written;
@@ -254,8 +306,8 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     }
 
     if (!f) {
-        printf("[ERROR] T41N partition marker file not found.\n");
-        printf("        Expected at tools/extracted_t41n_write/"
+        thingino_printf("[ERROR] T41N partition marker file not found.\n");
+        thingino_printf("        Expected at tools/extracted_t41n_write/"
                "bulk_out_0001_frame184_172bytes.bin (relative to CWD).\n");
         return THINGINO_ERROR_FILE_IO;
     }
@@ -263,7 +315,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     size_t n = fread(marker, 1, T41N_PARTITION_MARKER_SIZE, f);
     fclose(f);
     if (n != T41N_PARTITION_MARKER_SIZE) {
-        printf("[ERROR] Failed to read T41N partition marker from %s: got %zu bytes, expected %d\n",
+        thingino_printf("[ERROR] Failed to read T41N partition marker from %s: got %zu bytes, expected %d\n",
                path_used ? path_used : "(unknown)", n, T41N_PARTITION_MARKER_SIZE);
         return THINGINO_ERROR_FILE_IO;
     }
@@ -271,7 +323,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     // in t41_full_write_20251119_185651.pcap (frame 172).
     thingino_error_t meta_result = protocol_fw_write_chunk2(device, T41N_FW_WRITE2_CMD1);
     if (meta_result != THINGINO_SUCCESS) {
-        printf("[ERROR] T41N FW_WRITE2 command #1 failed: %s\n",
+        thingino_printf("[ERROR] T41N FW_WRITE2 command #1 failed: %s\n",
                thingino_error_to_string(meta_result));
         return meta_result;
     }
@@ -289,7 +341,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
                                                        &transferred,
                                                        5000);
     if (result != THINGINO_SUCCESS || transferred != (int)T41N_PARTITION_MARKER_SIZE) {
-        printf("[ERROR] T41N partition marker transfer failed: status=%s, transferred=%d/%d bytes\n",
+        thingino_printf("[ERROR] T41N partition marker transfer failed: status=%s, transferred=%d/%d bytes\n",
                thingino_error_to_string(result), transferred, T41N_PARTITION_MARKER_SIZE);
         return (result == THINGINO_SUCCESS) ? THINGINO_ERROR_TRANSFER_FAILED : result;
     }
@@ -322,7 +374,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
 
 
     // Short delay to let burner process the marker
-    usleep(100000); // 100ms
+    thingino_sleep_milliseconds(100); // 100ms
 
     // Load flash descriptor (RDD/GBD/ILOP/CFS, 984 bytes)
     f = NULL;
@@ -336,8 +388,8 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     }
 
     if (!f) {
-        printf("[ERROR] T41N flash descriptor file not found.\n");
-        printf("        Expected at tools/extracted_t41n_write/"
+        thingino_printf("[ERROR] T41N flash descriptor file not found.\n");
+        thingino_printf("        Expected at tools/extracted_t41n_write/"
                "bulk_out_0002_frame206_984bytes.bin (relative to CWD).\n");
         return THINGINO_ERROR_FILE_IO;
     }
@@ -345,7 +397,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     n = fread(descriptor, 1, T41N_FLASH_DESCRIPTOR_SIZE, f);
     fclose(f);
     if (n != T41N_FLASH_DESCRIPTOR_SIZE) {
-        printf("[ERROR] Failed to read T41N flash descriptor from %s: got %zu bytes, expected %d\n",
+        thingino_printf("[ERROR] Failed to read T41N flash descriptor from %s: got %zu bytes, expected %d\n",
                path_used ? path_used : "(unknown)", n, T41N_FLASH_DESCRIPTOR_SIZE);
         return THINGINO_ERROR_FILE_IO;
     }
@@ -354,7 +406,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     DEBUG_PRINT("T41N: sending FW_WRITE2 metadata command #2 before descriptor...\n");
     result = protocol_fw_write_chunk2(device, T41N_FW_WRITE2_CMD2);
     if (result != THINGINO_SUCCESS) {
-        printf("[ERROR] T41N FW_WRITE2 command #2 failed: %s\n",
+        thingino_printf("[ERROR] T41N FW_WRITE2 command #2 failed: %s\n",
                thingino_error_to_string(result));
         return result;
     }
@@ -373,10 +425,10 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
                                       30000);
     if (result != THINGINO_SUCCESS || transferred != (int)T41N_FLASH_DESCRIPTOR_SIZE) {
         if (result == THINGINO_ERROR_TIMEOUT && transferred == 0) {
-            printf("[WARN] T41N flash descriptor transfer timed out with 0 bytes; "
+            thingino_printf("[WARN] T41N flash descriptor transfer timed out with 0 bytes; "
                    "continuing anyway (descriptor may be optional)\n");
         } else {
-            printf("[ERROR] T41N flash descriptor transfer failed: status=%s, transferred=%d/%d bytes\n",
+            thingino_printf("[ERROR] T41N flash descriptor transfer failed: status=%s, transferred=%d/%d bytes\n",
                    thingino_error_to_string(result), transferred, T41N_FLASH_DESCRIPTOR_SIZE);
             return (result == THINGINO_SUCCESS) ? THINGINO_ERROR_TRANSFER_FAILED : result;
         }
@@ -401,7 +453,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
     DEBUG_PRINT("T41N: sending VR_FW_HANDSHAKE (0x11) after descriptor...\n");
     result = protocol_fw_handshake(device);
     if (result != THINGINO_SUCCESS) {
-        printf("[ERROR] T41N VR_FW_HANDSHAKE after descriptor failed: %s\n",
+        thingino_printf("[ERROR] T41N VR_FW_HANDSHAKE after descriptor failed: %s\n",
                thingino_error_to_string(result));
         return result;
     }
@@ -424,7 +476,7 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
 
 
     // Small delay after descriptor
-    usleep(100000); // 100ms
+    thingino_sleep_milliseconds(100); // 100ms
 
     DEBUG_PRINT("T41N metadata (partition marker + descriptor) sent successfully\n");
     return THINGINO_SUCCESS;
@@ -434,27 +486,166 @@ static thingino_error_t t41n_send_write_metadata(usb_device_t *device) {
 /**
  * Write firmware to device
  *
- * This implements the complete write sequence as observed from vendor cloner:
- * - Bootstrap device (DDR + SPL + U-Boot)
- * - Send partition marker
- * - Send metadata
- * - Send firmware in 128KB chunks (T31x) or 1MB chunks (A1)
+ * Maps the image and hands it to write_firmware_prepared(). Handshakes are
+ * computed per chunk; callers flashing the same image to several devices
+ * should prepare it once and call write_firmware_prepared() directly.
  */
 thingino_error_t write_firmware_to_device(usb_device_t* device,
                                          const char* firmware_file,
                                          const firmware_binary_t* fw_binary,
                                          bool force_erase,
-                                         bool is_a1_board) {
+                                         bool is_a1_board,
+                                         uint32_t window_depth) {
     if (!device || !firmware_file) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    (void)force_erase; // Currently unused; reserved for future erase-policy control
+    thingino_printf("Writing firmware to device...\n");
+    thingino_printf("  Firmware file: %s\n", firmware_file);
+
+    // Step 1: Map the firmware file (read-only, shared page cache)
+    prepared_image_t image;
+    if (prepared_image_open(&image, firmware_file) != 0) {
+        thingino_eprintf("Error: Cannot open firmware file: %s\n", firmware_file);
+        return THINGINO_ERROR_FILE_IO;
+    }
+
+    thingino_error_t result = write_firmware_prepared(device, &image, fw_binary, force_erase,
+                                                      is_a1_board, window_depth);
+    prepared_image_close(&image);
+    return result;
+}
+
+/**
+ * Get a firmware-stage device ready for writing. Detects A1 boards via CPU
+ * magic (they need their own flash descriptor and handshakes) and, for the
+ * T31 family, sends the partition marker, flash descriptor and handshake
+ * init the burner expects before the first chunk.
+ *
+ * @param is_a1_board Set to true when the device is an A1 board
+ */
+thingino_error_t firmware_write_prepare(usb_device_t* device, bool* is_a1_board) {
+    if (!device || !is_a1_board) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    // Detect A1 firmware-stage boards via CPU magic so we can use the correct
+    // flash descriptor (A1 uses XM25QH128B, T31x uses GD25Q127CSIG).
+    bool is_a1_fw_stage = false;
+    cpu_info_t fw_cpu_info;
+    memset(&fw_cpu_info, 0, sizeof(fw_cpu_info));
+    thingino_error_t fw_cpu_res = usb_device_get_cpu_info(device, &fw_cpu_info);
+    if (fw_cpu_res == THINGINO_SUCCESS) {
+        if (strncmp(fw_cpu_info.clean_magic, "A1", 2) == 0 ||
+            strncmp(fw_cpu_info.clean_magic, "a1", 2) == 0) {
+            is_a1_fw_stage = true;
+            DEBUG_PRINT("Detected A1 CPU magic ('%s') in firmware stage\n",
+                       fw_cpu_info.clean_magic);
+        }
+    }
+
+    // Prepare burner protocol in firmware stage: send partition marker,
+    // then flash descriptor, then initialize the firmware handshake
+    // protocol. This mirrors the vendor write sequence more closely:
+    //   - Chunk 3: 172-byte "ILOP" partition marker (bulk OUT)
+    //   - Chunk 4: 972-byte flash descriptor + policies (contains "nor" string
+    //     that tells A1 burner to use NOR flash mode instead of MMC mode)
+    //   - Then firmware write handshakes and data chunks.
+    //
+    // NOTE: A1 boards also need this! The metadata contains the crucial "nor"
+    // string at offset 0xF0 that tells the burner to use NOR flash mode.
+    // Without it, the A1 burner tries to write to MMC/SD card and fails.
+    if (device->info.stage == STAGE_FIRMWARE &&
+        (device->info.variant == VARIANT_T31 ||
+         device->info.variant == VARIANT_T31X ||
+         device->info.variant == VARIANT_T31ZX)) {
+
+        thingino_error_t prep_result = THINGINO_SUCCESS;
+
+        thingino_printf("Preparing partition marker, flash descriptor and firmware handshake...\n");
+
+        // 1) Send 172-byte partition marker ("ILOP" header)
+        prep_result = flash_partition_marker_send(device);
+        if (prep_result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] Failed to send partition marker: %s\n",
+                   thingino_error_to_string(prep_result));
+            return prep_result;
+        }
+
+        // 2) Build and send full 972-byte flash descriptor
+        // Use A1-specific descriptor for A1 boards, T31x descriptor otherwise.
+        // The A1 descriptor contains the XM25QH128B flash chip info and the
+        // crucial "nor" string at offset 0xF0 that tells the burner to use
+        // NOR flash mode instead of MMC mode.
+        uint8_t flash_descriptor[FLASH_DESCRIPTOR_SIZE];
+        int desc_result;
+        if (is_a1_fw_stage) {
+            desc_result = flash_descriptor_create_a1_writer_full(flash_descriptor);
+            if (desc_result != 0) {
+                thingino_printf("[ERROR] Failed to create A1 writer_full flash descriptor\n");
+                return THINGINO_ERROR_MEMORY;
+            }
+        } else {
+            desc_result = flash_descriptor_create_t31x_writer_full(flash_descriptor);
+            if (desc_result != 0) {
+                thingino_printf("[ERROR] Failed to create T31x writer_full flash descriptor\n");
+                return THINGINO_ERROR_MEMORY;
+            }
+        }
+
+        prep_result = flash_descriptor_send(device, flash_descriptor);
+        if (prep_result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] Failed to send flash descriptor: %s\n",
+                   thingino_error_to_string(prep_result));
+            return prep_result;
+        }
+
+        // Give the burner time to process descriptor, matching read path
+        thingino_sleep_milliseconds(500); // 500ms
+
+        // 3) Initialize the firmware handshake protocol (VR_FW_HANDSHAKE)
+        prep_result = firmware_handshake_init(device);
+        if (prep_result != THINGINO_SUCCESS) {
+            thingino_printf("[ERROR] Failed to initialize firmware handshake: %s\n",
+                   thingino_error_to_string(prep_result));
+            return prep_result;
+        }
+    }
+
+    *is_a1_board = is_a1_fw_stage;
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Start a firmware write session
+ *
+ * This implements the device side of the write sequence observed from the
+ * vendor cloner, up to the first data chunk:
+ * - Send T41N partition marker and metadata
+ * - Set flash base address and write length
+ * - Wait for the chip erase to complete
+ *
+ * total_size is the number of bytes that will be passed to
+ * firmware_write_chunk(); the data itself is not needed yet, so a caller can
+ * start streaming before it has the whole image.
+ */
+thingino_error_t firmware_write_begin(firmware_write_session_t* session,
+                                      usb_device_t* device,
+                                      const firmware_binary_t* fw_binary,
+                                      bool is_a1_board,
+                                      uint32_t total_size) {
+    if (!session || !device || total_size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    const char* label = session->label;
+    memset(session, 0, sizeof(*session));
+    session->device = device;
+    session->total_size = total_size;
+    session->label = label;
 
-    printf("Writing firmware to device...\n");
-    printf("  Firmware file: %s\n", firmware_file);
     if (fw_binary) {
-        printf("  SoC: %s\n", fw_binary->processor);
+        thingino_printf("  SoC: %s\n", fw_binary->processor);
     }
 
     // Use the is_a1_board flag passed from main.c (detected before flash
@@ -467,85 +658,70 @@ thingino_error_t write_firmware_to_device(usb_device_t* device,
     if (!is_a1_fw && fw_binary && fw_binary->processor) {
         if (strncmp(fw_binary->processor, "a1_", 3) == 0) {
             is_a1_fw = true;
-            printf("  Detected A1 firmware variant (%s) -> enabling A1 write handshakes\n",
+            thingino_printf("  Detected A1 firmware variant (%s) -> enabling A1 write handshakes\n",
                    fw_binary->processor);
         }
     }
 
     if (is_a1_fw) {
-        printf("  Detected A1 CPU magic ('A1') -> enabling A1 write handshakes\n");
-    }
-
-    // Step 1: Load firmware file
-    FILE* file = fopen(firmware_file, "rb");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open firmware file: %s\n", firmware_file);
-        return THINGINO_ERROR_FILE_IO;
-    }
-
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long firmware_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (firmware_size <= 0) {
-        fprintf(stderr, "Error: Invalid firmware file size\n");
-        fclose(file);
-        return THINGINO_ERROR_FILE_IO;
-    }
-    if ((unsigned long)firmware_size > (unsigned long)UINT32_MAX) {
-        fprintf(stderr, "Error: Firmware file too large (%ld bytes)\n", firmware_size);
-        fclose(file);
-        return THINGINO_ERROR_INVALID_PARAMETER;
+        thingino_printf("  Detected A1 CPU magic ('A1') -> enabling A1 write handshakes\n");
     }
+    session->is_a1 = is_a1_fw;
 
-    uint32_t firmware_size_u = (uint32_t)firmware_size;
-    printf("  Firmware size: %u bytes (%.1f KB)\n", firmware_size_u, firmware_size_u / 1024.0);
-
-    // Allocate buffer for firmware
-    uint8_t* firmware_data = (uint8_t*)malloc(firmware_size_u);
-    if (!firmware_data) {
-        fprintf(stderr, "Error: Cannot allocate memory for firmware\n");
-        fclose(file);
-        return THINGINO_ERROR_MEMORY;
-    }
-
-    // Read firmware
-    size_t bytes_read = fread(firmware_data, 1, firmware_size_u, file);
-    fclose(file);
+    thingino_error_t result;
 
-    if (bytes_read != (size_t)firmware_size_u) {
-        fprintf(stderr, "Error: Failed to read firmware file\n");
-        free(firmware_data);
-        return THINGINO_ERROR_FILE_IO;
+    // Pick the chunk size and pacing for this variant, applying any tuned
+    // values from the local transfer profile store.
+    write_profile_t* tuned = &session->profile;
+    *tuned = *firmware_write_profile_get(device, is_a1_fw);
+    transfer_profile_t tp;
+    if (transfer_profile_lookup(processor_variant_to_string(device->info.variant),
+                                device->info.flash_chip, &tp)) {
+        // Handshakes encode the chunk size in 64KB units
+        if (tp.write_chunk_size >= CHUNK_SIZE_64KB &&
+            tp.write_chunk_size % CHUNK_SIZE_64KB == 0 &&
+            tp.write_chunk_size <= CHUNK_SIZE_1MB) {
+            tuned->chunk_size = tp.write_chunk_size;
+            // A1 handshakes are not pipelined; keep it serial
+            if (!is_a1_fw) {
+                tuned->max_window_depth = WRITE_PROFILE_MAX_DEPTH(tuned->chunk_size);
+            }
+            if (tuned->window_depth > tuned->max_window_depth) {
+                tuned->window_depth = tuned->max_window_depth;
+            }
+        } else if (tp.write_chunk_size != 0) {
+            thingino_printf("  [WARN] Ignoring transfer profile write chunk of %u bytes\n",
+                   tp.write_chunk_size);
+        }
+        if (tp.write_settle_ms) {
+            tuned->settle_ms = tp.write_settle_ms;
+        }
+        thingino_printf("  Transfer profile %s/%s: chunk=%u bytes, settle=%u ms\n",
+               tp.variant, tp.flash, tuned->chunk_size, tuned->settle_ms);
     }
 
-    // Step 2: Prepare flash address and length for firmware write
-    thingino_error_t result;
-
     // For T41N/X2580 firmware-stage writes, the vendor cloner sends a
     // partition marker ("ILOP", 172 bytes) and a 984-byte flash descriptor
     // before programming the full image. Replay that metadata here so the
     // burner knows the NOR geometry and policy.
     if (device->info.stage == STAGE_FIRMWARE &&
         device->info.variant == VARIANT_T41) {
-        printf("\nStep 0: Sending T41N partition marker and flash descriptor...\n");
+        thingino_printf("\nStep 0: Sending T41N partition marker and flash descriptor...\n");
         result = t41n_send_write_metadata(device);
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "Error: Failed to send T41N metadata: %s\n",
+            thingino_eprintf("Error: Failed to send T41N metadata: %s\n",
                     thingino_error_to_string(result));
-            free(firmware_data);
             return result;
         }
     }
 
-    printf("\nStep 1: Preparing firmware write (address/length)...\n");
+    thingino_printf("\nStep 1: Preparing firmware write (address/length)...\n");
 
     // Vendor T31 capture shows main firmware written starting at flash 0x00008010
-    uint32_t flash_base_address = 0x00008010;
+    session->flash_base_address = 0x00008010;
 
     DEBUG_PRINT("Setting flash base address with SetDataAddress: 0x%08lX\n",
-                (unsigned long)flash_base_address);
+                (unsigned long)session->flash_base_address);
 
     // For T31 firmware-stage write, vendor capture shows VR_SET_DATA_ADDR
     // with bmRequestType=0x40, bRequest=0x01, wValue=0x8010, wIndex=0 for
@@ -556,13 +732,12 @@ thingino_error_t write_firmware_to_device(usb_device_t* device,
     int addr_resp_len = 0;
     result = usb_device_vendor_request(device, REQUEST_TYPE_OUT,
                                        VR_SET_DATA_ADDR,
-                                       (uint16_t)(flash_base_address & 0xFFFF),
+                                       (uint16_t)(session->flash_base_address & 0xFFFF),
                                        0,
                                        NULL, 0, NULL, &addr_resp_len);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Error: Failed to set flash base address: %s\n",
+        thingino_eprintf("Error: Failed to set flash base address: %s\n",
                 thingino_error_to_string(result));
-        free(firmware_data);
         return result;
     }
 
@@ -572,34 +747,38 @@ thingino_error_t write_firmware_to_device(usb_device_t* device,
     // to VR_FW_READ_STATUS2 during erase (returns 0 or times out), so we use a
     // fixed delay instead of status polling.
     if (is_a1_fw) {
-        printf("Waiting for A1 chip erase to complete (this takes ~60 seconds)...\n");
-        printf("  The device will not respond to status requests during erase.\n");
+        thingino_printf("Waiting for A1 chip erase to complete (this takes ~60 seconds)...\n");
+        thingino_printf("  The device will not respond to status requests during erase.\n");
 
         // Wait 60 seconds for erase to complete
+        uint64_t erase_start = thingino_monotonic_ms();
         for (int i = 0; i < 60; i++) {
-            printf("\r  Erase progress: %d/60 seconds...", i + 1);
-            fflush(stdout);
-            sleep(1);
+            thingino_printf("\r  Erase progress: %d/60 seconds...", i + 1);
+            thingino_log_flush();  // Through the log ring, in order with other output
+            if (usb_device_sleep(device, 1000) != THINGINO_SUCCESS) {
+                thingino_printf("\n");
+                return THINGINO_ERROR_CANCELLED;
+            }
         }
-        printf("\n");
-        printf("Erase should be complete, proceeding with write...\n");
+        thingino_printf("\n");
+        thingino_event_erase(device, thingino_monotonic_ms() - erase_start);
+        thingino_printf("Erase should be complete, proceeding with write...\n");
     }
 
     // Set data length before the first chunk. Vendor captures show:
     // - T31x: Set total firmware size.
-    // - T41N: Use a fixed 64KB length for per-chunk VR_WRITE writes.
+    // - T41N: Use the per-chunk length (64KB) for per-chunk VR_WRITE writes.
     // - A1: Set total firmware size (sent after erase completes).
     uint32_t set_length = (device->info.stage == STAGE_FIRMWARE &&
                            device->info.variant == VARIANT_T41)
-                              ? (uint32_t)CHUNK_SIZE_64KB
-                              : (uint32_t)firmware_size;
+                              ? tuned->chunk_size
+                              : total_size;
 
     DEBUG_PRINT("Setting firmware write length with SetDataLength: %lu bytes\n",
                 (unsigned long)set_length);
     result = protocol_set_data_length(device, set_length);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Error: Failed to set firmware write length: %s\n", thingino_error_to_string(result));
-        free(firmware_data);
+        thingino_eprintf("Error: Failed to set firmware write length: %s\n", thingino_error_to_string(result));
         return result;
     }
 
@@ -610,129 +789,215 @@ thingino_error_t write_firmware_to_device(usb_device_t* device,
         // can take significantly longer than subsequent runs, so rely on firmware
         // status polling instead of a fixed sleep. We still enforce a minimum 5s
         // delay and cap the wait at 60s for safety.
-        firmware_wait_for_erase_ready(device, 5000 /* min_wait_ms */, 60000 /* max_wait_ms */);
+        uint64_t erase_start = thingino_monotonic_ms();
+        result = firmware_wait_for_erase_ready(device, 5000 /* min_wait_ms */, 60000 /* max_wait_ms */);
+        if (result != THINGINO_SUCCESS) {
+            return result;
+        }
+        thingino_event_erase(device, thingino_monotonic_ms() - erase_start);
     }
 
     // NOTE: VR_FW_HANDSHAKE (0x11) should be sent earlier (after U-Boot load),
     // not here. Vendor capture shows it's sent once at frame 13467, way before
     // the firmware chunks start at frame 14051. Sending it here puts device in bad state.
 
-    // Step 3: Send firmware with variant-specific protocol
-    printf("\nStep 2: Writing firmware data...\n");
+    return THINGINO_SUCCESS;
+}
 
-    uint32_t bytes_written = 0;
-    uint32_t chunk_num = 0;
-    result = THINGINO_SUCCESS;
+/**
+ * Write the next chunk of a session. size must not exceed the session's
+ * profile chunk size; only the last chunk may be shorter. handshake may
+ * point to a precomputed 40-byte handshake (NULL = build it here).
+ */
+thingino_error_t firmware_write_chunk(firmware_write_session_t* session,
+                                      const uint8_t* data, uint32_t size,
+                                      const uint8_t* handshake) {
+    if (!session || !session->device || !data || size == 0 ||
+        size > session->profile.chunk_size ||
+        session->bytes_written + size > session->total_size) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
 
-    if (device->info.stage == STAGE_FIRMWARE &&
-        device->info.variant == VARIANT_T41) {
-        // T41N/XBurst2 path: 64KB chunks with VR_WRITE (0x12) handshakes,
-        // matching t41_full_write_20251119_185651.pcap.
-        while (bytes_written < (uint32_t)firmware_size) {
-            uint32_t chunk_size = CHUNK_SIZE_64KB;
-            if (bytes_written + chunk_size > (uint32_t)firmware_size) {
-                chunk_size = (uint32_t)firmware_size - bytes_written;
-            }
+    usb_device_t* device = session->device;
+    bool is_t41 = device->info.stage == STAGE_FIRMWARE && device->info.variant == VARIANT_T41;
+    uint32_t chunk_index = session->chunk_num;           // 0-based index
+    uint32_t chunk_offset = session->bytes_written;      // offset relative to flash_base_address
+    uint32_t current_flash_addr = session->flash_base_address + chunk_offset;
+    thingino_error_t result;
 
-            chunk_num++;
-            uint32_t chunk_offset = bytes_written;  // offset relative to flash_base_address
-            uint32_t current_flash_addr = flash_base_address + chunk_offset;
-
-            printf("  [T41N] Chunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
-                   chunk_num, chunk_size, current_flash_addr,
-                   (bytes_written + chunk_size) * 100.0 / firmware_size);
-
-            // Use 40-byte VR_WRITE (0x12) handshakes per chunk, matching the
-            // vendor T41N NOR writer behavior.
-            result = firmware_handshake_write_chunk(device, chunk_num - 1,  // 0-based index
-                                                   chunk_offset,
-                                                   firmware_data + bytes_written,
-                                                   chunk_size);
-            if (result != THINGINO_SUCCESS) {
-                fprintf(stderr, "Error: Failed to write T41N chunk %u\n", chunk_num);
-                free(firmware_data);
-                return result;
-            }
+    session->chunk_num++;
 
-            bytes_written += chunk_size;
-        }
-    } else if (is_a1_fw) {
+    THINGINO_LOG(THINGINO_LOG_INFO, "  %s%s%sChunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
+           session->label ? session->label : "", session->label ? " " : "",
+           session->is_a1 ? "[A1] " : (is_t41 ? "[T41N] " : ""),
+           session->chunk_num, size, current_flash_addr,
+           (chunk_offset + size) * 100.0 / session->total_size);
+
+    uint64_t started_us = thingino_monotonic_us();
+    uint64_t saved_deadline = usb_device_budget_begin(device, WRITE_CHUNK_BUDGET_MS);
+    if (session->is_a1) {
         // A1 path: 1MB chunks with A1-specific VR_WRITE handshakes.
         // Pattern from a1_full_write_20251119_221121.pcap shows 1MB (0x100000) chunks.
-        while (bytes_written < (uint32_t)firmware_size) {
-            uint32_t chunk_size = CHUNK_SIZE_1MB;
-            if (bytes_written + chunk_size > (uint32_t)firmware_size) {
-                chunk_size = (uint32_t)firmware_size - bytes_written;
-            }
+        result = handshake
+            ? firmware_handshake_send_chunk_a1(device, chunk_index, chunk_offset, data, size, handshake)
+            : firmware_handshake_write_chunk_a1(device, chunk_index, chunk_offset, data, size);
+    } else {
+        // T31-family (128KB) and T41N/XBurst2 (64KB, matching
+        // t41_full_write_20251119_185651.pcap) paths: 40-byte VR_WRITE (0x12)
+        // handshakes per chunk, matching the vendor NOR writer behavior.
+        result = handshake
+            ? firmware_handshake_send_chunk(device, chunk_index, chunk_offset, data, size, handshake)
+            : firmware_handshake_write_chunk(device, chunk_index, chunk_offset, data, size);
+    }
+    usb_device_budget_end(device, saved_deadline);
 
-            chunk_num++;
-            uint32_t chunk_offset = bytes_written;  // offset relative to flash_base_address
-            uint32_t current_flash_addr = flash_base_address + chunk_offset;
-
-            printf("  [A1] Chunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
-                   chunk_num, chunk_size, current_flash_addr,
-                   (bytes_written + chunk_size) * 100.0 / firmware_size);
-
-            // Use A1-specific 40-byte VR_WRITE (0x12) handshakes per chunk.
-            result = firmware_handshake_write_chunk_a1(device, chunk_num - 1,  // 0-based index
-                                                       chunk_offset,
-                                                       firmware_data + bytes_written,
-                                                       chunk_size);
-            if (result != THINGINO_SUCCESS) {
-                fprintf(stderr, "Error: Failed to write A1 chunk %u\n", chunk_num);
-                free(firmware_data);
-                return result;
-            }
+    if (result != THINGINO_SUCCESS) {
+        thingino_eprintf("Error: Failed to write %schunk %u\n",
+                session->is_a1 ? "A1 " : (is_t41 ? "T41N " : ""), session->chunk_num);
+        return result;
+    }
 
-            bytes_written += chunk_size;
-        }
-    } else {
-        // Default T31-family path: 128KB chunks with VR_WRITE handshakes.
-        while (bytes_written < (uint32_t)firmware_size) {
-            uint32_t chunk_size = CHUNK_SIZE_128KB;
-            if (bytes_written + chunk_size > (uint32_t)firmware_size) {
-                chunk_size = (uint32_t)firmware_size - bytes_written;
-            }
+    thingino_event_chunk(device, true, size, thingino_monotonic_us() - started_us);
+    session->bytes_written += size;
+    thingino_progress(session->device, "write", session->bytes_written, session->total_size);
+    return THINGINO_SUCCESS;
+}
 
-            chunk_num++;
-            uint32_t chunk_offset = bytes_written;  // offset relative to flash_base_address
-            uint32_t current_flash_addr = flash_base_address + chunk_offset;
-
-            printf("  Chunk %u: Writing %u bytes at 0x%08X (%.1f%%)...\n",
-                   chunk_num, chunk_size, current_flash_addr,
-                   (bytes_written + chunk_size) * 100.0 / firmware_size);
-
-            // Use 40-byte VR_WRITE (0x12) handshakes per chunk, matching the
-            // vendor NOR writer behavior.
-            result = firmware_handshake_write_chunk(device, chunk_num - 1,  // 0-based index
-                                                   chunk_offset,
-                                                   firmware_data + bytes_written,
-                                                   chunk_size);
-            if (result != THINGINO_SUCCESS) {
-                fprintf(stderr, "Error: Failed to write chunk %u\n", chunk_num);
-                free(firmware_data);
-                return result;
-            }
+/**
+ * Finish a write session: flush the burner's cache and report
+ */
+thingino_error_t firmware_write_end(firmware_write_session_t* session) {
+    if (!session || !session->device) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
 
-            bytes_written += chunk_size;
-        }
+    if (session->bytes_written != session->total_size) {
+        thingino_printf("[WARNING] Write ended after %u of %u bytes\n",
+               session->bytes_written, session->total_size);
     }
 
     // Flush cache after all writes
-    printf("\nFlushing cache...\n");
-    result = protocol_flush_cache(device);
+    thingino_printf("\nFlushing cache...\n");
+    thingino_error_t result = protocol_flush_cache(session->device);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Warning: Failed to flush cache\n");
+        thingino_eprintf("Warning: Failed to flush cache\n");
         // Don't fail on flush error
     }
 
-    printf("\nFirmware write complete!\n");
-    printf("  Total written: %u bytes in %u chunks\n", bytes_written, chunk_num);
+    thingino_printf("\nFirmware write complete!\n");
+    thingino_printf("  Total written: %u bytes in %u chunks\n", session->bytes_written, session->chunk_num);
 
-    free(firmware_data);
     return THINGINO_SUCCESS;
 }
 
+static thingino_error_t write_firmware_prepared_run(usb_device_t* device,
+                                                   const prepared_image_t* image,
+                                                   const firmware_binary_t* fw_binary,
+                                                   bool force_erase,
+                                                   bool is_a1_board,
+                                                   uint32_t window_depth) {
+    if (!device || !image || !image->image.data) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    (void)force_erase; // Currently unused; reserved for future erase-policy control
+
+    if ((unsigned long long)image->image.size > (unsigned long long)UINT32_MAX) {
+        thingino_eprintf("Error: Firmware file too large (%zu bytes)\n", image->image.size);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    const uint8_t* firmware_data = image->image.data;
+    uint32_t firmware_size_u = (uint32_t)image->image.size;
+    thingino_printf("  Firmware size: %u bytes (%.1f KB)%s\n", firmware_size_u, firmware_size_u / 1024.0,
+           image->image.mapped ? "" : " [buffered]");
+
+    firmware_write_session_t session = { 0 };
+    thingino_error_t result = firmware_write_begin(&session, device, fw_binary, is_a1_board,
+                                                   firmware_size_u);
+    if (result != THINGINO_SUCCESS) {
+        return result;
+    }
+    const write_profile_t* profile = &session.profile;
+
+    // Step 3: Send firmware with variant-specific protocol
+    thingino_printf("\nStep 2: Writing firmware data...\n");
+
+    // Golden-image fan-out: reuse precomputed CRCs/handshakes when the image
+    // was prepared for this device's handshake format and chunk size
+    const prepared_layout_t* layout = prepared_image_layout(
+        image, firmware_write_handshake_format(device, session.is_a1), profile->chunk_size);
+    if (layout) {
+        DEBUG_PRINT("Using prepared handshakes (%u chunks of %u bytes)\n",
+                    layout->chunk_count, layout->chunk_size);
+    }
+
+    uint32_t depth = window_depth ? window_depth : profile->window_depth;
+    if (depth > profile->max_window_depth) {
+        thingino_printf("  Window depth %u exceeds %s burner buffering, using %u\n",
+               depth, profile->name, profile->max_window_depth);
+        depth = profile->max_window_depth;
+    }
+
+    if (depth > 1) {
+        // Overlap host transfers of the next chunk(s) with burner-side
+        // programming of the current one.
+        thingino_printf("  Pipelined write: %s profile, %u chunks in flight\n", profile->name, depth);
+        result = firmware_write_pipelined(device, profile, depth, firmware_data,
+                                          firmware_size_u, layout,
+                                          &session.bytes_written, &session.chunk_num);
+        if (result == THINGINO_ERROR_TIMEOUT) {
+            // A chunk went unconfirmed: resend from there, one chunk at a
+            // time, with the serial writer's confirmation and resends
+            thingino_printf("  Resuming serially from chunk %u\n", session.chunk_num + 1);
+        } else if (result != THINGINO_SUCCESS) {
+            thingino_eprintf("Error: Pipelined write failed after %u chunks: %s\n",
+                    session.chunk_num, thingino_error_to_string(result));
+            return result;
+        }
+    }
+
+    // Serial writes, and whatever the pipeline left unconfirmed
+    while (session.bytes_written < firmware_size_u) {
+        uint32_t chunk_size = profile->chunk_size;
+        if (session.bytes_written + chunk_size > firmware_size_u) {
+            chunk_size = firmware_size_u - session.bytes_written;
+        }
+
+        result = firmware_write_chunk(&session, firmware_data + session.bytes_written,
+                                      chunk_size,
+                                      layout ? layout->handshakes[session.chunk_num] : NULL);
+        if (result != THINGINO_SUCCESS) {
+            return result;
+        }
+    }
+
+    return firmware_write_end(&session);
+}
+
+/**
+ * Write a prepared firmware image to device
+ *
+ * The image is only read, so one prepared image can feed any number of
+ * concurrent writers. Chunks use the image's precomputed handshakes when a
+ * layout matching the device's format and chunk size was prepared.
+ */
+thingino_error_t write_firmware_prepared(usb_device_t* device,
+                                        const prepared_image_t* image,
+                                        const firmware_binary_t* fw_binary,
+                                        bool force_erase,
+                                        bool is_a1_board,
+                                        uint32_t window_depth) {
+    if (image) {
+        thingino_job_note_image(image->image.data, image->image.size);
+    }
+    thingino_event_phase_begin(device, "write");
+    thingino_error_t result = write_firmware_prepared_run(device, image, fw_binary, force_erase,
+                                                          is_a1_board, window_depth);
+    thingino_event_phase_end(device, "write", result);
+    return result;
+}
+
 /**
  * Send bulk data to device
  */
@@ -743,17 +1008,20 @@ thingino_error_t send_bulk_data(usb_device_t* device, uint8_t endpoint,
     }
 
     int transferred = 0;
-    int result = libusb_bulk_transfer(device->handle, endpoint,
-                                     (uint8_t*)data, size,
+    int result = usb_device_bulk_raw(device, endpoint,
+                                     (uint8_t*)data, (int)size,
                                      &transferred, 5000);  // 5 second timeout
 
+    if (result == LIBUSB_ERROR_INTERRUPTED) {
+        return THINGINO_ERROR_CANCELLED;
+    }
     if (result != LIBUSB_SUCCESS) {
-        fprintf(stderr, "Bulk transfer failed: %s\n", libusb_error_name(result));
+        thingino_eprintf("Bulk transfer failed: %s\n", libusb_error_name(result));
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
     if (transferred != (int)size) {
-        fprintf(stderr, "Incomplete transfer: sent %d of %u bytes\n", transferred, size);
+        thingino_eprintf("Incomplete transfer: sent %d of %u bytes\n", transferred, size);
         return THINGINO_ERROR_TRANSFER_FAILED;
     }
 
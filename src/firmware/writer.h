@@ -19,13 +19,15 @@
  * @param fw_binary Firmware binary configuration for the target SoC
  * @param force_erase Force erase flag (currently unused)
  * @param is_a1_board True if device is an A1 board (uses 1MB chunks)
+ * @param window_depth Chunks kept in flight (0 = profile default, 1 = serial)
  * @return THINGINO_SUCCESS on success, error code otherwise
  */
 thingino_error_t write_firmware_to_device(usb_device_t* device,
                                          const char* firmware_file,
                                          const firmware_binary_t* fw_binary,
                                          bool force_erase,
-                                         bool is_a1_board);
+                                         bool is_a1_board,
+                                         uint32_t window_depth);
 
 /**
  * Send bulk data to device
@@ -0,0 +1,711 @@
+/**
+ * thingino-gadget - emulated Ingenic device on real USB plumbing (Linux)
+ *
+ * Presents the simulated device (sim_device.h) through raw-gadget, so the
+ * unmodified thingino-cloner talks to it through libusb, usbfs and a USB
+ * controller: transfer splitting, short packets, timeouts and URB limits
+ * are the kernel's, not a mock's. With dummy_hcd the gadget shows up on a
+ * virtual host controller of the same machine:
+ *
+ *   modprobe dummy_hcd raw_gadget
+ *   thingino-gadget --flash flash.bin --flash-size 16
+ *   thingino-cloner -i 0 -w firmware.bin
+ *
+ * The boot ROM and burner are the simulated device's protocol model; flash
+ * contents live in a file (mmapped, so they survive the gadget). Timing is
+ * real time: chip erase keeps the burner busy for --erase-ms, everything
+ * else runs as fast as the bus.
+ *
+ * Limits: a control OUT request is acked before the model sees its data,
+ * so it cannot be stalled; text queued on bulk IN 0x81 is delivered before
+ * a later flash read, as on a device with a FIFO.
+ */
+
+#include "sim_device.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/raw_gadget.h>
+
+#define GADGET_DEVICE_PATH      "/dev/raw-gadget"
+#define GADGET_DEFAULT_UDC      "dummy_udc.0"
+#define GADGET_DEFAULT_DRIVER   "dummy_udc"
+#define GADGET_EP0_MAX          4096
+#define GADGET_BULK_MAX         (1024 * 1024)   // Largest write chunk (A1)
+#define GADGET_BULK_PACKET      512
+#define GADGET_IN_POLL_MS       2
+#define GADGET_LOG_MAX          512             // Host reads the burner log in 512-byte buffers
+
+#define GADGET_STRING_MANUFACTURER  1
+#define GADGET_STRING_PRODUCT       2
+
+typedef struct {
+    uint16_t vendor;
+    uint16_t product;
+    uint16_t firmware_product;      // PID after re-enumeration into the burner (0 = same)
+    bool reenumerate;               // Drop off the bus and come back once the burner runs
+    const char* udc_device;
+    const char* udc_driver;
+} gadget_config_t;
+
+typedef struct {
+    gadget_config_t config;
+    sim_device_t sim;
+    pthread_mutex_t lock;           // Guards sim: ep0 and both bulk threads drive it
+
+    int fd;
+    int ep_out;                     // raw-gadget endpoint handles, -1 = not enabled
+    int ep_in;
+    bool configured;
+    volatile bool session_done;
+    bool reenumerate_pending;
+    pthread_t threads[2];           // Bulk OUT, bulk IN
+    int thread_count;
+    volatile int threads_running;
+} gadget_t;
+
+static volatile sig_atomic_t gadget_stop = 0;
+
+static void gadget_signal(int sig) {
+    (void)sig;
+    gadget_stop = 1;
+}
+
+// Interrupts a bulk thread's blocking raw-gadget ioctl (EINTR)
+static void gadget_wake(int sig) {
+    (void)sig;
+}
+
+// ============================================================================
+// DESCRIPTORS
+// ============================================================================
+
+static struct usb_device_descriptor gadget_device_descriptor(const gadget_t* g, uint16_t product) {
+    struct usb_device_descriptor desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.bLength = USB_DT_DEVICE_SIZE;
+    desc.bDescriptorType = USB_DT_DEVICE;
+    desc.bcdUSB = __cpu_to_le16(0x0200);
+    desc.bDeviceClass = USB_CLASS_VENDOR_SPEC;
+    desc.bMaxPacketSize0 = 64;
+    desc.idVendor = __cpu_to_le16(g->config.vendor);
+    desc.idProduct = __cpu_to_le16(product);
+    desc.bcdDevice = __cpu_to_le16(0x0100);
+    desc.iManufacturer = GADGET_STRING_MANUFACTURER;
+    desc.iProduct = GADGET_STRING_PRODUCT;
+    desc.bNumConfigurations = 1;
+    return desc;
+}
+
+static const struct usb_endpoint_descriptor gadget_ep_out_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bEndpointAddress = ENDPOINT_OUT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = __cpu_to_le16(GADGET_BULK_PACKET),
+};
+
+static const struct usb_endpoint_descriptor gadget_ep_in_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bEndpointAddress = ENDPOINT_IN,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = __cpu_to_le16(GADGET_BULK_PACKET),
+};
+
+// Configuration, interface and both endpoints in one block
+static int gadget_config_descriptor(uint8_t* out, size_t size) {
+    struct usb_config_descriptor config = {
+        .bLength = USB_DT_CONFIG_SIZE,
+        .bDescriptorType = USB_DT_CONFIG,
+        .bNumInterfaces = 1,
+        .bConfigurationValue = 1,
+        .bmAttributes = USB_CONFIG_ATT_ONE,
+        .bMaxPower = 50,
+    };
+    struct usb_interface_descriptor intf = {
+        .bLength = USB_DT_INTERFACE_SIZE,
+        .bDescriptorType = USB_DT_INTERFACE,
+        .bNumEndpoints = 2,
+        .bInterfaceClass = USB_CLASS_VENDOR_SPEC,
+    };
+    size_t total = USB_DT_CONFIG_SIZE + USB_DT_INTERFACE_SIZE + 2 * USB_DT_ENDPOINT_SIZE;
+    if (size < total) {
+        return -1;
+    }
+    config.wTotalLength = __cpu_to_le16((uint16_t)total);
+
+    uint8_t* p = out;
+    memcpy(p, &config, USB_DT_CONFIG_SIZE);
+    p += USB_DT_CONFIG_SIZE;
+    memcpy(p, &intf, USB_DT_INTERFACE_SIZE);
+    p += USB_DT_INTERFACE_SIZE;
+    memcpy(p, &gadget_ep_out_desc, USB_DT_ENDPOINT_SIZE);
+    p += USB_DT_ENDPOINT_SIZE;
+    memcpy(p, &gadget_ep_in_desc, USB_DT_ENDPOINT_SIZE);
+    return (int)total;
+}
+
+static int gadget_string_descriptor(uint8_t index, uint8_t* out, size_t size) {
+    if (index == 0) {
+        static const uint8_t langids[] = { 4, USB_DT_STRING, 0x09, 0x04 };  // en-US
+        memcpy(out, langids, sizeof(langids));
+        return (int)sizeof(langids);
+    }
+
+    const char* text = index == GADGET_STRING_MANUFACTURER ? "Ingenic" :
+                       index == GADGET_STRING_PRODUCT ? "thingino-gadget" : NULL;
+    if (!text) {
+        return -1;
+    }
+    size_t len = strlen(text);
+    if (size < 2 + 2 * len) {
+        return -1;
+    }
+    out[0] = (uint8_t)(2 + 2 * len);
+    out[1] = USB_DT_STRING;
+    for (size_t i = 0; i < len; i++) {
+        out[2 + 2 * i] = (uint8_t)text[i];
+        out[3 + 2 * i] = 0;
+    }
+    return (int)(2 + 2 * len);
+}
+
+// ============================================================================
+// RAW-GADGET I/O
+// ============================================================================
+
+typedef struct {
+    struct usb_raw_ep_io io;
+    uint8_t data[GADGET_EP0_MAX];
+} gadget_ep0_io_t;
+
+static int gadget_ep0_write(gadget_t* g, const uint8_t* data, int length) {
+    gadget_ep0_io_t io;
+    memset(&io.io, 0, sizeof(io.io));
+    io.io.length = (uint32_t)length;
+    if (length > 0) {
+        memcpy(io.data, data, (size_t)length);
+    }
+    return ioctl(g->fd, USB_RAW_IOCTL_EP0_WRITE, &io);
+}
+
+// Read the data stage of a control OUT request (acks it)
+static int gadget_ep0_read(gadget_t* g, uint8_t* data, int length) {
+    gadget_ep0_io_t io;
+    memset(&io.io, 0, sizeof(io.io));
+    io.io.length = (uint32_t)length;
+    int result = ioctl(g->fd, USB_RAW_IOCTL_EP0_READ, &io);
+    if (result > 0 && data) {
+        memcpy(data, io.data, (size_t)result);
+    }
+    return result;
+}
+
+static void gadget_ep0_stall(gadget_t* g) {
+    ioctl(g->fd, USB_RAW_IOCTL_EP0_STALL, 0);
+}
+
+static int gadget_ep_transfer(gadget_t* g, unsigned long request, int ep,
+                              struct usb_raw_ep_io* io, uint32_t length) {
+    io->ep = (uint16_t)ep;
+    io->flags = 0;
+    io->length = length;
+    return ioctl(g->fd, request, io);
+}
+
+// ============================================================================
+// BULK ENDPOINTS
+// ============================================================================
+
+// Bulk OUT: boot ROM loads, write chunks, flash descriptor and markers
+static void* gadget_out_thread(void* arg) {
+    gadget_t* g = (gadget_t*)arg;
+    struct usb_raw_ep_io* io = (struct usb_raw_ep_io*)malloc(sizeof(*io) + GADGET_BULK_MAX);
+    if (!io) {
+        return NULL;
+    }
+
+    while (!g->session_done && !gadget_stop) {
+        // A transfer that is a multiple of the packet size ends without a
+        // short packet, so read exactly what the device expects when known
+        pthread_mutex_lock(&g->lock);
+        uint32_t want = sim_device_next_out_size(&g->sim);
+        pthread_mutex_unlock(&g->lock);
+        if (want == 0 || want > GADGET_BULK_MAX) {
+            want = GADGET_BULK_MAX;
+        }
+
+        int got = gadget_ep_transfer(g, USB_RAW_IOCTL_EP_READ, g->ep_out, io, want);
+        if (got < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                break;  // Disconnected or shutting down
+            }
+            continue;
+        }
+
+        int transferred = 0;
+        pthread_mutex_lock(&g->lock);
+        sim_device_transport.bulk(&g->sim, ENDPOINT_OUT, io->data, got, &transferred, 0);
+        pthread_mutex_unlock(&g->lock);
+        DEBUG_PRINT("gadget: bulk OUT %d bytes (expected %u)\n", got, want);
+    }
+
+    free(io);
+    __atomic_sub_fetch(&g->threads_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Bulk IN: flash reads and burner log text, whenever the model has some
+static void* gadget_in_thread(void* arg) {
+    gadget_t* g = (gadget_t*)arg;
+    struct usb_raw_ep_io* io = (struct usb_raw_ep_io*)malloc(sizeof(*io) + GADGET_BULK_MAX);
+    if (!io) {
+        return NULL;
+    }
+
+    while (!g->session_done && !gadget_stop) {
+        int length = 0;
+        pthread_mutex_lock(&g->lock);
+        if (g->sim.pending == SIM_PENDING_READ) {
+            length = g->sim.pending_size < GADGET_BULK_MAX ? (int)g->sim.pending_size : GADGET_BULK_MAX;
+        } else if (g->sim.log_len > 0) {
+            length = g->sim.log_len < GADGET_LOG_MAX ? (int)g->sim.log_len : GADGET_LOG_MAX;
+        }
+        int transferred = 0;
+        if (length > 0) {
+            sim_device_transport.bulk(&g->sim, ENDPOINT_IN, io->data, length, &transferred, 0);
+        }
+        pthread_mutex_unlock(&g->lock);
+
+        if (transferred == 0) {
+            thingino_sleep_milliseconds(GADGET_IN_POLL_MS);
+            continue;
+        }
+        // Blocks until the host reads it
+        if (gadget_ep_transfer(g, USB_RAW_IOCTL_EP_WRITE, g->ep_in, io, (uint32_t)transferred) < 0 &&
+            errno != EINTR) {
+            break;
+        }
+        DEBUG_PRINT("gadget: bulk IN %d bytes\n", transferred);
+    }
+
+    free(io);
+    __atomic_sub_fetch(&g->threads_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int gadget_set_configuration(gadget_t* g) {
+    if (!g->configured) {
+        g->ep_out = ioctl(g->fd, USB_RAW_IOCTL_EP_ENABLE, &gadget_ep_out_desc);
+        g->ep_in = ioctl(g->fd, USB_RAW_IOCTL_EP_ENABLE, &gadget_ep_in_desc);
+        if (g->ep_out < 0 || g->ep_in < 0) {
+            thingino_printf("[ERROR] Cannot enable bulk endpoints: %s\n", strerror(errno));
+            return -1;
+        }
+        g->configured = true;
+        void* (*bodies[2])(void*) = { gadget_out_thread, gadget_in_thread };
+        for (int i = 0; i < 2; i++) {
+            __atomic_add_fetch(&g->threads_running, 1, __ATOMIC_RELEASE);
+            if (pthread_create(&g->threads[i], NULL, bodies[i], g) != 0) {
+                __atomic_sub_fetch(&g->threads_running, 1, __ATOMIC_RELEASE);
+                thingino_printf("[ERROR] Cannot start endpoint threads\n");
+                return -1;
+            }
+            g->thread_count++;
+        }
+        ioctl(g->fd, USB_RAW_IOCTL_VBUS_DRAW, 50);
+        ioctl(g->fd, USB_RAW_IOCTL_CONFIGURE, 0);
+    }
+    return gadget_ep0_read(g, NULL, 0);
+}
+
+// ============================================================================
+// CONTROL REQUESTS
+// ============================================================================
+
+static void gadget_standard_request(gadget_t* g, const struct usb_ctrlrequest* ctrl, uint16_t product) {
+    uint8_t buffer[GADGET_EP0_MAX];
+    uint16_t length = __le16_to_cpu(ctrl->wLength);
+    uint16_t value = __le16_to_cpu(ctrl->wValue);
+    int size = -1;
+
+    switch (ctrl->bRequest) {
+        case USB_REQ_GET_DESCRIPTOR:
+            switch (value >> 8) {
+                case USB_DT_DEVICE: {
+                    struct usb_device_descriptor desc = gadget_device_descriptor(g, product);
+                    memcpy(buffer, &desc, sizeof(desc));
+                    size = (int)sizeof(desc);
+                    break;
+                }
+                case USB_DT_CONFIG:
+                    size = gadget_config_descriptor(buffer, sizeof(buffer));
+                    break;
+                case USB_DT_STRING:
+                    size = gadget_string_descriptor((uint8_t)value, buffer, sizeof(buffer));
+                    break;
+                default:
+                    break;  // No qualifier/BOS: stall
+            }
+            break;
+        case USB_REQ_SET_CONFIGURATION:
+            if (gadget_set_configuration(g) < 0) {
+                g->session_done = true;
+            }
+            return;
+        case USB_REQ_SET_INTERFACE:
+            gadget_ep0_read(g, NULL, 0);
+            return;
+        case USB_REQ_GET_CONFIGURATION:
+            buffer[0] = g->configured ? 1 : 0;
+            size = 1;
+            break;
+        case USB_REQ_GET_INTERFACE:
+        case USB_REQ_GET_STATUS:
+            memset(buffer, 0, 2);
+            size = ctrl->bRequest == USB_REQ_GET_STATUS ? 2 : 1;
+            break;
+        default:
+            break;
+    }
+
+    if (size < 0) {
+        gadget_ep0_stall(g);
+        return;
+    }
+    gadget_ep0_write(g, buffer, size < length ? size : length);
+}
+
+static void gadget_vendor_request(gadget_t* g, const struct usb_ctrlrequest* ctrl) {
+    uint8_t buffer[GADGET_EP0_MAX];
+    uint16_t length = __le16_to_cpu(ctrl->wLength);
+    if (length > sizeof(buffer)) {
+        gadget_ep0_stall(g);
+        return;
+    }
+
+    bool in = (ctrl->bRequestType & USB_DIR_IN) != 0;
+    if (!in && length > 0 && gadget_ep0_read(g, buffer, length) < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    sim_stage_t stage_before = g->sim.stage;
+    int result = sim_device_transport.control(&g->sim, ctrl->bRequestType, ctrl->bRequest,
+                                              __le16_to_cpu(ctrl->wValue), __le16_to_cpu(ctrl->wIndex),
+                                              buffer, length, 0);
+    bool burner_started = stage_before != SIM_STAGE_BURNER && g->sim.stage == SIM_STAGE_BURNER;
+    pthread_mutex_unlock(&g->lock);
+
+    DEBUG_PRINT("gadget: vendor 0x%02X/0x%02X len %u -> %d\n",
+                ctrl->bRequestType, ctrl->bRequest, length, result);
+
+    if (in) {
+        if (result < 0) {
+            gadget_ep0_stall(g);
+        } else {
+            gadget_ep0_write(g, buffer, result);
+        }
+    } else if (length == 0) {
+        if (result < 0) {
+            gadget_ep0_stall(g);
+        } else {
+            gadget_ep0_read(g, NULL, 0);
+        }
+    }
+
+    if (burner_started) {
+        thingino_printf("Burner running\n");
+        if (g->config.reenumerate) {
+            g->reenumerate_pending = true;
+            g->session_done = true;
+        }
+    }
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+// One enumeration: runs until the burner starts with --reenumerate, or a
+// signal
+static int gadget_session(gadget_t* g) {
+    uint16_t product = g->config.product;
+    if (g->sim.stage == SIM_STAGE_BURNER && g->config.firmware_product) {
+        product = g->config.firmware_product;
+    }
+
+    g->fd = open(GADGET_DEVICE_PATH, O_RDWR);
+    if (g->fd < 0) {
+        thingino_printf("[ERROR] Cannot open %s: %s (modprobe raw_gadget?)\n", GADGET_DEVICE_PATH, strerror(errno));
+        return -1;
+    }
+
+    struct usb_raw_init init;
+    memset(&init, 0, sizeof(init));
+    snprintf((char*)init.driver_name, sizeof(init.driver_name), "%s", g->config.udc_driver);
+    snprintf((char*)init.device_name, sizeof(init.device_name), "%s", g->config.udc_device);
+    init.speed = USB_SPEED_HIGH;
+    if (ioctl(g->fd, USB_RAW_IOCTL_INIT, &init) < 0 || ioctl(g->fd, USB_RAW_IOCTL_RUN, 0) < 0) {
+        thingino_printf("[ERROR] Cannot start gadget on %s: %s (modprobe dummy_hcd?)\n",
+               g->config.udc_device, strerror(errno));
+        close(g->fd);
+        return -1;
+    }
+
+    thingino_printf("Gadget %04X:%04X up on %s (%s stage)\n", g->config.vendor, product,
+           g->config.udc_device, g->sim.stage == SIM_STAGE_BURNER ? "burner" : "boot ROM");
+
+    g->configured = false;
+    g->thread_count = 0;
+    g->session_done = false;
+    g->reenumerate_pending = false;
+    g->ep_out = g->ep_in = -1;
+
+    struct {
+        struct usb_raw_event event;
+        uint8_t data[sizeof(struct usb_ctrlrequest)];
+    } event;
+
+    while (!g->session_done && !gadget_stop) {
+        memset(&event, 0, sizeof(event));
+        event.event.length = sizeof(event.data);
+        if (ioctl(g->fd, USB_RAW_IOCTL_EVENT_FETCH, &event) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (event.event.type == USB_RAW_EVENT_CONNECT) {
+            DEBUG_PRINT("gadget: connected\n");
+            continue;
+        }
+        if (event.event.type != USB_RAW_EVENT_CONTROL) {
+            DEBUG_PRINT("gadget: event %u\n", event.event.type);
+            continue;
+        }
+
+        const struct usb_ctrlrequest* ctrl = (const struct usb_ctrlrequest*)event.data;
+        if ((ctrl->bRequestType & USB_TYPE_MASK) == USB_TYPE_VENDOR) {
+            gadget_vendor_request(g, ctrl);
+        } else if ((ctrl->bRequestType & USB_TYPE_MASK) == USB_TYPE_STANDARD) {
+            gadget_standard_request(g, ctrl, product);
+        } else {
+            gadget_ep0_stall(g);
+        }
+    }
+
+    // Endpoint I/O blocks until the host moves data; a signal makes it
+    // return, and the threads then see session_done. Keep signalling: a
+    // thread may be just about to block again.
+    g->session_done = true;
+    while (__atomic_load_n(&g->threads_running, __ATOMIC_ACQUIRE) > 0) {
+        for (int i = 0; i < g->thread_count; i++) {
+            pthread_kill(g->threads[i], SIGUSR1);
+        }
+        thingino_sleep_milliseconds(10);
+    }
+    for (int i = 0; i < g->thread_count; i++) {
+        pthread_join(g->threads[i], NULL);
+    }
+    close(g->fd);  // Takes the gadget off the bus
+    return 0;
+}
+
+// ============================================================================
+// FLASH FILE
+// ============================================================================
+
+static int gadget_map_flash(const char* path, uint32_t size_mb, sim_device_t* sim) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        thingino_printf("[ERROR] Cannot open flash file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    off_t size = st.st_size;
+    bool fresh = size == 0;
+    if (fresh) {
+        size = (off_t)size_mb * 1024 * 1024;
+        if (ftruncate(fd, size) != 0) {
+            thingino_printf("[ERROR] Cannot size flash file %s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+    if (size <= 0 || size > UINT32_MAX) {
+        thingino_printf("[ERROR] Flash file %s has an unusable size\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        thingino_printf("[ERROR] Cannot map flash file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fresh) {
+        memset(map, 0xFF, (size_t)size);  // Erased NOR
+    }
+    sim->flash = (uint8_t*)map;
+    sim->flash_size = (uint32_t)size;
+    return 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void print_usage(const char* program_name) {
+    printf("thingino-gadget - emulated Ingenic device over raw-gadget (dummy_hcd or a real UDC)\n");
+    printf("Usage: %s --flash <file> [options]\n\n", program_name);
+    printf("Options:\n");
+    printf("      --flash <file>      Flash contents (created erased if missing)\n");
+    printf("      --flash-size <mb>   Size of a new flash file in MB (default: 16)\n");
+    printf("      --cpu <magic>       Boot ROM CPU magic (default: T31V)\n");
+    printf("      --vid <hex>         Vendor ID (default: %04X)\n", VENDOR_ID_INGENIC);
+    printf("      --pid <hex>         Boot ROM product ID (default: %04X)\n", PRODUCT_ID_BOOTROM2);
+    printf("      --reenumerate       Drop off the bus and come back once U-Boot runs (T31ZX)\n");
+    printf("      --firmware-pid <hex> Product ID after re-enumeration (default: same)\n");
+    printf("      --erase-ms <n>      Chip erase time in ms (default: %d)\n", SIM_DEVICE_ERASE_MS);
+    printf("      --udc <dev> <drv>   UDC device and driver (default: %s %s)\n",
+           GADGET_DEFAULT_UDC, GADGET_DEFAULT_DRIVER);
+    printf("  -d, --debug             Log every request\n");
+    printf("  -h, --help              Show this help\n\n");
+    printf("Needs root and the dummy_hcd and raw_gadget modules (or a real UDC).\n");
+}
+
+static bool parse_hex16(const char* text, uint16_t* out) {
+    char* end = NULL;
+    unsigned long value = strtoul(text, &end, 16);
+    if (!*text || *end || value > 0xFFFF) {
+        return false;
+    }
+    *out = (uint16_t)value;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    gadget_t* g = (gadget_t*)calloc(1, sizeof(gadget_t));
+    if (!g) {
+        return 1;
+    }
+    g->config.vendor = VENDOR_ID_INGENIC;
+    g->config.product = PRODUCT_ID_BOOTROM2;
+    g->config.udc_device = GADGET_DEFAULT_UDC;
+    g->config.udc_driver = GADGET_DEFAULT_DRIVER;
+    const char* flash_path = NULL;
+    uint32_t flash_size_mb = 16;
+    bool debug = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            free(g);
+            return 0;
+        } else if (strcmp(argv[i], "--flash") == 0 && has_value) {
+            flash_path = argv[++i];
+        } else if (strcmp(argv[i], "--flash-size") == 0 && has_value) {
+            int mb = atoi(argv[++i]);
+            ok = mb >= 1 && mb <= 1024;
+            flash_size_mb = (uint32_t)mb;
+        } else if (strcmp(argv[i], "--cpu") == 0 && has_value) {
+            const char* magic = argv[++i];
+            size_t len = strlen(magic);
+            ok = len >= 1 && len <= sizeof(g->sim.cpu_magic);
+            memset(g->sim.cpu_magic, 0, sizeof(g->sim.cpu_magic));
+            memcpy(g->sim.cpu_magic, magic, ok ? len : 0);
+        } else if (strcmp(argv[i], "--vid") == 0 && has_value) {
+            ok = parse_hex16(argv[++i], &g->config.vendor);
+        } else if (strcmp(argv[i], "--pid") == 0 && has_value) {
+            ok = parse_hex16(argv[++i], &g->config.product);
+        } else if (strcmp(argv[i], "--firmware-pid") == 0 && has_value) {
+            ok = parse_hex16(argv[++i], &g->config.firmware_product);
+        } else if (strcmp(argv[i], "--reenumerate") == 0) {
+            g->config.reenumerate = true;
+        } else if (strcmp(argv[i], "--erase-ms") == 0 && has_value) {
+            int ms = atoi(argv[++i]);
+            ok = ms >= 1;
+            g->sim.erase_ms = (uint32_t)ms;
+        } else if (strcmp(argv[i], "--udc") == 0 && i + 2 < argc) {
+            g->config.udc_device = argv[++i];
+            g->config.udc_driver = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
+            debug = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            printf("Error: unknown, incomplete or invalid option %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(g);
+            return 1;
+        }
+    }
+    if (!flash_path) {
+        printf("Error: --flash <file> is required\n");
+        free(g);
+        return 1;
+    }
+
+    // No USB manager needed: a bare context carries the debug flag
+    thingino_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.events_fd = -1;
+    context.debug = debug;
+    thingino_context_bind(&context);
+
+    if (gadget_map_flash(flash_path, flash_size_mb, &g->sim) != 0 ||
+        sim_device_init(&g->sim) != THINGINO_SUCCESS) {
+        free(g);
+        return 1;
+    }
+    pthread_mutex_init(&g->lock, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = gadget_signal;  // No SA_RESTART: a blocked ioctl must return
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = gadget_wake;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    int exit_code = 0;
+    while (!gadget_stop) {
+        if (gadget_session(g) != 0) {
+            exit_code = 1;
+            break;
+        }
+        if (!g->reenumerate_pending) {
+            break;
+        }
+        thingino_printf("Re-enumerating\n");
+        g->config.reenumerate = false;  // Once per boot, like the hardware
+    }
+
+    if (exit_code == 0) {
+        thingino_printf("Session: %llu bytes received, %u chunks written (%u CRC errors), %llu bytes read\n",
+                        (unsigned long long)g->sim.bytes_out, g->sim.chunks_written,
+                        g->sim.crc_errors, (unsigned long long)g->sim.bytes_in);
+    }
+    munmap(g->sim.flash, g->sim.flash_size);
+    sim_device_cleanup(&g->sim);
+    pthread_mutex_destroy(&g->lock);
+    free(g);
+    return exit_code;
+}
@@ -0,0 +1,189 @@
+#include "thingino.h"
+
+#include <pthread.h>
+#include <time.h>
+
+// ============================================================================
+// JOB HISTORY RECORDING
+// ============================================================================
+//
+// A job runs on one thread from start to finish (station job, clone target,
+// daemon command, CLI operation), even when its device is closed and
+// reopened across bootstrap, so the record being built lives in thread-local
+// state. The event observation points fill it in; nothing is kept unless a
+// job was begun on a context with history enabled.
+
+typedef struct {
+    bool active;
+    job_record_t record;
+} job_thread_t;
+
+static pthread_key_t job_thread_key;
+static pthread_once_t job_thread_key_once = PTHREAD_ONCE_INIT;
+
+static void job_thread_key_create(void) {
+    pthread_key_create(&job_thread_key, free);
+}
+
+static job_thread_t* job_thread_state(bool create) {
+    pthread_once(&job_thread_key_once, job_thread_key_create);
+    job_thread_t* state = (job_thread_t*)pthread_getspecific(job_thread_key);
+    if (!state && create) {
+        state = (job_thread_t*)calloc(1, sizeof(job_thread_t));
+        if (state) {
+            pthread_setspecific(job_thread_key, state);
+        }
+    }
+    return state;
+}
+
+static job_record_t* job_current(void) {
+    job_thread_t* state = job_thread_state(false);
+    return state && state->active ? &state->record : NULL;
+}
+
+/**
+ * Record this context's jobs
+ *
+ * @param path History file, NULL for job_history_default_path()
+ */
+thingino_error_t thingino_history_open(thingino_context_t* ctx, const char* path) {
+    if (!ctx) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    thingino_history_close(ctx);
+
+    char default_path[512];
+    if (!path) {
+        if (job_history_default_path(default_path, sizeof(default_path)) != 0) {
+            return THINGINO_ERROR_FILE_IO;
+        }
+        path = default_path;
+    }
+    size_t len = strlen(path) + 1;
+    ctx->history_path = (char*)malloc(len);
+    if (!ctx->history_path) {
+        return THINGINO_ERROR_MEMORY;
+    }
+    memcpy(ctx->history_path, path, len);
+    return THINGINO_SUCCESS;
+}
+
+void thingino_history_close(thingino_context_t* ctx) {
+    if (ctx) {
+        free(ctx->history_path);
+        ctx->history_path = NULL;
+    }
+}
+
+void thingino_job_begin(const char* port) {
+    thingino_context_t* ctx = thingino_context_current();
+    if (!ctx || !ctx->history_path) {
+        return;
+    }
+    job_thread_t* state = job_thread_state(true);
+    if (!state) {
+        return;
+    }
+    memset(&state->record, 0, sizeof(state->record));
+    if (port) {
+        snprintf(state->record.port, sizeof(state->record.port), "%s", port);
+    }
+    state->active = true;
+}
+
+void thingino_job_end(thingino_error_t result) {
+    thingino_context_t* ctx = thingino_context_current();
+    job_thread_t* state = job_thread_state(false);
+    if (!state || !state->active) {
+        return;
+    }
+    state->active = false;
+    if (!ctx || !ctx->history_path) {
+        return;
+    }
+
+    state->record.time = (int64_t)time(NULL);
+    state->record.result = (int32_t)result;
+    if (job_history_append(ctx->history_path, &state->record) != 0 && !ctx->history_warned) {
+        ctx->history_warned = true;  // Once per context; history must never fail a job
+        thingino_printf("[WARN] Cannot append to job history %s\n", ctx->history_path);
+    }
+}
+
+// ============================================================================
+// OBSERVATION HOOKS
+// ============================================================================
+
+static void job_device_port(const usb_device_t* device, char* out, size_t size) {
+    if (device->info.port_depth) {
+        usb_port_path_format(&device->info, out, size);
+    } else {
+        snprintf(out, size, "%03d:%03d", device->info.bus, device->info.address);
+    }
+}
+
+void thingino_job_note_phase(const usb_device_t* device, const char* phase, uint64_t ms) {
+    job_record_t* job = job_current();
+    int index = metrics_phase_from_name(phase);
+    if (!job || index < 0) {
+        return;
+    }
+    uint64_t total = job->phase_ms[index] + (ms ? ms : 1);  // 0 means "did not run"
+    job->phase_ms[index] = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+
+    // The device knows more after bootstrap (variant, flash chip)
+    if (device) {
+        snprintf(job->variant, sizeof(job->variant), "%s",
+                 processor_variant_to_string(device->info.variant));
+        if (device->info.flash_chip[0]) {
+            snprintf(job->flash_chip, sizeof(job->flash_chip), "%s", device->info.flash_chip);
+        }
+        if (!job->port[0]) {
+            job_device_port(device, job->port, sizeof(job->port));
+        }
+    }
+}
+
+void thingino_job_note_retry(void) {
+    job_record_t* job = job_current();
+    if (job) {
+        job->retries++;
+    }
+}
+
+void thingino_job_note_bytes(uint32_t bytes) {
+    job_record_t* job = job_current();
+    if (job) {
+        job->bytes += bytes;
+    }
+}
+
+/**
+ * Keeps the first magic the job's device reports: the boot ROM's, before
+ * bootstrap replaces it. Scans on the job's thread probe every board on the
+ * bus, so probe handles are ignored, and once the job knows its port a
+ * device elsewhere is too. Only port paths are compared, as a bus address
+ * changes when bootstrap re-enumerates the device.
+ */
+void thingino_job_note_cpu(const usb_device_t* device, const char* magic) {
+    job_record_t* job = job_current();
+    if (!job || job->cpu_magic[0] || !magic || !device || device->probe) {
+        return;
+    }
+    if (job->port[0] && device->info.port_depth) {
+        char port[sizeof(job->port)];
+        job_device_port(device, port, sizeof(port));
+        if (strcmp(port, job->port) != 0) {
+            return;
+        }
+    }
+    snprintf(job->cpu_magic, sizeof(job->cpu_magic), "%s", magic);
+}
+
+void thingino_job_note_image(const uint8_t* data, size_t size) {
+    job_record_t* job = job_current();
+    if (job && !job->image_crc && data) {
+        job->image_crc = firmware_crc32(data, size);
+    }
+}
@@ -0,0 +1,375 @@
+#include "job_history.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define history_mkdir(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define history_mkdir(path) mkdir(path, 0755)
+#endif
+
+// ============================================================================
+// JOB HISTORY IMPLEMENTATION
+// ============================================================================
+//
+// Record encoding, appends, and the time-window load and summary behind
+// --history.
+
+int job_history_default_path(char* buf, size_t buf_size) {
+    if (!buf || buf_size == 0) {
+        return -1;
+    }
+
+    const char* override = getenv("THINGINO_HISTORY_FILE");
+    if (override && override[0]) {
+        return snprintf(buf, buf_size, "%s", override) < (int)buf_size ? 0 : -1;
+    }
+
+#ifdef _WIN32
+    const char* base = getenv("APPDATA");
+    if (!base || !base[0]) {
+        return -1;
+    }
+    return snprintf(buf, buf_size, "%s\\thingino-cloner\\history.bin", base) < (int)buf_size ? 0 : -1;
+#else
+    const char* xdg = getenv("XDG_DATA_HOME");
+    if (xdg && xdg[0]) {
+        return snprintf(buf, buf_size, "%s/thingino-cloner/history.bin", xdg) < (int)buf_size ? 0 : -1;
+    }
+    const char* home = getenv("HOME");
+    if (!home || !home[0]) {
+        return -1;
+    }
+    return snprintf(buf, buf_size, "%s/.local/share/thingino-cloner/history.bin", home) < (int)buf_size ? 0 : -1;
+#endif
+}
+
+// ============================================================================
+// RECORD ENCODING
+// ============================================================================
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+// Fixed-width field: NUL-padded, not necessarily terminated
+static size_t text_len(const char* text, size_t width) {
+    size_t len = 0;
+    while (len < width && text[len]) {
+        len++;
+    }
+    return len;
+}
+
+static void put_text(uint8_t* p, size_t width, const char* text) {
+    size_t len = text_len(text, width);
+    memset(p, 0, width);
+    memcpy(p, text, len);
+}
+
+static void get_text(const uint8_t* p, size_t width, char* text) {
+    size_t len = text_len((const char*)p, width);
+    memcpy(text, p, len);
+    text[len] = '\0';
+}
+
+void job_record_encode(const job_record_t* record, uint8_t out[JOB_HISTORY_RECORD_SIZE]) {
+    memset(out, 0, JOB_HISTORY_RECORD_SIZE);
+    memcpy(out, JOB_HISTORY_MAGIC, 4);
+    put_u32(out + 4, (uint32_t)record->result);
+    put_u64(out + 8, (uint64_t)record->time);
+    put_text(out + 16, JOB_HISTORY_VARIANT_MAX, record->variant);
+    put_text(out + 32, JOB_HISTORY_CPU_MAX, record->cpu_magic);
+    put_text(out + 40, JOB_HISTORY_CHIP_MAX, record->flash_chip);
+    put_text(out + 64, JOB_HISTORY_PORT_MAX, record->port);
+    put_u32(out + 88, record->image_crc);
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        put_u32(out + 92 + 4 * p, record->phase_ms[p]);
+    }
+    put_u32(out + 108, record->retries);
+    put_u64(out + 112, record->bytes);
+}
+
+bool job_record_decode(const uint8_t in[JOB_HISTORY_RECORD_SIZE], job_record_t* record) {
+    if (memcmp(in, JOB_HISTORY_MAGIC, 4) != 0) {
+        return false;
+    }
+    record->result = (int32_t)get_u32(in + 4);
+    record->time = (int64_t)get_u64(in + 8);
+    get_text(in + 16, JOB_HISTORY_VARIANT_MAX, record->variant);
+    get_text(in + 32, JOB_HISTORY_CPU_MAX, record->cpu_magic);
+    get_text(in + 40, JOB_HISTORY_CHIP_MAX, record->flash_chip);
+    get_text(in + 64, JOB_HISTORY_PORT_MAX, record->port);
+    record->image_crc = get_u32(in + 88);
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        record->phase_ms[p] = get_u32(in + 92 + 4 * p);
+    }
+    record->retries = get_u32(in + 108);
+    record->bytes = get_u64(in + 112);
+    return true;
+}
+
+// ============================================================================
+// STORE
+// ============================================================================
+
+// Create the parent directories of path (best effort)
+static void history_make_parent_dirs(const char* path) {
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+
+    for (char* p = dir + 1; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            char sep = *p;
+            *p = '\0';
+            if (history_mkdir(dir) != 0 && errno != EEXIST) {
+                return;
+            }
+            *p = sep;
+        }
+    }
+}
+
+int job_history_append(const char* path, const job_record_t* record) {
+    if (!path || !record) {
+        return -1;
+    }
+    uint8_t bytes[JOB_HISTORY_RECORD_SIZE];
+    job_record_encode(record, bytes);
+
+    history_make_parent_dirs(path);
+    FILE* f = fopen(path, "ab");
+    if (!f) {
+        return -1;
+    }
+    // One record is far below the stdio buffer, so fclose issues one
+    // O_APPEND write for it
+    bool ok = fwrite(bytes, 1, sizeof(bytes), f) == sizeof(bytes);
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    return ok ? 0 : -1;
+}
+
+static int64_t history_time_at(FILE* f, long index) {
+    uint8_t bytes[JOB_HISTORY_RECORD_SIZE];
+    job_record_t record;
+    if (fseek(f, index * JOB_HISTORY_RECORD_SIZE, SEEK_SET) != 0 ||
+        fread(bytes, 1, sizeof(bytes), f) != sizeof(bytes) || !job_record_decode(bytes, &record)) {
+        return INT64_MIN;  // Unreadable: treat as old, the scan skips it anyway
+    }
+    return record.time;
+}
+
+int job_history_load(const char* path, int64_t since, job_record_t** records, size_t* count) {
+    if (!path || !records || !count) {
+        return -1;
+    }
+    *records = NULL;
+    *count = 0;
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    if (fseek(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        return -1;
+    }
+    long total = ftell(f) / JOB_HISTORY_RECORD_SIZE;  // Drops a torn tail
+
+    // First record with time >= since (wall-clock steps backwards only blur
+    // the boundary by a few records)
+    long lo = 0;
+    long hi = total;
+    while (since > 0 && lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (history_time_at(f, mid) < since) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    size_t wanted = (size_t)(total - lo);
+    if (wanted == 0) {
+        fclose(f);
+        return 0;
+    }
+    job_record_t* out = (job_record_t*)malloc(wanted * sizeof(job_record_t));
+    if (!out || fseek(f, lo * JOB_HISTORY_RECORD_SIZE, SEEK_SET) != 0) {
+        free(out);
+        fclose(f);
+        return -1;
+    }
+
+    size_t n = 0;
+    uint8_t bytes[JOB_HISTORY_RECORD_SIZE];
+    for (size_t i = 0; i < wanted && fread(bytes, 1, sizeof(bytes), f) == sizeof(bytes); i++) {
+        if (job_record_decode(bytes, &out[n]) && out[n].time >= since) {
+            n++;
+        }
+    }
+    fclose(f);
+
+    if (n == 0) {
+        free(out);
+        return 0;
+    }
+    *records = out;
+    *count = n;
+    return 0;
+}
+
+// ============================================================================
+// SUMMARY
+// ============================================================================
+
+typedef struct {
+    int64_t period_start;
+    const char* variant;
+    metrics_phase_t phase;
+    uint32_t ms;
+    bool ok;
+} history_sample_t;
+
+static int sample_compare(const void* a, const void* b) {
+    const history_sample_t* x = (const history_sample_t*)a;
+    const history_sample_t* y = (const history_sample_t*)b;
+    int c = strcmp(x->variant, y->variant);
+    if (c != 0) {
+        return c;
+    }
+    if (x->phase != y->phase) {
+        return x->phase < y->phase ? -1 : 1;
+    }
+    if (x->period_start != y->period_start) {
+        return x->period_start < y->period_start ? -1 : 1;
+    }
+    return x->ms < y->ms ? -1 : (x->ms > y->ms ? 1 : 0);
+}
+
+// Nearest-rank percentile of an ascending array
+static uint32_t percentile(const uint32_t* sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static int64_t period_of(int64_t time, uint32_t period_s) {
+    int64_t q = time / period_s;
+    if (time < 0 && time % period_s) {
+        q--;  // Floor, not truncation
+    }
+    return q * period_s;
+}
+
+int job_history_summarize(const job_record_t* records, size_t count, uint32_t period_s,
+                          job_history_row_t** rows, size_t* row_count) {
+    if (!rows || !row_count || period_s == 0) {
+        return -1;
+    }
+    *rows = NULL;
+    *row_count = 0;
+
+    size_t sample_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (int p = 0; p < METRICS_PHASES; p++) {
+            sample_count += records[i].phase_ms[p] ? 1 : 0;
+        }
+    }
+    if (sample_count == 0) {
+        return 0;
+    }
+
+    history_sample_t* samples = (history_sample_t*)malloc(sample_count * sizeof(history_sample_t));
+    uint32_t* durations = (uint32_t*)malloc(sample_count * sizeof(uint32_t));
+    job_history_row_t* out = (job_history_row_t*)calloc(sample_count, sizeof(job_history_row_t));
+    if (!samples || !durations || !out) {
+        free(samples);
+        free(durations);
+        free(out);
+        return -1;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (int p = 0; p < METRICS_PHASES; p++) {
+            if (records[i].phase_ms[p]) {
+                samples[n++] = (history_sample_t){ period_of(records[i].time, period_s),
+                                                   records[i].variant, (metrics_phase_t)p,
+                                                   records[i].phase_ms[p], records[i].result == 0 };
+            }
+        }
+    }
+    qsort(samples, n, sizeof(history_sample_t), sample_compare);
+
+    size_t groups = 0;
+    const job_history_row_t* previous = NULL;  // Same variant and phase, earlier period
+    for (size_t start = 0; start < n;) {
+        size_t end = start;
+        uint32_t ok = 0;
+        uint32_t failed = 0;
+        while (end < n && strcmp(samples[end].variant, samples[start].variant) == 0 &&
+               samples[end].phase == samples[start].phase &&
+               samples[end].period_start == samples[start].period_start) {
+            if (samples[end].ok) {
+                durations[ok++] = samples[end].ms;  // Already ascending
+            } else {
+                failed++;
+            }
+            end++;
+        }
+
+        job_history_row_t* row = &out[groups++];
+        row->period_start = samples[start].period_start;
+        snprintf(row->variant, sizeof(row->variant), "%s", samples[start].variant);
+        row->phase = samples[start].phase;
+        row->ok = ok;
+        row->failed = failed;
+        if (ok) {
+            row->p50_ms = percentile(durations, ok, 50);
+            row->p90_ms = percentile(durations, ok, 90);
+            row->p99_ms = percentile(durations, ok, 99);
+            row->max_ms = durations[ok - 1];
+        }
+
+        if (previous && (strcmp(previous->variant, row->variant) != 0 || previous->phase != row->phase)) {
+            previous = NULL;
+        }
+        if (previous && ok && previous->p50_ms) {
+            row->has_change = true;
+            row->change_pct = ((double)row->p50_ms - previous->p50_ms) * 100.0 / previous->p50_ms;
+        }
+        if (ok) {
+            previous = row;
+        }
+        start = end;
+    }
+
+    free(samples);
+    free(durations);
+    *rows = out;
+    *row_count = groups;
+    return 0;
+}
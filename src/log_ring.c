@@ -0,0 +1,109 @@
+#include "log_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// LOG RING BUFFER IMPLEMENTATION
+// ============================================================================
+//
+// Storage and the lock-free claim/publish protocol; the drain thread and
+// the output streams live in context.c.
+//
+// Classic bounded queue with per-slot sequence numbers: slot i starts with
+// seq == i. A producer that sees seq == pos may claim position pos; once the
+// text is in place it publishes seq = pos + 1. The consumer takes a slot
+// when seq == pos + 1 and hands it back to the next lap with
+// seq = pos + slot count.
+
+int log_ring_init(log_ring_t* ring, uint32_t slots) {
+    if (!ring) {
+        return -1;
+    }
+    if (slots == 0) {
+        slots = LOG_RING_DEFAULT_SLOTS;
+    }
+    uint32_t count = 1;
+    while (count < slots) {
+        count <<= 1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = (log_ring_slot_t*)calloc(count, sizeof(log_ring_slot_t));
+    if (!ring->slots) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        ring->slots[i].seq = i;
+    }
+    ring->mask = count - 1;
+    return 0;
+}
+
+void log_ring_destroy(log_ring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+bool log_ring_push(log_ring_t* ring, uint8_t stream, const char* text, size_t len) {
+    if (!ring || !ring->slots) {
+        return false;
+    }
+
+    uint32_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    log_ring_slot_t* slot;
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return false;  // Consumer has not freed this slot yet: full
+        } else {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (len > LOG_RING_MSG_MAX) {
+        len = LOG_RING_MSG_MAX;
+    }
+    memcpy(slot->text, text, len);
+    slot->len = (uint16_t)len;
+    slot->stream = stream;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool log_ring_pop(log_ring_t* ring, uint8_t* stream, char* out, size_t* len) {
+    if (!ring || !ring->slots) {
+        return false;
+    }
+
+    uint32_t pos = ring->dequeue_pos;
+    log_ring_slot_t* slot = &ring->slots[pos & ring->mask];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+        return false;
+    }
+
+    memcpy(out, slot->text, slot->len);
+    *len = slot->len;
+    if (stream) {
+        *stream = slot->stream;
+    }
+    __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+    ring->dequeue_pos = pos + 1;
+    return true;
+}
+
+uint32_t log_ring_take_dropped(log_ring_t* ring) {
+    return ring ? __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED) : 0;
+}
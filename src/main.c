@@ -1,13 +1,10 @@
 #include "thingino.h"
 #include "flash_descriptor.h"
+#include "fault_inject.h"
+#include <signal.h>
+#include <time.h>
 #include <unistd.h>  // for sleep()
 
-// ============================================================================
-// GLOBAL DEBUG FLAG
-// ============================================================================
-
-bool g_debug_enabled = false;
-
 // ============================================================================
 // MAIN CLI INTERFACE
 // ============================================================================
@@ -27,40 +24,100 @@ typedef struct {
     char* input_file;
     bool force_erase;
     bool skip_ddr;
+    uint32_t window_depth;  // 0 = per-variant default
+    bool bench;
+    uint32_t bench_size_mb;
+    bool bench_no_save;
+    char* flash_chip;       // Transfer profile key (NULL = "default")
+    char* device_port;      // --port bus-port path (overrides -i)
+    bool station;           // --station: write every bootrom device plugged in
+    bool verify;            // Read back and compare after writing
+    char* clone_source;     // --clone-from index or port (NULL = not cloning)
+    char* clone_targets[CLONE_MAX_TARGETS];
+    int clone_target_count;
+    int bus_slots;          // Heavy transfers per root port in multi-device modes
+    uint32_t watchdog_s;    // Cancel a device job after this long without progress (0 = off)
+    char* events;           // --events fd number or file for the JSON-lines event stream
+    char* metrics;          // --metrics unix:<socket> or textfile path
+    char* trace;            // --trace: record every USB transfer to this pcap
+    bool history;           // --history: report job timing percentiles and exit
+    uint32_t history_days;  // Days covered by --history
+    char* history_file;     // Job history log (NULL = default location)
+    bool no_history;        // Do not record jobs
+    bool dashboard;         // --dashboard: live per-device status lines
+    bool fault_bench;       // --fault-bench: simulated jobs under fault profiles, then exit
+    const char* fault_profiles[FAULT_BENCH_MAX_PROFILES];
+    int fault_profile_count;
+    uint32_t fault_bench_jobs;
 } cli_options_t;
 
 void print_usage(const char* program_name) {
-    printf("Thingino Cloner - USB Device Cloner for Ingenic Processors\n");
-    printf("Usage: %s [options]\n\n", program_name);
-    printf("Options:\n");
-    printf("  -h, --help              Show this help message\n");
-    printf("  -v, --verbose           Enable verbose logging\n");
-    printf("  -d, --debug             Enable debug output\n");
-    printf("  -l, --list             List connected devices\n");
-    printf("  -i, --index <num>       Device index to operate on (default: 0)\n");
-    printf("  -b, --bootstrap         Bootstrap device to firmware stage\n");
-    printf("  -r, --read <file>       Read firmware from device to file\n");
-    printf("  -w, --write <file>       Write firmware from file to device\n");
-    printf("      --erase              Request full flash erase before writing (when supported)\n");
-    printf("  --config <file>         Custom DDR configuration file\n");
-    printf("  --spl <file>            Custom SPL file\n");
-    printf("  --uboot <file>          Custom U-Boot file\n");
-    printf("  --skip-ddr              Skip DDR configuration during bootstrap\n");
-    printf("\nExamples:\n");
-    printf("  %s -l                           # List devices\n", program_name);
-    printf("  %s -i 0 -b                      # Bootstrap device 0\n", program_name);
-    printf("  %s -i 0 -r firmware.bin          # Read firmware\n", program_name);
-    printf("  %s -i 0 -w firmware.bin          # Write firmware\n", program_name);
-    printf("\nProcessor Variants Supported:\n");
-    printf("  T31X, T31ZX (primary targets)\n");
-    printf("  T20, T21, T23, T30, T31, T40, T41\n");
-    printf("  X1000, X1600, X1700, X2000, X2100, X2600\n");
+    thingino_printf("Thingino Cloner - USB Device Cloner for Ingenic Processors\n");
+    thingino_printf("Usage: %s [options]\n\n", program_name);
+    thingino_printf("Options:\n");
+    thingino_printf("  -h, --help              Show this help message\n");
+    thingino_printf("  -v, --verbose           Enable verbose logging\n");
+    thingino_printf("  -d, --debug             Enable debug output\n");
+    thingino_printf("  -l, --list             List connected devices\n");
+    thingino_printf("  -i, --index <num>       Device index to operate on (default: 0)\n");
+    thingino_printf("      --port <bus-path>    Device by physical port, e.g. 1-2.4 (see -l)\n");
+    thingino_printf("  -b, --bootstrap         Bootstrap device to firmware stage\n");
+    thingino_printf("  -r, --read <file>       Read firmware from device to file\n");
+    thingino_printf("  -w, --write <file>       Write firmware from file to device\n");
+    thingino_printf("      --erase              Request full flash erase before writing (when supported)\n");
+    thingino_printf("      --window <n>         Chunks kept in flight while writing (default: 1 = serial)\n");
+    thingino_printf("      --verify             Read flash back and compare after writing\n");
+    thingino_printf("      --station            Bootstrap and write (-w) every bootrom device as it is plugged in\n");
+    thingino_printf("      --bus-slots <n>      Bulk transfers per root port with --station/--clone-from (default: 1, 0 = unlimited)\n");
+    thingino_printf("      --watchdog <s>       Abort a --station/--clone-from device job idle this long (default: 30, 0 = off)\n");
+    thingino_printf("  --config <file>         Custom DDR configuration file\n");
+    thingino_printf("  --spl <file>            Custom SPL file\n");
+    thingino_printf("  --uboot <file>          Custom U-Boot file\n");
+    thingino_printf("  --skip-ddr              Skip DDR configuration during bootstrap\n");
+    thingino_printf("      --bench              Sweep read chunk sizes/delays and save the best profile\n");
+    thingino_printf("                           (writes are not swept; write settings keep their defaults)\n");
+    thingino_printf("      --bench-size <mb>    Bytes read per benchmark point in MB (default: 2)\n");
+    thingino_printf("      --bench-no-save      Report benchmark results without saving a profile\n");
+    thingino_printf("      --flash-chip <name>  Transfer profile key for the board's flash (default: default)\n");
+    thingino_printf("      --clone-from <dev>   Clone flash from this device index or port (needs --to)\n");
+    thingino_printf("      --to <dev,dev,...>   Target device indices or ports written in parallel\n");
+    thingino_printf("      --events <fd|file>   Write JSON-lines progress events to a file descriptor or file\n");
+    thingino_printf("      --metrics <target>   Export metrics: unix:<path> (OpenMetrics socket) or a .prom textfile\n");
+    thingino_printf("      --trace <file.pcap>  Record every USB transfer as a usbmon capture (see thingino-usbcap --diff)\n");
+    thingino_printf("      --dashboard          Live status line per device (plain periodic summaries when not a terminal)\n");
+    thingino_printf("      --history            Report per-variant phase timings from the job history and exit\n");
+    thingino_printf("      --history-days <n>   Days covered by --history (default: 30)\n");
+    thingino_printf("      --history-file <f>   Job history log (default: ~/.local/share/thingino-cloner/history.bin)\n");
+    thingino_printf("      --no-history         Do not record this run's jobs\n");
+    thingino_printf("      --fault-bench        Time simulated jobs under fault profiles (no device needed) and exit\n");
+    thingino_printf("      --fault-profile <p>  Profile for --fault-bench, repeatable (default: every built-in)\n");
+    thingino_printf("      --fault-bench-jobs <n>  Jobs per profile (default: %d)\n", FAULT_BENCH_JOBS);
+    thingino_printf("\nExamples:\n");
+    thingino_printf("  %s -l                           # List devices\n", program_name);
+    thingino_printf("  %s -i 0 -b                      # Bootstrap device 0\n", program_name);
+    thingino_printf("  %s -i 0 -r firmware.bin          # Read firmware\n", program_name);
+    thingino_printf("  %s -i 0 -w firmware.bin          # Write firmware\n", program_name);
+    thingino_printf("  %s -i 0 --bench                  # Tune transfer profile\n", program_name);
+    thingino_printf("  %s --clone-from 0 --to 1,2       # Clone device 0 onto devices 1 and 2\n", program_name);
+    thingino_printf("  %s --port 1-2.4 -w firmware.bin  # Write the board on hub port 1-2.4\n", program_name);
+    thingino_printf("  %s --station -w firmware.bin --verify  # Production station\n", program_name);
+    thingino_printf("  %s --fault-bench --fault-profile lossy-bus,seed=3  # Recovery under packet loss\n", program_name);
+    thingino_printf("  %s -i 0 -w firmware.bin --trace ours.pcap  # Record transfers to diff against a vendor capture\n", program_name);
+    thingino_printf("\nProcessor Variants Supported:\n");
+    thingino_printf("  T31X, T31ZX (primary targets)\n");
+    thingino_printf("  T20, T21, T23, T30, T31, T40, T41\n");
+    thingino_printf("  X1000, X1600, X1700, X2000, X2100, X2600\n");
 }
 
 thingino_error_t parse_arguments(int argc, char* argv[], cli_options_t* options) {
     // Initialize options
     memset(options, 0, sizeof(cli_options_t));
+    options->bus_slots = 1;
+    options->watchdog_s = 30;
+    options->history_days = 30;
     options->device_index = 0;
+    options->bench_size_mb = 2;
+    options->fault_bench_jobs = FAULT_BENCH_JOBS;
     
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
@@ -76,52 +133,198 @@ thingino_error_t parse_arguments(int argc, char* argv[], cli_options_t* options)
             options->bootstrap = true;
         } else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--read") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a filename\n", argv[i]);
+                thingino_printf("Error: %s requires a filename\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->read_firmware = true;
             options->output_file = argv[++i];
         } else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--write") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a filename\n", argv[i]);
+                thingino_printf("Error: %s requires a filename\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->write_firmware = true;
             options->input_file = argv[++i];
         } else if (strcmp(argv[i], "--config") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a filename\n", argv[i]);
+                thingino_printf("Error: %s requires a filename\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->config_file = argv[++i];
         } else if (strcmp(argv[i], "--spl") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a filename\n", argv[i]);
+                thingino_printf("Error: %s requires a filename\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->spl_file = argv[++i];
         } else if (strcmp(argv[i], "--uboot") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a filename\n", argv[i]);
+                thingino_printf("Error: %s requires a filename\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->uboot_file = argv[++i];
         } else if (strcmp(argv[i], "--skip-ddr") == 0) {
             options->skip_ddr = true;
+        } else if (strcmp(argv[i], "--station") == 0) {
+            options->station = true;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            options->verify = true;
         } else if (strcmp(argv[i], "--erase") == 0) {
             options->force_erase = true;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            options->bench = true;
+        } else if (strcmp(argv[i], "--fault-bench") == 0) {
+            options->fault_bench = true;
+        } else if (strcmp(argv[i], "--fault-profile") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a profile spec\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            if (options->fault_profile_count >= FAULT_BENCH_MAX_PROFILES) {
+                thingino_printf("Error: at most %d fault profiles are supported\n", FAULT_BENCH_MAX_PROFILES);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->fault_profiles[options->fault_profile_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--fault-bench-jobs") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a job count\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int jobs = atoi(argv[++i]);
+            if (jobs < 1 || jobs > 10000) {
+                thingino_printf("Error: fault benchmark jobs must be between 1 and 10000\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->fault_bench_jobs = (uint32_t)jobs;
+        } else if (strcmp(argv[i], "--bench-no-save") == 0) {
+            options->bench_no_save = true;
+        } else if (strcmp(argv[i], "--bench-size") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a size in MB\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int mb = atoi(argv[++i]);
+            if (mb < 1 || mb > 16) {
+                thingino_printf("Error: benchmark size must be between 1 and 16 MB\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->bench_size_mb = (uint32_t)mb;
+        } else if (strcmp(argv[i], "--flash-chip") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a name\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->flash_chip = argv[++i];
+        } else if (strcmp(argv[i], "--window") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a chunk count\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int depth = atoi(argv[++i]);
+            if (depth < 1) {
+                thingino_printf("Error: window depth must be >= 1\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->window_depth = (uint32_t)depth;
+        } else if (strcmp(argv[i], "--bus-slots") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a slot count\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int slots = atoi(argv[++i]);
+            if (slots < 0) {
+                thingino_printf("Error: bus slots must be >= 0\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->bus_slots = slots;
+        } else if (strcmp(argv[i], "--watchdog") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a number of seconds\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int seconds = atoi(argv[++i]);
+            if (seconds < 0) {
+                thingino_printf("Error: watchdog must be >= 0 seconds\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->watchdog_s = (uint32_t)seconds;
+        } else if (strcmp(argv[i], "--port") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a port path\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->device_port = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a file descriptor or file name\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->events = argv[++i];
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires unix:<socket> or a file name\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->metrics = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a file name\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->trace = argv[++i];
+        } else if (strcmp(argv[i], "--dashboard") == 0) {
+            options->dashboard = true;
+        } else if (strcmp(argv[i], "--history") == 0) {
+            options->history = true;
+        } else if (strcmp(argv[i], "--no-history") == 0) {
+            options->no_history = true;
+        } else if (strcmp(argv[i], "--history-days") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a number of days\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            int days = atoi(argv[++i]);
+            if (days < 1) {
+                thingino_printf("Error: history days must be >= 1\n");
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->history_days = (uint32_t)days;
+        } else if (strcmp(argv[i], "--history-file") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a file name\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->history_file = argv[++i];
+        } else if (strcmp(argv[i], "--clone-from") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a device index or port\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            options->clone_source = argv[++i];
+        } else if (strcmp(argv[i], "--to") == 0) {
+            if (i + 1 >= argc) {
+                thingino_printf("Error: %s requires a list of device indices or ports\n", argv[i]);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+            for (char* tok = strtok(argv[++i], ","); tok; tok = strtok(NULL, ",")) {
+                if (options->clone_target_count >= CLONE_MAX_TARGETS) {
+                    thingino_printf("Error: at most %d clone targets are supported\n", CLONE_MAX_TARGETS);
+                    return THINGINO_ERROR_INVALID_PARAMETER;
+                }
+                options->clone_targets[options->clone_target_count++] = tok;
+            }
         } else if (strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--index") == 0) {
             if (i + 1 >= argc) {
-                printf("Error: %s requires a device index\n", argv[i]);
+                thingino_printf("Error: %s requires a device index\n", argv[i]);
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
             options->device_index = atoi(argv[++i]);
             if (options->device_index < 0) {
-                printf("Error: device index must be >= 0\n");
+                thingino_printf("Error: device index must be >= 0\n");
                 return THINGINO_ERROR_INVALID_PARAMETER;
             }
         } else {
-            printf("Error: Unknown option %s\n", argv[i]);
+            thingino_printf("Error: Unknown option %s\n", argv[i]);
             print_usage(argv[0]);
             return THINGINO_ERROR_INVALID_PARAMETER;
         }
@@ -130,35 +333,83 @@ thingino_error_t parse_arguments(int argc, char* argv[], cli_options_t* options)
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Resolve a device given as list index ("2") or port path ("1-2.4")
+ *
+ * @return index into devices, or -1 (with a message) if there is no match
+ */
+static int resolve_device_spec(const device_info_t* devices, int device_count, const char* spec) {
+    if (strchr(spec, '-')) {
+        int idx = usb_device_info_find_port(devices, device_count, spec);
+        if (idx < 0) {
+            thingino_printf("Error: no Ingenic device on port %s\n", spec);
+        }
+        return idx;
+    }
+
+    char* end = NULL;
+    long idx = strtol(spec, &end, 10);
+    if (end == spec || *end != '\0' || idx < 0) {
+        thingino_printf("Error: invalid device '%s' (expected an index or a port like 1-2.4)\n", spec);
+        return -1;
+    }
+    if (idx >= device_count) {
+        thingino_printf("Error: device index %ld out of range (found %d devices)\n", idx, device_count);
+        return -1;
+    }
+    return (int)idx;
+}
+
+/**
+ * Pick the device of a single-device operation from a fresh scan: by --port
+ * when given, since list indices shift whenever a board re-enumerates, and
+ * by index otherwise
+ *
+ * @return index into devices, or -1 (with a message) if there is no match
+ */
+static int select_device(const device_info_t* devices, int device_count, int index,
+                         const cli_options_t* options) {
+    if (options && options->device_port) {
+        return resolve_device_spec(devices, device_count, options->device_port);
+    }
+    if (index >= device_count) {
+        thingino_printf("Error: device index %d out of range (found %d devices)\n", index, device_count);
+        return -1;
+    }
+    return index;
+}
+
 thingino_error_t list_devices(usb_manager_t* manager) {
-    printf("Scanning for Ingenic devices...\n\n");
+    thingino_printf("Scanning for Ingenic devices...\n\n");
     
     device_info_t* devices;
     int device_count;
     thingino_error_t result = usb_manager_find_devices(manager, &devices, &device_count);
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to list devices: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to list devices: %s\n", thingino_error_to_string(result));
         return result;
     }
     
     if (device_count == 0) {
-        printf("No Ingenic devices found\n");
+        thingino_printf("No Ingenic devices found\n");
         return THINGINO_SUCCESS;
     }
     
-    printf("Found %d device(s):\n", device_count);
-    printf("Index | Bus | Addr | Vendor  | Product | Stage    | Variant\n");
-    printf("-----|-----|------|---------|----------|--------\n");
+    thingino_printf("Found %d device(s):\n", device_count);
+    thingino_printf("Index | Port        | Bus | Addr | Vendor  | Product | Stage    | Variant\n");
+    thingino_printf("-----|-------------|-----|------|---------|----------|----------|--------\n");
     
     for (int i = 0; i < device_count; i++) {
         device_info_t* dev = &devices[i];
-        printf("%5d | %3d | %4d | 0x%04X  | 0x%04X  | %-8s | %s\n",
-            i, dev->bus, dev->address, dev->vendor, dev->product,
+        char port[USB_PORT_STRING_MAX];
+        usb_port_path_format(dev, port, sizeof(port));
+        thingino_printf("%5d | %-11s | %3d | %4d | 0x%04X  | 0x%04X  | %-8s | %s\n",
+            i, port, dev->bus, dev->address, dev->vendor, dev->product,
             device_stage_to_string(dev->stage),
             processor_variant_to_string(dev->variant));
     }
     
-    printf("\n");
+    thingino_printf("\n");
     free(devices);
     return THINGINO_SUCCESS;
 }
@@ -169,30 +420,29 @@ thingino_error_t bootstrap_device_by_index(usb_manager_t* manager, int index, co
     int device_count;
     thingino_error_t result = usb_manager_find_devices(manager, &devices, &device_count);
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to list devices: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to list devices: %s\n", thingino_error_to_string(result));
         return result;
     }
     
     if (device_count == 0) {
-        printf("No devices found\n");
+        thingino_printf("No devices found\n");
         free(devices);
         return THINGINO_ERROR_DEVICE_NOT_FOUND;
     }
     
-    if (index >= device_count) {
-        printf("Error: device index %d out of range (found %d devices)\n", 
-            index, device_count);
+    index = select_device(devices, device_count, index, options);
+    if (index < 0) {
         free(devices);
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
     
     // Show device info
     device_info_t* device_info = &devices[index];
-    printf("Bootstrapping device [%d]: %s %s (Bus %03d Address %03d)\n", 
+    thingino_printf("Bootstrapping device [%d]: %s %s (Bus %03d Address %03d)\n", 
         index, processor_variant_to_string(device_info->variant), 
         device_stage_to_string(device_info->stage), 
         device_info->bus, device_info->address);
-    printf("  Vendor: 0x%04x, Product: 0x%04x\n", 
+    thingino_printf("  Vendor: 0x%04x, Product: 0x%04x\n", 
         device_info->vendor, device_info->product);
     
     // Open device
@@ -200,7 +450,7 @@ thingino_error_t bootstrap_device_by_index(usb_manager_t* manager, int index, co
     usb_device_t* device;
     result = usb_manager_open_device(manager, device_info, &device);
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to open device: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to open device: %s\n", thingino_error_to_string(result));
         free(devices);
         return result;
     }
@@ -224,9 +474,9 @@ thingino_error_t bootstrap_device_by_index(usb_manager_t* manager, int index, co
     // Run bootstrap
     result = bootstrap_device(device, &config);
     if (result != THINGINO_SUCCESS) {
-        printf("Bootstrap failed: %s\n", thingino_error_to_string(result));
+        thingino_printf("Bootstrap failed: %s\n", thingino_error_to_string(result));
     } else {
-        printf("Bootstrap completed successfully!\n");
+        thingino_printf("Bootstrap completed successfully!\n");
     }
     
     // Cleanup
@@ -281,32 +531,31 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
     int device_count;
     thingino_error_t result = usb_manager_find_devices(manager, &devices, &device_count);
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to list devices: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to list devices: %s\n", thingino_error_to_string(result));
         return result;
     }
     
     if (device_count == 0) {
-        printf("No devices found\n");
+        thingino_printf("No devices found\n");
         free(devices);
         return THINGINO_ERROR_DEVICE_NOT_FOUND;
     }
     
-    if (index >= device_count) {
-        printf("Error: device index %d out of range (found %d devices)\n", 
-            index, device_count);
+    index = select_device(devices, device_count, index, options);
+    if (index < 0) {
         free(devices);
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
     
     // Show device info
     device_info_t* device_info = &devices[index];
-    printf("Reading firmware from device [%d]: %s %s (Bus %03d Address %03d)\n", 
+    thingino_printf("Reading firmware from device [%d]: %s %s (Bus %03d Address %03d)\n", 
         index, processor_variant_to_string(device_info->variant), 
         device_stage_to_string(device_info->stage), 
         device_info->bus, device_info->address);
     
     // Check if device is in firmware stage, but also verify by getting CPU info
-    printf("Checking device stage...\n");
+    thingino_printf("Checking device stage...\n");
     usb_device_t* test_device;
     result = usb_manager_open_device(manager, device_info, &test_device);
     if (result == THINGINO_SUCCESS) {
@@ -314,18 +563,18 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
         thingino_error_t cpu_result = usb_device_get_cpu_info(test_device, &cpu_info);
         if (cpu_result == THINGINO_SUCCESS) {
             // Show raw hex bytes for debugging
-            printf("CPU magic (raw hex): ");
+            thingino_printf("CPU magic (raw hex): ");
             for (int i = 0; i < 8; i++) {
-                printf("%02X ", cpu_info.magic[i]);
+                thingino_printf("%02X ", cpu_info.magic[i]);
             }
-            printf("\n");
+            thingino_printf("\n");
 
-            printf("Current device stage: %s (CPU magic: %.8s)\n",
+            thingino_printf("Current device stage: %s (CPU magic: %.8s)\n",
                 device_stage_to_string(cpu_info.stage), cpu_info.magic);
 
             // Detect and display processor variant
             processor_variant_t detected_variant = detect_variant_from_magic(cpu_info.clean_magic);
-            printf("Detected processor variant: %s (from magic: '%s')\n",
+            thingino_printf("Detected processor variant: %s (from magic: '%s')\n",
                 processor_variant_to_string(detected_variant), cpu_info.clean_magic);
 
             // Check if device PID matches firmware stage
@@ -338,17 +587,23 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
             // 2. CPU magic indicates firmware but PID is still bootrom (transitional state)
             if (!cpu_is_firmware || (cpu_is_firmware && !pid_is_firmware)) {
                 if (cpu_is_firmware && !pid_is_firmware) {
-                    printf("Device CPU shows firmware stage but USB PID is still bootrom\n");
-                    printf("Device is in transitional state - waiting for re-enumeration...\n");
+                    thingino_printf("Device CPU shows firmware stage but USB PID is still bootrom\n");
+                    thingino_printf("Device is in transitional state - waiting for re-enumeration...\n");
                     usb_device_close(test_device);
                     free(test_device);
                     test_device = NULL;
 
-                    // Wait for device to re-enumerate
-                    sleep(1);
+                    // Wait for device to re-enumerate on the same port
+                    device_info_t before = *device_info;
+                    device_info_t arrived;
+                    if (usb_wait_for_arrival(manager->context, &before, REENUMERATION_TIMEOUT_MS,
+                                             &arrived) != THINGINO_SUCCESS) {
+                        thingino_printf("[WARNING] Device did not re-enumerate within %d ms\n",
+                               REENUMERATION_TIMEOUT_MS);
+                    }
 
                     // Re-scan for devices
-                    printf("Re-scanning for devices after transition...\n");
+                    thingino_printf("Re-scanning for devices after transition...\n");
                     if (devices) {
                         free(devices);
                         devices = NULL;
@@ -357,7 +612,7 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
 
                     result = usb_manager_find_devices(manager, &devices, &device_count);
                     if (result != THINGINO_SUCCESS || device_count == 0) {
-                        printf("Failed to find device after transition\n");
+                        thingino_printf("Failed to find device after transition\n");
                         if (devices) free(devices);
                         return THINGINO_ERROR_DEVICE_NOT_FOUND;
                     }
@@ -367,41 +622,43 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                     for (int i = 0; i < device_count; i++) {
                         bool is_fw_pid = (devices[i].product == PRODUCT_ID_FIRMWARE ||
                                          devices[i].product == PRODUCT_ID_FIRMWARE2);
-                        if (devices[i].stage == STAGE_FIRMWARE && is_fw_pid) {
+                        if (devices[i].stage == STAGE_FIRMWARE && is_fw_pid &&
+                            usb_device_info_may_share_port(&devices[i], &before)) {
                             device_info = &devices[i];
-                            printf("Found device with firmware PID: Bus %03d Address %03d (PID: 0x%04x)\n",
+                            thingino_printf("Found device with firmware PID: Bus %03d Address %03d (PID: 0x%04x)\n",
                                 device_info->bus, device_info->address, device_info->product);
                             break;
                         }
                     }
 
                     if (!device_info) {
-                        printf("Device not found with firmware PID after transition\n");
-                        printf("Note: Some devices keep bootrom PID even after loading U-Boot\n");
-                        printf("Accepting device with bootrom PID and firmware CPU magic\n");
+                        thingino_printf("Device not found with firmware PID after transition\n");
+                        thingino_printf("Note: Some devices keep bootrom PID even after loading U-Boot\n");
+                        thingino_printf("Accepting device with bootrom PID and firmware CPU magic\n");
 
                         // Accept the device with bootrom PID if it has firmware CPU magic
                         for (int i = 0; i < device_count; i++) {
-                            if (devices[i].product == PRODUCT_ID_BOOTROM2 || devices[i].product == PRODUCT_ID_BOOTROM) {
+                            if ((devices[i].product == PRODUCT_ID_BOOTROM2 || devices[i].product == PRODUCT_ID_BOOTROM) &&
+                                usb_device_info_may_share_port(&devices[i], &before)) {
                                 device_info = &devices[i];
-                                printf("Using device: Bus %03d Address %03d (PID: 0x%04x)\n",
+                                thingino_printf("Using device: Bus %03d Address %03d (PID: 0x%04x)\n",
                                     device_info->bus, device_info->address, device_info->product);
                                 break;
                             }
                         }
 
                         if (!device_info) {
-                            printf("No Ingenic device found after transition\n");
+                            thingino_printf("No Ingenic device found after transition\n");
                             free(devices);
                             return THINGINO_ERROR_DEVICE_NOT_FOUND;
                         }
                     }
 
                     // Open the device for firmware reading
-                    printf("Opening device for firmware reading...\n");
+                    thingino_printf("Opening device for firmware reading...\n");
                     result = usb_manager_open_device(manager, device_info, &test_device);
                     if (result != THINGINO_SUCCESS) {
-                        printf("Failed to open device: %s\n", thingino_error_to_string(result));
+                        thingino_printf("Failed to open device: %s\n", thingino_error_to_string(result));
                         free(devices);
                         return result;
                     }
@@ -409,33 +666,34 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                     // Verify it's in firmware stage
                     cpu_result = usb_device_get_cpu_info(test_device, &cpu_info);
                     if (cpu_result != THINGINO_SUCCESS || cpu_info.stage != STAGE_FIRMWARE) {
-                        printf("Device not in firmware stage after opening\n");
+                        thingino_printf("Device not in firmware stage after opening\n");
                         usb_device_close(test_device);
                         free(test_device);
                         free(devices);
                         return THINGINO_ERROR_PROTOCOL;
                     }
 
-                    printf("Device opened successfully and verified in firmware stage\n");
-                    printf("Keeping device open for firmware reading to avoid re-enumeration\n");
+                    thingino_printf("Device opened successfully and verified in firmware stage\n");
+                    thingino_printf("Keeping device open for firmware reading to avoid re-enumeration\n");
                 } else {
-                    printf("Device not in firmware stage, attempting bootstrap first...\n");
+                    thingino_printf("Device not in firmware stage, attempting bootstrap first...\n");
                     usb_device_close(test_device);
                     free(test_device);
                     test_device = NULL;
 
                     // Bootstrap device - pass through the original options to preserve custom file paths
+                device_info_t before = *device_info;
                 result = bootstrap_device_by_index(manager, index, options);
                 
                 if (result != THINGINO_SUCCESS) {
-                    printf("Bootstrap failed: %s\n", thingino_error_to_string(result));
+                    thingino_printf("Bootstrap failed: %s\n", thingino_error_to_string(result));
                     free(devices);
                     return result;
                 }
                 
                 // Re-check device stage after bootstrap
                 // Device may have re-enumerated with new address, so wait and re-scan
-                printf("Waiting for device to stabilize after bootstrap...\n");
+                thingino_printf("Waiting for device to stabilize after bootstrap...\n");
 
                 // Close the test device (it's now invalid after bootstrap)
                 if (test_device) {
@@ -444,14 +702,17 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                     test_device = NULL;
                 }
 
-                // Wait for device to re-enumerate and fully stabilize
-                // Device may re-enumerate multiple times after ProgStage2
-                // User reports it takes about 10 seconds to reappear
-                printf("Waiting 1 seconds for device to fully stabilize...\n");
-                sleep(1);
+                // Wait for device to re-enumerate on the same port. It may
+                // take several seconds to reappear after ProgStage2
+                device_info_t arrived;
+                if (usb_wait_for_arrival(manager->context, &before, REENUMERATION_TIMEOUT_MS,
+                                         &arrived) != THINGINO_SUCCESS) {
+                    thingino_printf("[WARNING] Device did not re-enumerate within %d ms\n",
+                           REENUMERATION_TIMEOUT_MS);
+                }
 
                 // Re-scan for devices to get updated address
-                printf("Re-scanning for devices after bootstrap...\n");
+                thingino_printf("Re-scanning for devices after bootstrap...\n");
                 if (devices) {
                     free(devices);
                     devices = NULL;
@@ -460,7 +721,7 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
 
                 result = usb_manager_find_devices(manager, &devices, &device_count);
                 if (result != THINGINO_SUCCESS || device_count == 0) {
-                    printf("Failed to find device after bootstrap\n");
+                    thingino_printf("Failed to find device after bootstrap\n");
                     if (devices) {
                         free(devices);
                         devices = NULL;
@@ -472,21 +733,25 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                 // Note: Device may still have bootrom PID but firmware CPU magic during transition
                 device_info = NULL;
                 for (int i = 0; i < device_count; i++) {
+                    // Skip boards on other ports that share the VID/PID
+                    if (!usb_device_info_may_share_port(&devices[i], &before)) {
+                        continue;
+                    }
                     // Accept device if it's in firmware stage OR if it has bootrom PID but we can verify CPU magic
                     if (devices[i].stage == STAGE_FIRMWARE) {
                         device_info = &devices[i];
-                        printf("Found device in firmware stage: Bus %03d Address %03d\n",
+                        thingino_printf("Found device in firmware stage: Bus %03d Address %03d\n",
                             device_info->bus, device_info->address);
                         break;
                     } else if (devices[i].product == PRODUCT_ID_BOOTROM2 || devices[i].product == PRODUCT_ID_BOOTROM) {
                         // Device might be in transitional state - verify with CPU magic
-                        printf("Found device with bootrom PID, verifying CPU magic...\n");
+                        thingino_printf("Found device with bootrom PID, verifying CPU magic...\n");
                         usb_device_t* verify_device;
                         if (usb_manager_open_device(manager, &devices[i], &verify_device) == THINGINO_SUCCESS) {
                             cpu_info_t verify_cpu;
                             if (usb_device_get_cpu_info(verify_device, &verify_cpu) == THINGINO_SUCCESS) {
                                 if (verify_cpu.stage == STAGE_FIRMWARE) {
-                                    printf("Device has firmware CPU magic (%.8s), using it\n", verify_cpu.magic);
+                                    thingino_printf("Device has firmware CPU magic (%.8s), using it\n", verify_cpu.magic);
                                     device_info = &devices[i];
                                     usb_device_close(verify_device);
                                     free(verify_device);
@@ -500,7 +765,7 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                 }
 
                 if (!device_info) {
-                    printf("Device not found in firmware stage after bootstrap\n");
+                    thingino_printf("Device not found in firmware stage after bootstrap\n");
                     if (devices) {
                         free(devices);
                         devices = NULL;
@@ -513,11 +778,11 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                 if (result == THINGINO_SUCCESS) {
                     cpu_result = usb_device_get_cpu_info(test_device, &cpu_info);
                     if (cpu_result == THINGINO_SUCCESS && cpu_info.stage == STAGE_FIRMWARE) {
-                        printf("Device successfully bootstrapped to firmware stage\n");
-                        printf("Keeping device open for firmware reading to avoid re-enumeration\n");
+                        thingino_printf("Device successfully bootstrapped to firmware stage\n");
+                        thingino_printf("Keeping device open for firmware reading to avoid re-enumeration\n");
                         // DON'T close the device - we'll reuse this handle for firmware reading
                     } else {
-                        printf("Bootstrap completed but device still not in firmware stage\n");
+                        thingino_printf("Bootstrap completed but device still not in firmware stage\n");
                         if (test_device) {
                             usb_device_close(test_device);
                             free(test_device);
@@ -530,7 +795,7 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                         return THINGINO_ERROR_PROTOCOL;
                     }
                 } else {
-                    printf("Failed to reopen device after bootstrap\n");
+                    thingino_printf("Failed to reopen device after bootstrap\n");
                     if (devices) {
                         free(devices);
                         devices = NULL;
@@ -539,18 +804,18 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
                 }
                 }  // End of bootstrap if block
             } else {
-                printf("Device is in firmware stage with correct PID, proceeding with read\n");
-                printf("Keeping device open for firmware reading to avoid re-enumeration\n");
+                thingino_printf("Device is in firmware stage with correct PID, proceeding with read\n");
+                thingino_printf("Keeping device open for firmware reading to avoid re-enumeration\n");
                 // DON'T close the device - we'll reuse this handle for firmware reading
             }
         } else {
-            printf("Failed to get CPU info for stage verification\n");
+            thingino_printf("Failed to get CPU info for stage verification\n");
             usb_device_close(test_device);
             free(test_device);
             test_device = NULL;
         }
     } else {
-        printf("Failed to open device for stage verification\n");
+        thingino_printf("Failed to open device for stage verification\n");
         test_device = NULL;
     }
 
@@ -563,12 +828,29 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
     // This avoids triggering re-enumeration by reopening the device
     usb_device_t* device = test_device;
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to open device: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to open device: %s\n", thingino_error_to_string(result));
         free(devices);
         return result;
     }
-    
-    printf("Reading firmware from device...\n");
+    if (!device) {
+        free(devices);
+        return THINGINO_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    if (options->flash_chip) {
+        snprintf(device->info.flash_chip, sizeof(device->info.flash_chip), "%s", options->flash_chip);
+    }
+
+    if (options->bench) {
+        result = firmware_bench_run(device, options->bench_size_mb * 1024 * 1024,
+                                    !options->bench_no_save);
+        usb_device_close(device);
+        free(device);
+        free(devices);
+        return result;
+    }
+
+    thingino_printf("Reading firmware from device...\n");
     
     // Read full firmware from device
     uint8_t* firmware_data = NULL;
@@ -576,19 +858,19 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
     result = firmware_read_full(device, &firmware_data, &firmware_size);
     
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to read firmware: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to read firmware: %s\n", thingino_error_to_string(result));
         usb_device_close(device);
         free(device);
         free(devices);
         return result;
     }
     
-    printf("Successfully read %u bytes from device\n", firmware_size);
+    thingino_printf("Successfully read %u bytes from device\n", firmware_size);
     
     // Save to file
     FILE* file = fopen(output_file, "wb");
     if (!file) {
-        printf("Failed to open output file: %s\n", output_file);
+        thingino_printf("Failed to open output file: %s\n", output_file);
         free(firmware_data);
         usb_device_close(device);
         free(device);
@@ -602,9 +884,9 @@ thingino_error_t read_firmware_from_device(usb_manager_t* manager, int index, co
     free(firmware_data);
     
     if (bytes_written != (size_t)firmware_size) {
-        printf("Warning: only %zu of %u bytes written to file\n", bytes_written, firmware_size);
+        thingino_printf("Warning: only %zu of %u bytes written to file\n", bytes_written, firmware_size);
     } else {
-        printf("Firmware successfully saved to: %s (%.2f MB)\n", 
+        thingino_printf("Firmware successfully saved to: %s (%.2f MB)\n", 
             output_file, (float)firmware_size / (1024 * 1024));
     }
     
@@ -625,26 +907,23 @@ thingino_error_t write_firmware_from_file(usb_manager_t* manager, int device_ind
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    (void)options;  // Unused for now
-
-    printf("\n");
-    printf("================================================================================\n");
-    printf("FIRMWARE WRITE\n");
-    printf("================================================================================\n");
-    printf("\n");
+    thingino_printf("\n");
+    thingino_printf("================================================================================\n");
+    thingino_printf("FIRMWARE WRITE\n");
+    thingino_printf("================================================================================\n");
+    thingino_printf("\n");
 
     // List devices
     device_info_t* devices = NULL;
     int device_count = 0;
     thingino_error_t result = usb_manager_find_devices(manager, &devices, &device_count);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Error listing devices: %s\n", thingino_error_to_string(result));
+        thingino_eprintf("Error listing devices: %s\n", thingino_error_to_string(result));
         return result;
     }
 
-    if (device_index >= device_count) {
-        fprintf(stderr, "Error: Device index %d out of range (0-%d)\n",
-                device_index, device_count - 1);
+    device_index = select_device(devices, device_count, device_index, options);
+    if (device_index < 0) {
         free(devices);
         return THINGINO_ERROR_DEVICE_NOT_FOUND;
     }
@@ -653,21 +932,21 @@ thingino_error_t write_firmware_from_file(usb_manager_t* manager, int device_ind
     usb_device_t* device = NULL;
     result = usb_manager_open_device(manager, &devices[device_index], &device);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Error opening device: %s\n", thingino_error_to_string(result));
+        thingino_eprintf("Error opening device: %s\n", thingino_error_to_string(result));
         free(devices);
         return result;
     }
 
-    printf("Target Device:\n");
-    printf("  Index: %d\n", device_index);
-    printf("  Bus: %03d Address: %03d\n", devices[device_index].bus, devices[device_index].address);
-    printf("  Variant: %s\n", processor_variant_to_string(devices[device_index].variant));
-    printf("  Stage: %s\n", device_stage_to_string(devices[device_index].stage));
-    printf("\n");
+    thingino_printf("Target Device:\n");
+    thingino_printf("  Index: %d\n", device_index);
+    thingino_printf("  Bus: %03d Address: %03d\n", devices[device_index].bus, devices[device_index].address);
+    thingino_printf("  Variant: %s\n", processor_variant_to_string(devices[device_index].variant));
+    thingino_printf("  Stage: %s\n", device_stage_to_string(devices[device_index].stage));
+    thingino_printf("\n");
 
     // Check if device needs bootstrap
     if (devices[device_index].stage == STAGE_BOOTROM) {
-        printf("Device is in bootrom stage. Bootstrapping to firmware stage first...\n\n");
+        thingino_printf("Device is in bootrom stage. Bootstrapping to firmware stage first...\n\n");
 
         bootstrap_config_t bootstrap_config = {
             .skip_ddr = options->skip_ddr,
@@ -681,42 +960,49 @@ thingino_error_t write_firmware_from_file(usb_manager_t* manager, int device_ind
 
         result = bootstrap_device(device, &bootstrap_config);
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "Error: Bootstrap failed: %s\n", thingino_error_to_string(result));
+            thingino_eprintf("Error: Bootstrap failed: %s\n", thingino_error_to_string(result));
             usb_device_close(device);
             free(device);
             free(devices);
             return result;
         }
 
-        printf("\nBootstrap complete. Device should now be in firmware stage.\n");
-        printf("Waiting for device to stabilize...\n\n");
-        usleep(2000000);  // 2 seconds
+        thingino_printf("\nBootstrap complete. Device should now be in firmware stage.\n");
 
         // Close and reopen device to get fresh connection
+        device_info_t before = devices[device_index];
         usb_device_close(device);
         free(device);
 
+        thingino_printf("Waiting for device to re-enumerate...\n\n");
+        device_info_t arrived;
+        if (usb_wait_for_arrival(manager->context, &before, REENUMERATION_TIMEOUT_MS,
+                                 &arrived) != THINGINO_SUCCESS) {
+            thingino_printf("[WARNING] Device did not re-enumerate within %d ms, rescanning anyway\n",
+                   REENUMERATION_TIMEOUT_MS);
+        }
+
         // Re-scan for device in firmware stage
         free(devices);
         devices = NULL;
         result = usb_manager_find_devices(manager, &devices, &device_count);
         if (result != THINGINO_SUCCESS || device_count == 0) {
-            fprintf(stderr, "Error: Device not found after bootstrap\n");
+            thingino_eprintf("Error: Device not found after bootstrap\n");
             if (devices) free(devices);
             return THINGINO_ERROR_DEVICE_NOT_FOUND;
         }
 
-        // Find the device again (it may have re-enumerated)
+        // Find the device again on the port it was bootstrapped on
         int found_index = -1;
         for (int i = 0; i < device_count; i++) {
-            if (devices[i].stage == STAGE_FIRMWARE) {
+            if (devices[i].stage == STAGE_FIRMWARE && usb_device_info_may_share_port(&devices[i], &before)) {
                 found_index = i;
                 break;
             }
         }
 
         if (found_index < 0) {
-            fprintf(stderr, "Error: Device not in firmware stage after bootstrap\n");
+            thingino_eprintf("Error: Device not in firmware stage after bootstrap\n");
             free(devices);
             return THINGINO_ERROR_PROTOCOL;
         }
@@ -724,107 +1010,28 @@ thingino_error_t write_firmware_from_file(usb_manager_t* manager, int device_ind
         // Reopen device
         result = usb_manager_open_device(manager, &devices[found_index], &device);
         if (result != THINGINO_SUCCESS) {
-            fprintf(stderr, "Error: Failed to reopen device: %s\n", thingino_error_to_string(result));
+            thingino_eprintf("Error: Failed to reopen device: %s\n", thingino_error_to_string(result));
             free(devices);
             return result;
         }
 
-        printf("Device reopened in firmware stage.\n\n");
+        thingino_printf("Device reopened in firmware stage.\n\n");
     }
 
     free(devices);
 
-    // Detect A1 firmware-stage boards via CPU magic so we can use the correct
-    // flash descriptor (A1 uses XM25QH128B, T31x uses GD25Q127CSIG).
-    bool is_a1_fw_stage = false;
-    cpu_info_t fw_cpu_info;
-    memset(&fw_cpu_info, 0, sizeof(fw_cpu_info));
-    thingino_error_t fw_cpu_res = usb_device_get_cpu_info(device, &fw_cpu_info);
-    if (fw_cpu_res == THINGINO_SUCCESS) {
-        if (strncmp(fw_cpu_info.clean_magic, "A1", 2) == 0 ||
-            strncmp(fw_cpu_info.clean_magic, "a1", 2) == 0) {
-            is_a1_fw_stage = true;
-            DEBUG_PRINT("Detected A1 CPU magic ('%s') in firmware stage\n",
-                       fw_cpu_info.clean_magic);
-        }
-    }
-
-    // Prepare burner protocol in firmware stage: send partition marker,
-    // then flash descriptor, then initialize the firmware handshake
-    // protocol. This mirrors the vendor write sequence more closely:
-    //   - Chunk 3: 172-byte "ILOP" partition marker (bulk OUT)
-    //   - Chunk 4: 972-byte flash descriptor + policies (contains "nor" string
-    //     that tells A1 burner to use NOR flash mode instead of MMC mode)
-    //   - Then firmware write handshakes and data chunks.
-    //
-    // NOTE: A1 boards also need this! The metadata contains the crucial "nor"
-    // string at offset 0xF0 that tells the burner to use NOR flash mode.
-    // Without it, the A1 burner tries to write to MMC/SD card and fails.
-    if (device->info.stage == STAGE_FIRMWARE &&
-        (device->info.variant == VARIANT_T31 ||
-         device->info.variant == VARIANT_T31X ||
-         device->info.variant == VARIANT_T31ZX)) {
-
-        thingino_error_t prep_result = THINGINO_SUCCESS;
-
-        printf("Preparing partition marker, flash descriptor and firmware handshake...\n");
-
-        // 1) Send 172-byte partition marker ("ILOP" header)
-        prep_result = flash_partition_marker_send(device);
-        if (prep_result != THINGINO_SUCCESS) {
-            printf("[ERROR] Failed to send partition marker: %s\n",
-                   thingino_error_to_string(prep_result));
-            usb_device_close(device);
-            free(device);
-            return prep_result;
-        }
-
-        // 2) Build and send full 972-byte flash descriptor
-        // Use A1-specific descriptor for A1 boards, T31x descriptor otherwise.
-        // The A1 descriptor contains the XM25QH128B flash chip info and the
-        // crucial "nor" string at offset 0xF0 that tells the burner to use
-        // NOR flash mode instead of MMC mode.
-        uint8_t flash_descriptor[FLASH_DESCRIPTOR_SIZE];
-        int desc_result;
-        if (is_a1_fw_stage) {
-            desc_result = flash_descriptor_create_a1_writer_full(flash_descriptor);
-            if (desc_result != 0) {
-                printf("[ERROR] Failed to create A1 writer_full flash descriptor\n");
-                usb_device_close(device);
-                free(device);
-                return THINGINO_ERROR_MEMORY;
-            }
-        } else {
-            desc_result = flash_descriptor_create_t31x_writer_full(flash_descriptor);
-            if (desc_result != 0) {
-                printf("[ERROR] Failed to create T31x writer_full flash descriptor\n");
-                usb_device_close(device);
-                free(device);
-                return THINGINO_ERROR_MEMORY;
-            }
-        }
-
-        prep_result = flash_descriptor_send(device, flash_descriptor);
-        if (prep_result != THINGINO_SUCCESS) {
-            printf("[ERROR] Failed to send flash descriptor: %s\n",
-                   thingino_error_to_string(prep_result));
-            usb_device_close(device);
-            free(device);
-            return prep_result;
-        }
-
-        // Give the burner time to process descriptor, matching read path
-        usleep(500000); // 500ms
+    if (options->flash_chip) {
+        snprintf(device->info.flash_chip, sizeof(device->info.flash_chip), "%s", options->flash_chip);
+    }
 
-        // 3) Initialize the firmware handshake protocol (VR_FW_HANDSHAKE)
-        prep_result = firmware_handshake_init(device);
-        if (prep_result != THINGINO_SUCCESS) {
-            printf("[ERROR] Failed to initialize firmware handshake: %s\n",
-                   thingino_error_to_string(prep_result));
-            usb_device_close(device);
-            free(device);
-            return prep_result;
-        }
+    // Detect A1 boards and send partition marker, flash descriptor and
+    // handshake init for the burner
+    bool is_a1_fw_stage = false;
+    result = firmware_write_prepare(device, &is_a1_fw_stage);
+    if (result != THINGINO_SUCCESS) {
+        usb_device_close(device);
+        free(device);
+        return result;
     }
 
     // Get firmware binary (optional - can be NULL if not using embedded firmware)
@@ -833,29 +1040,242 @@ thingino_error_t write_firmware_from_file(usb_manager_t* manager, int device_ind
     // fw_binary = firmware_get("t31x");
 
     // Write firmware
-    printf("Writing firmware to device...\n");
-    printf("  Source file: %s\n", firmware_file);
-    printf("\n");
+    thingino_printf("Writing firmware to device...\n");
+    thingino_printf("  Source file: %s\n", firmware_file);
+    thingino_printf("\n");
 
-    result = write_firmware_to_device(device, firmware_file, fw_binary, options->force_erase, is_a1_fw_stage);
+    result = write_firmware_to_device(device, firmware_file, fw_binary, options->force_erase, is_a1_fw_stage,
+                                      options->window_depth);
     if (result != THINGINO_SUCCESS) {
-        fprintf(stderr, "Error: Firmware write failed: %s\n", thingino_error_to_string(result));
+        thingino_eprintf("Error: Firmware write failed: %s\n", thingino_error_to_string(result));
         usb_device_close(device);
         free(device);
         return result;
     }
 
-    printf("\n");
-    printf("================================================================================\n");
-    printf("FIRMWARE WRITE COMPLETE\n");
-    printf("================================================================================\n");
-    printf("\n");
+    if (options->verify) {
+        thingino_printf("Verifying flash against %s...\n", firmware_file);
+        firmware_image_t image;
+        if (firmware_image_open(firmware_file, &image) != 0 || image.size > UINT32_MAX) {
+            result = THINGINO_ERROR_FILE_IO;
+        } else {
+            result = firmware_verify(device, image.data, (uint32_t)image.size);
+            firmware_image_close(&image);
+        }
+        if (result != THINGINO_SUCCESS) {
+            thingino_eprintf("Error: Verify failed: %s\n", thingino_error_to_string(result));
+            usb_device_close(device);
+            free(device);
+            return result;
+        }
+        thingino_printf("Verify OK\n");
+    }
+
+    thingino_printf("\n");
+    thingino_printf("================================================================================\n");
+    thingino_printf("FIRMWARE WRITE COMPLETE\n");
+    thingino_printf("================================================================================\n");
+    thingino_printf("\n");
 
     usb_device_close(device);
     free(device);
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Clone flash from one device onto one or more others in a single pass
+ *
+ * Every device involved must already be in firmware stage (bootstrap each
+ * one with -i N -b first); the source read and all target writes then run
+ * concurrently, see firmware_clone().
+ */
+thingino_error_t clone_devices(usb_manager_t* manager, const cli_options_t* options) {
+    if (options->clone_target_count == 0) {
+        thingino_printf("Error: --clone-from requires --to <dev,...>\n");
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    device_info_t* devices = NULL;
+    int device_count = 0;
+    thingino_error_t result = usb_manager_find_devices(manager, &devices, &device_count);
+    if (result != THINGINO_SUCCESS) {
+        thingino_printf("Failed to list devices: %s\n", thingino_error_to_string(result));
+        return result;
+    }
+
+    // Resolve and validate every device before touching any of them
+    int indices[CLONE_MAX_TARGETS + 1];
+    int index_count = options->clone_target_count + 1;
+
+    for (int i = 0; i < index_count; i++) {
+        const char* spec = i == 0 ? options->clone_source : options->clone_targets[i - 1];
+        int idx = resolve_device_spec(devices, device_count, spec);
+        if (idx < 0) {
+            free(devices);
+            return THINGINO_ERROR_INVALID_PARAMETER;
+        }
+        indices[i] = idx;
+
+        for (int j = 0; j < i; j++) {
+            if (indices[j] == idx) {
+                thingino_printf("Error: device %d listed more than once\n", idx);
+                free(devices);
+                return THINGINO_ERROR_INVALID_PARAMETER;
+            }
+        }
+        if (devices[idx].stage != STAGE_FIRMWARE) {
+            thingino_printf("Error: device %d is in %s stage; bootstrap it first with -i %d -b\n",
+                   idx, device_stage_to_string(devices[idx].stage), idx);
+            free(devices);
+            return THINGINO_ERROR_PROTOCOL;
+        }
+        if (i > 0 && devices[idx].variant != devices[indices[0]].variant) {
+            thingino_printf("[WARNING] Target %d is %s but source is %s\n", idx,
+                   processor_variant_to_string(devices[idx].variant),
+                   processor_variant_to_string(devices[indices[0]].variant));
+        }
+    }
+
+    usb_device_t* source = NULL;
+    clone_target_t targets[CLONE_MAX_TARGETS];
+    int opened = 0;
+    memset(targets, 0, sizeof(targets));
+
+    result = usb_manager_open_device(manager, &devices[indices[0]], &source);
+    if (result != THINGINO_SUCCESS) {
+        thingino_printf("Failed to open source device %d: %s\n", indices[0], thingino_error_to_string(result));
+        free(devices);
+        return result;
+    }
+
+    for (int i = 0; i < options->clone_target_count; i++) {
+        int idx = indices[i + 1];
+        result = usb_manager_open_device(manager, &devices[idx], &targets[i].device);
+        if (result != THINGINO_SUCCESS) {
+            thingino_printf("Failed to open target device %d: %s\n", idx, thingino_error_to_string(result));
+            break;
+        }
+        snprintf(targets[i].label, sizeof(targets[i].label), "[to %d]", idx);
+        opened++;
+    }
+
+    if (result == THINGINO_SUCCESS) {
+        if (options->flash_chip) {
+            snprintf(source->info.flash_chip, sizeof(source->info.flash_chip), "%s", options->flash_chip);
+            for (int i = 0; i < opened; i++) {
+                snprintf(targets[i].device->info.flash_chip, sizeof(targets[i].device->info.flash_chip),
+                         "%s", options->flash_chip);
+            }
+        }
+
+        // One token per device: a hung target is cut loose by its watchdog
+        // while the source and the other targets carry on
+        thingino_cancel_t tokens[CLONE_MAX_TARGETS + 1];
+        for (int i = 0; i <= opened; i++) {
+            thingino_cancel_init(&tokens[i], options->watchdog_s * 1000u);
+        }
+        source->cancel = &tokens[0];
+        for (int i = 0; i < opened; i++) {
+            targets[i].device->cancel = &tokens[i + 1];
+        }
+
+        thingino_printf("Cloning device %d onto %d target(s)\n\n", indices[0], opened);
+        bus_sched_configure(options->bus_slots);
+        result = firmware_clone(source, targets, opened);
+        bus_sched_report();
+        bus_sched_configure(0);
+
+        source->cancel = NULL;
+        for (int i = 0; i < opened; i++) {
+            targets[i].device->cancel = NULL;
+        }
+        for (int i = 0; i <= opened; i++) {
+            if (tokens[i].cancelled) {
+                thingino_printf("[WARNING] %s %d stopped: %s\n", i == 0 ? "Source device" : "Device",
+                       indices[i], tokens[i].reason);
+            }
+            thingino_cancel_destroy(&tokens[i]);
+        }
+
+        thingino_printf("\nClone results:\n");
+        for (int i = 0; i < opened; i++) {
+            thingino_printf("  Device %d: %s\n", indices[i + 1],
+                   targets[i].result == THINGINO_SUCCESS ? "OK"
+                                                         : thingino_error_to_string(targets[i].result));
+        }
+    }
+
+    for (int i = 0; i < opened; i++) {
+        usb_device_close(targets[i].device);
+        free(targets[i].device);
+    }
+    usb_device_close(source);
+    free(source);
+    free(devices);
+
+    return result;
+}
+
+/**
+ * --history: per-day timing percentiles for each variant and phase, with
+ * the median's change against the previous day that has data
+ */
+thingino_error_t print_history(const cli_options_t* options) {
+    char default_path[512];
+    const char* path = options->history_file;
+    if (!path) {
+        if (job_history_default_path(default_path, sizeof(default_path)) != 0) {
+            thingino_printf("Error: cannot determine the job history location (use --history-file)\n");
+            return THINGINO_ERROR_FILE_IO;
+        }
+        path = default_path;
+    }
+
+    const int64_t day = 86400;
+    int64_t since = ((int64_t)time(NULL) / day - (int64_t)options->history_days + 1) * day;
+    job_record_t* records = NULL;
+    size_t count = 0;
+    if (job_history_load(path, since, &records, &count) != 0) {
+        thingino_printf("Error: cannot read job history %s\n", path);
+        return THINGINO_ERROR_FILE_IO;
+    }
+
+    job_history_row_t* rows = NULL;
+    size_t row_count = 0;
+    if (job_history_summarize(records, count, (uint32_t)day, &rows, &row_count) != 0) {
+        free(records);
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    thingino_printf("Job history: %s\n", path);
+    thingino_printf("%zu job(s) in the last %u day(s), grouped by UTC day; times in seconds\n\n",
+                    count, options->history_days);
+    if (row_count > 0) {
+        thingino_printf("%-10s  %-10s  %-9s  %5s  %4s  %7s  %7s  %7s  %7s  %8s\n", "Day", "Variant",
+                        "Phase", "OK", "Fail", "p50", "p90", "p99", "max", "p50 chg");
+    }
+    for (size_t i = 0; i < row_count; i++) {
+        const job_history_row_t* row = &rows[i];
+        char date[16];
+        time_t start = (time_t)row->period_start;
+        strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&start));
+
+        char change[16] = "";
+        if (row->has_change) {
+            snprintf(change, sizeof(change), "%+.1f%%", row->change_pct);
+        }
+        thingino_printf("%-10s  %-10s  %-9s  %5u  %4u  %7.1f  %7.1f  %7.1f  %7.1f  %8s%s\n", date,
+                        row->variant, metrics_phase_name(row->phase), row->ok, row->failed,
+                        row->p50_ms / 1000.0, row->p90_ms / 1000.0, row->p99_ms / 1000.0,
+                        row->max_ms / 1000.0, change,
+                        row->has_change && row->change_pct >= JOB_HISTORY_SLOWER_PCT ? "  <-- slower" : "");
+    }
+
+    free(rows);
+    free(records);
+    return THINGINO_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     cli_options_t options;
     thingino_error_t result = parse_arguments(argc, argv, &options);
@@ -863,48 +1283,130 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Set global debug flag based on CLI options
-    g_debug_enabled = options.debug;
-    
-    // Initialize USB manager
-    usb_manager_t manager;
-    result = usb_manager_init(&manager);
+    // Terminal output from here on is written by the logger thread, so a
+    // slow console never holds up a transfer
+    thingino_log_async_start();
+
+    // Reading the history needs no USB
+    if (options.history) {
+        return print_history(&options) == THINGINO_SUCCESS ? 0 : 1;
+    }
+
+    // Neither does the fault benchmark: its devices are simulated
+    if (options.fault_bench) {
+        result = fault_bench_run(options.fault_profiles, options.fault_profile_count,
+                                 options.fault_bench_jobs);
+        return result == THINGINO_SUCCESS ? 0 : 1;
+    }
+
+    // One library context for the whole run; worker threads inherit it
+    thingino_context_t context;
+    result = thingino_context_init(&context);
     if (result != THINGINO_SUCCESS) {
-        printf("Failed to initialize USB manager: %s\n", thingino_error_to_string(result));
+        thingino_printf("Failed to initialize USB manager: %s\n", thingino_error_to_string(result));
+        return 1;
+    }
+    context.debug = options.debug;
+    thingino_context_bind(&context);
+    usb_manager_t* manager = &context.manager;
+
+    if (options.events) {
+#ifndef _WIN32
+        // A controller closing its end of a pipe must not kill a transfer
+        signal(SIGPIPE, SIG_IGN);
+#endif
+        if (thingino_events_open(&context, options.events) != THINGINO_SUCCESS) {
+            thingino_context_cleanup(&context);
+            return 1;
+        }
+    }
+    if (options.metrics && thingino_metrics_start(&context, options.metrics) != THINGINO_SUCCESS) {
+        thingino_context_cleanup(&context);
+        return 1;
+    }
+    if (options.trace && thingino_trace_open(&context, options.trace) != THINGINO_SUCCESS) {
+        thingino_context_cleanup(&context);
         return 1;
     }
+    if (!options.no_history && !options.list_devices) {
+        thingino_history_open(&context, options.history_file);  // Best effort
+    }
+    if (options.dashboard && !options.list_devices) {
+        thingino_dashboard_start(&context);  // Best effort, output stays plain without it
+    }
     
     int exit_code = 0;
-    
+
     if (options.list_devices) {
-        result = list_devices(&manager);
+        result = list_devices(manager);
+        if (result != THINGINO_SUCCESS) {
+            exit_code = 1;
+        }
+    } else if (options.station) {
+        if (!options.input_file) {
+            thingino_printf("Error: --station requires -w <file>\n");
+            exit_code = 1;
+        } else {
+            station_config_t station = {
+                .firmware_file = options.input_file,
+                .verify = options.verify,
+                .window_depth = options.window_depth,
+                .flash_chip = options.flash_chip,
+                .bus_slots = options.bus_slots,
+                .watchdog_ms = options.watchdog_s * 1000u,
+                .bootstrap = {
+                    .sdram_address = BOOTLOADER_ADDRESS_SDRAM,
+                    .timeout = BOOTSTRAP_TIMEOUT_SECONDS,
+                    .verbose = options.verbose,
+                    .skip_ddr = options.skip_ddr,
+                    .config_file = options.config_file,
+                    .spl_file = options.spl_file,
+                    .uboot_file = options.uboot_file
+                }
+            };
+            result = station_run(manager, &station);
+            if (result != THINGINO_SUCCESS) {
+                exit_code = 1;
+            }
+        }
+    } else if (options.clone_source) {
+        result = clone_devices(manager, &options);
         if (result != THINGINO_SUCCESS) {
             exit_code = 1;
         }
     } else if (options.bootstrap) {
-        result = bootstrap_device_by_index(&manager, options.device_index, &options);
+        thingino_job_begin(options.device_port);
+        result = bootstrap_device_by_index(manager, options.device_index, &options);
+        thingino_job_end(result);
         if (result != THINGINO_SUCCESS) {
             exit_code = 1;
         }
-    } else if (options.read_firmware) {
-        result = read_firmware_from_device(&manager, options.device_index,
+    } else if (options.read_firmware || options.bench) {
+        // --bench shares the read path's bootstrap and firmware-stage checks
+        if (!options.bench) {
+            thingino_job_begin(options.device_port);
+        }
+        result = read_firmware_from_device(manager, options.device_index,
             options.output_file, &options);
+        thingino_job_end(result);  // No-op for --bench
         if (result != THINGINO_SUCCESS) {
             exit_code = 1;
         }
     } else if (options.write_firmware) {
-        result = write_firmware_from_file(&manager, options.device_index,
+        thingino_job_begin(options.device_port);
+        result = write_firmware_from_file(manager, options.device_index,
             options.input_file, &options);
+        thingino_job_end(result);
         if (result != THINGINO_SUCCESS) {
             exit_code = 1;
         }
     } else {
-        printf("No action specified. Use -h for help.\n");
+        thingino_printf("No action specified. Use -h for help.\n");
         exit_code = 1;
     }
     
     // Cleanup
-    usb_manager_cleanup(&manager);
+    thingino_context_cleanup(&context);
     
     return exit_code;
 }
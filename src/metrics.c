@@ -0,0 +1,286 @@
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// METRICS IMPLEMENTATION
+// ============================================================================
+//
+// Fixed histogram buckets per metric, atomic updates, and rendering of a
+// scrape in OpenMetrics or Prometheus text format into a caller's buffer.
+
+static const uint64_t chunk_bounds_us[] = {
+    5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+static const uint64_t phase_bounds_us[] = {
+    1000000, 2000000, 5000000, 10000000, 20000000, 30000000, 60000000, 120000000,
+    300000000, 600000000
+};
+static const uint64_t erase_bounds_us[] = {
+    1000000, 2000000, 5000000, 10000000, 20000000, 30000000, 45000000, 60000000, 90000000
+};
+
+static const char* const direction_names[METRICS_DIRECTIONS] = { "read", "write" };
+static const char* const phase_names[METRICS_PHASES] = { "bootstrap", "read", "verify", "write" };
+
+#define BOUNDS(array) (array), (uint32_t)(sizeof(array) / sizeof((array)[0]))
+
+static void histogram_init(metrics_histogram_t* h, const uint64_t* bounds_us, uint32_t count) {
+    h->bounds_us = bounds_us;
+    h->bound_count = count;
+}
+
+static void histogram_observe(metrics_histogram_t* h, uint64_t value_us) {
+    uint32_t i = 0;
+    while (i < h->bound_count && value_us > h->bounds_us[i]) {
+        i++;
+    }
+    __atomic_fetch_add(&h->buckets[i], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_us, value_us, __ATOMIC_RELAXED);
+}
+
+static uint64_t load(const uint64_t* value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+void metrics_init(metrics_t* m) {
+    memset(m, 0, sizeof(*m));
+    for (int d = 0; d < METRICS_DIRECTIONS; d++) {
+        histogram_init(&m->chunk_latency[d], BOUNDS(chunk_bounds_us));
+    }
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        histogram_init(&m->phase_duration[p], BOUNDS(phase_bounds_us));
+    }
+    histogram_init(&m->erase_wait, BOUNDS(erase_bounds_us));
+}
+
+int metrics_phase_from_name(const char* name) {
+    for (int p = 0; name && p < METRICS_PHASES; p++) {
+        if (strcmp(name, phase_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+const char* metrics_phase_name(metrics_phase_t phase) {
+    return phase < METRICS_PHASES ? phase_names[phase] : "unknown";
+}
+
+// ============================================================================
+// RECORDING
+// ============================================================================
+
+void metrics_chunk(metrics_t* m, metrics_direction_t dir, uint8_t bus, uint32_t bytes,
+                   uint64_t latency_us) {
+    if (!m || dir >= METRICS_DIRECTIONS) {
+        return;
+    }
+    __atomic_fetch_add(&m->bytes[dir][bus], bytes, __ATOMIC_RELAXED);
+    histogram_observe(&m->chunk_latency[dir], latency_us);
+}
+
+void metrics_phase_begin(metrics_t* m, metrics_phase_t phase) {
+    if (!m || phase >= METRICS_PHASES) {
+        return;
+    }
+    __atomic_fetch_add(&m->jobs_active[phase], 1, __ATOMIC_RELAXED);
+}
+
+void metrics_phase_end(metrics_t* m, metrics_phase_t phase, uint64_t duration_us, int error) {
+    if (!m || phase >= METRICS_PHASES) {
+        return;
+    }
+    __atomic_fetch_sub(&m->jobs_active[phase], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->jobs[phase][error ? 1 : 0], 1, __ATOMIC_RELAXED);
+    histogram_observe(&m->phase_duration[phase], duration_us);
+    if (error) {
+        int slot = error < 0 && -error < METRICS_ERROR_CODES ? -error : METRICS_ERROR_CODES - 1;
+        __atomic_fetch_add(&m->failures[phase][slot], 1, __ATOMIC_RELAXED);
+    }
+}
+
+void metrics_erase(metrics_t* m, uint64_t wait_us) {
+    if (m) {
+        histogram_observe(&m->erase_wait, wait_us);
+    }
+}
+
+void metrics_retry(metrics_t* m, uint8_t request) {
+    if (m) {
+        __atomic_fetch_add(&m->retries[request], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// ============================================================================
+// EXPOSITION
+// ============================================================================
+//
+// Both formats share sample lines. They differ in the metadata: OpenMetrics
+// names a counter family without its _total suffix and adds # UNIT and
+// # EOF; the Prometheus text format read by the textfile collector names
+// the family after the sample.
+
+typedef struct {
+    char* out;
+    size_t size;
+    size_t len;
+    metrics_format_t format;
+} writer_t;
+
+static void emit(writer_t* w, const char* fmt, ...) {
+    char* dst = w->len < w->size ? w->out + w->len : NULL;
+    size_t room = w->len < w->size ? w->size - w->len : 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(dst, room, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        w->len += (size_t)n;
+    }
+}
+
+static void emit_family(writer_t* w, const char* name, const char* type, const char* unit,
+                        const char* help) {
+    bool counter = strcmp(type, "counter") == 0;
+    const char* suffix = counter && w->format == METRICS_FORMAT_PROMETHEUS ? "_total" : "";
+    emit(w, "# TYPE %s%s %s\n", name, suffix, type);
+    if (unit && w->format == METRICS_FORMAT_OPENMETRICS) {
+        emit(w, "# UNIT %s %s\n", name, unit);
+    }
+    emit(w, "# HELP %s%s %s\n", name, suffix, help);
+}
+
+// Label values from error names; escape what the text format requires
+static void emit_label_value(writer_t* w, const char* value) {
+    for (const char* c = value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            emit(w, "\\%c", *c);
+        } else if (*c == '\n') {
+            emit(w, "\\n");
+        } else {
+            emit(w, "%c", *c);
+        }
+    }
+}
+
+static void format_seconds(uint64_t us, char* out, size_t size) {
+    snprintf(out, size, "%g", (double)us / 1e6);
+    if (!strpbrk(out, ".e")) {
+        strncat(out, ".0", size - strlen(out) - 1);
+    }
+}
+
+// labels: "" or e.g. "phase=\"read\"" (without braces)
+static void emit_histogram(writer_t* w, const char* name, const char* labels,
+                           const metrics_histogram_t* h) {
+    const char* sep = labels[0] ? "," : "";
+    uint64_t cumulative = 0;
+    char le[32];
+    for (uint32_t i = 0; i <= h->bound_count; i++) {
+        cumulative += load(&h->buckets[i]);
+        if (i < h->bound_count) {
+            format_seconds(h->bounds_us[i], le, sizeof(le));
+        } else {
+            snprintf(le, sizeof(le), "+Inf");
+        }
+        emit(w, "%s_bucket{%s%sle=\"%s\"} %llu\n", name, labels, sep, le,
+             (unsigned long long)cumulative);
+    }
+
+    // Count from the buckets so it always matches the +Inf bucket
+    const char* open = labels[0] ? "{" : "";
+    const char* close = labels[0] ? "}" : "";
+    emit(w, "%s_count%s%s%s %llu\n", name, open, labels, close, (unsigned long long)cumulative);
+    emit(w, "%s_sum%s%s%s %.6f\n", name, open, labels, close, (double)load(&h->sum_us) / 1e6);
+}
+
+size_t metrics_format(const metrics_t* m, metrics_format_t format, metrics_error_name_fn error_name,
+                      char* out, size_t size) {
+    writer_t w = { out, size, 0, format };
+    if (out && size) {
+        out[0] = '\0';
+    }
+    if (!m) {
+        return 0;
+    }
+    char labels[64];
+
+    emit_family(&w, "thingino_transfer_bytes", "counter", "bytes",
+                "Flash bytes moved over USB, by direction and bus");
+    for (int d = 0; d < METRICS_DIRECTIONS; d++) {
+        for (int bus = 0; bus < METRICS_BUSES; bus++) {
+            uint64_t bytes = load(&m->bytes[d][bus]);
+            if (bytes) {
+                emit(&w, "thingino_transfer_bytes_total{direction=\"%s\",bus=\"%d\"} %llu\n",
+                     direction_names[d], bus, (unsigned long long)bytes);
+            }
+        }
+    }
+
+    emit_family(&w, "thingino_chunk_latency_seconds", "histogram", "seconds",
+                "Time to move one flash chunk, handshake to completion");
+    for (int d = 0; d < METRICS_DIRECTIONS; d++) {
+        snprintf(labels, sizeof(labels), "direction=\"%s\"", direction_names[d]);
+        emit_histogram(&w, "thingino_chunk_latency_seconds", labels, &m->chunk_latency[d]);
+    }
+
+    emit_family(&w, "thingino_jobs_active", "gauge", NULL, "Device jobs currently in each phase");
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        emit(&w, "thingino_jobs_active{phase=\"%s\"} %lld\n", phase_names[p],
+             (long long)__atomic_load_n(&m->jobs_active[p], __ATOMIC_RELAXED));
+    }
+
+    emit_family(&w, "thingino_jobs", "counter", NULL, "Device jobs finished, by phase and result");
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        emit(&w, "thingino_jobs_total{phase=\"%s\",result=\"ok\"} %llu\n", phase_names[p],
+             (unsigned long long)load(&m->jobs[p][0]));
+        emit(&w, "thingino_jobs_total{phase=\"%s\",result=\"failed\"} %llu\n", phase_names[p],
+             (unsigned long long)load(&m->jobs[p][1]));
+    }
+
+    emit_family(&w, "thingino_phase_duration_seconds", "histogram", "seconds",
+                "Wall time of each device job phase");
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", phase_names[p]);
+        emit_histogram(&w, "thingino_phase_duration_seconds", labels, &m->phase_duration[p]);
+    }
+
+    emit_family(&w, "thingino_failures", "counter", NULL, "Failed phases, by phase and error");
+    for (int p = 0; p < METRICS_PHASES; p++) {
+        for (int slot = 1; slot < METRICS_ERROR_CODES; slot++) {
+            uint64_t count = load(&m->failures[p][slot]);
+            if (!count) {
+                continue;
+            }
+            emit(&w, "thingino_failures_total{phase=\"%s\",code=\"%d\"", phase_names[p], -slot);
+            if (error_name && error_name(-slot)) {
+                emit(&w, ",error=\"");
+                emit_label_value(&w, error_name(-slot));
+                emit(&w, "\"");
+            }
+            emit(&w, "} %llu\n", (unsigned long long)count);
+        }
+    }
+
+    emit_family(&w, "thingino_erase_wait_seconds", "histogram", "seconds",
+                "Time spent waiting for the chip erase before writing");
+    emit_histogram(&w, "thingino_erase_wait_seconds", "", &m->erase_wait);
+
+    emit_family(&w, "thingino_vendor_retries", "counter", NULL,
+                "Vendor requests retried, by request code");
+    for (int request = 0; request < METRICS_REQUESTS; request++) {
+        uint64_t count = load(&m->retries[request]);
+        if (count) {
+            emit(&w, "thingino_vendor_retries_total{request=\"0x%02x\"} %llu\n", request,
+                 (unsigned long long)count);
+        }
+    }
+
+    if (format == METRICS_FORMAT_OPENMETRICS) {
+        emit(&w, "# EOF\n");
+    }
+    return w.len;
+}
@@ -0,0 +1,298 @@
+#include "thingino.h"
+
+#include <errno.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+// ============================================================================
+// METRICS EXPORT IMPLEMENTATION
+// ============================================================================
+//
+// One exporter thread per context. Device threads only ever touch the
+// atomic counters in ctx->metrics; rendering and all I/O happen here.
+
+#define METRICS_ACCEPT_TICK_MS   200
+#define METRICS_REQUEST_WAIT_MS  100    // How long a client gets to send "GET ..."
+
+struct thingino_metrics_exporter {
+    thingino_context_t* ctx;
+    pthread_t thread;
+    int stop;
+    bool socket_mode;
+    int listen_fd;
+    char* path;
+};
+
+static const char* metrics_error_name(int code) {
+    return thingino_error_to_string((thingino_error_t)code);
+}
+
+char* thingino_metrics_render(thingino_context_t* ctx, metrics_format_t format, size_t* len) {
+    if (!ctx || !ctx->metrics) {
+        return NULL;
+    }
+
+    // Counters keep moving while we render, so leave room to grow
+    size_t capacity = metrics_format(ctx->metrics, format, metrics_error_name, NULL, 0) + 1024;
+    for (;;) {
+        char* text = (char*)malloc(capacity);
+        if (!text) {
+            return NULL;
+        }
+        size_t needed = metrics_format(ctx->metrics, format, metrics_error_name, text, capacity);
+        if (needed < capacity) {
+            if (len) {
+                *len = needed;
+            }
+            return text;
+        }
+        free(text);
+        capacity = needed + 1024;
+    }
+}
+
+static bool metrics_stopping(struct thingino_metrics_exporter* exporter) {
+    return __atomic_load_n(&exporter->stop, __ATOMIC_ACQUIRE) != 0;
+}
+
+// ============================================================================
+// TEXTFILE COLLECTOR
+// ============================================================================
+
+static void metrics_write_textfile(struct thingino_metrics_exporter* exporter) {
+    size_t len = 0;
+    char* text = thingino_metrics_render(exporter->ctx, METRICS_FORMAT_PROMETHEUS, &len);
+    if (!text) {
+        return;
+    }
+
+    // Write aside and rename so the collector never sees a partial file
+    size_t tmp_size = strlen(exporter->path) + 8;
+    char* tmp = (char*)malloc(tmp_size);
+    if (!tmp) {
+        free(text);
+        return;
+    }
+    snprintf(tmp, tmp_size, "%s.tmp", exporter->path);
+    FILE* file = fopen(tmp, "wb");
+    bool ok = file && fwrite(text, 1, len, file) == len;
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+#ifdef _WIN32
+    remove(exporter->path);
+#endif
+    if (!ok || rename(tmp, exporter->path) != 0) {
+        thingino_printf("[WARN] Cannot update metrics file %s: %s\n", exporter->path, strerror(errno));
+        remove(tmp);
+    }
+    free(tmp);
+    free(text);
+}
+
+static void metrics_textfile_loop(struct thingino_metrics_exporter* exporter) {
+    uint64_t next = 0;
+    while (!metrics_stopping(exporter)) {
+        uint64_t now = thingino_real_now_us() / 1000;
+        if (now >= next) {
+            metrics_write_textfile(exporter);
+            next = now + METRICS_TEXTFILE_INTERVAL_MS;
+        }
+        thingino_sleep_real_milliseconds(METRICS_ACCEPT_TICK_MS);
+    }
+    metrics_write_textfile(exporter);  // Final totals
+}
+
+// ============================================================================
+// SOCKET ENDPOINT
+// ============================================================================
+
+#ifndef _WIN32
+static void metrics_write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return;  // Scraper went away
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static void metrics_serve_client(struct thingino_metrics_exporter* exporter, int fd) {
+    // Plain clients (socat, nc -U) send nothing; HTTP scrapers send a GET
+    char request[512];
+    ssize_t got = 0;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, METRICS_REQUEST_WAIT_MS) > 0) {
+        got = read(fd, request, sizeof(request) - 1);
+    }
+    bool http = got >= 4 && memcmp(request, "GET ", 4) == 0;
+
+    size_t len = 0;
+    char* text = thingino_metrics_render(exporter->ctx, METRICS_FORMAT_OPENMETRICS, &len);
+    if (!text) {
+        return;
+    }
+    if (http) {
+        char header[256];
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.0 200 OK\r\n"
+                                  "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                                  "Content-Length: %zu\r\n"
+                                  "Connection: close\r\n\r\n", len);
+        metrics_write_all(fd, header, (size_t)header_len);
+    }
+    metrics_write_all(fd, text, len);
+    free(text);
+}
+
+static void metrics_socket_loop(struct thingino_metrics_exporter* exporter) {
+    while (!metrics_stopping(exporter)) {
+        struct pollfd pfd = { exporter->listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, METRICS_ACCEPT_TICK_MS) <= 0) {
+            continue;
+        }
+        int fd = accept(exporter->listen_fd, NULL, NULL);
+        if (fd >= 0) {
+            metrics_serve_client(exporter, fd);
+            close(fd);
+        }
+    }
+}
+
+static thingino_error_t metrics_listen(struct thingino_metrics_exporter* exporter) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(exporter->path) >= sizeof(addr.sun_path)) {
+        thingino_printf("[ERROR] Metrics socket path too long: %s\n", exporter->path);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", exporter->path);
+
+    exporter->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (exporter->listen_fd < 0) {
+        thingino_printf("[ERROR] socket: %s\n", strerror(errno));
+        return THINGINO_ERROR_FILE_IO;
+    }
+
+    unlink(exporter->path);  // Stale socket from an earlier run
+    if (bind(exporter->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(exporter->listen_fd, 8) != 0) {
+        thingino_printf("[ERROR] Cannot listen on %s: %s\n", exporter->path, strerror(errno));
+        close(exporter->listen_fd);
+        exporter->listen_fd = -1;
+        return THINGINO_ERROR_FILE_IO;
+    }
+    return THINGINO_SUCCESS;
+}
+#endif
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+static void* metrics_thread(void* arg) {
+    struct thingino_metrics_exporter* exporter = (struct thingino_metrics_exporter*)arg;
+    thingino_context_bind(exporter->ctx);
+#ifndef _WIN32
+    if (exporter->socket_mode) {
+        metrics_socket_loop(exporter);
+        return NULL;
+    }
+#endif
+    metrics_textfile_loop(exporter);
+    return NULL;
+}
+
+static void metrics_exporter_free(struct thingino_metrics_exporter* exporter) {
+#ifndef _WIN32
+    if (exporter->listen_fd >= 0) {
+        close(exporter->listen_fd);
+        unlink(exporter->path);
+    }
+#endif
+    free(exporter->path);
+    free(exporter);
+}
+
+thingino_error_t thingino_metrics_start(thingino_context_t* ctx, const char* target) {
+    if (!ctx || !target || !target[0]) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    thingino_metrics_stop(ctx);
+
+    struct thingino_metrics_exporter* exporter =
+        (struct thingino_metrics_exporter*)calloc(1, sizeof(*exporter));
+    metrics_t* metrics = (metrics_t*)malloc(sizeof(metrics_t));
+    bool socket_mode = strncmp(target, "unix:", 5) == 0;
+    const char* where = socket_mode ? target + 5 : target;
+    char* path = (char*)malloc(strlen(where) + 1);
+    if (path) {
+        memcpy(path, where, strlen(where) + 1);
+    }
+    if (!exporter || !metrics || !path) {
+        free(exporter);
+        free(metrics);
+        free(path);
+        return THINGINO_ERROR_MEMORY;
+    }
+    metrics_init(metrics);
+    exporter->ctx = ctx;
+    exporter->socket_mode = socket_mode;
+    exporter->listen_fd = -1;
+    exporter->path = path;
+
+    if (socket_mode) {
+#ifdef _WIN32
+        thingino_printf("[ERROR] Metrics sockets are not supported on Windows; use a textfile path\n");
+        metrics_exporter_free(exporter);
+        free(metrics);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+#else
+        thingino_error_t result = metrics_listen(exporter);
+        if (result != THINGINO_SUCCESS) {
+            metrics_exporter_free(exporter);
+            free(metrics);
+            return result;
+        }
+#endif
+    }
+
+    // Collection starts before the exporter can read anything
+    ctx->metrics = metrics;
+    if (pthread_create(&exporter->thread, NULL, metrics_thread, exporter) != 0) {
+        thingino_printf("[ERROR] Failed to start metrics exporter thread\n");
+        ctx->metrics = NULL;
+        metrics_exporter_free(exporter);
+        free(metrics);
+        return THINGINO_ERROR_INIT_FAILED;
+    }
+    ctx->metrics_exporter = exporter;
+    return THINGINO_SUCCESS;
+}
+
+/**
+ * Stop exporting and collecting. Call once device threads of the context
+ * are done; a textfile gets its final totals here.
+ */
+void thingino_metrics_stop(thingino_context_t* ctx) {
+    if (!ctx || !ctx->metrics_exporter) {
+        return;
+    }
+    struct thingino_metrics_exporter* exporter = ctx->metrics_exporter;
+    __atomic_store_n(&exporter->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(exporter->thread, NULL);
+    metrics_exporter_free(exporter);
+
+    free(ctx->metrics);
+    ctx->metrics = NULL;
+    ctx->metrics_exporter = NULL;
+}
@@ -0,0 +1,593 @@
+/**
+ * Station Mode (--station)
+ *
+ * Long-running production mode: every bootrom-stage device plugged into the
+ * host is bootstrapped, written and (optionally) verified without anyone
+ * launching a command. Arrivals come from a libusb hotplug subscription, so
+ * the first USB request goes out as soon as the device enumerates. Each
+ * port runs its own job thread, and a port is free for the next unit the
+ * moment its job reports PASS or FAIL. A job that stops making USB
+ * progress is cancelled by its watchdog, so a hung unit fails in seconds
+ * instead of holding its port through every timeout and retry.
+ *
+ * Everything that does not depend on the unit is done once at startup and
+ * shared read-only by all jobs: the firmware image is mapped and its chunk
+ * handshakes precomputed for every write format, and stage files (DDR
+ * config, SPL, U-Boot) are loaded once per SoC variant.
+ */
+
+#include "thingino.h"
+#include <pthread.h>
+#include <signal.h>
+
+#define STATION_EVENT_TICK_MS 200
+
+typedef struct station station_t;
+
+#define STATION_SERIAL_MAX 64
+
+typedef struct {
+    station_t* station;
+    device_info_t info;             // Identity of the unit on this port
+    char port[USB_PORT_STRING_MAX];
+    char log_tag[USB_PORT_STRING_MAX + 12];  // "[station <port>]"
+    libusb_device* device;          // Referenced until the job opens it
+    pthread_t thread;
+    bool used;
+    bool running;
+    bool finished;                  // Job done, thread not joined yet
+    uint8_t last_address;           // Address of the last unit handled here
+    char serial[STATION_SERIAL_MAX];  // Unit's serial number ("" = none or not read)
+    thingino_error_t result;
+    thingino_cancel_t cancel;       // Watchdog, and Ctrl+C during shutdown
+} station_slot_t;
+
+struct station {
+    libusb_context* context;
+    thingino_context_t* owner;      // Caller's library context, bound in jobs
+    const station_config_t* config;
+    prepared_image_t image;
+    pthread_mutex_t lock;
+    station_slot_t slots[STATION_MAX_PORTS];
+    firmware_files_t files[VARIANT_X2600 + 1];
+    bool files_loaded[VARIANT_X2600 + 1];
+    libusb_device* pending[STATION_MAX_PORTS];  // Arrivals not yet dispatched
+    int pending_count;
+    unsigned passed;
+    unsigned failed;
+};
+
+// First Ctrl+C stops taking new units, a second one aborts running jobs
+static volatile sig_atomic_t station_stop = 0;
+
+static void station_handle_signal(int sig) {
+    (void)sig;
+    station_stop++;
+}
+
+// ============================================================================
+// JOB
+// ============================================================================
+
+// Stage files for a variant, loaded on first use and kept for later units
+static const firmware_files_t* station_stage_files(station_t* station, processor_variant_t variant) {
+    const bootstrap_config_t* bc = &station->config->bootstrap;
+    const firmware_files_t* files = NULL;
+
+    pthread_mutex_lock(&station->lock);
+    if (!station->files_loaded[variant]) {
+        thingino_error_t result;
+        if (bc->config_file || bc->spl_file || bc->uboot_file) {
+            result = firmware_load_from_files(variant, bc->config_file, bc->spl_file,
+                                              bc->uboot_file, &station->files[variant]);
+        } else {
+            result = firmware_load(variant, &station->files[variant]);
+        }
+        station->files_loaded[variant] = (result == THINGINO_SUCCESS);
+    }
+    if (station->files_loaded[variant]) {
+        files = &station->files[variant];
+    }
+    pthread_mutex_unlock(&station->lock);
+
+    return files;
+}
+
+// Open a device by bus/address on the station's context
+static thingino_error_t station_open(station_t* station, const device_info_t* info,
+                                     usb_device_t** out) {
+    libusb_device** list = NULL;
+    ssize_t count = libusb_get_device_list(station->context, &list);
+    if (count < 0) {
+        return THINGINO_ERROR_DEVICE_NOT_FOUND;
+    }
+
+    thingino_error_t result = THINGINO_ERROR_DEVICE_NOT_FOUND;
+    for (ssize_t i = 0; i < count; i++) {
+        if (libusb_get_bus_number(list[i]) != info->bus ||
+            libusb_get_device_address(list[i]) != info->address) {
+            continue;
+        }
+
+        usb_device_t* device = (usb_device_t*)calloc(1, sizeof(usb_device_t));
+        if (!device) {
+            result = THINGINO_ERROR_MEMORY;
+            break;
+        }
+        device->info = *info;
+        device->context = station->context;
+        result = usb_device_open_libusb(device, list[i]);
+        if (result != THINGINO_SUCCESS) {
+            free(device);
+            break;
+        }
+        *out = device;
+        break;
+    }
+
+    libusb_free_device_list(list, 1);
+    return result;
+}
+
+static void station_close(usb_device_t* device) {
+    if (device) {
+        usb_device_close(device);
+        free(device);
+    }
+}
+
+static thingino_error_t station_job(station_slot_t* slot) {
+    station_t* station = slot->station;
+    const station_config_t* config = station->config;
+    usb_device_t* device = (usb_device_t*)calloc(1, sizeof(usb_device_t));
+    if (!device) {
+        libusb_unref_device(slot->device);
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    device->info = slot->info;
+    device->context = station->context;
+    thingino_error_t result = usb_device_open_libusb(device, slot->device);
+    libusb_unref_device(slot->device);
+    slot->device = NULL;
+    if (result != THINGINO_SUCCESS) {
+        free(device);
+        return result;
+    }
+    device->cancel = &slot->cancel;
+
+    // Identify the SoC so the right (cached) stage files are used
+    cpu_info_t cpu_info;
+    result = usb_device_get_cpu_info(device, &cpu_info);
+    if (result != THINGINO_SUCCESS) {
+        station_close(device);
+        return result;
+    }
+    device->info.variant = detect_variant_from_magic(cpu_info.clean_magic);
+    device->info.stage = cpu_info.stage;
+    thingino_printf("%s detected, starting\n", processor_variant_to_string(device->info.variant));
+
+    if (device->info.stage == STAGE_BOOTROM) {
+        bootstrap_config_t bootstrap = config->bootstrap;
+        bootstrap.files = station_stage_files(station, device->info.variant);
+        if (!bootstrap.files) {
+            thingino_printf("[ERROR] No stage files for %s\n", processor_variant_to_string(device->info.variant));
+            station_close(device);
+            return THINGINO_ERROR_FILE_IO;
+        }
+
+        result = bootstrap_device(device, &bootstrap);
+        device_info_t before = device->info;
+        station_close(device);
+        device = NULL;
+        if (result != THINGINO_SUCCESS) {
+            return result;
+        }
+
+        // Most units re-enumerate after U-Boot starts; some keep their
+        // address, in which case the original instance is reopened
+        device_info_t arrived;
+        if (usb_wait_for_arrival(station->context, &before, REENUMERATION_TIMEOUT_MS,
+                                 &arrived) != THINGINO_SUCCESS) {
+            arrived = before;
+        }
+        arrived.variant = before.variant;
+        thingino_sleep_milliseconds(50);  // Let udev apply permissions
+
+        result = station_open(station, &arrived, &device);
+        if (result != THINGINO_SUCCESS) {
+            return result;
+        }
+        device->cancel = &slot->cancel;
+
+        // Without port paths the dispatcher knows the unit by its address
+        pthread_mutex_lock(&station->lock);
+        slot->info.bus = arrived.bus;
+        slot->info.address = arrived.address;
+        pthread_mutex_unlock(&station->lock);
+        if (usb_device_get_cpu_info(device, &cpu_info) != THINGINO_SUCCESS ||
+            cpu_info.stage != STAGE_FIRMWARE) {
+            thingino_printf("[ERROR] Device not in firmware stage after bootstrap\n");
+            station_close(device);
+            return THINGINO_ERROR_PROTOCOL;
+        }
+        device->info.stage = STAGE_FIRMWARE;
+    }
+
+    if (config->flash_chip) {
+        snprintf(device->info.flash_chip, sizeof(device->info.flash_chip), "%s", config->flash_chip);
+    }
+
+    bool is_a1 = false;
+    result = firmware_write_prepare(device, &is_a1);
+    if (result == THINGINO_SUCCESS) {
+        result = write_firmware_prepared(device, &station->image, NULL, false, is_a1,
+                                         config->window_depth);
+    }
+    if (result == THINGINO_SUCCESS && config->verify) {
+        thingino_printf("Verifying...\n");
+        result = firmware_verify(device, station->image.image.data,
+                                 (uint32_t)station->image.image.size);
+    }
+
+    station_close(device);
+    return result;
+}
+
+static void* station_job_thread(void* arg) {
+    station_slot_t* slot = (station_slot_t*)arg;
+    thingino_context_bind(slot->station->owner);
+    snprintf(slot->log_tag, sizeof(slot->log_tag), "[station %s]", slot->port);
+    thingino_log_set_tag(slot->log_tag);  // Every line of this job carries its port
+    uint64_t start_ms = thingino_monotonic_ms();
+
+    thingino_job_begin(slot->port);
+    thingino_error_t result = station_job(slot);
+    thingino_job_end(result);
+    double elapsed = (thingino_monotonic_ms() - start_ms) / 1000.0;
+
+    if (result == THINGINO_SUCCESS) {
+        thingino_printf("PASS (%.1f s) - unplug and insert the next unit\n", elapsed);
+    } else if (result == THINGINO_ERROR_CANCELLED) {
+        thingino_printf("FAIL (%.1f s): %s\n", elapsed, slot->cancel.reason);
+    } else {
+        thingino_printf("FAIL (%.1f s): %s\n", elapsed,
+               thingino_error_to_string(result));
+    }
+
+    pthread_mutex_lock(&slot->station->lock);
+    slot->result = result;
+    slot->finished = true;
+    if (result == THINGINO_SUCCESS) {
+        slot->station->passed++;
+    } else {
+        slot->station->failed++;
+    }
+    pthread_mutex_unlock(&slot->station->lock);
+    return NULL;
+}
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+static bool is_bootrom_pid(uint16_t product) {
+    return product == PRODUCT_ID_BOOTROM || product == PRODUCT_ID_BOOTROM2;
+}
+
+static int LIBUSB_CALL station_arrival(libusb_context* ctx, libusb_device* dev,
+                                       libusb_hotplug_event event, void* user_data) {
+    (void)ctx;
+    station_t* station = (station_t*)user_data;
+    struct libusb_device_descriptor desc;
+
+    // No I/O is allowed from a hotplug callback; queue it for the main loop
+    if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED &&
+        libusb_get_device_descriptor(dev, &desc) == LIBUSB_SUCCESS &&
+        usb_is_supported_ingenic(desc.idVendor, desc.idProduct) &&
+        is_bootrom_pid(desc.idProduct)) {
+        pthread_mutex_lock(&station->lock);
+        if (station->pending_count < STATION_MAX_PORTS) {
+            station->pending[station->pending_count++] = libusb_ref_device(dev);
+        }
+        pthread_mutex_unlock(&station->lock);
+    }
+    return 0;
+}
+
+// Queue bootrom devices by polling where hotplug is unavailable
+static void station_poll(station_t* station) {
+    libusb_device** list = NULL;
+    ssize_t count = libusb_get_device_list(station->context, &list);
+    for (ssize_t i = 0; i < count; i++) {
+        station_arrival(station->context, list[i], LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED, station);
+    }
+    if (count >= 0) {
+        libusb_free_device_list(list, 1);
+    }
+}
+
+// What a port-less arrival tells about itself: serial number, and whether it
+// already runs the burner (then it is a unit mid-job, not a fresh one)
+typedef struct {
+    char serial[STATION_SERIAL_MAX];
+    bool firmware;
+} station_identity_t;
+
+static void station_identify(station_t* station, libusb_device* dev, const device_info_t* info,
+                             uint8_t serial_index, station_identity_t* id) {
+    memset(id, 0, sizeof(*id));
+    usb_device_t device;
+    memset(&device, 0, sizeof(device));
+    device.info = *info;
+    device.context = station->context;
+    if (usb_device_open_libusb(&device, dev) != THINGINO_SUCCESS) {
+        return;
+    }
+    device.probe = true;
+
+    if (serial_index &&
+        libusb_get_string_descriptor_ascii(device.handle, serial_index, (unsigned char*)id->serial,
+                                           sizeof(id->serial)) < 0) {
+        id->serial[0] = '\0';
+    }
+    cpu_info_t cpu_info;
+    id->firmware = usb_device_get_cpu_info(&device, &cpu_info) == THINGINO_SUCCESS &&
+                   cpu_info.stage == STAGE_FIRMWARE;
+    usb_device_close(&device);
+}
+
+// Is the arrival the unit s is (or was) working on? By port when both sides
+// have one; otherwise by bus/address, by serial number, or, for a running
+// job whose unit is re-enumerating, by the burner answering GET_CPU_INFO.
+// Caller holds station->lock.
+static bool station_same_unit(const station_slot_t* s, const device_info_t* info,
+                              const station_identity_t* id) {
+    if (s->info.port_depth && info->port_depth) {
+        return usb_device_info_same_port(&s->info, info);
+    }
+    if (s->info.bus != info->bus) {
+        return false;
+    }
+    if (s->info.address == info->address) {
+        return true;
+    }
+    if (s->serial[0] && strcmp(s->serial, id->serial) == 0) {
+        return true;
+    }
+    return s->running && id->firmware;
+}
+
+static void station_dispatch(station_t* station, libusb_device* dev) {
+    device_info_t info;
+    memset(&info, 0, sizeof(info));
+    struct libusb_device_descriptor desc;
+    libusb_get_device_descriptor(dev, &desc);
+    info.bus = libusb_get_bus_number(dev);
+    info.address = libusb_get_device_address(dev);
+    info.vendor = desc.idVendor;
+    info.product = desc.idProduct;
+    info.stage = STAGE_BOOTROM;
+    info.variant = VARIANT_T31X;
+    usb_port_path_fill(dev, &info);
+
+    station_identity_t id;
+    memset(&id, 0, sizeof(id));
+    if (info.port_depth == 0) {
+        station_identify(station, dev, &info, desc.iSerialNumber, &id);
+    }
+
+    station_slot_t* slot = NULL;
+    station_slot_t* free_slot = NULL;
+    pthread_mutex_lock(&station->lock);
+    for (int i = 0; i < STATION_MAX_PORTS; i++) {
+        station_slot_t* s = &station->slots[i];
+        if (s->used && station_same_unit(s, &info, &id)) {
+            slot = s;
+            break;
+        }
+        if (!s->used && !free_slot) {
+            free_slot = s;
+        }
+    }
+    pthread_mutex_unlock(&station->lock);
+
+    // A busy port re-enumerating during bootstrap is part of its own job,
+    // and a unit that already failed here is not retried until replugged
+    if (slot && (slot->running || slot->last_address == info.address)) {
+        libusb_unref_device(dev);
+        return;
+    }
+    if (!slot) {
+        slot = free_slot;
+    }
+    if (!slot) {
+        thingino_printf("[WARN] More than %d ports in use, ignoring arrival\n", STATION_MAX_PORTS);
+        libusb_unref_device(dev);
+        return;
+    }
+
+    slot->station = station;
+    slot->info = info;
+    slot->device = dev;
+    slot->used = true;
+    slot->running = true;
+    slot->finished = false;
+    slot->last_address = info.address;
+    snprintf(slot->serial, sizeof(slot->serial), "%s", id.serial);
+    usb_port_path_format(&info, slot->port, sizeof(slot->port));
+    if (info.port_depth == 0) {
+        snprintf(slot->port, sizeof(slot->port), "%03d:%03d", info.bus, info.address);
+    }
+
+    thingino_cancel_init(&slot->cancel, station->config->watchdog_ms);
+    if (pthread_create(&slot->thread, NULL, station_job_thread, slot) != 0) {
+        thingino_printf("[station %s] [ERROR] Failed to start job\n", slot->port);
+        thingino_cancel_destroy(&slot->cancel);
+        libusb_unref_device(dev);
+        slot->device = NULL;
+        slot->running = false;
+    }
+}
+
+// Join finished jobs; returns the number still running
+static int station_reap(station_t* station) {
+    int running = 0;
+    for (int i = 0; i < STATION_MAX_PORTS; i++) {
+        station_slot_t* slot = &station->slots[i];
+        if (!slot->running) {
+            continue;
+        }
+
+        pthread_mutex_lock(&station->lock);
+        bool finished = slot->finished;
+        pthread_mutex_unlock(&station->lock);
+
+        if (finished) {
+            pthread_join(slot->thread, NULL);
+            thingino_cancel_destroy(&slot->cancel);
+            slot->running = false;
+        } else {
+            running++;
+        }
+    }
+    return running;
+}
+
+static void station_cancel_all(station_t* station, const char* reason) {
+    for (int i = 0; i < STATION_MAX_PORTS; i++) {
+        if (station->slots[i].running) {
+            thingino_cancel_request(&station->slots[i].cancel, reason);
+        }
+    }
+}
+
+// ============================================================================
+// ENTRY POINT
+// ============================================================================
+
+static void station_prepare_image(station_t* station) {
+    for (int f = 0; f < WRITE_HANDSHAKE_FORMAT_COUNT; f++) {
+        const write_profile_t* profile = firmware_write_profile_for_format((write_handshake_format_t)f);
+        if (prepared_image_add_layout(&station->image, (write_handshake_format_t)f,
+                                      profile->chunk_size) != 0) {
+            thingino_printf("[WARN] Could not precompute %s handshakes\n", profile->name);
+        }
+    }
+}
+
+/**
+ * Run the station until interrupted (Ctrl+C)
+ *
+ * @return THINGINO_SUCCESS if no job failed
+ */
+thingino_error_t station_run(usb_manager_t* manager, const station_config_t* config) {
+    if (!manager || !manager->initialized || !config || !config->firmware_file) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    station_t* station = (station_t*)calloc(1, sizeof(station_t));
+    if (!station) {
+        return THINGINO_ERROR_MEMORY;
+    }
+    station->context = manager->context;
+    station->owner = thingino_context_current();
+    station->config = config;
+
+    if (prepared_image_open(&station->image, config->firmware_file) != 0) {
+        thingino_printf("[ERROR] Cannot open firmware image %s\n", config->firmware_file);
+        free(station);
+        return THINGINO_ERROR_FILE_IO;
+    }
+    if (station->image.image.size > UINT32_MAX) {
+        thingino_printf("[ERROR] Firmware image too large (%zu bytes)\n", station->image.image.size);
+        prepared_image_close(&station->image);
+        free(station);
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    station_prepare_image(station);
+    pthread_mutex_init(&station->lock, NULL);
+
+    bool hotplug = libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG) != 0;
+    libusb_hotplug_callback_handle handle;
+    if (hotplug) {
+        // ENUMERATE picks up units that were already plugged in at startup
+        int rc = libusb_hotplug_register_callback(station->context, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED,
+                                                  LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY,
+                                                  LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                                                  station_arrival, station, &handle);
+        if (rc != LIBUSB_SUCCESS) {
+            DEBUG_PRINT("Hotplug registration failed (%s), polling instead\n", libusb_error_name(rc));
+            hotplug = false;
+        }
+    }
+
+    station_stop = 0;
+    signal(SIGINT, station_handle_signal);
+    bus_sched_configure(config->bus_slots);
+
+    thingino_printf("Station ready: %s (%zu bytes)%s, %s. Press Ctrl+C to stop.\n",
+           config->firmware_file, station->image.image.size,
+           config->verify ? " with verify" : "",
+           hotplug ? "waiting for hotplug arrivals" : "polling for devices");
+    fflush(stdout);
+
+    while (!station_stop) {
+        if (hotplug) {
+            struct timeval tv = { 0, STATION_EVENT_TICK_MS * 1000 };
+            libusb_handle_events_timeout_completed(station->context, &tv, NULL);
+        } else {
+            station_poll(station);
+            thingino_sleep_real_milliseconds(STATION_EVENT_TICK_MS);
+        }
+
+        station_reap(station);
+
+        // The callback runs on this thread (inside handle_events) or on a
+        // job thread that is waiting for its unit to re-enumerate
+        pthread_mutex_lock(&station->lock);
+        libusb_device* pending[STATION_MAX_PORTS];
+        int pending_count = station->pending_count;
+        memcpy(pending, station->pending, sizeof(pending[0]) * (size_t)pending_count);
+        station->pending_count = 0;
+        pthread_mutex_unlock(&station->lock);
+
+        for (int i = 0; i < pending_count; i++) {
+            station_dispatch(station, pending[i]);
+        }
+    }
+
+    thingino_printf("\nStopping station, waiting for running jobs (Ctrl+C again to abort them)...\n");
+    fflush(stdout);
+    bool aborted = false;
+    while (station_reap(station) > 0) {
+        if (station_stop > 1 && !aborted) {
+            station_cancel_all(station, "aborted by user");
+            aborted = true;
+        }
+        thingino_sleep_real_milliseconds(STATION_EVENT_TICK_MS);
+    }
+
+    if (hotplug) {
+        libusb_hotplug_deregister_callback(station->context, handle);
+    }
+    for (int i = 0; i < station->pending_count; i++) {
+        libusb_unref_device(station->pending[i]);
+    }
+
+    thingino_printf("Station summary: %u passed, %u failed\n", station->passed, station->failed);
+    bus_sched_report();
+    bus_sched_configure(0);
+    thingino_error_t result = station->failed ? THINGINO_ERROR_TRANSFER_FAILED : THINGINO_SUCCESS;
+
+    for (int v = 0; v <= VARIANT_X2600; v++) {
+        if (station->files_loaded[v]) {
+            firmware_cleanup(&station->files[v]);
+        }
+    }
+    pthread_mutex_destroy(&station->lock);
+    prepared_image_close(&station->image);
+    free(station);
+    signal(SIGINT, SIG_DFL);
+    return result;
+}
@@ -0,0 +1,127 @@
+/**
+ * Test program for the burner log decoder
+ */
+
+#include "burner_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void expect_event(burner_log_t* log, burner_event_type_t type, int32_t value) {
+    burner_event_t ev;
+
+    if (!burner_log_pop(log, &ev)) {
+        printf("  [FAIL] expected %s, queue empty\n", burner_event_type_to_string(type));
+        failures++;
+        return;
+    }
+
+    if (ev.type != type || ev.value != value) {
+        printf("  [FAIL] expected %s(%d), got %s(%d) at line %u\n",
+               burner_event_type_to_string(type), value,
+               burner_event_type_to_string(ev.type), ev.value, ev.line_no);
+        failures++;
+        return;
+    }
+
+    printf("  [OK] %s(%d) at line %u\n", burner_event_type_to_string(ev.type), ev.value, ev.line_no);
+}
+
+static void feed_str(burner_log_t* log, const char* s) {
+    burner_log_feed(log, (const uint8_t*)s, strlen(s));
+}
+
+int main() {
+    printf("=== Burner Log Decoder Test ===\n\n");
+
+    burner_log_t log;
+    burner_log_init(&log);
+
+    printf("Classification:\n");
+    feed_str(&log,
+        "U-Boot SPL 2013.07\r\n"
+        "sfc nor erase ok\r\n"
+        "policy0 write ret: ok\r\n"
+        "chunk 3 crc ok\r\n"
+        "chunk 4 CRC mismatch\r\n"
+        "block 5 program failed\r\n"
+        "cloner->ack = -22\r\n"
+        "cloner->ack = 0\r\n"
+        "All policy completed\r\n"
+        "Reserved instruction exception\r\n");
+    expect_event(&log, BURNER_EVENT_ERASE_DONE, -1);
+    expect_event(&log, BURNER_EVENT_CHUNK_DONE, 0);
+    expect_event(&log, BURNER_EVENT_CRC_OK, 3);
+    expect_event(&log, BURNER_EVENT_CRC_FAIL, 4);
+    expect_event(&log, BURNER_EVENT_WRITE_FAIL, 5);
+    expect_event(&log, BURNER_EVENT_ACK_ERROR, -22);
+    expect_event(&log, BURNER_EVENT_POLICY_DONE, -1);
+    expect_event(&log, BURNER_EVENT_TRAP, -1);
+    if (burner_log_pending(&log) != 0) {
+        printf("  [FAIL] %u unexpected events left\n", burner_log_pending(&log));
+        failures++;
+    }
+
+    printf("\nSplit feeds with NUL padding:\n");
+    const char* split = "write chunk 7 d\0\0one\n";
+    for (size_t i = 0; i < 21; i++) {
+        burner_log_feed(&log, (const uint8_t*)&split[i], 1);
+    }
+    expect_event(&log, BURNER_EVENT_CHUNK_DONE, 7);
+
+    printf("\nMasked pop:\n");
+    feed_str(&log, "erase done\nwrite ok\ncrc ok\n");
+    burner_event_t ev;
+    if (burner_log_pop_match(&log, BURNER_EVENT_MASK(BURNER_EVENT_CRC_OK), &ev) &&
+        ev.type == BURNER_EVENT_CRC_OK && burner_log_pending(&log) == 0) {
+        printf("  [OK] skipped older events\n");
+    } else {
+        printf("  [FAIL] pop_match did not skip older events\n");
+        failures++;
+    }
+
+    printf("\nChunk matching:\n");
+    // Chunk 3's report arrived after its wait gave up; chunk 5 runs ahead
+    feed_str(&log, "crc ok chunk 3\nwrite chunk 5 done\ncrc ok chunk 4\n");
+    uint32_t ok_mask = BURNER_EVENT_MASK(BURNER_EVENT_CRC_OK) | BURNER_EVENT_MASK(BURNER_EVENT_CHUNK_DONE);
+    if (burner_log_pop_chunk(&log, ok_mask, 4, &ev) && ev.type == BURNER_EVENT_CRC_OK &&
+        ev.value == 4 && log.stale == 2 && burner_log_pending(&log) == 0) {
+        printf("  [OK] stale and out-of-order reports skipped\n");
+    } else {
+        printf("  [FAIL] pop_chunk returned %s(%d), stale=%u\n",
+               burner_event_type_to_string(ev.type), ev.value, log.stale);
+        failures++;
+    }
+    feed_str(&log, "crc ok chunk 6\n");
+    if (!burner_log_pop_chunk(&log, ok_mask, 7, &ev) && log.stale == 3) {
+        printf("  [OK] no report for the expected chunk\n");
+    } else {
+        printf("  [FAIL] accepted a report for another chunk\n");
+        failures++;
+    }
+    feed_str(&log, "crc ok\nchunk 2 crc mismatch\n");
+    bool unnumbered = burner_log_pop_chunk(&log, ok_mask, 8, &ev) && ev.value == -1;
+    bool late_failure = burner_log_pop_chunk(&log, ok_mask | BURNER_EVENT_MASK_FAILURE, 8, &ev) &&
+                        ev.type == BURNER_EVENT_CRC_FAIL && ev.value == 2;
+    if (unnumbered && late_failure) {
+        printf("  [OK] unnumbered reports and late failures returned\n");
+    } else {
+        printf("  [FAIL] unnumbered=%d late_failure=%d\n", unnumbered, late_failure);
+        failures++;
+    }
+
+    printf("\nQueue overflow:\n");
+    for (int i = 0; i < BURNER_EVENT_QUEUE_SIZE + 4; i++) {
+        feed_str(&log, "crc ok\n");
+    }
+    if (burner_log_pending(&log) == BURNER_EVENT_QUEUE_SIZE && log.dropped == 4) {
+        printf("  [OK] %d queued, %u dropped\n", BURNER_EVENT_QUEUE_SIZE, log.dropped);
+    } else {
+        printf("  [FAIL] pending=%u dropped=%u\n", burner_log_pending(&log), log.dropped);
+        failures++;
+    }
+
+    printf("\n%s: %d failure(s)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * Test program for cancellation tokens and the progress watchdog
+ */
+
+#include "cancel.h"
+#include "platform_compat.h"
+#include "test_check.h"
+#include <stdio.h>
+
+static void* cancel_later(void* arg) {
+    thingino_sleep_milliseconds(100);
+    thingino_cancel_request((thingino_cancel_t*)arg, "test");
+    return NULL;
+}
+
+int main() {
+    printf("=== Cancellation Token Test ===\n\n");
+
+    printf("Basics:\n");
+    check(!thingino_cancel_check(NULL), "NULL token is never cancelled");
+    check(!thingino_cancel_sleep(NULL, 1), "NULL token sleeps normally");
+
+    thingino_cancel_t token;
+    thingino_cancel_init(&token, 0);
+    check(!thingino_cancel_check(&token), "fresh token not cancelled");
+    thingino_cancel_request(&token, "first");
+    thingino_cancel_request(&token, "second");
+    check(thingino_cancel_check(&token), "request cancels");
+    check(token.reason && token.reason[0] == 'f', "first reason sticks");
+    check(thingino_cancel_sleep(&token, 5000), "sleep on a cancelled token returns at once");
+    thingino_cancel_destroy(&token);
+
+    printf("\nInterruptible sleep:\n");
+    thingino_cancel_init(&token, 0);
+    pthread_t thread;
+    uint64_t start = thingino_monotonic_ms();
+    pthread_create(&thread, NULL, cancel_later, &token);
+    bool cancelled = thingino_cancel_sleep(&token, 10000);
+    uint64_t elapsed = thingino_monotonic_ms() - start;
+    pthread_join(thread, NULL);
+    printf("    woke after %llu ms\n", (unsigned long long)elapsed);
+    check(cancelled, "sleep reports cancellation");
+    check(elapsed < 2000, "sleep wakes early on cancel");
+    thingino_cancel_destroy(&token);
+
+    thingino_cancel_init(&token, 0);
+    check(!thingino_cancel_sleep(&token, 20), "uncancelled sleep completes");
+    thingino_cancel_destroy(&token);
+
+    printf("\nWatchdog:\n");
+    thingino_cancel_init(&token, 100);
+    thingino_sleep_milliseconds(60);
+    thingino_cancel_progress(&token);
+    thingino_sleep_milliseconds(60);
+    check(!thingino_cancel_check(&token), "progress resets the watchdog");
+    check(!thingino_cancel_sleep(&token, 150), "a sleep runs to its end");
+    check(thingino_cancel_check(&token), "a sleep is not progress");
+    thingino_cancel_destroy(&token);
+
+    thingino_cancel_init(&token, 100);
+    thingino_sleep_milliseconds(150);
+    check(thingino_cancel_check(&token), "idle job is cancelled");
+    thingino_cancel_destroy(&token);
+
+    printf("\nVirtual clock:\n");
+    thingino_virtual_clock_t clock;
+    thingino_virtual_clock_init(&clock, 5000000);
+    thingino_clock_set(&clock.base);
+    uint64_t wall_start = thingino_real_now_us();
+    check(thingino_monotonic_ms() == 5000, "timestamps come from the virtual clock");
+    thingino_cancel_init(&token, 30000);
+    check(!thingino_cancel_sleep(&token, 20000), "virtual sleep completes");
+    check(thingino_monotonic_ms() == 25000, "virtual sleep advances the clock");
+    thingino_virtual_clock_advance(&clock, 30000000);
+    check(thingino_cancel_check(&token), "watchdog runs on virtual time");
+    check(thingino_cancel_sleep(&token, 1000), "cancelled virtual sleep returns at once");
+    thingino_cancel_destroy(&token);
+    check(thingino_real_now_us() - wall_start < 1000000, "no real time spent");
+    thingino_clock_set(NULL);
+    check(!thingino_clock_is_virtual(), "real clock restored");
+
+    return test_report();
+}
@@ -0,0 +1,29 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// ============================================================================
+// TEST CHECKS
+// ============================================================================
+//
+// Shared by the unit test programs (one per module, src/test_*.c). Each
+// check prints one OK/FAIL line; main() ends with test_report(), whose
+// result is the process exit status.
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  [%s] %s\n", ok ? "OK" : "FAIL", what);
+    if (!ok) {
+        failures++;
+    }
+}
+
+static int test_report(void) {
+    printf("\n%s: %d failure(s)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
+
+#endif // TEST_CHECK_H
@@ -1,139 +1,305 @@
+/**
+ * Complete workflow test: bootstrap, write and read back a simulated T31ZX
+ * in virtual time. The simulated device models bus, erase and programming
+ * latency, so the job takes several virtual seconds but milliseconds of
+ * wall time.
+ */
+
 #include "thingino.h"
+#include "sim_device.h"
+#include "fault_inject.h"
+#include "test_check.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#define FLASH_SIZE  (16 * 1024 * 1024)
+#define IMAGE_SIZE  (1024 * 1024)
+
+typedef struct {
+    uint32_t writes;                // VR_WRITE handshakes
+    uint64_t bulk_out;              // Bytes sent on the bulk pipe
+    bool ordered;                   // Timestamps never go backwards
+    uint64_t last_us;
+} trace_totals_t;
+
+static void count_transfer(void* user_data, const usb_capture_transfer_t* t) {
+    trace_totals_t* totals = (trace_totals_t*)user_data;
+    if (t->has_setup && t->request == VR_WRITE && t->data_len == FIRMWARE_WRITE_HANDSHAKE_SIZE) {
+        totals->writes++;
+    }
+    if (t->type == USB_CAPTURE_XFER_BULK && !(t->endpoint & 0x80)) {
+        totals->bulk_out += t->actual;
+    }
+    totals->ordered &= t->submit_us >= totals->last_us && t->complete_us >= t->submit_us;
+    totals->last_us = t->submit_us;
+}
 
-// Complete workflow test: bootstrap + firmware reading with timeout fixes
 int main() {
-    printf("=== Complete Firmware Reading Workflow Test ===\n");
-    printf("Testing bootstrap + firmware reading with enhanced timeout handling...\n\n");
-    
-    // Initialize USB manager
-    usb_manager_t manager;
-    thingino_error_t result = usb_manager_init(&manager);
-    if (result != THINGINO_SUCCESS) {
-        printf("Failed to initialize USB manager: %s\n", thingino_error_to_string(result));
+    printf("=== Complete Workflow Test (simulated device, virtual time) ===\n\n");
+
+    thingino_virtual_clock_t clock;
+    thingino_virtual_clock_init(&clock, 1000000);
+    thingino_clock_set(&clock.base);
+
+    uint8_t* flash = (uint8_t*)malloc(FLASH_SIZE);
+    uint8_t* image = (uint8_t*)malloc(IMAGE_SIZE);
+    if (!flash || !image) {
+        printf("Out of memory\n");
         return 1;
     }
-    
-    // Find connected devices
-    device_info_t* devices = NULL;
-    int device_count = 0;
-    result = usb_manager_find_devices(&manager, &devices, &device_count);
-    if (result != THINGINO_SUCCESS || device_count == 0) {
-        printf("No Ingenic devices found. Please connect a device and try again.\n");
-        usb_manager_cleanup(&manager);
+    memset(flash, 0xFF, FLASH_SIZE);
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < IMAGE_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        image[i] = (uint8_t)(seed >> 16);
+    }
+
+    char path[] = "/tmp/thingino_workflow_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, image, IMAGE_SIZE) != IMAGE_SIZE) {
+        printf("Failed to create temp image\n");
         return 1;
     }
-    
-    // Use first device
-    device_info_t* target_device = &devices[0];
-    printf("Found device: VID=0x%04X, PID=0x%04X, Stage=%s\n",
-            target_device->vendor, target_device->product, device_stage_to_string(target_device->stage));
-    
-    // Check if device needs bootstrap
-    if (target_device->stage == STAGE_BOOTROM) {
-        printf("\nDevice is in bootrom stage - performing bootstrap...\n");
-        
-        // Open device for bootstrap
-        usb_device_t device;
-        result = usb_device_init(&device, target_device->bus, target_device->address);
-        if (result != THINGINO_SUCCESS) {
-            printf("Failed to open device for bootstrap: %s\n", thingino_error_to_string(result));
-            free(devices);
-            usb_manager_cleanup(&manager);
-            return 1;
-        }
-        
-        // Configure bootstrap
-        bootstrap_config_t bootstrap_config;
-        bootstrap_config.sdram_address = BOOTLOADER_ADDRESS_SDRAM;
-        bootstrap_config.timeout = BOOTSTRAP_TIMEOUT_SECONDS;
-        bootstrap_config.verbose = true;
-        bootstrap_config.skip_ddr = false;
-        
-        // Perform bootstrap
-        result = bootstrap_device(&device, &bootstrap_config);
-        if (result != THINGINO_SUCCESS) {
-            printf("Bootstrap failed: %s\n", thingino_error_to_string(result));
-            usb_device_close(&device);
-            free(devices);
-            usb_manager_cleanup(&manager);
-            return 1;
-        }
-        
-        printf("Bootstrap completed successfully!\n");
-        
-        // Note: In a real implementation, you would wait for device re-enumeration here
-        // For this test, we'll assume bootstrap worked and device is now in firmware stage
-        printf("Note: Assuming device transitioned to firmware stage for testing...\n");
-        
-        usb_device_close(&device);
+    close(fd);
+
+    sim_device_t sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.flash = flash;
+    sim.flash_size = FLASH_SIZE;
+    sim.clock = &clock;
+    usb_device_t device;
+    if (sim_device_init(&sim) != THINGINO_SUCCESS ||
+        sim_device_open(&sim, &device, VARIANT_T31ZX) != THINGINO_SUCCESS) {
+        printf("Failed to open simulated device\n");
+        return 1;
     }
-    
-    // Now test firmware reading with our enhanced implementation
-    if (target_device->stage == STAGE_FIRMWARE) {
-        printf("\nDevice is in firmware stage - testing enhanced firmware reading...\n");
-        
-        // Open device for firmware reading
-        usb_device_t device;
-        result = usb_device_init(&device, target_device->bus, target_device->address);
-        if (result != THINGINO_SUCCESS) {
-            printf("Failed to open device: %s\n", thingino_error_to_string(result));
-            free(devices);
-            usb_manager_cleanup(&manager);
-            return 1;
-        }
-        
-        // Test our enhanced firmware reading
-        uint8_t* firmware_data = NULL;
-        uint32_t firmware_size = 0;
-        
-        printf("Attempting firmware read with enhanced timeout handling...\n");
-        printf("Features: adaptive timeouts, chunked reading, retry logic, fallback mechanisms\n\n");
-        
-        result = firmware_read_full(&device, &firmware_data, &firmware_size);
-        
-        if (result == THINGINO_SUCCESS) {
-            printf("✓ SUCCESS: Enhanced firmware reading completed!\n");
-            printf("  Total size: %u bytes (%.2f MB)\n", firmware_size, (float)firmware_size / (1024 * 1024));
-            
-            // Save to file
-            char filename[256];
-            snprintf(filename, sizeof(filename), "firmware_enhanced_%u.bin", (unsigned int)time(NULL));
-            
-            FILE* file = fopen(filename, "wb");
-            if (file) {
-                fwrite(firmware_data, 1, firmware_size, file);
-                fclose(file);
-                printf("  Saved to: %s\n", filename);
-                printf("  This file contains the complete firmware read from the device\n");
-            } else {
-                printf("  Warning: Could not save firmware to file\n");
-            }
-            
-            free(firmware_data);
-        } else {
-            printf("✗ FAILED: Enhanced firmware reading failed\n");
-            printf("  Error: %s\n", thingino_error_to_string(result));
-            
-            printf("\nThis demonstrates the timeout issue has been addressed:\n");
-            printf("• If timeout was the problem, you'd see transfer failures\n");
-            printf("• If chunking works, you'd see partial success\n");
-            printf("• If retry logic works, you'd see retry attempts\n");
-            printf("• If fallback works, you'd see method switching\n");
-        }
-        
-        usb_device_close(&device);
+
+    uint64_t wall_start = thingino_real_now_us();
+    uint64_t virtual_start = thingino_monotonic_us();
+
+    printf("Bootstrap:\n");
+    bootstrap_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.sdram_address = BOOTLOADER_ADDRESS_SDRAM;
+    config.timeout = BOOTSTRAP_TIMEOUT_SECONDS;
+    thingino_error_t result = bootstrap_device(&device, &config);
+    check(result == THINGINO_SUCCESS, "bootstrap succeeds");
+    check(sim.stage == SIM_STAGE_BURNER && device.info.stage == STAGE_FIRMWARE,
+          "device reaches the burner");
+    check(sim.reopens == 1, "T31ZX reopened after SPL");
+
+    firmware_files_t fw;
+    if (firmware_load(VARIANT_T31ZX, &fw) == THINGINO_SUCCESS) {
+        check(fw.uboot_size <= SIM_DEVICE_RAM_SIZE - 0x100000 &&
+              memcmp(sim.ram + 0x100000, fw.uboot, fw.uboot_size) == 0,
+              "U-Boot loaded at 0x80100000");
+        firmware_cleanup(&fw);
     } else {
-        printf("Device is in unexpected stage: %s\n", device_stage_to_string(target_device->stage));
+        check(false, "stage files load");
     }
-    
-    // Cleanup
-    free(devices);
-    usb_manager_cleanup(&manager);
-    
-    printf("\n=== Test Complete ===\n");
-    printf("Enhanced firmware reading implementation tested with real device!\n");
-    return 0;
-}
\ No newline at end of file
+    uint64_t bootstrap_us = thingino_monotonic_us() - virtual_start;
+
+    printf("\nWrite:\n");
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    check(result == THINGINO_SUCCESS, "write succeeds");
+    check(sim.crc_errors == 0 && sim.chunks_written > 0, "every chunk passed its CRC");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+    check(flash[IMAGE_SIZE] == 0xFF, "nothing written past the image");
+
+    printf("\nRead back:\n");
+    uint8_t* read_data = NULL;
+    uint32_t read_size = 0;
+    result = firmware_read_full(&device, &read_data, &read_size);
+    check(result == THINGINO_SUCCESS && read_size >= IMAGE_SIZE, "read succeeds");
+    check(read_data && memcmp(read_data, image, IMAGE_SIZE) == 0, "read matches the image");
+    free(read_data);
+
+    printf("\nRead into caller buffers:\n");
+    uint8_t* bank = (uint8_t*)malloc(IMAGE_SIZE + 16);
+    memset(bank, 0xA5, IMAGE_SIZE + 16);
+    result = firmware_read_bank_into(&device, 0, IMAGE_SIZE, bank);
+    check(result == THINGINO_SUCCESS && memcmp(bank, image, IMAGE_SIZE) == 0,
+          "firmware_read_bank_into fills the caller's buffer");
+    check(bank[IMAGE_SIZE] == 0xA5 && bank[IMAGE_SIZE + 15] == 0xA5, "and nothing past it");
+
+    int actual = 0;
+    memset(bank, 0xA5, 8192);
+    sim.pending = SIM_PENDING_READ;     // As after a VR_FW_WRITE1 for 4 KB at 0x1000
+    sim.pending_offset = 0x1000;
+    sim.pending_size = 4096;
+    result = protocol_fw_read_into(&device, bank, 4096, &actual);
+    check(result == THINGINO_SUCCESS && actual == 4096 && memcmp(bank, image + 0x1000, 4096) == 0,
+          "protocol_fw_read_into fills the caller's buffer");
+    check(bank[4096] == 0xA5, "and stops at the transfer length");
+    free(bank);
+
+    result = firmware_verify_prepared(&device, image, IMAGE_SIZE);
+    const uint8_t* bank_buffer = device.bank_pool.buffers[0];
+    check(result == THINGINO_SUCCESS && device.bank_pool.count == 1,
+          "verify reads into the device's bank buffer");
+    result = firmware_verify_prepared(&device, image, IMAGE_SIZE);
+    check(result == THINGINO_SUCCESS && device.bank_pool.buffers[0] == bank_buffer,
+          "a second verify reuses it");
+
+    uint64_t virtual_ms = (thingino_monotonic_us() - virtual_start) / 1000;
+    uint64_t wall_ms = (thingino_real_now_us() - wall_start) / 1000;
+    printf("\nTiming: bootstrap %llu ms, whole job %llu ms virtual, %llu ms wall\n",
+           (unsigned long long)(bootstrap_us / 1000), (unsigned long long)virtual_ms,
+           (unsigned long long)wall_ms);
+    check(bootstrap_us >= 2000000, "bootstrap waits are modelled (>= 2 s)");
+    check(virtual_ms >= 5000, "erase wait is modelled (>= 5 s)");
+    check(wall_ms * 10 < virtual_ms, "runs at least 10x faster than virtual time");
+
+    printf("\nWrite with lost acks:\n");
+    fault_profile_t profile;
+    fault_inject_t fi;
+    memset(flash, 0xFF, FLASH_SIZE);
+    fault_profile_parse("req=0x12,at=2:late,at=5:late", &profile, NULL, 0);
+    check(fault_inject_attach(&fi, &device, &profile, 0) == THINGINO_SUCCESS, "fault injection attached");
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    check(result == THINGINO_SUCCESS, "write recovers");
+    check(fi.state.injected[FAULT_LATE] == 2, "both scripted faults injected");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+
+    printf("\nWrite with lost handshakes:\n");
+    // The burner never sees these VR_WRITEs, so their chunks must be resent
+    fault_inject_t lost;
+    memset(flash, 0xFF, FLASH_SIZE);
+    fault_profile_parse("req=0x12,at=3:timeout,at=6:timeout", &profile, NULL, 0);
+    check(fault_inject_attach(&lost, &device, &profile, 0) == THINGINO_SUCCESS, "fault injection attached");
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    check(result == THINGINO_SUCCESS, "write recovers");
+    check(lost.state.injected[FAULT_TIMEOUT] == 2, "both scripted faults injected");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+
+    printf("\nSilent burner with lost acks:\n");
+    // Without log traffic a timed-out handshake is taken as accepted, and
+    // no chunk is sent twice
+    fault_inject_t quiet;
+    memset(flash, 0xFF, FLASH_SIZE);
+    sim.silent = true;
+    burner_log_init(&device.burner_log);    // As on a fresh session with this burner
+    fault_profile_parse("req=0x12,at=2:late,at=5:late", &profile, NULL, 0);
+    check(fault_inject_attach(&quiet, &device, &profile, 0) == THINGINO_SUCCESS, "fault injection attached");
+    uint32_t silent_before = sim.chunks_written;
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    sim.silent = false;
+    check(result == THINGINO_SUCCESS && quiet.state.injected[FAULT_LATE] == 2, "write succeeds");
+    check(sim.chunks_written - silent_before == IMAGE_SIZE / (128 * 1024), "no chunk resent");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+
+    printf("\nTraced write:\n");
+    char trace_path[] = "/tmp/thingino_workflow_trace_XXXXXX";
+    int trace_fd = mkstemp(trace_path);
+    if (trace_fd >= 0) {
+        close(trace_fd);
+    }
+    thingino_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.events_fd = -1;
+    check(thingino_trace_open(&context, trace_path) == THINGINO_SUCCESS, "trace opened");
+    thingino_context_t* previous = thingino_context_bind(&context);
+    uint32_t chunks_before = sim.chunks_written;
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    thingino_context_bind(previous);
+    thingino_trace_close(&context);
+    check(result == THINGINO_SUCCESS, "traced write succeeds");
+
+    firmware_image_t trace;
+    trace_totals_t totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.ordered = true;
+    usb_capture_stats_t stats;
+    bool parsed = firmware_image_open(trace_path, &trace) == 0 &&
+                  usb_capture_parse(trace.data, trace.size, count_transfer, &totals, &stats,
+                                    NULL, 0) == 0;
+    check(parsed && stats.unmatched == 0, "trace parses as a usbmon capture");
+    printf("    %llu transfers, %u write handshakes, %llu bytes out\n",
+           (unsigned long long)stats.transfers, totals.writes,
+           (unsigned long long)totals.bulk_out);
+    check(totals.writes == sim.chunks_written - chunks_before, "one handshake per chunk written");
+    check(totals.bulk_out >= IMAGE_SIZE, "every image byte is in the trace");
+    check(totals.ordered, "timestamps follow the virtual clock in order");
+    firmware_image_close(&trace);
+    remove(trace_path);
+
+    printf("\nPipelined write:\n");
+    // The sim has no libusb event loop; the pipeline runs its transfers
+    // through the transport, so the window really holds several chunks
+    memset(flash, 0xFF, FLASH_SIZE);
+    uint32_t pipelined_before = sim.chunks_written;
+    result = write_firmware_to_device(&device, path, NULL, false, false, 2);
+    check(result == THINGINO_SUCCESS, "write with a window of 2 succeeds");
+    check(sim.crc_errors == 0 && sim.chunks_written - pipelined_before == IMAGE_SIZE / (128 * 1024),
+          "every chunk written once");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+
+    fault_inject_t pipelined_lost;
+    memset(flash, 0xFF, FLASH_SIZE);
+    fault_profile_parse("req=0x12,at=2:late,at=5:late", &profile, NULL, 0);
+    check(fault_inject_attach(&pipelined_lost, &device, &profile, 0) == THINGINO_SUCCESS,
+          "fault injection attached");
+    result = write_firmware_to_device(&device, path, NULL, false, false, 4);
+    check(result == THINGINO_SUCCESS && pipelined_lost.state.injected[FAULT_LATE] == 2,
+          "window of 4 recovers from lost acks");
+    check(memcmp(flash, image, IMAGE_SIZE) == 0, "flash holds the image");
+
+    printf("\nClone onto failing targets:\n");
+    // Every VR_WRITE stalls, so both targets fail on their first chunk while
+    // the source still has banks to read
+    sim_device_t target_sims[2];
+    usb_device_t target_devices[2];
+    fault_inject_t target_faults[2];
+    clone_target_t targets[2];
+    fault_profile_parse("req=0x12,stall=1", &profile, NULL, 0);
+    bool targets_ready = true;
+    for (int i = 0; i < 2; i++) {
+        memset(&target_sims[i], 0, sizeof(target_sims[i]));
+        target_sims[i].flash = (uint8_t*)malloc(FLASH_SIZE);
+        target_sims[i].flash_size = FLASH_SIZE;
+        target_sims[i].clock = &clock;
+        targets_ready &= target_sims[i].flash && sim_device_init(&target_sims[i]) == THINGINO_SUCCESS;
+        target_sims[i].stage = SIM_STAGE_BURNER;
+        targets_ready &= sim_device_open(&target_sims[i], &target_devices[i], VARIANT_T31ZX) == THINGINO_SUCCESS &&
+                         fault_inject_attach(&target_faults[i], &target_devices[i], &profile, i) == THINGINO_SUCCESS;
+        memset(&targets[i], 0, sizeof(targets[i]));
+        targets[i].device = &target_devices[i];
+        snprintf(targets[i].label, sizeof(targets[i].label), "[to %d]", i + 1);
+    }
+    check(targets_ready, "targets open in burner stage");
+    result = firmware_clone(&device, targets, 2);
+    check(result != THINGINO_SUCCESS, "clone returns once every target has failed");
+    check(targets[0].result != THINGINO_SUCCESS && targets[1].result != THINGINO_SUCCESS,
+          "both targets report a failure");
+    for (int i = 0; i < 2; i++) {
+        usb_device_close(&target_devices[i]);
+        sim_device_cleanup(&target_sims[i]);
+        free(target_sims[i].flash);
+    }
+
+    printf("\nUnplugged during a write:\n");
+    // The second bulk transfer is the first burner log poll after chunk 1;
+    // the device stays gone, so every log poll after it fails at once
+    fault_inject_t unplug;
+    memset(flash, 0xFF, FLASH_SIZE);
+    fault_profile_parse("on=bulk,at=2:disconnect", &profile, NULL, 0);
+    check(fault_inject_attach(&unplug, &device, &profile, 0) == THINGINO_SUCCESS, "fault injection attached");
+    uint64_t unplug_start_ms = thingino_monotonic_ms();
+    result = write_firmware_to_device(&device, path, NULL, false, false, 0);
+    uint64_t unplug_ms = thingino_monotonic_ms() - unplug_start_ms;
+    check(result != THINGINO_SUCCESS && unplug.state.injected[FAULT_DISCONNECT] == 1,
+          "write fails once the device is gone");
+    printf("    gave up after %llu ms virtual\n", (unsigned long long)unplug_ms);
+    check(unplug_ms < 60000, "without waiting out every chunk's log timeout");
+
+    usb_device_close(&device);
+    sim_device_cleanup(&sim);
+    thingino_clock_set(NULL);
+    remove(path);
+    free(image);
+    free(flash);
+
+    return test_report();
+}
@@ -0,0 +1,120 @@
+/**
+ * Test program for fault profile parsing and injection decisions
+ */
+
+#include "fault_profile.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool parses(const char* spec, fault_profile_t* profile) {
+    char error[128] = "";
+    if (fault_profile_parse(spec, profile, error, sizeof(error)) != 0) {
+        printf("    %s -> %s\n", spec, error);
+        return false;
+    }
+    return true;
+}
+
+static bool rejects(const char* spec) {
+    fault_profile_t profile;
+    char error[128] = "";
+    int result = fault_profile_parse(spec, &profile, error, sizeof(error));
+    return result != 0 && error[0] != '\0';
+}
+
+int main() {
+    printf("=== Fault Profile Test ===\n\n");
+
+    printf("Parsing:\n");
+    fault_profile_t profile;
+    check(parses("", &profile) && strcmp(profile.name, "clean") == 0, "empty spec is clean");
+    check(profile.on == (FAULT_ON_CONTROL | FAULT_ON_BULK) && profile.request == -1 &&
+          profile.reconnect_ms == FAULT_RECONNECT_MS, "defaults");
+
+    size_t builtins = 0;
+    bool all_parse = true;
+    while (fault_profile_builtin(builtins)) {
+        all_parse &= parses(fault_profile_builtin(builtins), &profile) &&
+                     strcmp(profile.name, fault_profile_builtin(builtins)) == 0;
+        builtins++;
+    }
+    check(builtins >= 5 && all_parse, "every built-in profile parses under its own name");
+
+    check(parses("lossy-bus,timeout=0.5,seed=7", &profile) &&
+          profile.probability[FAULT_TIMEOUT] == 0.5 && profile.seed == 7 &&
+          strcmp(profile.name, "lossy-bus") == 0, "settings override a built-in");
+    check(parses("req=0x12,at=3:late,at=5:stall", &profile) && profile.request == 0x12 &&
+          profile.on == FAULT_ON_CONTROL && profile.script_count == 2 &&
+          profile.script[0].op == 3 && profile.script[0].kind == FAULT_LATE,
+          "request filter and script");
+
+    check(rejects("bogus"), "unknown profile rejected");
+    check(rejects("stall=0.1,lossy-bus"), "profile name after settings rejected");
+    check(rejects("stall=2"), "probability above 1 rejected");
+    check(rejects("stall="), "empty probability rejected");
+    check(rejects("on=sideways"), "bad on= rejected");
+    check(rejects("req=0x100"), "request above 0xFF rejected");
+    check(rejects("at=0:stall") && rejects("at=3") && rejects("at=3:none"), "bad at= rejected");
+    check(rejects("frobnicate=1"), "unknown setting rejected");
+
+    printf("\nFilters:\n");
+    fault_state_t state;
+    parses("on=bulk,stall=1", &profile);
+    fault_state_init(&state, &profile, 0);
+    check(fault_next(&state, false, 0x12) == FAULT_NONE, "on=bulk spares control transfers");
+    check(fault_next(&state, true, 0) == FAULT_STALL, "on=bulk hits bulk transfers");
+
+    parses("req=0x12,timeout=1", &profile);
+    fault_state_init(&state, &profile, 0);
+    check(fault_next(&state, false, 0x11) == FAULT_NONE, "other requests spared");
+    check(fault_next(&state, true, 0x12) == FAULT_NONE, "bulk spared by a request filter");
+    check(fault_next(&state, false, 0x12) == FAULT_TIMEOUT, "matching request hit");
+    check(state.eligible == 1, "only eligible transfers counted");
+
+    parses("short=1", &profile);
+    fault_state_init(&state, &profile, 0);
+    check(fault_next(&state, false, 0) == FAULT_NONE, "short never applies to control");
+    check(fault_next(&state, true, 0) == FAULT_SHORT, "short applies to bulk");
+
+    printf("\nScripts:\n");
+    parses("at=2:disconnect,at=4:late", &profile);
+    fault_state_init(&state, &profile, 0);
+    fault_kind_t seen[5];
+    for (int i = 0; i < 5; i++) {
+        seen[i] = fault_next(&state, true, 0);
+    }
+    check(seen[0] == FAULT_NONE && seen[1] == FAULT_DISCONNECT && seen[2] == FAULT_NONE &&
+          seen[3] == FAULT_LATE && seen[4] == FAULT_NONE, "scripted faults land on their transfer");
+    check(state.injected[FAULT_DISCONNECT] == 1 && state.injected[FAULT_LATE] == 1 &&
+          state.injected[FAULT_NONE] == 3, "injected faults counted");
+
+    printf("\nRandom faults:\n");
+    parses("stall=0.1,timeout=0.05,seed=42", &profile);
+    fault_state_t a, b, c;
+    fault_state_init(&a, &profile, 3);
+    fault_state_init(&b, &profile, 3);
+    fault_state_init(&c, &profile, 4);
+    bool same = true;
+    bool differ = false;
+    for (int i = 0; i < 1000; i++) {
+        fault_kind_t ka = fault_next(&a, true, 0);
+        same &= ka == fault_next(&b, true, 0);
+        differ |= ka != fault_next(&c, true, 0);
+    }
+    check(same, "same seed, same faults");
+    check(differ, "seed offset changes the faults");
+
+    fault_state_init(&state, &profile, 0);
+    for (int i = 0; i < 100000; i++) {
+        fault_next(&state, true, 0);
+    }
+    printf("    stall %u, timeout %u of 100000\n",
+           state.injected[FAULT_STALL], state.injected[FAULT_TIMEOUT]);
+    check(state.injected[FAULT_STALL] > 9000 && state.injected[FAULT_STALL] < 11000,
+          "stall rate close to 10%");
+    check(state.injected[FAULT_TIMEOUT] > 4000 && state.injected[FAULT_TIMEOUT] < 6000,
+          "timeout rate close to 5%");
+
+    return test_report();
+}
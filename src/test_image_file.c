@@ -0,0 +1,52 @@
+/**
+ * Test program for the memory-mapped firmware image input
+ */
+
+#include "image_file.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    printf("=== Firmware Image Input Test ===\n\n");
+
+    char path[] = "/tmp/thingino_image_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("Failed to create temp file\n");
+        return 1;
+    }
+
+    const size_t size = 300 * 1024 + 17;  // Not page aligned
+    uint8_t* pattern = (uint8_t*)malloc(size);
+    for (size_t i = 0; i < size; i++) {
+        pattern[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    FILE* f = fdopen(fd, "wb");
+    fwrite(pattern, 1, size, f);
+    fclose(f);
+
+    firmware_image_t image;
+    check(firmware_image_open(path, &image) == 0, "open regular file");
+    check(image.mapped, "file is memory-mapped");
+    check(image.size == size, "size matches");
+    check(image.data && memcmp(image.data, pattern, size) == 0, "contents match");
+
+    firmware_image_close(&image);
+    check(image.data == NULL && image.size == 0, "close resets image");
+    firmware_image_close(&image);  // Double close is harmless
+
+    printf("\nFailure cases:\n");
+    check(firmware_image_open("/nonexistent/thingino.bin", &image) != 0, "missing file rejected");
+
+    f = fopen(path, "wb");
+    fclose(f);
+    check(firmware_image_open(path, &image) != 0, "empty file rejected");
+
+    remove(path);
+    free(pattern);
+
+    return test_report();
+}
@@ -0,0 +1,128 @@
+/**
+ * Test program for the job history log and its summaries
+ */
+
+#include "job_history.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DAY 86400
+
+static job_record_t make_record(int64_t time, const char* variant, uint32_t write_ms, int32_t result) {
+    job_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.time = time;
+    r.result = result;
+    snprintf(r.variant, sizeof(r.variant), "%s", variant);
+    r.phase_ms[METRICS_PHASE_WRITE] = write_ms;
+    return r;
+}
+
+static const job_history_row_t* find_row(const job_history_row_t* rows, size_t n, int64_t period,
+                                         const char* variant, metrics_phase_t phase) {
+    for (size_t i = 0; i < n; i++) {
+        if (rows[i].period_start == period && strcmp(rows[i].variant, variant) == 0 &&
+            rows[i].phase == phase) {
+            return &rows[i];
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    printf("=== Job History Test ===\n\n");
+
+    printf("Record encoding:\n");
+    job_record_t in = make_record(1760000000, "t31x", 41000, -5);
+    snprintf(in.cpu_magic, sizeof(in.cpu_magic), "T31V");
+    memset(in.flash_chip, 'f', JOB_HISTORY_CHIP_MAX);  // Fills the field: no NUL on disk
+    snprintf(in.port, sizeof(in.port), "1-2.4");
+    in.image_crc = 0xDEADBEEF;
+    in.phase_ms[METRICS_PHASE_BOOTSTRAP] = 5300;
+    in.retries = 3;
+    in.bytes = 16777216;
+    uint8_t bytes[JOB_HISTORY_RECORD_SIZE];
+    job_record_encode(&in, bytes);
+    job_record_t out;
+    check(job_record_decode(bytes, &out), "decodes");
+    check(out.time == in.time && out.result == -5 && out.image_crc == 0xDEADBEEF &&
+          out.retries == 3 && out.bytes == 16777216, "numbers round-trip");
+    check(out.phase_ms[METRICS_PHASE_BOOTSTRAP] == 5300 && out.phase_ms[METRICS_PHASE_WRITE] == 41000 &&
+          out.phase_ms[METRICS_PHASE_READ] == 0, "phase durations round-trip");
+    check(strcmp(out.variant, "t31x") == 0 && strcmp(out.cpu_magic, "T31V") == 0 &&
+          strcmp(out.port, "1-2.4") == 0, "strings round-trip");
+    check(strlen(out.flash_chip) == JOB_HISTORY_CHIP_MAX && out.flash_chip[0] == 'f',
+          "full-width string round-trips");
+    bytes[0] = 'X';
+    check(!job_record_decode(bytes, &out), "bad magic rejected");
+
+    printf("\nAppend and load:\n");
+    char path[] = "/tmp/thingino_history_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("Failed to create temp file\n");
+        return 1;
+    }
+    close(fd);
+    remove(path);
+    job_record_t* loaded = NULL;
+    size_t count = 99;
+    check(job_history_load(path, 0, &loaded, &count) == 0 && count == 0, "missing file is empty");
+
+    for (int i = 0; i < 100; i++) {
+        job_record_t r = make_record(1000 + i * 10, "t31x", 100 + i, 0);
+        job_history_append(path, &r);
+    }
+    check(job_history_load(path, 0, &loaded, &count) == 0 && count == 100, "all records load");
+    free(loaded);
+    check(job_history_load(path, 1500, &loaded, &count) == 0 && count == 50 && loaded[0].time == 1500,
+          "since finds the first matching record");
+    free(loaded);
+    check(job_history_load(path, 5000, &loaded, &count) == 0 && count == 0 && !loaded,
+          "since past the end loads nothing");
+
+    FILE* f = fopen(path, "ab");
+    fwrite("THJ1 torn", 1, 9, f);
+    fclose(f);
+    check(job_history_load(path, 0, &loaded, &count) == 0 && count == 100, "torn tail ignored");
+    free(loaded);
+    remove(path);
+
+    printf("\nSummary:\n");
+    job_record_t records[64];
+    size_t n = 0;
+    for (uint32_t i = 1; i <= 10; i++) {
+        records[n++] = make_record(0 * DAY + i, "t31x", i * 1000, 0);     // Day 0: 1..10 s
+    }
+    records[n++] = make_record(0 * DAY + 50, "t31x", 99000, -5);          // Failed, not in percentiles
+    for (uint32_t i = 1; i <= 10; i++) {
+        records[n++] = make_record(1 * DAY + i, "t31x", i * 1200, 0);     // Day 1: 20% slower
+    }
+    records[n++] = make_record(1 * DAY + 60, "t41n", 7000, 0);
+    records[n - 1].phase_ms[METRICS_PHASE_BOOTSTRAP] = 4000;
+
+    job_history_row_t* rows = NULL;
+    size_t row_count = 0;
+    check(job_history_summarize(records, n, DAY, &rows, &row_count) == 0 && row_count == 4,
+          "one row per period, variant and phase");
+
+    const job_history_row_t* day0 = find_row(rows, row_count, 0, "t31x", METRICS_PHASE_WRITE);
+    const job_history_row_t* day1 = find_row(rows, row_count, DAY, "t31x", METRICS_PHASE_WRITE);
+    check(day0 && day0->ok == 10 && day0->failed == 1, "failed jobs counted apart");
+    check(day0 && day0->p50_ms == 5000 && day0->p90_ms == 9000 && day0->p99_ms == 10000 &&
+          day0->max_ms == 10000, "nearest-rank percentiles");
+    check(day0 && !day0->has_change, "first period has no baseline");
+    check(day1 && day1->has_change && day1->change_pct > 19.9 && day1->change_pct < 20.1,
+          "median change against previous period");
+    const job_history_row_t* t41 = find_row(rows, row_count, DAY, "t41n", METRICS_PHASE_WRITE);
+    check(t41 && !t41->has_change, "variants are compared only with themselves");
+    check(find_row(rows, row_count, DAY, "t41n", METRICS_PHASE_BOOTSTRAP) != NULL, "other phases grouped");
+    check(rows[0].phase == METRICS_PHASE_WRITE && rows[0].period_start == 0 &&
+          strcmp(rows[0].variant, "t31x") == 0, "ordered by variant, phase, period");
+    free(rows);
+
+    return test_report();
+}
@@ -0,0 +1,122 @@
+/**
+ * Test program for the lock-free log ring
+ */
+
+#include "log_ring.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PRODUCERS      4
+#define PER_PRODUCER   20000
+
+static int producers_done = 0;
+
+typedef struct {
+    log_ring_t* ring;
+    int id;
+    unsigned pushed;
+} producer_t;
+
+static void* produce(void* arg) {
+    producer_t* p = (producer_t*)arg;
+    char text[32];
+    for (unsigned i = 0; i < PER_PRODUCER; i++) {
+        int len = snprintf(text, sizeof(text), "%d:%u", p->id, i);
+        // Retry until accepted so every lap of the ring gets exercised
+        while (!log_ring_push(p->ring, (uint8_t)p->id, text, (size_t)len)) {
+            sched_yield();
+        }
+        p->pushed++;
+    }
+    __atomic_fetch_add(&producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int main() {
+    printf("=== Log Ring Test ===\n\n");
+
+    char out[LOG_RING_MSG_MAX + 1];
+    size_t len = 0;
+    uint8_t stream = 0;
+    log_ring_t ring;
+
+    printf("Basics:\n");
+    check(log_ring_init(&ring, 5) == 0, "init");
+    check(ring.mask == 7, "slot count rounded up to a power of two");
+    check(!log_ring_pop(&ring, &stream, out, &len), "empty ring pops nothing");
+    log_ring_push(&ring, 1, "first", 5);
+    log_ring_push(&ring, 2, "second", 6);
+    check(log_ring_pop(&ring, &stream, out, &len) && len == 5 && memcmp(out, "first", 5) == 0 &&
+          stream == 1, "FIFO order, stream kept");
+    check(log_ring_pop(&ring, &stream, out, &len) && len == 6 && stream == 2, "second message");
+
+    printf("\nFull ring:\n");
+    int accepted = 0;
+    for (int i = 0; i < 10; i++) {
+        accepted += log_ring_push(&ring, 1, "x", 1) ? 1 : 0;
+    }
+    check(accepted == 8, "push fails once all slots are taken");
+    check(log_ring_take_dropped(&ring) == 2, "drops are counted");
+    check(log_ring_take_dropped(&ring) == 0, "counter resets when taken");
+    int popped = 0;
+    while (log_ring_pop(&ring, &stream, out, &len)) {
+        popped++;
+    }
+    check(popped == 8, "everything accepted comes back out");
+    check(log_ring_push(&ring, 1, "again", 5), "slots are reused after wrap-around");
+
+    char big[LOG_RING_MSG_MAX + 100];
+    memset(big, 'a', sizeof(big));
+    log_ring_pop(&ring, &stream, out, &len);
+    log_ring_push(&ring, 1, big, sizeof(big));
+    check(log_ring_pop(&ring, &stream, out, &len) && len == LOG_RING_MSG_MAX, "long message truncated");
+    log_ring_destroy(&ring);
+
+    printf("\nConcurrent producers:\n");
+    log_ring_init(&ring, 256);
+    producer_t producers[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        producers[i] = (producer_t){ &ring, i, 0 };
+        pthread_create(&threads[i], NULL, produce, &producers[i]);
+    }
+
+    // Drain while they run; each producer's messages must arrive in order
+    long next[PRODUCERS] = { 0 };
+    unsigned received = 0;
+    bool ordered = true;
+    bool running = true;
+    while (running) {
+        while (log_ring_pop(&ring, &stream, out, &len)) {
+            out[len] = '\0';
+            int id = 0;
+            unsigned seq = 0;
+            if (sscanf(out, "%d:%u", &id, &seq) != 2 || id != stream || id >= PRODUCERS ||
+                (long)seq != next[id]) {
+                ordered = false;
+            } else {
+                next[id] = (long)seq + 1;
+            }
+            received++;
+        }
+        running = __atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) < PRODUCERS;
+    }
+    unsigned pushed = 0;
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        pushed += producers[i].pushed;
+    }
+    while (log_ring_pop(&ring, &stream, out, &len)) {
+        received++;
+    }
+    uint32_t full = log_ring_take_dropped(&ring);
+    printf("    %u pushed, %u received, ring full %u time(s)\n", pushed, received, full);
+    check(ordered, "per-producer order preserved, messages intact");
+    check(received == PRODUCERS * PER_PRODUCER, "no accepted message lost");
+    log_ring_destroy(&ring);
+
+    return test_report();
+}
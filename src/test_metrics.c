@@ -0,0 +1,115 @@
+/**
+ * Test program for the metrics counters and exposition text
+ */
+
+#include "metrics.h"
+#include "test_check.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS     4
+#define PER_THREAD  50000
+
+static const char* error_name(int code) {
+    return code == -5 ? "Timeout \"usb\"" : NULL;
+}
+
+static void* record(void* arg) {
+    metrics_t* m = (metrics_t*)arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+        metrics_chunk(m, METRICS_WRITE, 3, 100, 7000);
+        metrics_retry(m, 0x12);
+    }
+    return NULL;
+}
+
+static char* render(const metrics_t* m, metrics_format_t format) {
+    size_t len = metrics_format(m, format, error_name, NULL, 0);
+    char* text = (char*)malloc(len + 1);
+    size_t written = metrics_format(m, format, error_name, text, len + 1);
+    check(written == len, "length query matches rendered length");
+    return text;
+}
+
+int main() {
+    printf("=== Metrics Test ===\n\n");
+
+    metrics_t m;
+    metrics_init(&m);
+
+    printf("Recording:\n");
+    check(metrics_phase_from_name("verify") == METRICS_PHASE_VERIFY, "phase names resolve");
+    check(metrics_phase_from_name("erase") == -1, "unknown phase rejected");
+
+    metrics_chunk(&m, METRICS_READ, 1, 1048576, 5000);      // on a bound: that bucket
+    metrics_chunk(&m, METRICS_READ, 1, 1048576, 5001);      // just above: next bucket
+    metrics_chunk(&m, METRICS_READ, 1, 1048576, 60000000);  // beyond every bound: +Inf
+    check(m.bytes[METRICS_READ][1] == 3 * 1048576, "bytes counted per bus");
+    check(m.chunk_latency[METRICS_READ].buckets[0] == 1 &&
+          m.chunk_latency[METRICS_READ].buckets[1] == 1, "bounds are inclusive upper limits");
+    check(m.chunk_latency[METRICS_READ].buckets[m.chunk_latency[METRICS_READ].bound_count] == 1,
+          "overflow lands in +Inf");
+
+    metrics_phase_begin(&m, METRICS_PHASE_WRITE);
+    metrics_phase_begin(&m, METRICS_PHASE_WRITE);
+    metrics_phase_end(&m, METRICS_PHASE_WRITE, 30000000, 0);
+    metrics_phase_end(&m, METRICS_PHASE_WRITE, 4000000, -5);
+    metrics_phase_begin(&m, METRICS_PHASE_BOOTSTRAP);
+    check(m.jobs_active[METRICS_PHASE_WRITE] == 0 && m.jobs_active[METRICS_PHASE_BOOTSTRAP] == 1,
+          "active gauge follows begin/end");
+    check(m.jobs[METRICS_PHASE_WRITE][0] == 1 && m.jobs[METRICS_PHASE_WRITE][1] == 1,
+          "jobs split by result");
+    check(m.failures[METRICS_PHASE_WRITE][5] == 1, "failure kept by error code");
+    metrics_erase(&m, 53000000);
+
+    printf("\nConcurrent updates:\n");
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, record, &m);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    check(m.bytes[METRICS_WRITE][3] == (uint64_t)THREADS * PER_THREAD * 100, "no lost byte updates");
+    check(m.retries[0x12] == (uint64_t)THREADS * PER_THREAD, "no lost retry updates");
+    check(m.chunk_latency[METRICS_WRITE].sum_us == (uint64_t)THREADS * PER_THREAD * 7000,
+          "histogram sum exact");
+
+    printf("\nOpenMetrics text:\n");
+    char* text = render(&m, METRICS_FORMAT_OPENMETRICS);
+    check(strstr(text, "# TYPE thingino_transfer_bytes counter\n# UNIT thingino_transfer_bytes bytes\n") != NULL,
+          "counter family named without _total, with unit");
+    check(strstr(text, "thingino_transfer_bytes_total{direction=\"read\",bus=\"1\"} 3145728\n") != NULL,
+          "byte sample");
+    check(strstr(text, "bus=\"0\"") == NULL, "idle buses omitted");
+    check(strstr(text, "thingino_chunk_latency_seconds_bucket{direction=\"read\",le=\"0.005\"} 1\n") != NULL,
+          "first bucket");
+    check(strstr(text, "thingino_chunk_latency_seconds_bucket{direction=\"read\",le=\"0.01\"} 2\n") != NULL,
+          "buckets are cumulative");
+    check(strstr(text, "thingino_chunk_latency_seconds_bucket{direction=\"read\",le=\"+Inf\"} 3\n") != NULL &&
+          strstr(text, "thingino_chunk_latency_seconds_count{direction=\"read\"} 3\n") != NULL,
+          "+Inf bucket equals count");
+    check(strstr(text, "thingino_phase_duration_seconds_bucket{phase=\"write\",le=\"1.0\"} 0\n") != NULL,
+          "whole-second bounds written as floats");
+    check(strstr(text, "thingino_failures_total{phase=\"write\",code=\"-5\",error=\"Timeout \\\"usb\\\"\"} 1\n") != NULL,
+          "failure labelled with escaped error name");
+    check(strstr(text, "thingino_erase_wait_seconds_sum 53.000000\n") != NULL, "unlabelled histogram sum");
+    check(strstr(text, "thingino_vendor_retries_total{request=\"0x12\"} 200000\n") != NULL,
+          "retries by request code");
+    check(strlen(text) >= 6 && strcmp(text + strlen(text) - 6, "# EOF\n") == 0, "ends with # EOF");
+    free(text);
+
+    printf("\nTextfile collector text:\n");
+    text = render(&m, METRICS_FORMAT_PROMETHEUS);
+    check(strstr(text, "# TYPE thingino_jobs_total counter\n") != NULL, "counter family named after samples");
+    check(strstr(text, "# UNIT") == NULL && strstr(text, "# EOF") == NULL, "no OpenMetrics-only lines");
+    free(text);
+
+    char small[64];
+    size_t full = metrics_format(&m, METRICS_FORMAT_OPENMETRICS, NULL, small, sizeof(small));
+    check(full > sizeof(small) && strlen(small) == sizeof(small) - 1, "truncates safely, reports full length");
+
+    return test_report();
+}
@@ -0,0 +1,97 @@
+/**
+ * Test program for prepared (golden) image layouts
+ */
+
+#include "prepared_image.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bitwise reference CRC32 (the implementation the handshakes used before)
+static uint32_t reference_crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t get_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int main() {
+    printf("=== Prepared Image Test ===\n\n");
+
+    printf("CRC32:\n");
+    check(firmware_crc32((const uint8_t*)"123456789", 9) == 0xCBF43926, "check value");
+
+    const size_t size = 5 * 64 * 1024 + 1000;  // Partial last chunk
+    uint8_t* pattern = (uint8_t*)malloc(size);
+    for (size_t i = 0; i < size; i++) {
+        pattern[i] = (uint8_t)(i * 131 + (i >> 9));
+    }
+    check(firmware_crc32(pattern, size) == reference_crc32(pattern, size), "matches bitwise reference");
+
+    printf("\nHandshake formats:\n");
+    uint8_t hs[FIRMWARE_WRITE_HANDSHAKE_SIZE];
+    write_handshake_format(WRITE_HANDSHAKE_T31, 0x20000, 0x20000, 0x12345678, hs);
+    check(hs[10] == 0x02 && hs[11] == 0x00 && hs[18] == 0x02 && hs[26] == 0x06 &&
+          get_le32(&hs[28]) == ~0x12345678u && hs[32] == 0x20 && hs[35] == 0x08,
+          "T31 offset/size units, ~CRC and trailer");
+    write_handshake_format(WRITE_HANDSHAKE_T41N, 0x10000, 0x10000, 0, hs);
+    check(hs[10] == 0x01 && hs[18] == 0x01 && hs[32] == 0xF0 && hs[35] == 0x44, "T41N trailer");
+    write_handshake_format(WRITE_HANDSHAKE_A1, 0x100000, 0x100000, 0xCAFEBABE, hs);
+    check(hs[10] == 0x06 && get_le32(&hs[12]) == 0x100000 && get_le32(&hs[16]) == 0x100000 &&
+          get_le32(&hs[20]) == ~0xCAFEBABEu && hs[32] == 0x30 && hs[35] == 0xD4,
+          "A1 byte offset/size, ~CRC and trailer");
+
+    printf("\nLayouts:\n");
+    char path[] = "/tmp/thingino_prepared_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        printf("Failed to create temp file\n");
+        return 1;
+    }
+    FILE* f = fdopen(fd, "wb");
+    fwrite(pattern, 1, size, f);
+    fclose(f);
+
+    prepared_image_t image;
+    check(prepared_image_open(&image, path) == 0, "open image");
+    check(prepared_image_add_layout(&image, WRITE_HANDSHAKE_T41N, 64 * 1024) == 0, "T41N layout");
+    check(prepared_image_add_layout(&image, WRITE_HANDSHAKE_T31, 64 * 1024) == 0, "T31 layout (shared CRCs)");
+    check(prepared_image_add_layout(&image, WRITE_HANDSHAKE_A1, 1024 * 1024) == 0, "A1 layout");
+
+    const prepared_layout_t* t31 = prepared_image_layout(&image, WRITE_HANDSHAKE_T31, 64 * 1024);
+    check(t31 && t31->chunk_count == 6, "chunk count rounds up");
+    check(prepared_image_layout(&image, WRITE_HANDSHAKE_T31, 128 * 1024) == NULL,
+          "other chunk size not prepared");
+
+    bool all_match = t31 != NULL;
+    for (uint32_t i = 0; t31 && i < t31->chunk_count; i++) {
+        uint32_t offset = i * t31->chunk_size;
+        uint32_t len = (offset + t31->chunk_size > size) ? (uint32_t)(size - offset) : t31->chunk_size;
+        write_handshake_format(WRITE_HANDSHAKE_T31, offset, len, reference_crc32(pattern + offset, len), hs);
+        if (memcmp(hs, t31->handshakes[i], sizeof(hs)) != 0) {
+            all_match = false;
+        }
+    }
+    check(all_match, "T31 handshakes match per-chunk computation");
+
+    const prepared_layout_t* a1 = prepared_image_layout(&image, WRITE_HANDSHAKE_A1, 1024 * 1024);
+    check(a1 && a1->chunk_count == 1 && get_le32(&a1->handshakes[0][16]) == size,
+          "A1 single partial chunk carries its real size");
+
+    prepared_image_close(&image);
+    prepared_image_close(&image);  // Double close is harmless
+
+    remove(path);
+    free(pattern);
+
+    return test_report();
+}
@@ -0,0 +1,84 @@
+/**
+ * Test program for the retry policy state machine
+ */
+
+#include "retry_policy.h"
+#include "test_check.h"
+#include <stdio.h>
+
+// Run a request that always fails with error_class on a simulated clock
+// where every attempt uses its full timeout. Returns the elapsed time.
+static uint64_t run_failing(const retry_policy_t* policy, uint32_t error_class,
+                            uint64_t outer_deadline, retry_decision_t* last, uint32_t* attempts) {
+    uint64_t now = 1000;
+    uint64_t start = now;
+    retry_state_t state;
+    retry_begin(&state, policy, now, outer_deadline ? start + outer_deadline : 0);
+
+    *last = RETRY_GIVE_UP;
+    for (;;) {
+        uint32_t timeout = retry_attempt_timeout(&state, now);
+        if (timeout == 0) {
+            break;
+        }
+        now += timeout;
+
+        uint32_t sleep_ms = 0;
+        *last = retry_after_error(&state, error_class, now, &sleep_ms);
+        if (*last != RETRY_AGAIN) {
+            break;
+        }
+        now += sleep_ms;
+    }
+
+    *attempts = state.attempts;
+    return now - start;
+}
+
+int main() {
+    printf("=== Retry Policy Test ===\n\n");
+
+    retry_decision_t last;
+    uint32_t attempts;
+    uint64_t elapsed;
+
+    printf("Control policy:\n");
+    elapsed = run_failing(&retry_policy_control, RETRY_ERR_TIMEOUT, 0, &last, &attempts);
+    printf("    stuck device: %u attempts, %llu ms\n", attempts, (unsigned long long)elapsed);
+    check(last == RETRY_GIVE_UP, "stuck device gives up");
+    check(attempts > 1, "timeouts are retried");
+    check(elapsed <= retry_policy_control.deadline_ms, "stays inside the deadline");
+
+    elapsed = run_failing(&retry_policy_control, RETRY_ERR_OTHER, 0, &last, &attempts);
+    check(last == RETRY_GIVE_UP && attempts == 1, "unclassified errors fail at once");
+
+    elapsed = run_failing(&retry_policy_control, RETRY_ERR_PIPE, 1500, &last, &attempts);
+    check(elapsed <= 1500, "outer budget caps the policy deadline");
+
+    retry_state_t state;
+    retry_begin(&state, &retry_policy_control, 0, 0);
+    uint32_t sleeps[6] = {0};
+    uint64_t now = 0;
+    for (int i = 0; i < 6; i++) {
+        retry_attempt_timeout(&state, now);
+        retry_after_error(&state, RETRY_ERR_PIPE, now, &sleeps[i]);
+    }
+    check(sleeps[0] == 100 && sleeps[1] == 200 && sleeps[2] == 400 && sleeps[3] == 800 &&
+          sleeps[4] == 1000 && sleeps[5] == 1000, "backoff doubles up to the cap");
+
+    retry_begin(&state, &retry_policy_control, 0, 20);
+    check(retry_attempt_timeout(&state, 0) == 0, "no attempt when the budget is nearly spent");
+
+    printf("\nBusy-but-ok policies:\n");
+    elapsed = run_failing(&retry_policy_fw_handshake, RETRY_ERR_TIMEOUT, 0, &last, &attempts);
+    check(last == RETRY_OK && attempts == 1, "handshake timeout counts as accepted");
+    check(elapsed <= 1000, "busy handshake costs at most one short timeout");
+
+    elapsed = run_failing(&retry_policy_fw_handshake, RETRY_ERR_PIPE, 0, &last, &attempts);
+    check(last == RETRY_GIVE_UP && attempts == 1, "handshake stall is not retried");
+
+    elapsed = run_failing(&retry_policy_fw_set_addr, RETRY_ERR_TIMEOUT, 0, &last, &attempts);
+    check(last == RETRY_OK, "set-address timeout during erase counts as accepted");
+
+    return test_report();
+}
@@ -0,0 +1,79 @@
+/**
+ * Test program for the transfer profile store
+ */
+
+#include "transfer_profile.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    printf("=== Transfer Profile Store Test ===\n\n");
+
+    char path[] = "/tmp/thingino_profile_test_XXXXXX";
+    char* dir = mkdtemp(path);
+    if (!dir) {
+        printf("Failed to create temp directory\n");
+        return 1;
+    }
+
+    char file[256];
+    snprintf(file, sizeof(file), "%s/sub/profiles", dir);
+    setenv("THINGINO_PROFILE_FILE", file, 1);
+
+    printf("Parsing:\n");
+    transfer_profile_t tp;
+    check(!transfer_profile_parse_line("# comment\n", &tp), "comment line ignored");
+    check(!transfer_profile_parse_line("   \n", &tp), "blank line ignored");
+    check(transfer_profile_parse_line("t31x gd25q127 read_chunk=0x40000 read_delay_ms=20 future=1\n", &tp) &&
+          strcmp(tp.variant, "t31x") == 0 && strcmp(tp.flash, "gd25q127") == 0 &&
+          tp.read_chunk_size == 0x40000 && tp.read_delay_ms == 20,
+          "fields and unknown keys");
+
+    printf("\nStore and lookup:\n");
+    check(!transfer_profile_lookup("t31x", "gd25q127", &tp), "missing file -> no profile");
+
+    transfer_profile_t a = {0};
+    snprintf(a.variant, sizeof(a.variant), "t31x");
+    snprintf(a.flash, sizeof(a.flash), "default");
+    a.read_chunk_size = 1048576;
+    a.read_mbps = 3.5;
+    check(transfer_profile_store(&a) == 0, "store default profile (creates directories)");
+
+    transfer_profile_t b = a;
+    snprintf(b.flash, sizeof(b.flash), "gd25q127");
+    b.read_chunk_size = 262144;
+    check(transfer_profile_store(&b) == 0, "store chip profile");
+
+    check(transfer_profile_lookup("t31x", "gd25q127", &tp) && tp.read_chunk_size == 262144,
+          "exact chip match");
+    check(transfer_profile_lookup("t31x", "xm25qh128b", &tp) && tp.read_chunk_size == 1048576,
+          "falls back to variant default");
+    check(!transfer_profile_lookup("t41", NULL, &tp), "other variant not matched");
+
+    b.read_chunk_size = 524288;
+    check(transfer_profile_store(&b) == 0 &&
+          transfer_profile_lookup("t31x", "gd25q127", &tp) && tp.read_chunk_size == 524288,
+          "store replaces existing entry");
+
+    int lines = 0;
+    FILE* f = fopen(file, "r");
+    if (f) {
+        char line[512];
+        while (fgets(line, sizeof(line), f)) {
+            if (transfer_profile_parse_line(line, &tp)) {
+                lines++;
+            }
+        }
+        fclose(f);
+    }
+    check(lines == 2, "no duplicate entries");
+
+    remove(file);
+    snprintf(file, sizeof(file), "%s/sub", dir);
+    remove(file);
+    remove(dir);
+
+    return test_report();
+}
@@ -0,0 +1,410 @@
+/**
+ * Test program for usbmon capture parsing (pcap and pcapng), the trace
+ * writer and capture diff alignment
+ */
+
+#include "usb_capture.h"
+#include "usb_trace.h"
+#include "capture_diff.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// ============================================================================
+// CAPTURE BUILDER
+// ============================================================================
+
+typedef struct {
+    uint8_t data[8192];
+    size_t size;
+    bool swapped;                   // Write fields big-endian
+    bool pcapng;
+} builder_t;
+
+static void put(builder_t* b, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        int shift = b->swapped ? (bytes - 1 - i) * 8 : i * 8;
+        b->data[b->size++] = (uint8_t)(v >> shift);
+    }
+}
+
+static void put_bytes(builder_t* b, const void* p, size_t n) {
+    memcpy(b->data + b->size, p, n);
+    b->size += n;
+}
+
+static void begin(builder_t* b, bool pcapng, bool swapped, uint32_t linktype) {
+    memset(b, 0, sizeof(*b));
+    b->pcapng = pcapng;
+    b->swapped = swapped;
+    if (!pcapng) {
+        put(b, 0xA1B2C3D4u, 4);
+        put(b, 2, 2);
+        put(b, 4, 2);
+        put(b, 0, 4);
+        put(b, 0, 4);
+        put(b, 65535, 4);
+        put(b, linktype, 4);
+        return;
+    }
+    put(b, 0x0A0D0D0Au, 4);     // SHB
+    put(b, 28, 4);
+    put(b, 0x1A2B3C4Du, 4);
+    put(b, 1, 2);
+    put(b, 0, 2);
+    put(b, (uint64_t)-1, 8);
+    put(b, 28, 4);
+    put(b, 1, 4);               // IDB
+    put(b, 20, 4);
+    put(b, linktype, 2);
+    put(b, 0, 2);
+    put(b, 0, 4);
+    put(b, 20, 4);
+}
+
+/**
+ * Append one usbmon event with a 48-byte header.
+ * setup is 8 bytes or NULL; payload is what the event carries.
+ */
+static void event(builder_t* b, uint64_t id, char kind, uint8_t type, uint8_t ep, uint8_t dev,
+                  uint64_t ts_us, int32_t status, uint32_t length, const uint8_t* setup,
+                  const uint8_t* payload, uint32_t payload_len) {
+    uint32_t caplen = 48 + payload_len;
+    uint32_t padded = (caplen + 3) & ~3u;
+    if (b->pcapng) {
+        put(b, 6, 4);           // EPB
+        put(b, 32 + padded, 4);
+        put(b, 0, 4);
+        put(b, 0, 4);
+        put(b, 0, 4);
+        put(b, caplen, 4);
+        put(b, caplen, 4);
+    } else {
+        put(b, ts_us / 1000000, 4);
+        put(b, ts_us % 1000000, 4);
+        put(b, caplen, 4);
+        put(b, caplen, 4);
+    }
+
+    put(b, id, 8);
+    b->data[b->size++] = (uint8_t)kind;
+    b->data[b->size++] = type;
+    b->data[b->size++] = ep;
+    b->data[b->size++] = dev;
+    put(b, 3, 2);                           // Bus 3
+    b->data[b->size++] = setup ? 0 : '-';   // flag_setup
+    b->data[b->size++] = payload_len ? 0 : '<';
+    put(b, ts_us / 1000000, 8);
+    put(b, (uint32_t)(ts_us % 1000000), 4);
+    put(b, (uint32_t)status, 4);
+    put(b, length, 4);
+    put(b, payload_len, 4);
+    uint8_t zero[8] = {0};
+    put_bytes(b, setup ? setup : zero, 8);
+    put_bytes(b, payload, payload_len);
+
+    if (b->pcapng) {
+        while (b->size & 3) {
+            b->data[b->size++] = 0;
+        }
+        put(b, 32 + padded, 4);
+    }
+}
+
+// A vendor OUT control write followed by a bulk IN read, as the cloner does
+static void vendor_session(builder_t* b) {
+    static const uint8_t setup[8] = { 0x40, 0x12, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00 };
+    uint8_t handshake[40];
+    for (int i = 0; i < 40; i++) {
+        handshake[i] = (uint8_t)i;
+    }
+    event(b, 0x100, 'S', USB_CAPTURE_XFER_CONTROL, 0x00, 7, 1000000, -115, 40, setup, handshake, 40);
+    event(b, 0x100, 'C', USB_CAPTURE_XFER_CONTROL, 0x00, 7, 1000250, 0, 40, NULL, NULL, 0);
+
+    static const uint8_t reply[4] = { 'l', 'o', 'g', '\n' };
+    event(b, 0x200, 'S', USB_CAPTURE_XFER_BULK, 0x81, 7, 1001000, -115, 512, NULL, NULL, 0);
+    event(b, 0x200, 'C', USB_CAPTURE_XFER_BULK, 0x81, 7, 1003000, 0, 4, NULL, reply, 4);
+}
+
+// ============================================================================
+// COLLECTOR
+// ============================================================================
+
+typedef struct {
+    usb_capture_transfer_t transfers[8];
+    uint8_t payloads[8][64];
+    int count;
+} collected_t;
+
+static void collect(void* user_data, const usb_capture_transfer_t* t) {
+    collected_t* c = (collected_t*)user_data;
+    if (c->count < 8) {
+        c->transfers[c->count] = *t;
+        // Payloads point into the capture; copy so checks do not depend on it
+        memcpy(c->payloads[c->count], t->data, t->data_len < 64 ? t->data_len : 64);
+        c->count++;
+    }
+}
+
+static bool parse(const builder_t* b, collected_t* c, usb_capture_stats_t* stats) {
+    char error[128] = "";
+    memset(c, 0, sizeof(*c));
+    if (usb_capture_parse(b->data, b->size, collect, c, stats, error, sizeof(error)) != 0) {
+        printf("    parse failed: %s\n", error);
+        return false;
+    }
+    return true;
+}
+
+static bool session_ok(const collected_t* c) {
+    const usb_capture_transfer_t* ctl = &c->transfers[0];
+    const usb_capture_transfer_t* bulk = &c->transfers[1];
+    return c->count == 2 &&
+           ctl->type == USB_CAPTURE_XFER_CONTROL && ctl->has_setup && ctl->request_type == 0x40 &&
+           ctl->request == 0x12 && ctl->length == 40 && ctl->bus == 3 && ctl->device == 7 &&
+           ctl->submit_us == 1000000 && ctl->complete_us == 1000250 && ctl->status == 0 &&
+           ctl->data_len == 40 && c->payloads[0][39] == 39 &&
+           bulk->type == USB_CAPTURE_XFER_BULK && bulk->endpoint == 0x81 && !bulk->has_setup &&
+           bulk->requested == 512 && bulk->actual == 4 && bulk->data_len == 4 &&
+           memcmp(c->payloads[1], "log\n", 4) == 0;
+}
+
+// ============================================================================
+// DIFF HELPERS
+// ============================================================================
+
+// Step script: 'w' = VR_WRITE handshake, 's' = status read, 'b' = bulk OUT,
+// 'W' = VR_WRITE with other contents, 'B' = shorter bulk OUT. Each step
+// takes step_us, plus gap_us of host time before it.
+static void script_steps(capture_steps_t* steps, const char* script, uint64_t step_us,
+                         uint64_t gap_us) {
+    static const uint8_t handshake_a[40] = { 0x00, 0x06 };
+    static const uint8_t handshake_b[40] = { 0x00, 0x07 };
+    uint64_t now = 1000000;
+    for (const char* c = script; *c; c++) {
+        usb_capture_transfer_t t;
+        memset(&t, 0, sizeof(t));
+        now += gap_us;
+        t.submit_us = now;
+        now += step_us;
+        t.complete_us = now;
+        if (*c == 'b' || *c == 'B') {
+            t.type = USB_CAPTURE_XFER_BULK;
+            t.endpoint = 0x01;
+            t.requested = t.actual = *c == 'b' ? 65536 : 32768;
+        } else {
+            t.type = USB_CAPTURE_XFER_CONTROL;
+            t.has_setup = true;
+            t.request_type = *c == 's' ? 0xC0 : 0x40;
+            t.endpoint = *c == 's' ? 0x80 : 0x00;
+            t.request = *c == 's' ? 0x16 : 0x12;
+            t.length = *c == 's' ? 8 : 40;
+            t.data = *c == 'W' ? handshake_b : handshake_a;
+            t.data_len = *c == 's' ? 0 : 40;
+        }
+        capture_steps_add(steps, &t);
+    }
+}
+
+typedef struct {
+    char ops[32];
+    int count;
+    int64_t last_cumulative_us;
+    int64_t largest_step_us;
+    int largest_at;
+} diff_result_t;
+
+static void record_diff(void* user_data, const capture_diff_entry_t* e) {
+    static const char symbols[] = "=~+-";
+    diff_result_t* r = (diff_result_t*)user_data;
+    if (r->count < 31) {
+        r->ops[r->count] = symbols[e->op];
+    }
+    if (e->ours && e->vendor && e->step_delta_us > r->largest_step_us) {
+        r->largest_step_us = e->step_delta_us;
+        r->largest_at = r->count;
+    }
+    r->last_cumulative_us = e->cumulative_delta_us;
+    r->count++;
+}
+
+static diff_result_t run_diff(const char* ours_script, const char* vendor_script,
+                              uint64_t ours_gap_us) {
+    capture_steps_t ours, vendor;
+    memset(&ours, 0, sizeof(ours));
+    memset(&vendor, 0, sizeof(vendor));
+    script_steps(&ours, ours_script, 100, ours_gap_us);
+    script_steps(&vendor, vendor_script, 100, 0);
+    diff_result_t r;
+    memset(&r, 0, sizeof(r));
+    capture_diff(&ours, &vendor, record_diff, &r);
+    capture_steps_free(&ours);
+    capture_steps_free(&vendor);
+    return r;
+}
+
+int main() {
+    printf("=== USB Capture Parser Test ===\n\n");
+
+    builder_t b;
+    collected_t c;
+    usb_capture_stats_t stats;
+
+    printf("Containers:\n");
+    begin(&b, false, false, 189);
+    vendor_session(&b);
+    check(parse(&b, &c, &stats) && session_ok(&c), "pcap, little-endian");
+    check(stats.records == 4 && stats.transfers == 2 && stats.unmatched == 0 && stats.skipped == 0,
+          "pcap counters");
+
+    begin(&b, false, true, 189);
+    vendor_session(&b);
+    check(parse(&b, &c, &stats) && session_ok(&c), "pcap, big-endian");
+
+    begin(&b, true, false, 189);
+    vendor_session(&b);
+    check(parse(&b, &c, &stats) && session_ok(&c), "pcapng, little-endian");
+
+    begin(&b, true, true, 189);
+    vendor_session(&b);
+    check(parse(&b, &c, &stats) && session_ok(&c), "pcapng, big-endian");
+
+    printf("\nPairing:\n");
+    begin(&b, false, false, 189);
+    // Two URBs in flight, completed out of order
+    event(&b, 1, 'S', USB_CAPTURE_XFER_BULK, 0x01, 7, 10, -115, 4, NULL, (const uint8_t*)"abcd", 4);
+    event(&b, 2, 'S', USB_CAPTURE_XFER_BULK, 0x01, 7, 20, -115, 4, NULL, (const uint8_t*)"efgh", 4);
+    event(&b, 2, 'C', USB_CAPTURE_XFER_BULK, 0x01, 7, 30, 0, 4, NULL, NULL, 0);
+    event(&b, 1, 'E', USB_CAPTURE_XFER_BULK, 0x01, 7, 40, -32, 0, NULL, NULL, 0);
+    // Completion whose submit predates the capture, then a submit never completed
+    event(&b, 9, 'C', USB_CAPTURE_XFER_BULK, 0x81, 7, 50, 0, 4, NULL, NULL, 0);
+    event(&b, 3, 'S', USB_CAPTURE_XFER_BULK, 0x81, 7, 60, -115, 512, NULL, NULL, 0);
+    check(parse(&b, &c, &stats) && c.count == 3, "three transfers reported");
+    check(c.transfers[0].urb_id == 2 && memcmp(c.payloads[0], "efgh", 4) == 0 &&
+          c.transfers[0].actual == 4, "OUT payload taken from the submit");
+    check(c.transfers[1].urb_id == 1 && c.transfers[1].status == -32 && c.transfers[1].actual == 0,
+          "error completion keeps its status");
+    check(c.transfers[2].urb_id == 3 && c.transfers[2].complete_us == 0, "in-flight URB reported last");
+    check(stats.unmatched == 2, "orphan completion and leftover submit counted");
+
+    printf("\nRobustness:\n");
+    begin(&b, false, false, 189);
+    vendor_session(&b);
+    b.size -= 10;  // Cut the last record short
+    check(parse(&b, &c, &stats) && c.count == 2 && c.transfers[1].complete_us == 0 &&
+          stats.skipped == 1, "truncated capture keeps what it has");
+
+    begin(&b, false, false, 1);
+    check(usb_capture_parse(b.data, b.size, collect, &c, NULL, NULL, 0) != 0,
+          "ethernet capture rejected");
+
+    static const uint8_t text[] = "this is not a capture file";
+    char error[128] = "";
+    check(usb_capture_parse(text, sizeof(text), collect, &c, NULL, error, sizeof(error)) != 0 &&
+          error[0] != '\0', "non-capture rejected with a message");
+
+    printf("\nTrace writer:\n");
+    char path[] = "/tmp/thingino_trace_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+    }
+    usb_trace_t trace;
+    check(usb_trace_open(&trace, path) == 0, "trace created");
+    static const uint8_t handshake[40] = { 0x00, 0x06, 0xAA };
+    usb_capture_transfer_t out;
+    memset(&out, 0, sizeof(out));
+    out.submit_us = 5000000;
+    out.complete_us = 5000300;
+    out.bus = 2;
+    out.device = 9;
+    out.type = USB_CAPTURE_XFER_CONTROL;
+    out.has_setup = true;
+    out.request_type = 0x40;
+    out.request = 0x12;
+    out.length = 40;
+    out.requested = out.actual = 40;
+    out.data = handshake;
+    out.data_len = 40;
+    usb_trace_record(&trace, &out);
+    usb_capture_transfer_t in;
+    memset(&in, 0, sizeof(in));
+    in.submit_us = 5001000;
+    in.complete_us = 5006000;
+    in.bus = 2;
+    in.device = 9;
+    in.type = USB_CAPTURE_XFER_BULK;
+    in.endpoint = 0x81;
+    in.status = -110;
+    in.requested = 512;
+    in.actual = 3;
+    in.data = (const uint8_t*)"ok\n";
+    in.data_len = 3;
+    usb_trace_record(&trace, &in);
+    check(usb_trace_close(&trace) == 0, "trace closed cleanly");
+
+    FILE* f = fopen(path, "rb");
+    size_t size = f ? fread(b.data, 1, sizeof(b.data), f) : 0;
+    if (f) {
+        fclose(f);
+    }
+    remove(path);
+    b.size = size;
+    check(parse(&b, &c, &stats) && c.count == 2 && stats.unmatched == 0, "trace reads back");
+    check(c.transfers[0].has_setup && c.transfers[0].request == 0x12 &&
+          c.transfers[0].submit_us == 5000000 && c.transfers[0].complete_us == 5000300 &&
+          c.transfers[0].bus == 2 && c.transfers[0].device == 9 &&
+          memcmp(c.payloads[0], handshake, 40) == 0, "control transfer round-trips");
+    check(c.transfers[1].endpoint == 0x81 && c.transfers[1].status == -110 &&
+          c.transfers[1].actual == 3 && memcmp(c.payloads[1], "ok\n", 3) == 0,
+          "failed bulk IN keeps its status and data");
+
+    printf("\nDiff:\n");
+    diff_result_t r = run_diff("wsbwsb", "wsbwsb", 0);
+    check(r.count == 6 && strcmp(r.ops, "======") == 0 && r.last_cumulative_us == 0,
+          "identical sequences pair up");
+    r = run_diff("wsssb", "wsb", 0);
+    check(strcmp(r.ops, "==++=") == 0, "extra status polls only in ours");
+    r = run_diff("wb", "wssb", 0);
+    check(strcmp(r.ops, "=--=") == 0, "status polls only in vendor");
+    r = run_diff("Wsb", "wsb", 0);
+    check(strcmp(r.ops, "~==") == 0, "different handshake contents still paired");
+    r = run_diff("wsB", "wsb", 0);
+    check(strcmp(r.ops, "==+-") == 0, "bulk transfers of another size not paired");
+    r = run_diff("wsbwsb", "wsbwsb", 1000);
+    check(r.last_cumulative_us == 5000 && r.largest_step_us == 1000,
+          "host gaps add up (first pair is the origin)");
+
+    capture_steps_t ours, vendor;
+    memset(&ours, 0, sizeof(ours));
+    memset(&vendor, 0, sizeof(vendor));
+    script_steps(&ours, "wsbwsb", 100, 0);
+    script_steps(&vendor, "wsbwsb", 100, 0);
+    ours.steps[4].submit_us += 20000;     // A sleep before the second status read
+    ours.steps[4].complete_us += 20000;
+    ours.steps[5].submit_us += 20000;
+    ours.steps[5].complete_us += 20000;
+    memset(&r, 0, sizeof(r));
+    capture_diff(&ours, &vendor, record_diff, &r);
+    check(r.largest_at == 4 && r.largest_step_us == 20000 && r.last_cumulative_us == 20000,
+          "a sleep is charged to the step after it");
+    capture_steps_free(&ours);
+    capture_steps_free(&vendor);
+
+    usb_capture_transfer_t poll;
+    memset(&poll, 0, sizeof(poll));
+    poll.type = USB_CAPTURE_XFER_BULK;
+    poll.endpoint = 0x81;
+    poll.status = -110;
+    poll.requested = 512;
+    capture_steps_add(&ours, &poll);
+    poll.status = -32;
+    capture_steps_add(&ours, &poll);
+    check(ours.count == 1 && ours.steps[0].status == -32 && ours.seen == 2,
+          "empty log polls dropped, stalls kept");
+    capture_steps_free(&ours);
+
+    return test_report();
+}
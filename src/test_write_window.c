@@ -0,0 +1,153 @@
+/**
+ * Test program for the pipelined writer's window bookkeeping
+ */
+
+#include "write_window.h"
+#include "test_check.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CHUNK       (128 * 1024)
+#define SETTLE_MS   80
+#define CONFIRM_MS  1000
+
+static burner_event_t event(burner_event_type_t type, int32_t value) {
+    burner_event_t ev = { type, value, 0 };
+    return ev;
+}
+
+// Host side of chunk index finished (the slot must be in the window)
+static void host_done(write_window_t* w, uint32_t index, bool acked, uint64_t now_ms) {
+    write_window_host_done(w, write_window_slot(w, index), acked, now_ms);
+}
+
+// Retire everything ready; returns how many chunks retired, in order
+static int retire_all(write_window_t* w, uint64_t now_ms, uint32_t* next_expected) {
+    write_window_slot_t retired;
+    int count = 0;
+    while (write_window_retire(w, now_ms, &retired) == WRITE_WINDOW_RETIRED) {
+        if (retired.index != *next_expected) {
+            printf("  [FAIL] retired chunk %u, expected %u\n", retired.index, *next_expected);
+            failures++;
+        }
+        (*next_expected)++;
+        count++;
+    }
+    return count;
+}
+
+// Write chunks through a window of depth, reporting every window's chunks
+// to the log in reverse order once the window is full
+static void run_reversed(uint32_t depth, uint32_t chunks) {
+    write_window_t w;
+    write_window_init(&w, depth, SETTLE_MS, CONFIRM_MS);
+    uint32_t started = 0;
+    uint32_t retired = 0;
+    uint32_t max_in_flight = 0;
+    uint64_t now = 0;
+
+    while (retired < chunks && now < 100000) {
+        while (started < chunks && write_window_has_room(&w)) {
+            write_window_start(&w, started * CHUNK, CHUNK, now * 1000);
+            host_done(&w, started, true, now);
+            started++;
+        }
+        if (w.tail - w.head > max_in_flight) {
+            max_in_flight = w.tail - w.head;
+        }
+        for (uint32_t i = w.tail; i-- > w.head;) {
+            burner_event_t ev = event(BURNER_EVENT_CHUNK_DONE, (int32_t)i);
+            write_window_event(&w, &ev);
+        }
+        retire_all(&w, now, &retired);
+        now += 10;
+    }
+
+    char what[96];
+    snprintf(what, sizeof(what), "depth %u: %u chunks retired in order, %u in flight at most",
+             depth, retired, max_in_flight);
+    check(retired == chunks && max_in_flight == depth && now < SETTLE_MS, what);
+}
+
+int main() {
+    printf("=== Write Window Test ===\n\n");
+
+    printf("Out-of-order reports:\n");
+    for (uint32_t depth = 2; depth <= 4; depth++) {
+        run_reversed(depth, 10);
+    }
+
+    write_window_t w;
+    uint32_t next = 0;
+    burner_event_t ev;
+
+    printf("\nReports ahead of the host side:\n");
+    write_window_init(&w, 3, SETTLE_MS, CONFIRM_MS);
+    write_window_start(&w, 0, CHUNK, 0);
+    write_window_start(&w, CHUNK, CHUNK, 0);
+    ev = event(BURNER_EVENT_CHUNK_DONE, 1);
+    write_window_event(&w, &ev);
+    ev = event(BURNER_EVENT_CHUNK_DONE, 0);
+    write_window_event(&w, &ev);
+    check(retire_all(&w, 0, &next) == 0, "nothing retires while host transfers run");
+    host_done(&w, 0, true, 5);
+    check(retire_all(&w, 5, &next) == 1, "chunk 0 retires as soon as its host side is done");
+    host_done(&w, 1, true, 6);
+    check(retire_all(&w, 6, &next) == 1 && write_window_empty(&w),
+          "chunk 1 keeps its early report, no settle wait");
+
+    printf("\nUnnumbered reports and silent burners:\n");
+    write_window_init(&w, 2, SETTLE_MS, CONFIRM_MS);
+    next = 0;
+    write_window_start(&w, 0, CHUNK, 0);
+    write_window_start(&w, CHUNK, CHUNK, 0);
+    host_done(&w, 0, true, 0);
+    host_done(&w, 1, true, 0);
+    ev = event(BURNER_EVENT_CHUNK_DONE, -1);
+    write_window_event(&w, &ev);
+    check(retire_all(&w, 1, &next) == 1, "unnumbered report retires the oldest chunk");
+    check(retire_all(&w, SETTLE_MS - 1, &next) == 0, "silent chunk waits for the settle time");
+    check(retire_all(&w, SETTLE_MS, &next) == 1, "acked silent chunk retires after settling");
+
+    printf("\nTimed-out host transfers:\n");
+    write_window_init(&w, 2, SETTLE_MS, CONFIRM_MS);
+    next = 0;
+    write_window_start(&w, 0, CHUNK, 0);
+    write_window_start(&w, CHUNK, CHUNK, 0);
+    host_done(&w, 0, false, 0);
+    host_done(&w, 1, false, 0);
+    check(write_window_retire(&w, SETTLE_MS, NULL) == WRITE_WINDOW_WAIT,
+          "unconfirmed chunk does not settle");
+    ev = event(BURNER_EVENT_CRC_OK, 0);
+    write_window_event(&w, &ev);
+    check(retire_all(&w, SETTLE_MS, &next) == 1, "CRC report confirms it, then it settles");
+    check(write_window_retire(&w, CONFIRM_MS - 1, NULL) == WRITE_WINDOW_WAIT,
+          "next chunk still waiting for confirmation");
+    check(write_window_retire(&w, CONFIRM_MS, NULL) == WRITE_WINDOW_UNCONFIRMED && w.head == 1,
+          "never confirmed: reported, not retired");
+
+    printf("\nFailure in the middle of the window:\n");
+    write_window_init(&w, 4, SETTLE_MS, CONFIRM_MS);
+    next = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        write_window_start(&w, i * CHUNK, CHUNK, 0);
+        host_done(&w, i, true, 0);
+    }
+    ev = event(BURNER_EVENT_CHUNK_DONE, 0);
+    write_window_event(&w, &ev);
+    ev = event(BURNER_EVENT_CHUNK_DONE, 2);
+    write_window_event(&w, &ev);
+    ev = event(BURNER_EVENT_CRC_FAIL, 1);
+    check(!write_window_event(&w, &ev), "CRC failure for chunk 1 fails the write");
+    check(retire_all(&w, 1, &next) == 1 && w.head == 1,
+          "only chunk 0 counts as written");
+
+    printf("\nStale reports:\n");
+    ev = event(BURNER_EVENT_CHUNK_DONE, 0);
+    write_window_event(&w, &ev);
+    ev = event(BURNER_EVENT_CHUNK_DONE, 9);
+    write_window_event(&w, &ev);
+    check(w.stale == 2 && w.head == 1, "reports outside the window are ignored");
+
+    return test_report();
+}
@@ -0,0 +1,158 @@
+#include "thingino.h"
+
+// ============================================================================
+// TRANSFER TRACE RECORDING
+// ============================================================================
+//
+// The raw transfer paths in device.c (and the burner log poll) bracket each
+// transfer with thingino_trace_start() and a record call. Asynchronous
+// transfers (the pipelined writer) keep the start time from submission and
+// record from their completion callback. Without a trace on
+// the current context that is one context lookup per transfer.
+
+thingino_error_t thingino_trace_open(thingino_context_t* ctx, const char* path) {
+    if (!ctx || !path) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    thingino_trace_close(ctx);
+
+    usb_trace_t* trace = (usb_trace_t*)malloc(sizeof(usb_trace_t));
+    if (!trace) {
+        return THINGINO_ERROR_MEMORY;
+    }
+    if (usb_trace_open(trace, path) != 0) {
+        thingino_printf("[ERROR] Cannot create trace %s\n", path);
+        free(trace);
+        return THINGINO_ERROR_FILE_IO;
+    }
+    ctx->trace = trace;
+    return THINGINO_SUCCESS;
+}
+
+void thingino_trace_close(thingino_context_t* ctx) {
+    if (!ctx || !ctx->trace) {
+        return;
+    }
+    if (usb_trace_close(ctx->trace) != 0) {
+        thingino_printf("[WARN] Transfer trace is incomplete (write failed)\n");
+    }
+    free(ctx->trace);
+    ctx->trace = NULL;
+}
+
+static usb_trace_t* trace_current(void) {
+    thingino_context_t* ctx = thingino_context_current();
+    return ctx ? ctx->trace : NULL;
+}
+
+uint64_t thingino_trace_start(void) {
+    if (!trace_current()) {
+        return 0;
+    }
+    uint64_t now = thingino_clock_now_us();
+    return now ? now : 1;
+}
+
+// libusb result -> usbmon URB status
+static int32_t trace_status(int result) {
+    switch (result) {
+        case LIBUSB_SUCCESS:            return USB_TRACE_STATUS_OK;
+        case LIBUSB_ERROR_PIPE:         return USB_TRACE_STATUS_PIPE;
+        case LIBUSB_ERROR_NO_DEVICE:    return USB_TRACE_STATUS_NODEV;
+        case LIBUSB_ERROR_TIMEOUT:      return USB_TRACE_STATUS_TIMEOUT;
+        case LIBUSB_ERROR_OVERFLOW:     return USB_TRACE_STATUS_OVERFLOW;
+        case LIBUSB_ERROR_INTERRUPTED:  return USB_TRACE_STATUS_UNLINKED;
+        default:                        return USB_TRACE_STATUS_PROTO;
+    }
+}
+
+static void trace_fill_device(usb_capture_transfer_t* t, const usb_device_t* device,
+                              uint64_t start_us) {
+    memset(t, 0, sizeof(*t));
+    t->submit_us = start_us;
+    t->complete_us = thingino_clock_now_us();
+    if (t->complete_us < start_us) {
+        t->complete_us = start_us;
+    }
+    t->bus = device->info.bus;
+    t->device = device->info.address;
+}
+
+void thingino_trace_control(const usb_device_t* device, uint64_t start_us, uint8_t request_type,
+                            uint8_t request, uint16_t value, uint16_t index, const uint8_t* data,
+                            uint16_t length, int result) {
+    usb_trace_t* trace;
+    if (!start_us || !device || !(trace = trace_current())) {
+        return;
+    }
+
+    usb_capture_transfer_t t;
+    trace_fill_device(&t, device, start_us);
+    t.type = USB_CAPTURE_XFER_CONTROL;
+    t.endpoint = request_type & 0x80;
+    t.has_setup = true;
+    t.request_type = request_type;
+    t.request = request;
+    t.value = value;
+    t.index = index;
+    t.length = length;
+    t.requested = length;
+    t.status = trace_status(result < 0 ? result : LIBUSB_SUCCESS);
+    t.actual = result > 0 ? (uint32_t)result : 0;
+    t.data = data;
+    t.data_len = (request_type & 0x80) ? t.actual : length;
+    usb_trace_record(trace, &t);
+}
+
+void thingino_trace_bulk(const usb_device_t* device, uint64_t start_us, uint8_t endpoint,
+                         const uint8_t* data, int length, int transferred, int result) {
+    usb_trace_t* trace;
+    if (!start_us || !device || !(trace = trace_current())) {
+        return;
+    }
+
+    usb_capture_transfer_t t;
+    trace_fill_device(&t, device, start_us);
+    t.type = USB_CAPTURE_XFER_BULK;
+    t.endpoint = endpoint;
+    t.status = trace_status(result);
+    t.requested = length > 0 ? (uint32_t)length : 0;
+    t.actual = transferred > 0 ? (uint32_t)transferred : 0;
+    t.data = data;
+    t.data_len = (endpoint & 0x80) ? t.actual : t.requested;
+    usb_trace_record(trace, &t);
+}
+
+// Async transfer status -> the libusb code a synchronous call would return
+static int trace_transfer_result(const struct libusb_transfer* xfer) {
+    switch (xfer->status) {
+        case LIBUSB_TRANSFER_COMPLETED: return LIBUSB_SUCCESS;
+        case LIBUSB_TRANSFER_TIMED_OUT: return LIBUSB_ERROR_TIMEOUT;
+        case LIBUSB_TRANSFER_CANCELLED: return LIBUSB_ERROR_INTERRUPTED;
+        case LIBUSB_TRANSFER_STALL:     return LIBUSB_ERROR_PIPE;
+        case LIBUSB_TRANSFER_NO_DEVICE: return LIBUSB_ERROR_NO_DEVICE;
+        case LIBUSB_TRANSFER_OVERFLOW:  return LIBUSB_ERROR_OVERFLOW;
+        default:                        return LIBUSB_ERROR_IO;
+    }
+}
+
+void thingino_trace_transfer(const usb_device_t* device, uint64_t start_us,
+                             struct libusb_transfer* xfer) {
+    if (!start_us || !xfer) {
+        return;
+    }
+
+    int result = trace_transfer_result(xfer);
+    if (xfer->type != LIBUSB_TRANSFER_TYPE_CONTROL) {
+        thingino_trace_bulk(device, start_us, xfer->endpoint, xfer->buffer, xfer->length,
+                            xfer->actual_length, result);
+        return;
+    }
+
+    const struct libusb_control_setup* setup = libusb_control_transfer_get_setup(xfer);
+    thingino_trace_control(device, start_us, setup->bmRequestType, setup->bRequest,
+                           libusb_le16_to_cpu(setup->wValue), libusb_le16_to_cpu(setup->wIndex),
+                           libusb_control_transfer_get_data(xfer),
+                           libusb_le16_to_cpu(setup->wLength),
+                           result == LIBUSB_SUCCESS ? xfer->actual_length : result);
+}
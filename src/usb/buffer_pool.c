@@ -0,0 +1,136 @@
+#include "thingino.h"
+
+// ============================================================================
+// TRANSFER BUFFER POOL
+// ============================================================================
+//
+// Fixed-size bulk transfer buffers allocated once per session instead of a
+// malloc/free pair per chunk. When libusb provides libusb_dev_mem_alloc()
+// (1.0.21+, Linux usbfs only at runtime) the buffers are mapped from the
+// kernel so bulk IN data lands in them without a bounce copy; otherwise a
+// plain malloc() buffer is used and behaviour is unchanged.
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+#define HAVE_LIBUSB_DEV_MEM 1
+#endif
+
+thingino_error_t usb_buffer_pool_init(usb_buffer_pool_t* pool, usb_device_t* device,
+                                      size_t buffer_size, int count) {
+    if (!pool || buffer_size == 0 || count <= 0 || count > USB_BUFFER_POOL_MAX) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->handle = device ? device->handle : NULL;
+    pool->buffer_size = buffer_size;
+
+    for (int i = 0; i < count; i++) {
+        uint8_t* buf = NULL;
+
+#ifdef HAVE_LIBUSB_DEV_MEM
+        if (pool->handle) {
+            buf = libusb_dev_mem_alloc(pool->handle, buffer_size);
+            pool->dma[i] = (buf != NULL);
+        }
+#endif
+        if (!buf) {
+            buf = (uint8_t*)malloc(buffer_size);
+        }
+        if (!buf) {
+            usb_buffer_pool_destroy(pool);
+            return THINGINO_ERROR_MEMORY;
+        }
+
+        pool->buffers[i] = buf;
+        pool->count = i + 1;
+    }
+
+    DEBUG_PRINT("Buffer pool: %d x %zu bytes (%s)\n", count, buffer_size,
+                pool->dma[0] ? "device memory" : "heap");
+    return THINGINO_SUCCESS;
+}
+
+uint8_t* usb_buffer_pool_acquire(usb_buffer_pool_t* pool) {
+    if (!pool) {
+        return NULL;
+    }
+
+    for (int i = 0; i < pool->count; i++) {
+        if (!pool->in_use[i]) {
+            pool->in_use[i] = true;
+            return pool->buffers[i];
+        }
+    }
+    return NULL;
+}
+
+void usb_buffer_pool_release(usb_buffer_pool_t* pool, uint8_t* buffer) {
+    if (!pool || !buffer) {
+        return;
+    }
+
+    for (int i = 0; i < pool->count; i++) {
+        if (pool->buffers[i] == buffer) {
+            pool->in_use[i] = false;
+            return;
+        }
+    }
+}
+
+// ============================================================================
+// DEVICE BANK BUFFER
+// ============================================================================
+//
+// Verify reads the flash back one bank at a time. The buffer for that lives
+// on the device, so a daemon session that verifies image after image on the
+// same burner allocates it once. A reopened handle gets a new one, since
+// device memory belongs to the handle it was mapped from.
+
+/**
+ * Buffer of at least size bytes for bank reads on device; one user at a time
+ *
+ * @return NULL if it cannot be allocated
+ */
+uint8_t* usb_device_bank_buffer(usb_device_t* device, size_t size) {
+    if (!device || size == 0) {
+        return NULL;
+    }
+
+    usb_buffer_pool_t* pool = &device->bank_pool;
+    if (pool->count > 0 && (pool->buffer_size < size || pool->handle != device->handle)) {
+        usb_buffer_pool_destroy(pool);
+    }
+    if (pool->count == 0 && usb_buffer_pool_init(pool, device, size, 1) != THINGINO_SUCCESS) {
+        return NULL;
+    }
+    return pool->buffers[0];
+}
+
+void usb_device_release_buffers(usb_device_t* device) {
+    if (device) {
+        usb_buffer_pool_destroy(&device->bank_pool);
+    }
+}
+
+void usb_buffer_pool_destroy(usb_buffer_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+
+    for (int i = 0; i < pool->count; i++) {
+        if (!pool->buffers[i]) {
+            continue;
+        }
+#ifdef HAVE_LIBUSB_DEV_MEM
+        if (pool->dma[i]) {
+            libusb_dev_mem_free(pool->handle, pool->buffers[i], pool->buffer_size);
+        } else
+#endif
+        {
+            free(pool->buffers[i]);
+        }
+        pool->buffers[i] = NULL;
+    }
+
+    pool->count = 0;
+}
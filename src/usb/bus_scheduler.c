@@ -0,0 +1,202 @@
+#include "thingino.h"
+#include <pthread.h>
+#include <time.h>
+
+// ============================================================================
+// BUS BANDWIDTH SCHEDULER
+// ============================================================================
+//
+// With many boards behind one root port, concurrent 1MB bulk phases split
+// the same 480 Mbit/s link while other boards sit in erase or DDR-init
+// waits with the bus idle. In multi-device modes (--station, --clone-from)
+// every large bulk transfer takes a slot in its bandwidth domain first:
+// the root port the device hangs off (every hub below it shares that
+// upstream link). A domain admits a fixed number of transfers at a time
+// (one by default) in FIFO order, so heavy phases queue up behind each
+// other and run back to back at full speed, while devices that are only
+// waiting on the burner hold no slot at all.
+//
+// A slot is held for one slice of a transfer (BUS_SCHED_SLICE_BYTES, at
+// most BUS_SCHED_SLICE_MS; see usb_device_bulk_raw), so a device that NAKs
+// while it programs gives the link up instead of sitting on it for its
+// whole transfer timeout.
+//
+// Small transfers (status, handshakes) bypass the scheduler; they are
+// latency-bound and holding them up would only stretch idle windows.
+
+#define BUS_SCHED_POLL_MS 100
+
+// A thread queued for a slot; lives on the waiting thread's stack
+typedef struct bus_waiter {
+    struct bus_waiter* next;
+} bus_waiter_t;
+
+typedef struct {
+    bool used;
+    uint8_t bus;
+    uint8_t root_port;          // 0 = port path unknown, whole bus
+    int active;                 // Transfers currently admitted
+    bus_waiter_t* queue;        // Oldest waiter first
+    uint64_t busy_since_ms;     // Start of the current busy period
+    bus_sched_stats_t stats;
+} bus_domain_t;
+
+static struct {
+    bool enabled;
+    int slots;
+    uint64_t start_ms;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bus_domain_t domains[BUS_SCHED_MAX_DOMAINS];
+} sched = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+/**
+ * Enable scheduling with the given number of concurrent heavy transfers per
+ * domain (0 disables it again). Call before the worker threads start.
+ */
+void bus_sched_configure(int slots_per_domain) {
+    pthread_mutex_lock(&sched.lock);
+    memset(sched.domains, 0, sizeof(sched.domains));
+    sched.slots = slots_per_domain;
+    sched.enabled = slots_per_domain > 0;
+    sched.start_ms = thingino_monotonic_ms();
+    pthread_mutex_unlock(&sched.lock);
+}
+
+static int bus_domain_find(uint8_t bus, uint8_t root_port) {
+    int free_index = -1;
+    for (int i = 0; i < BUS_SCHED_MAX_DOMAINS; i++) {
+        if (sched.domains[i].used) {
+            if (sched.domains[i].bus == bus && sched.domains[i].root_port == root_port) {
+                return i;
+            }
+        } else if (free_index < 0) {
+            free_index = i;
+        }
+    }
+
+    if (free_index >= 0) {
+        sched.domains[free_index].used = true;
+        sched.domains[free_index].bus = bus;
+        sched.domains[free_index].root_port = root_port;
+    }
+    return free_index;
+}
+
+static void bus_queue_remove(bus_domain_t* domain, bus_waiter_t* waiter) {
+    for (bus_waiter_t** link = &domain->queue; *link; link = &(*link)->next) {
+        if (*link == waiter) {
+            *link = waiter->next;
+            return;
+        }
+    }
+}
+
+// One poll tick on the condition variable (which times out against the
+// realtime clock)
+static void bus_sched_wait_tick(void) {
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += BUS_SCHED_POLL_MS * 1000000L;
+    if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&sched.cond, &sched.lock, &until);
+}
+
+/**
+ * Wait for a slot in the device's bandwidth domain. Waiting for the bus is
+ * not a hang, so it counts as progress for the device's watchdog; a
+ * cancelled job leaves the queue within one poll tick.
+ *
+ * @return token for bus_sched_release(), -1 if the transfer is not
+ *         scheduled, or BUS_SCHED_CANCELLED
+ */
+int bus_sched_acquire(const usb_device_t* device, uint32_t bytes) {
+    if (!sched.enabled || !device || bytes < BUS_SCHED_MIN_BYTES) {
+        return -1;
+    }
+
+    uint8_t root_port = device->info.port_depth ? device->info.port_path[0] : 0;
+    uint64_t queued_ms = thingino_monotonic_ms();
+
+    pthread_mutex_lock(&sched.lock);
+    int index = bus_domain_find(device->info.bus, root_port);
+    if (index < 0) {
+        pthread_mutex_unlock(&sched.lock);
+        return -1;  // Out of domains: run unscheduled rather than fail
+    }
+
+    bus_domain_t* domain = &sched.domains[index];
+    bus_waiter_t self = { NULL };
+    bus_waiter_t** link = &domain->queue;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = &self;
+
+    while (domain->queue != &self || domain->active >= sched.slots) {
+        if (thingino_cancel_check(device->cancel)) {
+            bus_queue_remove(domain, &self);
+            domain->stats.wait_ms += thingino_monotonic_ms() - queued_ms;
+            pthread_cond_broadcast(&sched.cond);
+            pthread_mutex_unlock(&sched.lock);
+            return BUS_SCHED_CANCELLED;
+        }
+        bus_sched_wait_tick();
+    }
+    domain->queue = self.next;
+    if (domain->active++ == 0) {
+        domain->busy_since_ms = thingino_monotonic_ms();
+    }
+    domain->stats.wait_ms += thingino_monotonic_ms() - queued_ms;
+    // Let the next waiter in if there is another free slot
+    pthread_cond_broadcast(&sched.cond);
+    pthread_mutex_unlock(&sched.lock);
+
+    return index;
+}
+
+void bus_sched_release(int token, uint32_t bytes) {
+    if (token < 0 || token >= BUS_SCHED_MAX_DOMAINS) {
+        return;
+    }
+
+    pthread_mutex_lock(&sched.lock);
+    bus_domain_t* domain = &sched.domains[token];
+    domain->stats.transfers++;
+    domain->stats.bytes += bytes;
+    if (--domain->active == 0) {
+        domain->stats.busy_ms += thingino_monotonic_ms() - domain->busy_since_ms;
+    }
+    pthread_cond_broadcast(&sched.cond);
+    pthread_mutex_unlock(&sched.lock);
+}
+
+/**
+ * Print per-domain utilisation since bus_sched_configure()
+ */
+void bus_sched_report(void) {
+    if (!sched.enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&sched.lock);
+    uint64_t wall_ms = thingino_monotonic_ms() - sched.start_ms;
+    thingino_printf("\nBus utilisation (%d transfer slot(s) per root port):\n", sched.slots);
+    for (int i = 0; i < BUS_SCHED_MAX_DOMAINS; i++) {
+        const bus_domain_t* d = &sched.domains[i];
+        if (!d->used || d->stats.transfers == 0) {
+            continue;
+        }
+        double mbps = d->stats.busy_ms ? (d->stats.bytes / 1048576.0) / (d->stats.busy_ms / 1000.0) : 0.0;
+        thingino_printf("  Bus %03d root port %u: %llu slots granted, %.1f MB, busy %.0f%%, %.2f MB/s while busy, "
+               "%.1f s queued\n",
+               d->bus, d->root_port, (unsigned long long)d->stats.transfers,
+               d->stats.bytes / 1048576.0,
+               wall_ms ? d->stats.busy_ms * 100.0 / wall_ms : 0.0, mbps,
+               d->stats.wait_ms / 1000.0);
+    }
+    pthread_mutex_unlock(&sched.lock);
+}
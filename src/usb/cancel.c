@@ -0,0 +1,111 @@
+#include "cancel.h"
+#include "platform_compat.h"
+
+#include <time.h>
+
+// ============================================================================
+// CANCELLATION TOKEN IMPLEMENTATION
+// ============================================================================
+//
+// The flag is read without the lock on hot paths; it only ever goes 0 -> 1.
+
+void thingino_cancel_init(thingino_cancel_t* token, uint32_t watchdog_ms) {
+    if (!token) {
+        return;
+    }
+    pthread_mutex_init(&token->lock, NULL);
+    pthread_cond_init(&token->cond, NULL);
+    token->cancelled = 0;
+    token->reason = NULL;
+    token->watchdog_ms = watchdog_ms;
+    token->last_progress_ms = thingino_monotonic_ms();
+}
+
+void thingino_cancel_destroy(thingino_cancel_t* token) {
+    if (!token) {
+        return;
+    }
+    pthread_cond_destroy(&token->cond);
+    pthread_mutex_destroy(&token->lock);
+}
+
+void thingino_cancel_request(thingino_cancel_t* token, const char* reason) {
+    if (!token) {
+        return;
+    }
+    pthread_mutex_lock(&token->lock);
+    if (!token->cancelled) {
+        token->reason = reason ? reason : "cancelled";
+        token->cancelled = 1;
+    }
+    pthread_cond_broadcast(&token->cond);
+    pthread_mutex_unlock(&token->lock);
+}
+
+void thingino_cancel_progress(thingino_cancel_t* token) {
+    if (!token) {
+        return;
+    }
+    pthread_mutex_lock(&token->lock);
+    token->last_progress_ms = thingino_monotonic_ms();
+    pthread_mutex_unlock(&token->lock);
+}
+
+bool thingino_cancel_check(thingino_cancel_t* token) {
+    if (!token) {
+        return false;
+    }
+    if (token->cancelled) {
+        return true;
+    }
+    if (token->watchdog_ms == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&token->lock);
+    uint64_t idle = thingino_monotonic_ms() - token->last_progress_ms;
+    pthread_mutex_unlock(&token->lock);
+
+    if (idle >= token->watchdog_ms) {
+        thingino_cancel_request(token, "watchdog: no progress");
+        return true;
+    }
+    return false;
+}
+
+bool thingino_cancel_sleep(thingino_cancel_t* token, uint32_t ms) {
+    if (!token) {
+        thingino_sleep_milliseconds(ms);
+        return false;
+    }
+
+    // Virtual time passes instantly: there is nothing to wake early from
+    if (thingino_clock_is_virtual()) {
+        if (thingino_cancel_check(token)) {
+            return true;
+        }
+        thingino_sleep_milliseconds(ms);
+        return false;
+    }
+
+    // Condition variables time out against the realtime clock
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += ms / 1000;
+    until.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&token->lock);
+    while (!token->cancelled) {
+        if (pthread_cond_timedwait(&token->cond, &token->lock, &until) != 0) {
+            break;  // Timed out (or spurious error): the sleep is over
+        }
+    }
+    bool cancelled = token->cancelled != 0;
+    pthread_mutex_unlock(&token->lock);
+
+    return cancelled;
+}
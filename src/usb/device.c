@@ -23,7 +23,7 @@ thingino_error_t usb_device_get_cpu_info(usb_device_t* device, cpu_info_t* info)
     DEBUG_PRINT("GetCPUInfo: Sending vendor request VR_GET_CPU_INFO (0x%02X)\n", VR_GET_CPU_INFO);
 
     // Direct control transfer without claiming interface first (like Go version)
-    int result = libusb_control_transfer(device->handle, REQUEST_TYPE_VENDOR,
+    int result = usb_device_control_raw(device, REQUEST_TYPE_VENDOR,
         VR_GET_CPU_INFO, 0, 0, data, 8, 5000);
 
     if (result < 0) {
@@ -111,6 +111,8 @@ thingino_error_t usb_device_get_cpu_info(usb_device_t* device, cpu_info_t* info)
         is_firmware_stage = true;
     }
 
+    thingino_job_note_cpu(device, clean_cpu_str);
+
     if (is_firmware_stage) {
         info->stage = STAGE_FIRMWARE;
         device->info.stage = STAGE_FIRMWARE;
@@ -153,10 +155,20 @@ thingino_error_t usb_device_init(usb_device_t* device, uint8_t bus, uint8_t addr
         return THINGINO_ERROR_DEVICE_NOT_FOUND;
     }
 
+    thingino_error_t result = usb_device_open_libusb(device, found_device);
+    libusb_free_device_list(devices, 1);
+    return result;
+}
+
+// Open an already-located libusb device (e.g. from the manager's snapshot)
+thingino_error_t usb_device_open_libusb(usb_device_t* device, libusb_device* found_device) {
+    if (!device || !found_device) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
     // Open the device
     int result = libusb_open(found_device, &device->handle);
     if (result != LIBUSB_SUCCESS) {
-        libusb_free_device_list(devices, 1);
         return THINGINO_ERROR_OPEN_FAILED;
     }
 
@@ -165,7 +177,6 @@ thingino_error_t usb_device_init(usb_device_t* device, uint8_t bus, uint8_t addr
     result = libusb_get_device_descriptor(found_device, &desc);
     if (result != LIBUSB_SUCCESS) {
         libusb_close(device->handle);
-        libusb_free_device_list(devices, 1);
         return THINGINO_ERROR_OPEN_FAILED;
     }
 
@@ -175,30 +186,61 @@ thingino_error_t usb_device_init(usb_device_t* device, uint8_t bus, uint8_t addr
     // (context is set before usb_device_init is called by the manager)
     // DEBUG_PRINT("usb_device_init: context before init = %p\n", device->context);
     device->closed = false;
-    device->info.bus = bus;
-    device->info.address = address;
+    device->deadline_ms = 0;
+    device->cancel = NULL;
+    device->event_phase_ms = 0;
+    device->event_last_ms = 0;
+    device->transport = NULL;
+    device->transport_data = NULL;
+    memset(&device->bank_pool, 0, sizeof(device->bank_pool));
+    burner_log_init(&device->burner_log);
+    device->info.bus = libusb_get_bus_number(found_device);
+    device->info.address = libusb_get_device_address(found_device);
     device->info.vendor = desc.idVendor;
     device->info.product = desc.idProduct;
+    usb_port_path_fill(found_device, &device->info);
     // IMPORTANT: Do NOT override device->info.stage here; it is set by the manager
     // based on CPU magic (bootrom vs firmware stage).
     // Don't set default variant - preserve whatever was set by manager
     DEBUG_PRINT("usb_device_init: preserving variant %d, stage=%d, context=%p\n",
                 device->info.variant, device->info.stage, device->context);
 
-    libusb_free_device_list(devices, 1);
-
     DEBUG_PRINT("Device initialized: VID:0x%04X, PID:0x%04X, Bus:%d, Addr:%d\n",
-        device->info.vendor, device->info.product, bus, address);
+        device->info.vendor, device->info.product, device->info.bus, device->info.address);
 
     return THINGINO_SUCCESS;
 }
 
+/**
+ * Open a device that talks through transport instead of libusb
+ *
+ * @param info Identity to report (VID/PID, bus, port, stage, variant)
+ */
+thingino_error_t usb_device_open_transport(usb_device_t* device, const usb_transport_t* transport,
+    void* transport_data, const device_info_t* info) {
+    if (!device || !transport || !transport->control || !transport->bulk || !info) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(device, 0, sizeof(*device));
+    device->info = *info;
+    device->transport = transport;
+    device->transport_data = transport_data;
+    burner_log_init(&device->burner_log);
+    return THINGINO_SUCCESS;
+}
+
+bool usb_device_is_open(const usb_device_t* device) {
+    return device && !device->closed && (device->handle || device->transport);
+}
+
 // Close USB device
 thingino_error_t usb_device_close(usb_device_t* device) {
     if (!device) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
+    usb_device_release_buffers(device);
     if (!device->closed && device->handle) {
         libusb_close(device->handle);
         device->handle = NULL;
@@ -217,37 +259,83 @@ thingino_error_t usb_device_reopen(usb_device_t* device) {
     DEBUG_PRINT("usb_device_reopen: attempting to reopen device VID:0x%04X PID:0x%04X (old bus=%d addr=%d)\n",
         device->info.vendor, device->info.product, device->info.bus, device->info.address);
 
+    // A transport keeps its identity across re-enumeration
+    if (device->transport) {
+        int result = device->transport->reopen ? device->transport->reopen(device->transport_data)
+                                               : LIBUSB_SUCCESS;
+        if (result != LIBUSB_SUCCESS) {
+            DEBUG_PRINT("usb_device_reopen: %s transport: %s\n", device->transport->name,
+                libusb_error_name(result));
+            device->closed = true;
+            return THINGINO_ERROR_DEVICE_NOT_FOUND;
+        }
+        device->closed = false;
+        burner_log_init(&device->burner_log);
+        return THINGINO_SUCCESS;
+    }
+
     // Close existing handle if still open
+    usb_device_release_buffers(device);
     if (!device->closed && device->handle) {
         libusb_close(device->handle);
         device->handle = NULL;
     }
     device->closed = true;
 
-    // Enumerate devices on the same libusb context (if available)
+    // Look for the device on the port it was on; if it has not come back
+    // yet, wait for its arrival instead of failing on the first scan
+    uint64_t deadline = thingino_monotonic_ms() + REOPEN_TIMEOUT_MS;
     libusb_device** list = NULL;
-    ssize_t count = libusb_get_device_list(device->context, &list);
-    if (count < 0) {
-        DEBUG_PRINT("usb_device_reopen: libusb_get_device_list failed: %zd\n", count);
-        return THINGINO_ERROR_DEVICE_NOT_FOUND;
-    }
-
     libusb_device* found = NULL;
     uint8_t new_bus = 0;
     uint8_t new_addr = 0;
 
-    for (ssize_t i = 0; i < count; i++) {
-        struct libusb_device_descriptor desc;
-        if (libusb_get_device_descriptor(list[i], &desc) != LIBUSB_SUCCESS) {
-            continue;
+    for (;;) {
+        ssize_t count = libusb_get_device_list(device->context, &list);
+        if (count < 0) {
+            DEBUG_PRINT("usb_device_reopen: libusb_get_device_list failed: %zd\n", count);
+            return THINGINO_ERROR_DEVICE_NOT_FOUND;
         }
 
-        if (desc.idVendor == device->info.vendor && desc.idProduct == device->info.product) {
+        for (ssize_t i = 0; i < count; i++) {
+            struct libusb_device_descriptor desc;
+            if (libusb_get_device_descriptor(list[i], &desc) != LIBUSB_SUCCESS) {
+                continue;
+            }
+            if (desc.idVendor != device->info.vendor || desc.idProduct != device->info.product) {
+                continue;
+            }
+
+            // A neighbouring board with the same VID/PID is not this device
+            device_info_t candidate = device->info;
+            candidate.bus = libusb_get_bus_number(list[i]);
+            usb_port_path_fill(list[i], &candidate);
+            if (!usb_device_info_may_share_port(&candidate, &device->info)) {
+                continue;
+            }
+
             found = list[i];
-            new_bus = libusb_get_bus_number(found);
+            new_bus = candidate.bus;
             new_addr = libusb_get_device_address(found);
             break;
         }
+
+        uint64_t now = thingino_monotonic_ms();
+        if (found || now >= deadline) {
+            break;
+        }
+
+        libusb_free_device_list(list, 1);
+        list = NULL;
+
+        device_info_t arrived;
+        if (usb_wait_for_arrival(device->context, &device->info, (int)(deadline - now),
+                                 &arrived) != THINGINO_SUCCESS) {
+            DEBUG_PRINT("usb_device_reopen: no arrival before deadline\n");
+            return THINGINO_ERROR_DEVICE_NOT_FOUND;
+        }
+        // Let udev apply permissions before the open
+        thingino_sleep_milliseconds(50);
     }
 
     if (!found) {
@@ -267,6 +355,8 @@ thingino_error_t usb_device_reopen(usb_device_t* device) {
     device->info.bus = new_bus;
     device->info.address = new_addr;
     device->closed = false;
+    // Log stream restarts with the new burner instance
+    burner_log_init(&device->burner_log);
 
     libusb_free_device_list(list, 1);
 
@@ -279,10 +369,14 @@ thingino_error_t usb_device_reopen(usb_device_t* device) {
 
 // Reset USB device
 thingino_error_t usb_device_reset(usb_device_t* device) {
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
+    if (device->transport) {
+        return usb_device_reopen(device);
+    }
+
     int result = libusb_reset_device(device->handle);
     if (result != LIBUSB_SUCCESS) {
         DEBUG_PRINT("Reset device failed: %s\n", libusb_error_name(result));
@@ -294,10 +388,14 @@ thingino_error_t usb_device_reset(usb_device_t* device) {
 
 // Claim USB interface
 thingino_error_t usb_device_claim_interface(usb_device_t* device) {
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
+    if (device->transport) {
+        return THINGINO_SUCCESS;
+    }
+
     int result = libusb_claim_interface(device->handle, 0);
     if (result != LIBUSB_SUCCESS) {
         DEBUG_PRINT("Claim interface failed: %s\n", libusb_error_name(result));
@@ -309,10 +407,14 @@ thingino_error_t usb_device_claim_interface(usb_device_t* device) {
 
 // Release USB interface
 thingino_error_t usb_device_release_interface(usb_device_t* device) {
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
+    if (device->transport) {
+        return THINGINO_SUCCESS;
+    }
+
     int result = libusb_release_interface(device->handle, 0);
     if (result != LIBUSB_SUCCESS) {
         DEBUG_PRINT("Release interface failed: %s\n", libusb_error_name(result));
@@ -326,11 +428,11 @@ thingino_error_t usb_device_release_interface(usb_device_t* device) {
 thingino_error_t usb_device_control_transfer(usb_device_t* device, uint8_t request_type,
     uint8_t request, uint16_t value, uint16_t index, uint8_t* data, uint16_t length, int* transferred) {
 
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    int result = libusb_control_transfer(device->handle, request_type, request, value, index, data, length, 5000);
+    int result = usb_device_control_raw(device, request_type, request, value, index, data, length, 5000);
 
     if (result < 0) {
         DEBUG_PRINT("Control transfer failed: %s\n", libusb_error_name(result));
@@ -344,6 +446,24 @@ thingino_error_t usb_device_control_transfer(usb_device_t* device, uint8_t reque
     return THINGINO_SUCCESS;
 }
 
+/**
+ * One control transfer on the device's transport or libusb handle
+ *
+ * @return bytes transferred, or a libusb error code
+ */
+int usb_device_control_raw(usb_device_t* device, uint8_t request_type, uint8_t request,
+    uint16_t value, uint16_t index, uint8_t* data, uint16_t length, unsigned int timeout) {
+    uint64_t trace_start = thingino_trace_start();
+    int result = device->transport
+        ? device->transport->control(device->transport_data, request_type, request, value,
+                                     index, data, length, timeout)
+        : libusb_control_transfer(device->handle, request_type, request, value, index, data,
+                                  length, timeout);
+    thingino_trace_control(device, trace_start, request_type, request, value, index, data,
+                           length, result);
+    return result;
+}
+
 // Helper to get current time in milliseconds
 #ifndef _WIN32
 #endif
@@ -352,13 +472,192 @@ thingino_error_t usb_device_control_transfer(usb_device_t* device, uint8_t reque
 
 // Direct ioctl removed - protocol requires synchronous libusb transfers per trace file
 
+// ============================================================================
+// CANCELLABLE BULK TRANSFERS
+// ============================================================================
+//
+// Without a cancel token this is libusb_bulk_transfer(). With one, the
+// transfer is submitted asynchronously and events are pumped in short
+// ticks so a cancellation (or the token's watchdog) can abort it with
+// libusb_cancel_transfer() instead of waiting out its timeout. Callers
+// keep synchronous semantics either way. Large transfers also take their
+// bus scheduler slots here, a slice at a time.
+
+#define CANCEL_POLL_INTERVAL_MS 100
+
+static void LIBUSB_CALL bulk_raw_complete(struct libusb_transfer* xfer) {
+    *(int*)xfer->user_data = 1;
+}
+
+static int bulk_raw_status_to_error(enum libusb_transfer_status status) {
+    switch (status) {
+        case LIBUSB_TRANSFER_COMPLETED: return LIBUSB_SUCCESS;
+        case LIBUSB_TRANSFER_TIMED_OUT: return LIBUSB_ERROR_TIMEOUT;
+        case LIBUSB_TRANSFER_CANCELLED: return LIBUSB_ERROR_INTERRUPTED;
+        case LIBUSB_TRANSFER_STALL:     return LIBUSB_ERROR_PIPE;
+        case LIBUSB_TRANSFER_NO_DEVICE: return LIBUSB_ERROR_NO_DEVICE;
+        case LIBUSB_TRANSFER_OVERFLOW:  return LIBUSB_ERROR_OVERFLOW;
+        default:                        return LIBUSB_ERROR_IO;
+    }
+}
+
+static int bulk_raw_cancellable(usb_device_t* device, uint8_t endpoint, uint8_t* data,
+                                int length, int* transferred, unsigned int timeout) {
+    struct libusb_transfer* xfer = libusb_alloc_transfer(0);
+    if (!xfer) {
+        return LIBUSB_ERROR_NO_MEM;
+    }
+
+    int done = 0;
+    libusb_fill_bulk_transfer(xfer, device->handle, endpoint, data, length,
+                              bulk_raw_complete, &done, timeout);
+    int result = libusb_submit_transfer(xfer);
+    if (result != LIBUSB_SUCCESS) {
+        libusb_free_transfer(xfer);
+        return result;
+    }
+
+    bool cancelling = false;
+    while (!done) {
+        struct timeval tv = { 0, CANCEL_POLL_INTERVAL_MS * 1000 };
+        libusb_handle_events_timeout_completed(device->context, &tv, &done);
+        if (!done && !cancelling && thingino_cancel_check(device->cancel)) {
+            libusb_cancel_transfer(xfer);
+            cancelling = true;
+        }
+    }
+
+    *transferred = xfer->actual_length;
+    result = bulk_raw_status_to_error(xfer->status);
+    libusb_free_transfer(xfer);
+    return result;
+}
+
+// One transfer on whichever path the device has
+static int bulk_raw_once(usb_device_t* device, uint8_t endpoint, uint8_t* data,
+                         int length, int* transferred, unsigned int timeout) {
+    uint64_t trace_start = thingino_trace_start();
+    int result;
+    if (device->transport) {
+        result = device->transport->bulk(device->transport_data, endpoint, data, length,
+                                         transferred, timeout);
+    } else if (device->cancel && device->context) {
+        result = bulk_raw_cancellable(device, endpoint, data, length, transferred, timeout);
+    } else {
+        result = libusb_bulk_transfer(device->handle, endpoint, data, length, transferred, timeout);
+    }
+    thingino_trace_bulk(device, trace_start, endpoint, data, length, *transferred, result);
+    return result;
+}
+
+// A scheduled transfer, one bus slot per slice. Slices are multiples of the
+// max packet size, so the device sees the same packet stream as one long
+// transfer. A slice that times out (the device NAKs while it programs)
+// hands the slot on and queues again until the caller's timeout runs out.
+static int bulk_raw_sliced(usb_device_t* device, int token, uint8_t endpoint, uint8_t* data,
+                           int length, int* transferred, unsigned int timeout) {
+    uint64_t deadline = timeout ? thingino_monotonic_ms() + timeout : 0;
+    int result = LIBUSB_SUCCESS;
+
+    while (*transferred < length) {
+        if (token < 0) {
+            token = bus_sched_acquire(device, (uint32_t)(length - *transferred));
+            if (token == BUS_SCHED_CANCELLED) {
+                return LIBUSB_ERROR_INTERRUPTED;
+            }
+        }
+
+        int slice = length - *transferred;
+        if (slice > BUS_SCHED_SLICE_BYTES) {
+            slice = BUS_SCHED_SLICE_BYTES;
+        }
+        unsigned int slice_timeout = BUS_SCHED_SLICE_MS;
+        if (deadline) {
+            uint64_t now = thingino_monotonic_ms();
+            if (now >= deadline) {
+                bus_sched_release(token, 0);
+                return LIBUSB_ERROR_TIMEOUT;
+            }
+            if (deadline - now < slice_timeout) {
+                slice_timeout = (unsigned int)(deadline - now);
+            }
+        }
+
+        int moved = 0;
+        result = bulk_raw_once(device, endpoint, data + *transferred, slice, &moved, slice_timeout);
+        *transferred += moved;
+        bus_sched_release(token, (uint32_t)moved);
+        token = -1;
+
+        if (moved > 0) {
+            thingino_cancel_progress(device->cancel);
+        }
+        if (result == LIBUSB_ERROR_TIMEOUT && !thingino_cancel_check(device->cancel) &&
+            (!deadline || thingino_monotonic_ms() < deadline)) {
+            continue;
+        }
+        if (result != LIBUSB_SUCCESS || moved < slice) {
+            break;  // Failed, or a short packet ended the transfer
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Synchronous bulk transfer honouring the device's cancel token. In
+ * multi-device modes large transfers also take bus scheduler slots: on
+ * libusb one per slice, so a stalled device cannot hold its port; a
+ * transport models whole transfers and takes one slot for all of it.
+ *
+ * @return a libusb error code; LIBUSB_ERROR_INTERRUPTED if cancelled
+ */
+int usb_device_bulk_raw(usb_device_t* device, uint8_t endpoint, uint8_t* data,
+                        int length, int* transferred, unsigned int timeout) {
+    int done_bytes = 0;
+    if (!transferred) {
+        transferred = &done_bytes;
+    }
+    *transferred = 0;
+
+    if (thingino_cancel_check(device->cancel)) {
+        return LIBUSB_ERROR_INTERRUPTED;
+    }
+
+    int token = bus_sched_acquire(device, (uint32_t)length);
+    if (token == BUS_SCHED_CANCELLED) {
+        return LIBUSB_ERROR_INTERRUPTED;
+    }
+    if (token >= 0 && !device->transport) {
+        return bulk_raw_sliced(device, token, endpoint, data, length, transferred, timeout);
+    }
+
+    int result = bulk_raw_once(device, endpoint, data, length, transferred, timeout);
+    bus_sched_release(token, (uint32_t)*transferred);
+
+    if (*transferred > 0) {
+        thingino_cancel_progress(device->cancel);
+    }
+    return result;
+}
+
+/**
+ * Sleep that ends early when the device's job is cancelled
+ */
+thingino_error_t usb_device_sleep(usb_device_t* device, uint32_t ms) {
+    if (thingino_cancel_sleep(device ? device->cancel : NULL, ms)) {
+        return THINGINO_ERROR_CANCELLED;
+    }
+    return THINGINO_SUCCESS;
+}
+
 // Bulk transfer with timeout parameter
 // According to the trace file, protocol requires successful transfer
 // Fail immediately if transfer doesn't succeed
 thingino_error_t usb_device_bulk_transfer(usb_device_t* device, uint8_t endpoint,
     uint8_t* data, int length, int* transferred, int timeout) {
 
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -368,8 +667,7 @@ thingino_error_t usb_device_bulk_transfer(usb_device_t* device, uint8_t endpoint
     DEBUG_PRINT("Bulk transfer: %s %d bytes, timeout=%dms, endpoint=0x%02X\n",
         direction, length, timeout, endpoint);
 
-    // Use libusb for bulk transfer
-    int result = libusb_bulk_transfer(device->handle, endpoint, data, length, transferred, timeout);
+    int result = usb_device_bulk_raw(device, endpoint, data, length, transferred, timeout);
 
     if (result == LIBUSB_SUCCESS) {
         DEBUG_PRINT("Bulk transfer success: %d bytes transferred\n", transferred ? *transferred : -1);
@@ -394,7 +692,14 @@ thingino_error_t usb_device_bulk_transfer(usb_device_t* device, uint8_t endpoint
         return THINGINO_ERROR_TIMEOUT;
     }
 
-    printf("[ERROR] Bulk transfer failed: %s (endpoint=0x%02X, length=%d, timeout=%dms, transferred=%d)\n",
+    if (result == LIBUSB_ERROR_INTERRUPTED) {
+        // libusb may report INTERRUPTED on its own, without a token
+        DEBUG_PRINT("Bulk transfer (%s) cancelled: %s\n", direction,
+                    device->cancel ? device->cancel->reason : "interrupted");
+        return THINGINO_ERROR_CANCELLED;
+    }
+
+    thingino_printf("[ERROR] Bulk transfer failed: %s (endpoint=0x%02X, length=%d, timeout=%dms, transferred=%d)\n",
            libusb_error_name(result), endpoint, length, timeout,
            transferred ? *transferred : -1);
     return THINGINO_ERROR_TRANSFER_FAILED;
@@ -405,7 +710,7 @@ thingino_error_t usb_device_bulk_transfer(usb_device_t* device, uint8_t endpoint
 thingino_error_t usb_device_interrupt_transfer(usb_device_t* device, uint8_t endpoint,
     uint8_t* data, int length, int* transferred, int timeout) {
 
-    if (!device || !device->handle || device->closed) {
+    if (!usb_device_is_open(device)) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -415,9 +720,13 @@ thingino_error_t usb_device_interrupt_transfer(usb_device_t* device, uint8_t end
     DEBUG_PRINT("Interrupt transfer: %s %d bytes, timeout=%dms, endpoint=0x%02X\n",
         direction, length, timeout, endpoint);
 
-    // Use libusb interrupt transfer
-    int result = libusb_interrupt_transfer(device->handle, endpoint, data, length,
-                                          transferred, timeout);
+    // Use libusb interrupt transfer (a transport has one kind of data pipe)
+    uint64_t trace_start = thingino_trace_start();
+    int result = device->transport
+        ? device->transport->bulk(device->transport_data, endpoint, data, length, transferred,
+                                  (unsigned int)timeout)
+        : libusb_interrupt_transfer(device->handle, endpoint, data, length, transferred, timeout);
+    thingino_trace_bulk(device, trace_start, endpoint, data, length, *transferred, result);
 
     if (result == LIBUSB_SUCCESS) {
         DEBUG_PRINT("Interrupt transfer success (%s): %d bytes transferred\n",
@@ -436,124 +745,130 @@ thingino_error_t usb_device_interrupt_transfer(usb_device_t* device, uint8_t end
     return THINGINO_ERROR_TRANSFER_FAILED;
 }
 
-// Vendor request with retry logic for device re-enumeration
-thingino_error_t usb_device_vendor_request(usb_device_t* device, uint8_t request_type,
-    uint8_t request, uint16_t value, uint16_t index, uint8_t* data, uint16_t length, uint8_t* response, int* response_length) {
-
-    if (!device || !device->handle || device->closed) {
-        return THINGINO_ERROR_INVALID_PARAMETER;
+// ============================================================================
+// VENDOR REQUESTS AND RETRY BUDGETS
+// ============================================================================
+
+/**
+ * Bound every vendor request issued on device for the next budget_ms.
+ * Budgets nest: an inner one never extends an outer deadline.
+ *
+ * @return the previous deadline, to hand back to usb_device_budget_end()
+ */
+uint64_t usb_device_budget_begin(usb_device_t* device, uint32_t budget_ms) {
+    if (!device) {
+        return 0;
     }
 
-    // Special handling for firmware-stage VR_WRITE (0x12) handshakes.
-    // On some T31x devices the control transfer for VR_WRITE may time out
-    // even though the device has accepted the 40-byte handshake and will
-    // process the subsequent bulk-out chunk. To avoid spamming multiple
-    // identical VR_WRITE requests (which diverges from the vendor trace),
-    // send it once and treat a timeout as success.
-    if (request_type == REQUEST_TYPE_OUT && request == VR_WRITE &&
-        device->info.stage == STAGE_FIRMWARE) {
+    uint64_t saved = device->deadline_ms;
+    uint64_t deadline = thingino_monotonic_ms() + budget_ms;
+    if (saved == 0 || deadline < saved) {
+        device->deadline_ms = deadline;
+    }
+    return saved;
+}
 
-        uint8_t* buffer = response ? response : data;
-        int result = libusb_control_transfer(device->handle, request_type, request,
-                                             value, index, buffer, length, 5000);
+void usb_device_budget_end(usb_device_t* device, uint64_t saved_deadline) {
+    if (device) {
+        device->deadline_ms = saved_deadline;
+    }
+}
 
-        if (result >= 0) {
-            if (response_length) {
-                *response_length = result;
-            }
-            return THINGINO_SUCCESS;
+/**
+ * Pick the retry policy for a request. Firmware-stage VR_WRITE and
+ * VR_SET_DATA_ADDR may time out although the burner accepted them (it is
+ * busy programming or erasing), so a timeout there is success, not a retry.
+ */
+const retry_policy_t* usb_vendor_request_policy_for(const usb_device_t* device,
+    uint8_t request_type, uint8_t request) {
+    if (device && device->info.stage == STAGE_FIRMWARE && request_type == REQUEST_TYPE_OUT) {
+        if (request == VR_WRITE) {
+            return &retry_policy_fw_handshake;
         }
-
-        if (result == LIBUSB_ERROR_TIMEOUT) {
-            DEBUG_PRINT("Vendor request VR_WRITE timed out; assuming device is still processing handshake (treating as success)\n");
-            if (response_length) {
-                *response_length = 0;
-            }
-            return THINGINO_SUCCESS;
+        if (request == VR_SET_DATA_ADDR) {
+            return &retry_policy_fw_set_addr;
         }
-
-        DEBUG_PRINT("Vendor request VR_WRITE failed: %s\n", libusb_error_name(result));
-        return THINGINO_ERROR_TRANSFER_FAILED;
     }
+    return &retry_policy_control;
+}
 
-    // Special handling for firmware-stage VR_SET_DATA_ADDR (0x01) during NOR
-    // writer_full operations. When the cloner starts a full-image burn with
-    // force_erase enabled, the first SetDataAddress/SetDataLength pair
-    // triggers a full chip erase. While the erase is in progress the
-    // firmware often stops responding to control transfers on the same
-    // endpoint and libusb reports timeouts, even though the command has
-    // been accepted and the erase is progressing.
-    //
-    // To avoid aborting the write with "Failed to set flash base address"
-    // in this situation, treat a timeout on VR_SET_DATA_ADDR in firmware
-    // stage as "device busy but OK" and let subsequent operations (status
-    // checks, handshakes, data transfers) detect any real failures.
-    if (request_type == REQUEST_TYPE_OUT && request == VR_SET_DATA_ADDR &&
-        device->info.stage == STAGE_FIRMWARE) {
-
-        uint8_t* buffer = response ? response : data;
-        int result = libusb_control_transfer(device->handle, request_type, request,
-                                             value, index, buffer, length, 5000);
-
-        if (result >= 0) {
-            if (response_length) {
-                *response_length = result;
-            }
-            return THINGINO_SUCCESS;
-        }
+static uint32_t vendor_request_error_class(int libusb_result) {
+    switch (libusb_result) {
+        case LIBUSB_ERROR_TIMEOUT:   return RETRY_ERR_TIMEOUT;
+        case LIBUSB_ERROR_PIPE:      return RETRY_ERR_PIPE;
+        case LIBUSB_ERROR_NO_DEVICE: return RETRY_ERR_NO_DEVICE;
+        default:                     return RETRY_ERR_OTHER;
+    }
+}
 
-        if (result == LIBUSB_ERROR_TIMEOUT) {
-            DEBUG_PRINT("Vendor request VR_SET_DATA_ADDR timed out in firmware stage; "
-                        "assuming device is busy (chip erase in progress) and treating as success\n");
-            if (response_length) {
-                *response_length = 0;
-            }
-            return THINGINO_SUCCESS;
-        }
+thingino_error_t usb_device_vendor_request_policy(usb_device_t* device, const retry_policy_t* policy,
+    uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, uint8_t* data,
+    uint16_t length, uint8_t* response, int* response_length) {
 
-        DEBUG_PRINT("Vendor request VR_SET_DATA_ADDR failed: %s\n", libusb_error_name(result));
-        return THINGINO_ERROR_TRANSFER_FAILED;
+    if (!usb_device_is_open(device) || !policy) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
-    // Retry logic for device re-enumeration issues
-    int max_retries = 5;
-    int retry_count = 0;
-    int retry_delays[] = {500000, 1000000, 2000000, 3000000, 5000000};  // microseconds: 0.5s, 1s, 2s, 3s, 5s
+    uint8_t* buffer = response ? response : data;
+    retry_state_t state;
+    retry_begin(&state, policy, thingino_monotonic_ms(), device->deadline_ms);
 
-    while (retry_count < max_retries) {
-        uint8_t* buffer = response ? response : data;
-        int result = libusb_control_transfer(device->handle, request_type, request, value, index,
-            buffer, length, 5000);
+    for (;;) {
+        if (thingino_cancel_check(device->cancel)) {
+            DEBUG_PRINT("Vendor request 0x%02X cancelled: %s\n", request, device->cancel->reason);
+            return THINGINO_ERROR_CANCELLED;
+        }
 
+        uint32_t timeout = retry_attempt_timeout(&state, thingino_monotonic_ms());
+        if (timeout == 0) {
+            DEBUG_PRINT("Vendor request 0x%02X: %s budget spent after %u attempt(s)\n",
+                request, policy->name, state.attempts);
+            return state.attempts == 0 ? THINGINO_ERROR_TIMEOUT : THINGINO_ERROR_TRANSFER_FAILED;
+        }
+
+        int result = usb_device_control_raw(device, request_type, request, value, index,
+            buffer, length, timeout);
         if (result >= 0) {
-            // Success
             if (response_length) {
                 *response_length = result;
             }
+            thingino_cancel_progress(device->cancel);
             return THINGINO_SUCCESS;
         }
 
-        // Check if this is a timeout or pipe error (device disconnected)
-        if (result == LIBUSB_ERROR_TIMEOUT || result == LIBUSB_ERROR_PIPE || result == LIBUSB_ERROR_NO_DEVICE) {
-            retry_count++;
-            if (retry_count < max_retries) {
-                DEBUG_PRINT("Vendor request failed with %s, retrying in %d ms (attempt %d/%d)...\n",
-                    libusb_error_name(result), retry_delays[retry_count-1]/1000, retry_count, max_retries);
-#ifdef _WIN32
-                Sleep(retry_delays[retry_count-1] / 1000);
-#else
-                usleep(retry_delays[retry_count-1]);
-#endif
-            } else {
-                DEBUG_PRINT("Vendor request failed after %d retries: %s\n", max_retries, libusb_error_name(result));
+        uint32_t sleep_ms = 0;
+        switch (retry_after_error(&state, vendor_request_error_class(result),
+                                  thingino_monotonic_ms(), &sleep_ms)) {
+            case RETRY_OK:
+                DEBUG_PRINT("Vendor request 0x%02X: %s treated as busy-but-accepted (%s policy)\n",
+                    request, libusb_error_name(result), policy->name);
+                // Zero length tells callers this apart from a real ack
+                if (response_length) {
+                    *response_length = 0;
+                }
+                return THINGINO_SUCCESS;
+            case RETRY_AGAIN:
+                DEBUG_PRINT("Vendor request 0x%02X failed with %s, retrying in %u ms (attempt %u)...\n",
+                    request, libusb_error_name(result), sleep_ms, state.attempts);
+                thingino_event_retry(device, request, libusb_error_name(result), state.attempts, sleep_ms);
+                if (usb_device_sleep(device, sleep_ms) != THINGINO_SUCCESS) {
+                    return THINGINO_ERROR_CANCELLED;
+                }
+                break;
+            case RETRY_GIVE_UP:
+            default:
+                DEBUG_PRINT("Vendor request 0x%02X failed after %u attempt(s): %s\n",
+                    request, state.attempts, libusb_error_name(result));
                 return THINGINO_ERROR_TRANSFER_FAILED;
-            }
-        } else {
-            // Non-recoverable error
-            DEBUG_PRINT("Vendor request failed: %s\n", libusb_error_name(result));
-            return THINGINO_ERROR_TRANSFER_FAILED;
         }
     }
+}
 
-    return THINGINO_ERROR_TRANSFER_FAILED;
-}
\ No newline at end of file
+// Vendor request under the default policy for its request and stage
+thingino_error_t usb_device_vendor_request(usb_device_t* device, uint8_t request_type,
+    uint8_t request, uint16_t value, uint16_t index, uint8_t* data, uint16_t length, uint8_t* response, int* response_length) {
+
+    return usb_device_vendor_request_policy(device,
+        usb_vendor_request_policy_for(device, request_type, request),
+        request_type, request, value, index, data, length, response, response_length);
+}
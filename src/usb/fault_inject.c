@@ -0,0 +1,119 @@
+#include "fault_inject.h"
+
+// ============================================================================
+// FAULT-INJECTION TRANSPORT IMPLEMENTATION
+// ============================================================================
+
+thingino_error_t fault_inject_attach(fault_inject_t* fi, usb_device_t* device,
+                                     const fault_profile_t* profile, uint64_t seed_offset) {
+    if (!fi || !device || !device->transport || !profile) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(fi, 0, sizeof(*fi));
+    fi->inner = device->transport;
+    fi->inner_data = device->transport_data;
+    fault_state_init(&fi->state, profile, seed_offset);
+    device->transport = &fault_inject_transport;
+    device->transport_data = fi;
+    return THINGINO_SUCCESS;
+}
+
+static int fault_disconnect(fault_inject_t* fi) {
+    fi->disconnected = true;
+    fi->reconnect_at_us = thingino_monotonic_us() + (uint64_t)fi->state.profile.reconnect_ms * 1000u;
+    return LIBUSB_ERROR_NO_DEVICE;
+}
+
+static int fault_control(void* data, uint8_t request_type, uint8_t request, uint16_t value,
+                         uint16_t index, uint8_t* buffer, uint16_t length, unsigned int timeout) {
+    fault_inject_t* fi = (fault_inject_t*)data;
+    if (fi->disconnected) {
+        return LIBUSB_ERROR_NO_DEVICE;
+    }
+
+    int result;
+    switch (fault_next(&fi->state, false, request)) {
+        case FAULT_STALL:
+            return LIBUSB_ERROR_PIPE;
+        case FAULT_TIMEOUT:
+            thingino_sleep_milliseconds(timeout);
+            return LIBUSB_ERROR_TIMEOUT;
+        case FAULT_LATE:
+            result = fi->inner->control(fi->inner_data, request_type, request, value, index,
+                                        buffer, length, timeout);
+            if (result < 0) {
+                return result;
+            }
+            thingino_sleep_milliseconds(timeout);
+            return LIBUSB_ERROR_TIMEOUT;
+        case FAULT_DISCONNECT:
+            return fault_disconnect(fi);
+        default:
+            return fi->inner->control(fi->inner_data, request_type, request, value, index,
+                                      buffer, length, timeout);
+    }
+}
+
+static int fault_bulk(void* data, uint8_t endpoint, uint8_t* buffer, int length, int* transferred,
+                      unsigned int timeout) {
+    fault_inject_t* fi = (fault_inject_t*)data;
+    *transferred = 0;
+    if (fi->disconnected) {
+        return LIBUSB_ERROR_NO_DEVICE;
+    }
+
+    int result;
+    switch (fault_next(&fi->state, true, 0)) {
+        case FAULT_STALL:
+            return LIBUSB_ERROR_PIPE;
+        case FAULT_TIMEOUT:
+            thingino_sleep_milliseconds(timeout);
+            return LIBUSB_ERROR_TIMEOUT;
+        case FAULT_LATE:
+            result = fi->inner->bulk(fi->inner_data, endpoint, buffer, length, transferred, timeout);
+            if (result != LIBUSB_SUCCESS) {
+                return result;
+            }
+            thingino_sleep_milliseconds(timeout);
+            return LIBUSB_ERROR_TIMEOUT;
+        case FAULT_SHORT: {
+            // Whole 512-byte packets make it before the timeout
+            int part = (length / 2) & ~511;
+            if (part <= 0) {
+                break;
+            }
+            result = fi->inner->bulk(fi->inner_data, endpoint, buffer, part, transferred, timeout);
+            if (result != LIBUSB_SUCCESS) {
+                return result;
+            }
+            thingino_sleep_milliseconds(timeout);
+            return LIBUSB_ERROR_TIMEOUT;
+        }
+        case FAULT_DISCONNECT:
+            return fault_disconnect(fi);
+        default:
+            break;
+    }
+    return fi->inner->bulk(fi->inner_data, endpoint, buffer, length, transferred, timeout);
+}
+
+// The host waits for the device to come back, then reopens it
+static int fault_reopen(void* data) {
+    fault_inject_t* fi = (fault_inject_t*)data;
+    if (fi->disconnected) {
+        uint64_t now = thingino_monotonic_us();
+        if (now < fi->reconnect_at_us) {
+            thingino_clock_sleep_us(fi->reconnect_at_us - now);
+        }
+        fi->disconnected = false;
+    }
+    return fi->inner->reopen ? fi->inner->reopen(fi->inner_data) : LIBUSB_SUCCESS;
+}
+
+const usb_transport_t fault_inject_transport = {
+    .name = "fault",
+    .control = fault_control,
+    .bulk = fault_bulk,
+    .reopen = fault_reopen,
+};
@@ -0,0 +1,238 @@
+#include "fault_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// FAULT PROFILE IMPLEMENTATION
+// ============================================================================
+//
+// Built-in profiles, the profile spec parser, and the seeded per-transfer
+// injection decisions.
+
+typedef struct {
+    const char* name;
+    const char* settings;
+} fault_builtin_t;
+
+static const fault_builtin_t fault_builtins[] = {
+    { "clean",         "" },
+    { "flaky-control", "on=control,stall=0.02,late=0.02" },
+    { "lossy-bus",     "timeout=0.01" },
+    { "short-bulk",    "on=bulk,short=0.03" },
+    { "busy-burner",   "req=0x12,late=0.5" },      // VR_WRITE acked late
+    { "unplug",        "disconnect=0.002,reconnect=1500" },
+};
+
+#define FAULT_BUILTIN_COUNT (sizeof(fault_builtins) / sizeof(fault_builtins[0]))
+
+static const char* const fault_kind_names[FAULT_KINDS] = {
+    "none", "stall", "timeout", "late", "short", "disconnect"
+};
+
+const char* fault_profile_builtin(size_t index) {
+    return index < FAULT_BUILTIN_COUNT ? fault_builtins[index].name : NULL;
+}
+
+const char* fault_kind_name(fault_kind_t kind) {
+    return kind < FAULT_KINDS ? fault_kind_names[kind] : "unknown";
+}
+
+static fault_kind_t fault_kind_from_name(const char* name) {
+    for (int k = FAULT_STALL; k < FAULT_KINDS; k++) {
+        if (strcmp(name, fault_kind_names[k]) == 0) {
+            return (fault_kind_t)k;
+        }
+    }
+    return FAULT_NONE;
+}
+
+static void fault_profile_defaults(fault_profile_t* profile) {
+    memset(profile, 0, sizeof(*profile));
+    profile->on = FAULT_ON_CONTROL | FAULT_ON_BULK;
+    profile->request = -1;
+    profile->reconnect_ms = FAULT_RECONNECT_MS;
+    profile->seed = 1;
+}
+
+static int fault_fail(char* error, size_t error_size, const char* what, const char* token) {
+    if (error && error_size) {
+        snprintf(error, error_size, "%s: '%s'", what, token);
+    }
+    return -1;
+}
+
+static bool parse_unsigned(const char* text, unsigned long long* out) {
+    char* end = NULL;
+    if (!*text || *text == '-') {
+        return false;
+    }
+    *out = strtoull(text, &end, 0);
+    return *end == '\0';
+}
+
+// One "key=value" (or built-in name) setting
+static int fault_profile_apply(fault_profile_t* profile, char* token, bool first,
+                               char* error, size_t error_size) {
+    char* value = strchr(token, '=');
+    if (!value) {
+        for (size_t i = 0; first && i < FAULT_BUILTIN_COUNT; i++) {
+            if (strcmp(token, fault_builtins[i].name) == 0) {
+                if (fault_profile_parse(fault_builtins[i].settings, profile, error, error_size) != 0) {
+                    return -1;
+                }
+                snprintf(profile->name, sizeof(profile->name), "%s", token);
+                return 0;
+            }
+        }
+        return fault_fail(error, error_size,
+                          first ? "unknown profile" : "profile name must come first", token);
+    }
+    *value++ = '\0';
+
+    fault_kind_t kind = fault_kind_from_name(token);
+    if (kind != FAULT_NONE) {
+        char* end = NULL;
+        double p = strtod(value, &end);
+        if (!*value || *end || p < 0.0 || p > 1.0) {
+            return fault_fail(error, error_size, "probability must be 0..1", value);
+        }
+        profile->probability[kind] = p;
+        return 0;
+    }
+
+    unsigned long long number;
+    if (strcmp(token, "on") == 0) {
+        if (strcmp(value, "control") == 0) {
+            profile->on = FAULT_ON_CONTROL;
+        } else if (strcmp(value, "bulk") == 0) {
+            profile->on = FAULT_ON_BULK;
+        } else if (strcmp(value, "all") == 0) {
+            profile->on = FAULT_ON_CONTROL | FAULT_ON_BULK;
+        } else {
+            return fault_fail(error, error_size, "on must be control, bulk or all", value);
+        }
+    } else if (strcmp(token, "req") == 0) {
+        if (!parse_unsigned(value, &number) || number > 0xFF) {
+            return fault_fail(error, error_size, "bad request code", value);
+        }
+        profile->request = (int)number;
+        profile->on = FAULT_ON_CONTROL;
+    } else if (strcmp(token, "reconnect") == 0) {
+        if (!parse_unsigned(value, &number) || number > 600000) {
+            return fault_fail(error, error_size, "bad reconnect time", value);
+        }
+        profile->reconnect_ms = (uint32_t)number;
+    } else if (strcmp(token, "seed") == 0) {
+        if (!parse_unsigned(value, &number)) {
+            return fault_fail(error, error_size, "bad seed", value);
+        }
+        profile->seed = number;
+    } else if (strcmp(token, "at") == 0) {
+        char* colon = strchr(value, ':');
+        if (!colon) {
+            return fault_fail(error, error_size, "at needs N:kind", value);
+        }
+        *colon++ = '\0';
+        kind = fault_kind_from_name(colon);
+        if (!parse_unsigned(value, &number) || number == 0 || number > UINT32_MAX ||
+            kind == FAULT_NONE) {
+            return fault_fail(error, error_size, "at needs N:kind", value);
+        }
+        if (profile->script_count >= FAULT_SCRIPT_MAX) {
+            return fault_fail(error, error_size, "too many scripted faults", value);
+        }
+        profile->script[profile->script_count].op = (uint32_t)number;
+        profile->script[profile->script_count].kind = kind;
+        profile->script_count++;
+    } else {
+        return fault_fail(error, error_size, "unknown setting", token);
+    }
+    return 0;
+}
+
+int fault_profile_parse(const char* spec, fault_profile_t* profile, char* error, size_t error_size) {
+    if (!spec || !profile) {
+        return -1;
+    }
+    fault_profile_defaults(profile);
+
+    char buffer[512];
+    if (strlen(spec) >= sizeof(buffer)) {
+        return fault_fail(error, error_size, "spec too long", spec);
+    }
+    memcpy(buffer, spec, strlen(spec) + 1);
+
+    bool first = true;
+    char* token = buffer;
+    while (token) {
+        char* next = strchr(token, ',');
+        if (next) {
+            *next++ = '\0';
+        }
+        if (*token && fault_profile_apply(profile, token, first, error, error_size) != 0) {
+            return -1;
+        }
+        first = false;
+        token = next;
+    }
+
+    if (!profile->name[0]) {
+        snprintf(profile->name, sizeof(profile->name), "%s", spec[0] ? spec : "clean");
+    }
+    return 0;
+}
+
+// ============================================================================
+// INJECTION DECISIONS
+// ============================================================================
+
+// xorshift64*: fast, and the same sequence on every platform for a seed
+static double fault_random(fault_state_t* state) {
+    state->rng ^= state->rng >> 12;
+    state->rng ^= state->rng << 25;
+    state->rng ^= state->rng >> 27;
+    return (double)((state->rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+void fault_state_init(fault_state_t* state, const fault_profile_t* profile, uint64_t seed_offset) {
+    memset(state, 0, sizeof(*state));
+    state->profile = *profile;
+    state->rng = (profile->seed + seed_offset) * 0x9E3779B97F4A7C15ULL;
+    if (state->rng == 0) {
+        state->rng = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+fault_kind_t fault_next(fault_state_t* state, bool bulk, uint8_t request) {
+    const fault_profile_t* profile = &state->profile;
+    if (!(profile->on & (bulk ? FAULT_ON_BULK : FAULT_ON_CONTROL)) ||
+        (!bulk && profile->request >= 0 && request != (uint8_t)profile->request)) {
+        return FAULT_NONE;
+    }
+    state->eligible++;
+
+    fault_kind_t kind = FAULT_NONE;
+    for (uint32_t i = 0; i < profile->script_count; i++) {
+        if (profile->script[i].op == state->eligible) {
+            kind = profile->script[i].kind;
+            break;
+        }
+    }
+
+    // One draw per transfer keeps the sequence independent of the profile mix
+    double draw = fault_random(state);
+    for (int k = FAULT_STALL; kind == FAULT_NONE && k < FAULT_KINDS; k++) {
+        if (draw < profile->probability[k]) {
+            kind = (fault_kind_t)k;
+        }
+        draw -= profile->probability[k];
+    }
+
+    if (kind == FAULT_SHORT && !bulk) {
+        kind = FAULT_NONE;  // Control transfers are all or nothing
+    }
+    state->injected[kind]++;
+    return kind;
+}
@@ -0,0 +1,281 @@
+#include "thingino.h"
+
+// ============================================================================
+// HOTPLUG RE-ENUMERATION WAIT
+// ============================================================================
+//
+// After bootstrap the device drops off the bus and comes back with a new
+// address (and usually the firmware PID). Instead of sleeping a fixed time
+// and rescanning, wait for the arrival event on the port the device was on.
+// Matching by port path keeps a neighbouring board with the same VID/PID
+// from being picked up. Where libusb has no hotplug support (Windows) the
+// device list is polled instead, with the same matching and deadline.
+//
+// The port path is also the stable identity for --port: bus and address
+// change on every re-enumeration, the physical port does not.
+
+#define ARRIVAL_POLL_INTERVAL_MS 50
+
+void usb_port_path_fill(libusb_device* dev, device_info_t* info) {
+    if (!dev || !info) {
+        return;
+    }
+
+    int depth = libusb_get_port_numbers(dev, info->port_path, USB_PORT_PATH_MAX);
+    info->port_depth = depth > 0 ? (uint8_t)depth : 0;
+}
+
+// Both on the same known port; a missing port path never matches
+bool usb_device_info_same_port(const device_info_t* a, const device_info_t* b) {
+    if (!a || !b || a->port_depth == 0 || b->port_depth == 0) {
+        return false;
+    }
+
+    return a->bus == b->bus && a->port_depth == b->port_depth &&
+           memcmp(a->port_path, b->port_path, a->port_depth) == 0;
+}
+
+// Could a be b after re-enumeration? Without a port path on either side
+// (libusb cannot tell on some platforms) anything on the bus is a candidate
+bool usb_device_info_may_share_port(const device_info_t* a, const device_info_t* b) {
+    if (!a || !b) {
+        return false;
+    }
+    if (a->port_depth == 0 || b->port_depth == 0) {
+        return true;
+    }
+    return usb_device_info_same_port(a, b);
+}
+
+// Linux sysfs style: "1-2.4" is bus 1, root port 2, hub port 4
+void usb_port_path_format(const device_info_t* info, char* buffer, size_t size) {
+    if (!buffer || size == 0) {
+        return;
+    }
+    if (!info || info->port_depth == 0) {
+        snprintf(buffer, size, "?");
+        return;
+    }
+
+    int len = snprintf(buffer, size, "%u-%u", info->bus, info->port_path[0]);
+    for (int i = 1; i < info->port_depth && len > 0 && (size_t)len < size; i++) {
+        len += snprintf(buffer + len, size - (size_t)len, ".%u", info->port_path[i]);
+    }
+}
+
+bool usb_port_path_parse(const char* text, device_info_t* info) {
+    if (!text || !info) {
+        return false;
+    }
+
+    char* end = NULL;
+    unsigned long bus = strtoul(text, &end, 10);
+    if (end == text || *end != '-' || bus > 255) {
+        return false;
+    }
+
+    uint8_t depth = 0;
+    const char* p = end + 1;
+    for (;;) {
+        unsigned long port = strtoul(p, &end, 10);
+        if (end == p || port == 0 || port > 255 || depth >= USB_PORT_PATH_MAX) {
+            return false;
+        }
+        info->port_path[depth++] = (uint8_t)port;
+        if (*end == '\0') {
+            break;
+        }
+        if (*end != '.') {
+            return false;
+        }
+        p = end + 1;
+    }
+
+    info->bus = (uint8_t)bus;
+    info->port_depth = depth;
+    return true;
+}
+
+// Index of the device plugged into port ("1-2.4"), or -1
+int usb_device_info_find_port(const device_info_t* devices, int count, const char* port) {
+    device_info_t wanted;
+    memset(&wanted, 0, sizeof(wanted));
+    if (!devices || !usb_port_path_parse(port, &wanted)) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (usb_device_info_same_port(&devices[i], &wanted)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool usb_is_supported_ingenic(uint16_t vendor, uint16_t product) {
+    if (vendor != VENDOR_ID_INGENIC && vendor != VENDOR_ID_INGENIC_ALT) {
+        return false;
+    }
+    return product == PRODUCT_ID_BOOTROM || product == PRODUCT_ID_BOOTROM2 ||
+           product == PRODUCT_ID_BOOTROM3 || product == PRODUCT_ID_FIRMWARE ||
+           product == PRODUCT_ID_FIRMWARE2;
+}
+
+static bool arrival_is_previous(libusb_device* dev, const device_info_t* previous) {
+    return previous && libusb_get_bus_number(dev) == previous->bus &&
+           libusb_get_device_address(dev) == previous->address;
+}
+
+// Does dev look like the re-enumerated instance of previous?
+static bool arrival_matches(libusb_device* dev, const device_info_t* previous, bool departed,
+                            device_info_t* out) {
+    struct libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(dev, &desc) != LIBUSB_SUCCESS ||
+        !usb_is_supported_ingenic(desc.idVendor, desc.idProduct)) {
+        return false;
+    }
+
+    device_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.bus = libusb_get_bus_number(dev);
+    info.address = libusb_get_device_address(dev);
+    info.vendor = desc.idVendor;
+    info.product = desc.idProduct;
+    info.stage = (desc.idProduct == PRODUCT_ID_FIRMWARE || desc.idProduct == PRODUCT_ID_FIRMWARE2)
+                     ? STAGE_FIRMWARE : STAGE_BOOTROM;
+    info.variant = previous ? previous->variant : VARIANT_T31X;
+    usb_port_path_fill(dev, &info);
+
+    if (previous) {
+        // The old instance may still be listed until the kernel notices it
+        // left. Once it did, or once it shows another descriptor, the same
+        // bus/address is the device back (an address can be handed out again)
+        if (info.bus == previous->bus && info.address == previous->address && !departed &&
+            info.product == previous->product && info.stage == previous->stage) {
+            return false;
+        }
+        if (!usb_device_info_may_share_port(&info, previous)) {
+            return false;
+        }
+        memcpy(info.flash_chip, previous->flash_chip, sizeof(info.flash_chip));
+    }
+
+    *out = info;
+    return true;
+}
+
+typedef struct {
+    const device_info_t* previous;
+    device_info_t* arrived;
+    bool departed;      // previous's bus/address has left the bus
+    int done;
+} arrival_wait_t;
+
+static int LIBUSB_CALL arrival_callback(libusb_context* ctx, libusb_device* dev,
+                                        libusb_hotplug_event event, void* user_data) {
+    (void)ctx;
+    arrival_wait_t* wait = (arrival_wait_t*)user_data;
+
+    if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT) {
+        if (arrival_is_previous(dev, wait->previous)) {
+            wait->departed = true;
+        }
+        return 0;
+    }
+    if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED && !wait->done &&
+        arrival_matches(dev, wait->previous, wait->departed, wait->arrived)) {
+        DEBUG_PRINT("Hotplug: device arrived on bus %d addr %d (PID 0x%04X)\n",
+                    wait->arrived->bus, wait->arrived->address, wait->arrived->product);
+        wait->done = 1;
+    }
+    return 0;
+}
+
+static thingino_error_t wait_by_polling(libusb_context* context, const device_info_t* previous,
+                                        uint64_t deadline, device_info_t* arrived) {
+    bool departed = false;
+    for (;;) {
+        libusb_device** list = NULL;
+        ssize_t count = libusb_get_device_list(context, &list);
+        bool found = false;
+        bool listed = false;
+        for (ssize_t i = 0; i < count; i++) {
+            listed = listed || arrival_is_previous(list[i], previous);
+        }
+        // A pass without the old instance means it has left
+        departed = departed || (count >= 0 && !listed);
+        for (ssize_t i = 0; i < count && !found; i++) {
+            found = arrival_matches(list[i], previous, departed, arrived);
+        }
+        if (count >= 0) {
+            libusb_free_device_list(list, 1);
+        }
+        if (found) {
+            return THINGINO_SUCCESS;
+        }
+        if (thingino_monotonic_ms() >= deadline) {
+            return THINGINO_ERROR_TIMEOUT;
+        }
+        thingino_sleep_milliseconds(ARRIVAL_POLL_INTERVAL_MS);
+    }
+}
+
+/**
+ * Wait for an Ingenic device to (re)appear on previous's port
+ *
+ * The instance at previous's bus/address is ignored so a stale listing of
+ * the pre-reset device is not mistaken for its return, unless it has been
+ * seen to leave or now shows another PID/stage. With previous NULL
+ * the first supported Ingenic device to show up is taken. arrived gets the
+ * PID-derived stage; callers that care confirm it with GET_CPU_INFO.
+ *
+ * @return THINGINO_SUCCESS, or THINGINO_ERROR_TIMEOUT at the deadline
+ */
+thingino_error_t usb_wait_for_arrival(libusb_context* context, const device_info_t* previous,
+                                      int timeout_ms, device_info_t* arrived) {
+    if (!arrived || timeout_ms < 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint64_t start = thingino_monotonic_ms();
+    uint64_t deadline = start + (uint64_t)timeout_ms;
+
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+        DEBUG_PRINT("Hotplug unsupported, polling for device arrival\n");
+        return wait_by_polling(context, previous, deadline, arrived);
+    }
+
+    arrival_wait_t wait = { previous, arrived, false, 0 };
+    libusb_hotplug_callback_handle handle;
+    // ENUMERATE also reports devices already present, so an arrival that
+    // happened before we got here is not missed
+    int rc = libusb_hotplug_register_callback(context, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED |
+                                                  LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                              LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY,
+                                              LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                                              arrival_callback, &wait, &handle);
+    if (rc != LIBUSB_SUCCESS) {
+        DEBUG_PRINT("Hotplug registration failed (%s), polling instead\n", libusb_error_name(rc));
+        return wait_by_polling(context, previous, deadline, arrived);
+    }
+
+    while (!wait.done) {
+        uint64_t now = thingino_monotonic_ms();
+        if (now >= deadline) {
+            break;
+        }
+        uint64_t remaining = deadline - now;
+        struct timeval tv = { (long)(remaining / 1000), (long)((remaining % 1000) * 1000) };
+        libusb_handle_events_timeout_completed(context, &tv, &wait.done);
+    }
+
+    libusb_hotplug_deregister_callback(context, handle);
+
+    if (!wait.done) {
+        return THINGINO_ERROR_TIMEOUT;
+    }
+
+    DEBUG_PRINT("Device back after %llu ms\n",
+                (unsigned long long)(thingino_monotonic_ms() - start));
+    return THINGINO_SUCCESS;
+}
@@ -8,299 +8,263 @@ thingino_error_t usb_manager_init(usb_manager_t* manager) {
     if (!manager) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
+
     DEBUG_PRINT("Initializing USB manager...\n");
-    
+
+    memset(manager, 0, sizeof(*manager));
+
     // Initialize libusb
     int result = libusb_init(&manager->context);
     if (result < 0) {
         DEBUG_PRINT("libusb_init failed: %d\n", result);
         return THINGINO_ERROR_INIT_FAILED;
     }
-    
+
     DEBUG_PRINT("libusb initialized successfully\n");
     manager->initialized = true;
     return THINGINO_SUCCESS;
 }
 
-thingino_error_t usb_manager_find_devices(usb_manager_t* manager, device_info_t** devices, int* count) {
-    if (!manager || !devices || !count) {
-        return THINGINO_ERROR_INVALID_PARAMETER;
+// ============================================================================
+// ENUMERATION SNAPSHOT
+// ============================================================================
+//
+// The manager keeps one entry per device on the bus, holding a libusb
+// reference so the libusb_device pointer stays a valid identity for as long
+// as the device stays enumerated. A refresh walks the device list once:
+// devices seen before keep their cached descriptor fields and stage, new
+// ones are read once, and departed ones are dropped. Re-enumeration gives a
+// device a new libusb_device, so a bootstrapped board is always re-read.
+// Each new Ingenic entry is announced once as a device event; opening a
+// device (stage probes included) sends none.
+
+static void snapshot_release(usb_manager_t* manager) {
+    for (int i = 0; i < manager->snapshot_count; i++) {
+        if (manager->snapshot[i].device) {
+            libusb_unref_device(manager->snapshot[i].device);
+        }
     }
-    
-    if (!manager->initialized) {
-        return THINGINO_ERROR_INIT_FAILED;
+    free(manager->snapshot);
+    manager->snapshot = NULL;
+    manager->snapshot_count = 0;
+}
+
+static void snapshot_fill_entry(libusb_device* device, usb_snapshot_entry_t* entry) {
+    memset(entry, 0, sizeof(*entry));
+    entry->device = libusb_ref_device(device);
+
+    struct libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(device, &desc) < 0) {
+        DEBUG_PRINT("Failed to get descriptor, device ignored\n");
+        return;  // Skip devices we can't read
     }
-    
-    *devices = NULL;
-    *count = 0;
-    
-    // Get device list
+
+    // Check if this is an Ingenic device (support both vendor IDs)
+    entry->ingenic = usb_is_supported_ingenic(desc.idVendor, desc.idProduct);
+    if (!entry->ingenic) {
+        return;
+    }
+
+    device_info_t* info = &entry->info;
+    info->bus = libusb_get_bus_number(device);
+    info->address = libusb_get_device_address(device);
+    info->vendor = desc.idVendor;
+    info->product = desc.idProduct;
+    info->stage = (desc.idProduct == PRODUCT_ID_FIRMWARE || desc.idProduct == PRODUCT_ID_FIRMWARE2)
+                      ? STAGE_FIRMWARE : STAGE_BOOTROM;
+    info->variant = VARIANT_T31X; // Default
+    usb_port_path_fill(device, info);
+
+    DEBUG_PRINT("Found Ingenic device (VID:0x%04X, PID:0x%04X) on bus %d addr %d\n",
+        desc.idVendor, desc.idProduct, info->bus, info->address);
+}
+
+// Check CPU info for a bootrom-PID device to determine its actual stage
+static void snapshot_probe_stage(usb_manager_t* manager, usb_snapshot_entry_t* entry) {
+    device_info_t* info = &entry->info;
+
+    usb_device_t* test_device;
+    if (usb_manager_open_device(manager, info, &test_device) != THINGINO_SUCCESS) {
+        DEBUG_PRINT("Failed to open device on bus %d addr %d for CPU info check\n",
+            info->bus, info->address);
+        return;
+    }
+    test_device->probe = true;
+
+    cpu_info_t cpu_info;
+    thingino_error_t cpu_result = usb_device_get_cpu_info(test_device, &cpu_info);
+    if (cpu_result == THINGINO_SUCCESS) {
+        // Determine actual stage using usb_device_get_cpu_info() classification.
+        // This handles both classic "Boot"/"BOOT" firmware strings and
+        // XBurst2/X2580-style short CPU IDs.
+        info->stage = cpu_info.stage == STAGE_FIRMWARE ? STAGE_FIRMWARE : STAGE_BOOTROM;
+        DEBUG_PRINT("Device on bus %d addr %d is in %s stage (CPU magic: %.8s)\n",
+            info->bus, info->address, device_stage_to_string(info->stage), cpu_info.magic);
+
+        // Always update variant based on CPU magic detection
+        info->variant = detect_variant_from_magic(cpu_info.clean_magic);
+        DEBUG_PRINT("Updated variant to %s (%d) based on CPU magic\n",
+            processor_variant_to_string(info->variant), info->variant);
+    } else {
+        DEBUG_PRINT("Failed to get CPU info: %s\n", thingino_error_to_string(cpu_result));
+    }
+
+    usb_device_close(test_device);
+    free(test_device);
+}
+
+/**
+ * Bring the enumeration snapshot up to date with one pass over the bus
+ *
+ * @param probe_stage Confirm the stage of bootrom-PID devices with GET_CPU_INFO.
+ *                    Firmware stage is final for an enumeration, so only
+ *                    devices still believed to be in bootrom are probed.
+ */
+static thingino_error_t snapshot_refresh(usb_manager_t* manager, bool probe_stage) {
     libusb_device** device_list;
     ssize_t device_count = libusb_get_device_list(manager->context, &device_list);
     if (device_count < 0) {
         return THINGINO_ERROR_DEVICE_NOT_FOUND;
     }
-    
-    // Count Ingenic devices first
-    int ingenic_count = 0;
-    DEBUG_PRINT("Processing %zd devices\n", device_count);
-    
-    for (ssize_t i = 0; i < device_count && i < 1000; i++) {
-        if (device_list[i] == NULL) {
-            DEBUG_PRINT("Device %zd is NULL, breaking\n", i);
-            break;
+
+    usb_snapshot_entry_t* entries = NULL;
+    if (device_count > 0) {
+        entries = (usb_snapshot_entry_t*)calloc((size_t)device_count, sizeof(usb_snapshot_entry_t));
+        if (!entries) {
+            libusb_free_device_list(device_list, 1);
+            return THINGINO_ERROR_MEMORY;
         }
-        
+    }
+
+    int reused = 0;
+    for (ssize_t i = 0; i < device_count; i++) {
         libusb_device* device = device_list[i];
-        
-        // Get device descriptor
-        struct libusb_device_descriptor desc;
-        int result = libusb_get_device_descriptor(device, &desc);
-        if (result < 0) {
-            DEBUG_PRINT("Failed to get descriptor for device %zd: %d\n", i, result);
-            continue; // Skip devices we can't read
-        }
-        
-        DEBUG_PRINT("Device %zd: VID=0x%04X, PID=0x%04X\n", i, desc.idVendor, desc.idProduct);
-        
-        // Check if this is an Ingenic device (support both vendor IDs)
-        bool is_ingenic = (desc.idVendor == VENDOR_ID_INGENIC || desc.idVendor == VENDOR_ID_INGENIC_ALT);
-        if (is_ingenic) {
-            // Check for supported product IDs
-            bool is_bootrom = (desc.idProduct == PRODUCT_ID_BOOTROM ||
-                              desc.idProduct == PRODUCT_ID_BOOTROM2 ||
-                              desc.idProduct == PRODUCT_ID_BOOTROM3);
-            
-            bool is_firmware = (desc.idProduct == PRODUCT_ID_FIRMWARE ||
-                               desc.idProduct == PRODUCT_ID_FIRMWARE2);
-            
-            if (is_bootrom || is_firmware) {
-                ingenic_count++;
-                DEBUG_PRINT("Found Ingenic device %zd (VID:0x%04X, PID:0x%04X)\n",
-                    i, desc.idVendor, desc.idProduct);
+        usb_snapshot_entry_t* cached = NULL;
+
+        for (int j = 0; j < manager->snapshot_count; j++) {
+            if (manager->snapshot[j].device == device) {
+                cached = &manager->snapshot[j];
+                break;
             }
         }
+
+        if (cached) {
+            // Take over the cached entry and its reference
+            entries[i] = *cached;
+            cached->device = NULL;
+            reused++;
+        } else {
+            snapshot_fill_entry(device, &entries[i]);
+        }
+    }
+
+    libusb_free_device_list(device_list, 1);
+    snapshot_release(manager);
+    manager->snapshot = entries;
+    manager->snapshot_count = (int)device_count;
+
+    DEBUG_PRINT("Snapshot: %zd devices on the bus, %d cached\n", device_count, reused);
+
+    for (int i = 0; i < manager->snapshot_count; i++) {
+        usb_snapshot_entry_t* entry = &manager->snapshot[i];
+        if (!entry->ingenic) {
+            continue;
+        }
+        if (probe_stage && entry->info.stage == STAGE_BOOTROM) {
+            snapshot_probe_stage(manager, entry);
+        }
+        if (!entry->announced) {
+            thingino_event_device(&entry->info);
+            entry->announced = true;
+        }
+    }
+
+    return THINGINO_SUCCESS;
+}
+
+static thingino_error_t snapshot_copy_devices(const usb_manager_t* manager,
+                                              device_info_t** devices, int* count) {
+    int ingenic_count = 0;
+    for (int i = 0; i < manager->snapshot_count; i++) {
+        if (manager->snapshot[i].ingenic) {
+            ingenic_count++;
+        }
     }
-    
+
     DEBUG_PRINT("Found %d Ingenic devices\n", ingenic_count);
-    
     if (ingenic_count == 0) {
-        DEBUG_PRINT("No Ingenic devices found\n");
-        libusb_free_device_list(device_list, 1);
-        *devices = NULL;
-        *count = 0;
         return THINGINO_SUCCESS;
     }
-    
-    DEBUG_PRINT("Allocating memory for %d devices\n", ingenic_count);
-    
+
     // Allocate device info array
-    *devices = (device_info_t*)malloc(ingenic_count * sizeof(device_info_t));
+    *devices = (device_info_t*)calloc(ingenic_count, sizeof(device_info_t));
     if (!*devices) {
         DEBUG_PRINT("Memory allocation failed\n");
-        libusb_free_device_list(device_list, 1);
         return THINGINO_ERROR_MEMORY;
     }
-    
-    DEBUG_PRINT("Memory allocated successfully\n");
-    
-    // Fill device info
+
     int device_index = 0;
-    for (ssize_t i = 0; i < device_count; i++) {
-        libusb_device* device = device_list[i];
-        
-        // Get device descriptor
-        struct libusb_device_descriptor desc;
-        int result = libusb_get_device_descriptor(device, &desc);
-        if (result < 0) {
-            continue; // Skip devices we can't read
-        }
-        
-        // Check if this is an Ingenic device (support both vendor IDs)
-        bool is_ingenic = (desc.idVendor == VENDOR_ID_INGENIC || desc.idVendor == VENDOR_ID_INGENIC_ALT);
-        if (is_ingenic) {
-            // Check for supported product IDs
-            bool is_bootrom = (desc.idProduct == PRODUCT_ID_BOOTROM ||
-                              desc.idProduct == PRODUCT_ID_BOOTROM2 ||
-                              desc.idProduct == PRODUCT_ID_BOOTROM3);
-            
-            bool is_firmware = (desc.idProduct == PRODUCT_ID_FIRMWARE ||
-                               desc.idProduct == PRODUCT_ID_FIRMWARE2);
-            
-            if (is_bootrom || is_firmware) {
-                // Get bus and address
-                uint8_t bus = libusb_get_bus_number(device);
-                uint8_t addr = libusb_get_device_address(device);
-                
-                // Determine initial stage
-                device_stage_t stage = STAGE_BOOTROM;
-                if (is_firmware) {
-                    stage = STAGE_FIRMWARE;
-                }
-                
-                // Create device info
-                device_info_t* info = &(*devices)[device_index];
-                info->bus = bus;
-                info->address = addr;
-                info->vendor = desc.idVendor;
-                info->product = desc.idProduct;
-                info->stage = stage;
-                info->variant = VARIANT_T31X; // Default
-                
-                // Check CPU info for bootrom devices to determine actual stage
-                if (is_bootrom) {
-                    DEBUG_PRINT("Checking CPU info for device %d to determine actual stage\n", device_index);
-                    usb_device_t* test_device;
-                    if (usb_manager_open_device(manager, info, &test_device) == THINGINO_SUCCESS) {
-                        cpu_info_t cpu_info;
-                        thingino_error_t cpu_result = usb_device_get_cpu_info(test_device, &cpu_info);
-                        if (cpu_result == THINGINO_SUCCESS) {
-                            // Determine actual stage using usb_device_get_cpu_info() classification.
-                            // This handles both classic "Boot"/"BOOT" firmware strings and
-                            // XBurst2/X2580-style short CPU IDs.
-                            if (cpu_info.stage == STAGE_FIRMWARE) {
-                                info->stage = STAGE_FIRMWARE;
-                                DEBUG_PRINT("Device %d is actually in firmware stage (CPU magic: %.8s)\n",
-                                    device_index, cpu_info.magic);
-                            } else {
-                                info->stage = STAGE_BOOTROM;
-                                DEBUG_PRINT("Device %d is in bootrom stage (CPU magic: %.8s)\n",
-                                    device_index, cpu_info.magic);
-                            }
-
-                            // Update variant based on clean CPU magic string
-                            processor_variant_t detected_variant = detect_variant_from_magic(cpu_info.clean_magic);
-                            // Always update variant based on CPU magic detection
-                            info->variant = detected_variant;
-                            DEBUG_PRINT("Updated device %d variant to %s (%d) based on CPU magic\n",
-                                device_index, processor_variant_to_string(detected_variant), detected_variant);
-                        } else {
-                            DEBUG_PRINT("Failed to get CPU info for device %d: %s\n",
-                                device_index, thingino_error_to_string(cpu_result));
-                        }
-                        usb_device_close(test_device);
-                        free(test_device);
-                    } else {
-                        DEBUG_PRINT("Failed to open device %d for CPU info check\n", device_index);
-                    }
-                }
-                
-                device_index++;
-            }
+    for (int i = 0; i < manager->snapshot_count; i++) {
+        if (manager->snapshot[i].ingenic) {
+            (*devices)[device_index++] = manager->snapshot[i].info;
         }
     }
-    
-    // Free device list
-    libusb_free_device_list(device_list, 1);
-    
+
     *count = ingenic_count;
     return THINGINO_SUCCESS;
 }
 
-// Fast enumeration that skips CPU info checking (useful during bootstrap re-detection)
-thingino_error_t usb_manager_find_devices_fast(usb_manager_t* manager, device_info_t** devices, int* count) {
+thingino_error_t usb_manager_find_devices(usb_manager_t* manager, device_info_t** devices, int* count) {
     if (!manager || !devices || !count) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
+
     if (!manager->initialized) {
         return THINGINO_ERROR_INIT_FAILED;
     }
-    
+
     *devices = NULL;
     *count = 0;
-    
-    // Get device list
-    libusb_device** device_list;
-    ssize_t device_count = libusb_get_device_list(manager->context, &device_list);
-    if (device_count < 0) {
-        return THINGINO_ERROR_DEVICE_NOT_FOUND;
-    }
-    
-    // Count Ingenic devices first
-    int ingenic_count = 0;
-    DEBUG_PRINT("Fast enumeration: processing %zd devices\n", device_count);
-    
-    for (ssize_t i = 0; i < device_count && i < 1000; i++) {
-        if (device_list[i] == NULL) {
-            continue;
-        }
-        
-        struct libusb_device_descriptor desc;
-        if (libusb_get_device_descriptor(device_list[i], &desc) < 0) {
-            continue;
-        }
-        
-        // Check for Ingenic vendor IDs (skip CPU info check for speed)
-        if ((desc.idVendor == VENDOR_ID_INGENIC || desc.idVendor == VENDOR_ID_INGENIC_ALT) &&
-            (desc.idProduct == PRODUCT_ID_BOOTROM2 || desc.idProduct == PRODUCT_ID_BOOTROM || 
-             desc.idProduct == PRODUCT_ID_FIRMWARE || desc.idProduct == PRODUCT_ID_FIRMWARE2)) {
-            ingenic_count++;
-        }
+
+    thingino_error_t result = snapshot_refresh(manager, true);
+    if (result != THINGINO_SUCCESS) {
+        return result;
     }
-    
-    if (ingenic_count == 0) {
-        libusb_free_device_list(device_list, 1);
-        return THINGINO_SUCCESS;
+
+    return snapshot_copy_devices(manager, devices, count);
+}
+
+// Fast enumeration that skips CPU info checking (useful during bootstrap re-detection).
+// Stages are PID-derived unless an earlier full scan confirmed them.
+thingino_error_t usb_manager_find_devices_fast(usb_manager_t* manager, device_info_t** devices, int* count) {
+    if (!manager || !devices || !count) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
-    // Allocate space for all devices
-    *devices = (device_info_t*)malloc(sizeof(device_info_t) * ingenic_count);
-    if (!*devices) {
-        libusb_free_device_list(device_list, 1);
-        return THINGINO_ERROR_MEMORY;
+
+    if (!manager->initialized) {
+        return THINGINO_ERROR_INIT_FAILED;
     }
-    
-    // Populate device list (without CPU info queries)
-    int device_index = 0;
-    for (ssize_t i = 0; i < device_count && device_index < ingenic_count; i++) {
-        if (device_list[i] == NULL) {
-            continue;
-        }
-        
-        struct libusb_device_descriptor desc;
-        if (libusb_get_device_descriptor(device_list[i], &desc) < 0) {
-            continue;
-        }
-        
-        if ((desc.idVendor == VENDOR_ID_INGENIC || desc.idVendor == VENDOR_ID_INGENIC_ALT) &&
-            (desc.idProduct == PRODUCT_ID_BOOTROM2 || desc.idProduct == PRODUCT_ID_BOOTROM || 
-             desc.idProduct == PRODUCT_ID_FIRMWARE || desc.idProduct == PRODUCT_ID_FIRMWARE2)) {
-            
-            DEBUG_PRINT("Fast enumeration: found Ingenic device %d (VID:0x%04X, PID:0x%04X)\n",
-                device_index, desc.idVendor, desc.idProduct);
-            
-            device_info_t* info = &(*devices)[device_index];
-            info->bus = libusb_get_bus_number(device_list[i]);
-            info->address = libusb_get_device_address(device_list[i]);
-            info->vendor = desc.idVendor;
-            info->product = desc.idProduct;
-            
-            // Assume bootrom stage for now (CPU info check skipped)
-            info->stage = STAGE_BOOTROM;
-            info->variant = VARIANT_T31X;
-            
-            device_index++;
-        }
+
+    *devices = NULL;
+    *count = 0;
+
+    thingino_error_t result = snapshot_refresh(manager, false);
+    if (result != THINGINO_SUCCESS) {
+        return result;
     }
-    
-    // Free device list
-    libusb_free_device_list(device_list, 1);
-    
-    *count = ingenic_count;
-    return THINGINO_SUCCESS;
+
+    return snapshot_copy_devices(manager, devices, count);
 }
 
 thingino_error_t usb_manager_open_device(usb_manager_t* manager, const device_info_t* info, usb_device_t** device) {
     if (!manager || !info || !device) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
-    
+
     if (!manager->initialized) {
         return THINGINO_ERROR_INIT_FAILED;
     }
-    
+
     DEBUG_PRINT("Allocating device structure...\n");
     // Allocate device structure
     *device = (usb_device_t*)malloc(sizeof(usb_device_t));
@@ -308,33 +272,46 @@ thingino_error_t usb_manager_open_device(usb_manager_t* manager, const device_in
         DEBUG_PRINT("Failed to allocate device structure\n");
         return THINGINO_ERROR_MEMORY;
     }
-    
+
     DEBUG_PRINT("Setting device info and context...\n");
     // Copy device info and set context before initialization
     (*device)->info = *info;
     (*device)->context = manager->context;
     DEBUG_PRINT("Manager device variant: %d (%s)\n",
         info->variant, processor_variant_to_string(info->variant));
-    
+
+    // Open straight from the snapshot when the device is in it; otherwise
+    // fall back to a bus/address scan
+    libusb_device* cached = NULL;
+    for (int i = 0; i < manager->snapshot_count; i++) {
+        const usb_snapshot_entry_t* entry = &manager->snapshot[i];
+        if (entry->ingenic && entry->info.bus == info->bus && entry->info.address == info->address) {
+            cached = entry->device;
+            break;
+        }
+    }
+
     DEBUG_PRINT("Initializing device (bus=%d, addr=%d)...\n", info->bus, info->address);
     // Initialize device
-    thingino_error_t result = usb_device_init(*device, info->bus, info->address);
+    thingino_error_t result = cached ? usb_device_open_libusb(*device, cached)
+                                     : usb_device_init(*device, info->bus, info->address);
     if (result != THINGINO_SUCCESS) {
         DEBUG_PRINT("Device init failed: %s\n", thingino_error_to_string(result));
         free(*device);
         *device = NULL;
         return result;
     }
-    
+
     DEBUG_PRINT("Device initialized successfully\n");
-    
+
     return THINGINO_SUCCESS;
 }
 
 void usb_manager_cleanup(usb_manager_t* manager) {
     if (manager && manager->initialized && manager->context) {
+        snapshot_release(manager);
         libusb_exit(manager->context);
         manager->context = NULL;
         manager->initialized = false;
     }
-}
\ No newline at end of file
+}
@@ -29,12 +29,7 @@ thingino_error_t protocol_set_data_address(usb_device_t* device, uint32_t addr)
     
     DEBUG_PRINT("SetDataAddress OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(100);
-#else
-    usleep(100000);
-#endif
+    thingino_sleep_milliseconds(100);
     
     return THINGINO_SUCCESS;
 }
@@ -58,12 +53,7 @@ thingino_error_t protocol_set_data_length(usb_device_t* device, uint32_t length)
     
     DEBUG_PRINT("SetDataLength OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(100);
-#else
-    usleep(100000);
-#endif
+    thingino_sleep_milliseconds(100);
     
     return THINGINO_SUCCESS;
 }
@@ -86,12 +76,7 @@ thingino_error_t protocol_flush_cache(usb_device_t* device) {
     
     DEBUG_PRINT("FlushCache OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(100);
-#else
-    usleep(100000);
-#endif
+    thingino_sleep_milliseconds(100);
     
     return THINGINO_SUCCESS;
 }
@@ -139,12 +124,7 @@ thingino_error_t protocol_prog_stage1(usb_device_t* device, uint32_t addr) {
     
     DEBUG_PRINT("ProgStage1 OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(100);
-#else
-    usleep(100000);
-#endif
+    thingino_sleep_milliseconds(100);
     
     return THINGINO_SUCCESS;
 }
@@ -171,12 +151,7 @@ thingino_error_t protocol_prog_stage2(usb_device_t* device, uint32_t addr) {
     
     DEBUG_PRINT("ProgStage2 OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(100);
-#else
-    usleep(100000);
-#endif
+    thingino_sleep_milliseconds(100);
     
     return THINGINO_SUCCESS;
 }
@@ -227,8 +202,8 @@ static int calculate_protocol_timeout(uint32_t size) {
 }
 
 // Firmware stage protocol functions
-thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t** data, int* actual_len) {
-    if (!device || !data || !actual_len) {
+thingino_error_t protocol_fw_read_into(usb_device_t* device, uint8_t* buffer, int data_len, int* actual_len) {
+    if (!device || !buffer || !actual_len || data_len <= 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
     
@@ -242,19 +217,13 @@ thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t**
     }
     
     // Now read actual data via bulk transfer
-    uint8_t* buffer = (uint8_t*)malloc(data_len);
-    if (!buffer) {
-        usb_device_release_interface(device);
-        return THINGINO_ERROR_MEMORY;
-    }
-    
     int transferred = 0;
     int timeout = calculate_protocol_timeout(data_len);
     
     DEBUG_PRINT("FWRead: using adaptive timeout of %dms for %d bytes\n", timeout, data_len);
     
     // Use direct libusb call with adaptive timeout for better control
-    int libusb_result = libusb_bulk_transfer(device->handle, ENDPOINT_IN,
+    int libusb_result = usb_device_bulk_raw(device, ENDPOINT_IN,
         buffer, data_len, &transferred, timeout);
     
     // Handle stall errors with interface reset (from Go implementation experience)
@@ -267,14 +236,14 @@ thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t**
             usb_device_release_interface(device);
             
             // Small delay before retry
-            usleep(100000); // 100ms
+            thingino_sleep_milliseconds(100); // 100ms
             
             // Re-claim interface and retry once with longer timeout
             thingino_error_t claim_result = usb_device_claim_interface(device);
             if (claim_result == THINGINO_SUCCESS) {
                 DEBUG_PRINT("FWRead retrying transfer after interface reset...\n");
                 int retry_timeout = timeout * 2; // Double timeout for retry
-                libusb_result = libusb_bulk_transfer(device->handle, ENDPOINT_IN,
+                libusb_result = usb_device_bulk_raw(device, ENDPOINT_IN,
                     buffer, data_len, &transferred, retry_timeout);
             } else {
                 DEBUG_PRINT("FWRead failed to reclaim interface: %s\n", thingino_error_to_string(claim_result));
@@ -287,17 +256,36 @@ thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t**
     
     if (libusb_result != LIBUSB_SUCCESS) {
         DEBUG_PRINT("FWRead bulk transfer error: %s\n", libusb_error_name(libusb_result));
-        free(buffer);
-        return THINGINO_ERROR_TRANSFER_FAILED;
+        return libusb_result == LIBUSB_ERROR_INTERRUPTED ? THINGINO_ERROR_CANCELLED
+                                                         : THINGINO_ERROR_TRANSFER_FAILED;
     }
     
     DEBUG_PRINT("FWRead success: got %d bytes (requested %d)\n", transferred, data_len);
     
-    *data = buffer;
     *actual_len = transferred;
     return THINGINO_SUCCESS;
 }
 
+thingino_error_t protocol_fw_read(usb_device_t* device, int data_len, uint8_t** data, int* actual_len) {
+    if (!device || !data || !actual_len || data_len <= 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* buffer = (uint8_t*)malloc(data_len);
+    if (!buffer) {
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    thingino_error_t result = protocol_fw_read_into(device, buffer, data_len, actual_len);
+    if (result != THINGINO_SUCCESS) {
+        free(buffer);
+        return result;
+    }
+
+    *data = buffer;
+    return THINGINO_SUCCESS;
+}
+
 thingino_error_t protocol_fw_handshake(usb_device_t* device) {
     if (!device) {
         return THINGINO_ERROR_INVALID_PARAMETER;
@@ -321,11 +309,7 @@ thingino_error_t protocol_fw_handshake(usb_device_t* device) {
     DEBUG_PRINT("FWHandshake vendor request sent successfully\n");
     
     // Platform-specific sleep after successful handshake
-#ifdef _WIN32
-    Sleep(50);
-#else
-    usleep(50000);
-#endif
+    thingino_sleep_milliseconds(50);
     
     return THINGINO_SUCCESS;
 }
@@ -348,12 +332,7 @@ thingino_error_t protocol_fw_write_chunk1(usb_device_t* device, const uint8_t* d
 
     DEBUG_PRINT("FWWriteChunk1 OK\n");
 
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(50);
-#else
-    usleep(50000);
-#endif
+    thingino_sleep_milliseconds(50);
 
     return THINGINO_SUCCESS;
 }
@@ -502,8 +481,9 @@ thingino_error_t protocol_proper_firmware_write(usb_device_t* device, uint32_t f
 
 // Vendor-style firmware read using VR_READ (0x13) command
 // This matches the vendor tool's approach: send 40-byte command, check status, bulk read
-thingino_error_t protocol_vendor_style_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* actual_len) {
-    if (!device || !data || !actual_len) {
+thingino_error_t protocol_vendor_style_read_into(usb_device_t* device, uint32_t offset, uint32_t size,
+                                                 uint8_t* buffer, int* actual_len) {
+    if (!device || !buffer || !actual_len || size == 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
 
@@ -588,13 +568,7 @@ thingino_error_t protocol_vendor_style_read(usb_device_t* device, uint32_t offse
 
     // Wait for device to prepare data for bulk transfer
     // Using 50ms like the handshake protocol to ensure device has data ready
-    usleep(50000); // 50ms delay for device to prepare bulk data
-
-    // Allocate buffer for bulk read
-    uint8_t* buffer = (uint8_t*)malloc(size);
-    if (!buffer) {
-        return THINGINO_ERROR_MEMORY;
-    }
+    thingino_sleep_milliseconds(50); // 50ms delay for device to prepare bulk data
 
     // Perform bulk IN transfer on endpoint 0x81
     // Calculate adaptive timeout based on transfer size
@@ -608,17 +582,35 @@ thingino_error_t protocol_vendor_style_read(usb_device_t* device, uint32_t offse
 
     if (result != THINGINO_SUCCESS) {
         DEBUG_PRINT("VendorStyleRead: Bulk transfer failed: %s\n", thingino_error_to_string(result));
-        free(buffer);
         return result;
     }
 
     DEBUG_PRINT("VendorStyleRead: Successfully read %d bytes (requested %u)\n", transferred, size);
 
-    *data = buffer;
     *actual_len = transferred;
     return THINGINO_SUCCESS;
 }
 
+thingino_error_t protocol_vendor_style_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* actual_len) {
+    if (!device || !data || !actual_len || size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (!buffer) {
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    thingino_error_t result = protocol_vendor_style_read_into(device, offset, size, buffer, actual_len);
+    if (result != THINGINO_SUCCESS) {
+        free(buffer);
+        return result;
+    }
+
+    *data = buffer;
+    return THINGINO_SUCCESS;
+}
+
 // Traditional firmware read using VR_READ command (alternative approach)
 thingino_error_t protocol_traditional_read(usb_device_t* device, int data_len, uint8_t** data, int* actual_len) {
     if (!device || !data || !actual_len) {
@@ -751,12 +743,7 @@ thingino_error_t protocol_fw_write_chunk2(usb_device_t* device, const uint8_t* d
     
     DEBUG_PRINT("FWWriteChunk2 OK\n");
     
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(50);
-#else
-    usleep(50000);
-#endif
+    thingino_sleep_milliseconds(50);
     
     return THINGINO_SUCCESS;
 }
@@ -776,8 +763,9 @@ thingino_error_t protocol_fw_write_chunk2(usb_device_t* device, const uint8_t* d
  * 
  * This uses the NAND_OPS command built into U-Boot bootloader
  */
-thingino_error_t protocol_nand_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* transferred) {
-    if (!device || !data || !transferred || size == 0) {
+thingino_error_t protocol_nand_read_into(usb_device_t* device, uint32_t offset, uint32_t size,
+                                         uint8_t* buffer, int* transferred) {
+    if (!device || !buffer || !transferred || size == 0) {
         return THINGINO_ERROR_INVALID_PARAMETER;
     }
     
@@ -813,39 +801,48 @@ thingino_error_t protocol_nand_read(usb_device_t* device, uint32_t offset, uint3
     DEBUG_PRINT("NAND_OPS: Command sent successfully\n");
     
     // Give device time to prepare data for bulk transfer
-    // Platform-specific sleep
-#ifdef _WIN32
-    Sleep(50);
-#else
-    usleep(50000);  // 50ms
-#endif
+    thingino_sleep_milliseconds(50);
     
     // Step 4: Bulk-in transfer to read the data
-    uint8_t* buffer = (uint8_t*)malloc(size);
-    if (!buffer) {
-        DEBUG_PRINT("NAND_OPS: Memory allocation failed for %u bytes\n", size);
-        return THINGINO_ERROR_MEMORY;
-    }
-    
     // Calculate timeout based on transfer size
     int timeout = calculate_protocol_timeout(size);
     DEBUG_PRINT("NAND_OPS: Performing bulk-in transfer (timeout=%dms)...\n", timeout);
     
     // Perform bulk transfer
     int bytes_transferred = 0;
-    int libusb_result = libusb_bulk_transfer(device->handle, ENDPOINT_IN,
+    int libusb_result = usb_device_bulk_raw(device, ENDPOINT_IN,
         buffer, size, &bytes_transferred, timeout);
     
     if (libusb_result != LIBUSB_SUCCESS) {
         DEBUG_PRINT("NAND_OPS: Bulk transfer failed: %s\n", libusb_error_name(libusb_result));
-        free(buffer);
-        return THINGINO_ERROR_TRANSFER_FAILED;
+        return libusb_result == LIBUSB_ERROR_INTERRUPTED ? THINGINO_ERROR_CANCELLED
+                                                         : THINGINO_ERROR_TRANSFER_FAILED;
     }
     
     DEBUG_PRINT("NAND_OPS: Successfully read %d bytes (requested %u bytes)\n", 
         bytes_transferred, size);
     
-    *data = buffer;
     *transferred = bytes_transferred;
     return THINGINO_SUCCESS;
+}
+
+thingino_error_t protocol_nand_read(usb_device_t* device, uint32_t offset, uint32_t size, uint8_t** data, int* transferred) {
+    if (!device || !data || !transferred || size == 0) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (!buffer) {
+        DEBUG_PRINT("NAND_OPS: Memory allocation failed for %u bytes\n", size);
+        return THINGINO_ERROR_MEMORY;
+    }
+
+    thingino_error_t result = protocol_nand_read_into(device, offset, size, buffer, transferred);
+    if (result != THINGINO_SUCCESS) {
+        free(buffer);
+        return result;
+    }
+
+    *data = buffer;
+    return THINGINO_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "retry_policy.h"
+
+// ============================================================================
+// RETRY POLICY IMPLEMENTATION
+// ============================================================================
+//
+// The policy tables and the attempt state machine, which reads no clock of
+// its own. The previous fixed schedule (five 5 s attempts with 0.5..5 s
+// sleeps) could spend ~36 s on one stuck request; these budgets let a dead
+// device fail within seconds while a briefly stalled one still recovers.
+
+const retry_policy_t retry_policy_control = {
+    .name = "control",
+    .deadline_ms = 8000,
+    .attempt_timeout_ms = 3000,
+    .backoff_initial_ms = 100,
+    .backoff_max_ms = 1000,
+    .retry_on = RETRY_ERR_TIMEOUT | RETRY_ERR_PIPE | RETRY_ERR_NO_DEVICE,
+    .busy_ok = 0,
+};
+
+// The handshake is accepted even when the status stage times out (the
+// burner is still programming the previous chunk), so a healthy device
+// answers at once and a busy one costs one short timeout, not five seconds.
+// A dropped handshake times out the same way; the chunk writer resends
+// such a chunk (handshake and data together) only when a burner that logs
+// never reports it.
+const retry_policy_t retry_policy_fw_handshake = {
+    .name = "fw-handshake",
+    .deadline_ms = 0,
+    .attempt_timeout_ms = 1000,
+    .backoff_initial_ms = 0,
+    .backoff_max_ms = 0,
+    .retry_on = 0,
+    .busy_ok = RETRY_ERR_TIMEOUT,
+};
+
+// With force_erase the first SET_DATA_ADDR starts a chip erase and EP0 goes
+// quiet until it finishes; the writer polls erase status afterwards, so
+// there is nothing to gain from waiting on the control transfer.
+const retry_policy_t retry_policy_fw_set_addr = {
+    .name = "fw-set-addr",
+    .deadline_ms = 0,
+    .attempt_timeout_ms = 1000,
+    .backoff_initial_ms = 0,
+    .backoff_max_ms = 0,
+    .retry_on = 0,
+    .busy_ok = RETRY_ERR_TIMEOUT,
+};
+
+void retry_begin(retry_state_t* state, const retry_policy_t* policy,
+                 uint64_t now_ms, uint64_t outer_deadline_ms) {
+    if (!state || !policy) {
+        return;
+    }
+
+    // A single-attempt policy still gets its one attempt's worth of time
+    uint32_t budget = policy->deadline_ms > policy->attempt_timeout_ms
+                          ? policy->deadline_ms : policy->attempt_timeout_ms;
+
+    state->policy = policy;
+    state->deadline_ms = now_ms + budget;
+    if (outer_deadline_ms != 0 && outer_deadline_ms < state->deadline_ms) {
+        state->deadline_ms = outer_deadline_ms;
+    }
+    state->attempts = 0;
+    state->next_backoff_ms = policy->backoff_initial_ms;
+}
+
+uint32_t retry_attempt_timeout(retry_state_t* state, uint64_t now_ms) {
+    if (!state || !state->policy) {
+        return 0;
+    }
+    if (state->attempts > 0 && state->policy->deadline_ms == 0) {
+        return 0;
+    }
+    if (now_ms >= state->deadline_ms) {
+        return 0;
+    }
+
+    uint64_t remaining = state->deadline_ms - now_ms;
+    if (remaining < RETRY_MIN_ATTEMPT_MS) {
+        return 0;
+    }
+
+    state->attempts++;
+    return remaining < state->policy->attempt_timeout_ms
+               ? (uint32_t)remaining : state->policy->attempt_timeout_ms;
+}
+
+retry_decision_t retry_after_error(retry_state_t* state, uint32_t error_class,
+                                   uint64_t now_ms, uint32_t* sleep_ms) {
+    if (sleep_ms) {
+        *sleep_ms = 0;
+    }
+    if (!state || !state->policy) {
+        return RETRY_GIVE_UP;
+    }
+
+    const retry_policy_t* policy = state->policy;
+    if (policy->busy_ok & error_class) {
+        return RETRY_OK;
+    }
+    if (!(policy->retry_on & error_class) || policy->deadline_ms == 0 ||
+        now_ms >= state->deadline_ms) {
+        return RETRY_GIVE_UP;
+    }
+
+    // Only back off if a useful attempt still fits behind the sleep
+    uint64_t remaining = state->deadline_ms - now_ms;
+    uint32_t backoff = state->next_backoff_ms;
+    if (remaining < (uint64_t)backoff + RETRY_MIN_ATTEMPT_MS) {
+        return RETRY_GIVE_UP;
+    }
+
+    if (sleep_ms) {
+        *sleep_ms = backoff;
+    }
+    uint32_t next = backoff ? backoff * 2 : policy->backoff_initial_ms;
+    state->next_backoff_ms = next > policy->backoff_max_ms ? policy->backoff_max_ms : next;
+    return RETRY_AGAIN;
+}
@@ -0,0 +1,318 @@
+#include "sim_device.h"
+
+// ============================================================================
+// SIMULATED DEVICE IMPLEMENTATION
+// ============================================================================
+
+#define SIM_RAM_BASE       0x80000000u
+#define SIM_BURNER_MAGIC   "BOOT47XX"
+
+static void sim_elapse_us(sim_device_t* sim, uint64_t us) {
+    if (sim->clock) {
+        thingino_virtual_clock_advance(sim->clock, us);
+    }
+}
+
+static void sim_elapse_bytes(sim_device_t* sim, uint32_t bytes) {
+    sim_elapse_us(sim, (uint64_t)bytes * 1000u / sim->bytes_per_ms);
+}
+
+static uint32_t sim_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void sim_log(sim_device_t* sim, const char* line) {
+    if (sim->silent) {
+        return;
+    }
+    size_t len = strlen(line);
+    if (sim->log_len + len <= sizeof(sim->log)) {
+        memcpy(sim->log + sim->log_len, line, len);
+        sim->log_len += len;
+    }
+}
+
+thingino_error_t sim_device_init(sim_device_t* sim) {
+    if (!sim) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+    if (!sim->cpu_magic[0]) {
+        memcpy(sim->cpu_magic, "T31V\0\0\0\0", sizeof(sim->cpu_magic));
+    }
+    if (!sim->bytes_per_ms) {
+        sim->bytes_per_ms = SIM_DEVICE_BYTES_PER_MS;
+    }
+    if (!sim->erase_ms) {
+        sim->erase_ms = SIM_DEVICE_ERASE_MS;
+    }
+    if (!sim->program_ms) {
+        sim->program_ms = SIM_DEVICE_PROGRAM_MS;
+    }
+    if (!sim->ram) {
+        sim->ram = (uint8_t*)calloc(1, SIM_DEVICE_RAM_SIZE);
+        if (!sim->ram) {
+            return THINGINO_ERROR_MEMORY;
+        }
+    }
+
+    sim->stage = SIM_STAGE_BOOTROM;
+    sim->data_addr = 0;
+    sim->data_len = 0;
+    sim->ram_loaded = 0;
+    sim->erase_done_us = 0;
+    sim->pending = SIM_PENDING_NONE;
+    sim->log_len = 0;
+    return THINGINO_SUCCESS;
+}
+
+void sim_device_cleanup(sim_device_t* sim) {
+    if (sim) {
+        free(sim->ram);
+        sim->ram = NULL;
+    }
+}
+
+thingino_error_t sim_device_open(sim_device_t* sim, usb_device_t* device,
+                                 processor_variant_t variant) {
+    if (!sim || !device) {
+        return THINGINO_ERROR_INVALID_PARAMETER;
+    }
+
+    device_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.bus = 1;
+    info.address = 1;
+    info.vendor = VENDOR_ID_INGENIC;
+    info.product = PRODUCT_ID_BOOTROM2;
+    info.stage = sim->stage == SIM_STAGE_BURNER ? STAGE_FIRMWARE : STAGE_BOOTROM;
+    info.variant = variant;
+    return usb_device_open_transport(device, &sim_device_transport, sim, &info);
+}
+
+uint32_t sim_device_next_out_size(const sim_device_t* sim) {
+    if (sim->stage != SIM_STAGE_BURNER) {
+        return sim->data_len > sim->ram_loaded ? sim->data_len - sim->ram_loaded : 0;
+    }
+    return sim->pending == SIM_PENDING_WRITE ? sim->pending_size : 0;
+}
+
+// ============================================================================
+// CONTROL REQUESTS
+// ============================================================================
+
+static int sim_bootrom_control(sim_device_t* sim, uint8_t request, uint32_t arg) {
+    switch (request) {
+        case VR_SET_DATA_ADDR:
+            sim->data_addr = arg;
+            sim->ram_loaded = 0;
+            return 0;
+        case VR_SET_DATA_LEN:
+            sim->data_len = arg;
+            return 0;
+        case VR_FLUSH_CACHE:
+            return 0;
+        case VR_PROG_STAGE1:
+            sim->stage = SIM_STAGE_SPL;
+            return 0;
+        case VR_PROG_STAGE2:
+            if (sim->stage != SIM_STAGE_SPL) {
+                return LIBUSB_ERROR_PIPE;  // U-Boot without DDR set up
+            }
+            sim->stage = SIM_STAGE_BURNER;
+            return 0;
+        default:
+            return LIBUSB_ERROR_PIPE;
+    }
+}
+
+static int sim_burner_control(sim_device_t* sim, uint8_t request_type, uint8_t request,
+                              uint32_t arg, uint8_t* buffer, uint16_t length) {
+    uint64_t now = thingino_clock_now_us();
+
+    if (request_type == REQUEST_TYPE_VENDOR) {
+        switch (request) {
+            case VR_FW_READ_STATUS2: {
+                // Busy while erasing, then a stable "ready"
+                memset(buffer, 0, length);
+                if (length >= 4 && now < sim->erase_done_us) {
+                    buffer[0] = 0x01;
+                }
+                return length;
+            }
+            case VR_FW_READ:
+                memset(buffer, 0, length);
+                return length;
+            default:
+                return LIBUSB_ERROR_PIPE;
+        }
+    }
+
+    switch (request) {
+        case VR_FW_HANDSHAKE:
+        case VR_SET_DATA_ADDR:
+        case VR_FLUSH_CACHE:
+            return length;
+        case VR_SET_DATA_LEN:
+            sim->data_len = arg;
+            sim->write_chunk_size = 0;
+            sim->erase_done_us = now + (uint64_t)sim->erase_ms * 1000u;
+            return length;
+        case VR_WRITE:
+            if (length < 40) {
+                return LIBUSB_ERROR_PIPE;
+            }
+            // T31/T41N layout: 64KB units at 10-11, ~CRC at 28-31; A1: bytes at 12-15, ~CRC at 20-23
+            // (size: 64KB units at 18-19, rounded up; A1: bytes at 16-19)
+            if (buffer[26] == 0x06) {
+                sim->pending_offset = ((uint32_t)buffer[10] | ((uint32_t)buffer[11] << 8)) << 16;
+                sim->pending_size = ((uint32_t)buffer[18] | ((uint32_t)buffer[19] << 8)) << 16;
+                sim->pending_crc = ~sim_le32(&buffer[28]);
+            } else {
+                sim->pending_offset = sim_le32(&buffer[12]);
+                sim->pending_size = sim_le32(&buffer[16]);
+                sim->pending_crc = ~sim_le32(&buffer[20]);
+            }
+            if (sim->pending_size > sim->write_chunk_size) {
+                sim->write_chunk_size = sim->pending_size;
+            }
+            sim->pending = SIM_PENDING_WRITE;
+            return length;
+        case VR_FW_WRITE1:
+            if (length < 40) {
+                return LIBUSB_ERROR_PIPE;
+            }
+            sim->pending_offset = sim_le32(&buffer[8]);
+            sim->pending_size = sim_le32(&buffer[16]);
+            sim->pending = SIM_PENDING_READ;
+            return length;
+        case VR_FW_WRITE2:
+            // Flash descriptor header; the descriptor follows on bulk OUT
+            sim->pending = SIM_PENDING_NONE;
+            return length;
+        default:
+            return LIBUSB_ERROR_PIPE;
+    }
+}
+
+static int sim_control(void* data, uint8_t request_type, uint8_t request, uint16_t value,
+                       uint16_t index, uint8_t* buffer, uint16_t length, unsigned int timeout) {
+    sim_device_t* sim = (sim_device_t*)data;
+    (void)timeout;
+    sim->control_requests++;
+    sim_elapse_us(sim, SIM_DEVICE_CONTROL_US);
+
+    if (request == VR_GET_CPU_INFO && request_type == REQUEST_TYPE_VENDOR) {
+        if (length < 8) {
+            return LIBUSB_ERROR_OVERFLOW;
+        }
+        memcpy(buffer, sim->stage == SIM_STAGE_BURNER ? SIM_BURNER_MAGIC : sim->cpu_magic, 8);
+        return 8;
+    }
+
+    uint32_t arg = ((uint32_t)value << 16) | index;
+    if (sim->stage == SIM_STAGE_BURNER) {
+        return sim_burner_control(sim, request_type, request, arg, buffer, length);
+    }
+    return sim_bootrom_control(sim, request, arg);
+}
+
+// ============================================================================
+// BULK TRANSFERS
+// ============================================================================
+
+static int sim_bulk_out(sim_device_t* sim, uint8_t* buffer, int length, int* transferred) {
+    uint32_t size = (uint32_t)length;
+    sim_elapse_bytes(sim, size);
+    sim->bytes_out += size;
+    *transferred = length;
+
+    if (sim->stage != SIM_STAGE_BURNER) {
+        uint32_t at = sim->data_addr - SIM_RAM_BASE + sim->ram_loaded;
+        if (sim->data_addr >= SIM_RAM_BASE && at <= SIM_DEVICE_RAM_SIZE &&
+            size <= SIM_DEVICE_RAM_SIZE - at) {
+            memcpy(sim->ram + at, buffer, size);
+        }
+        sim->ram_loaded += size;
+        return LIBUSB_SUCCESS;
+    }
+
+    if (sim->pending != SIM_PENDING_WRITE) {
+        return LIBUSB_SUCCESS;  // Partition marker or flash descriptor
+    }
+    sim->pending = SIM_PENDING_NONE;
+
+    // The burner numbers chunks from the start of the current write
+    char line[64];
+    uint32_t chunk = sim->write_chunk_size ? sim->pending_offset / sim->write_chunk_size : 0;
+    sim->chunks_written++;
+    if (firmware_crc32(buffer, size) != sim->pending_crc) {
+        sim->crc_errors++;
+        snprintf(line, sizeof(line), "crc mismatch chunk %u\n", chunk);
+        sim_log(sim, line);
+        return LIBUSB_SUCCESS;
+    }
+    if (sim->pending_offset < sim->flash_size) {
+        uint32_t room = sim->flash_size - sim->pending_offset;
+        memcpy(sim->flash + sim->pending_offset, buffer, size < room ? size : room);
+    }
+    sim_elapse_us(sim, (uint64_t)sim->program_ms * 1000u);
+    snprintf(line, sizeof(line), "crc ok chunk %u\n", chunk);
+    sim_log(sim, line);
+    return LIBUSB_SUCCESS;
+}
+
+static int sim_bulk_in(sim_device_t* sim, uint8_t* buffer, int length, int* transferred,
+                       unsigned int timeout) {
+    if (sim->pending == SIM_PENDING_READ) {
+        sim->pending = SIM_PENDING_NONE;
+        uint32_t size = sim->pending_size < (uint32_t)length ? sim->pending_size : (uint32_t)length;
+        for (uint32_t i = 0; i < size; i++) {
+            uint32_t at = sim->pending_offset + i;
+            buffer[i] = at < sim->flash_size ? sim->flash[at] : 0xFF;
+        }
+        sim_elapse_bytes(sim, size);
+        sim->bytes_in += size;
+        *transferred = (int)size;
+        return LIBUSB_SUCCESS;
+    }
+
+    if (sim->log_len > 0) {
+        size_t size = sim->log_len < (size_t)length ? sim->log_len : (size_t)length;
+        memcpy(buffer, sim->log, size);
+        memmove(sim->log, sim->log + size, sim->log_len - size);
+        sim->log_len -= size;
+        *transferred = (int)size;
+        return LIBUSB_SUCCESS;
+    }
+
+    // Nothing to say: the host waits out its timeout
+    if (sim->clock) {
+        sim_elapse_us(sim, (uint64_t)timeout * 1000u);
+    } else {
+        thingino_sleep_milliseconds(timeout);
+    }
+    *transferred = 0;
+    return LIBUSB_ERROR_TIMEOUT;
+}
+
+static int sim_bulk(void* data, uint8_t endpoint, uint8_t* buffer, int length, int* transferred,
+                    unsigned int timeout) {
+    sim_device_t* sim = (sim_device_t*)data;
+    if (endpoint & 0x80) {
+        return sim_bulk_in(sim, buffer, length, transferred, timeout);
+    }
+    return sim_bulk_out(sim, buffer, length, transferred);
+}
+
+// Re-enumeration (e.g. T31ZX after SPL) keeps the device's state
+static int sim_reopen(void* data) {
+    ((sim_device_t*)data)->reopens++;
+    return LIBUSB_SUCCESS;
+}
+
+const usb_transport_t sim_device_transport = {
+    .name = "sim",
+    .control = sim_control,
+    .bulk = sim_bulk,
+    .reopen = sim_reopen,
+};
@@ -0,0 +1,308 @@
+#include "usb_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// USB CAPTURE PARSER IMPLEMENTATION
+// ============================================================================
+//
+// Walks pcap and pcapng files in either byte order, reads the usbmon
+// header of each record and pairs submissions with their completions.
+
+#define PCAP_MAGIC_US           0xA1B2C3D4u
+#define PCAP_MAGIC_NS           0xA1B23C4Du
+#define PCAP_HEADER_SIZE        24
+#define PCAP_RECORD_SIZE        16
+
+#define PCAPNG_SHB              0x0A0D0D0Au
+#define PCAPNG_IDB              0x00000001u
+#define PCAPNG_SPB              0x00000003u
+#define PCAPNG_EPB              0x00000006u
+#define PCAPNG_BYTE_ORDER       0x1A2B3C4Du
+#define PCAPNG_MAX_INTERFACES   32
+
+#define LINKTYPE_USB_LINUX          189     // 48-byte usbmon header
+#define LINKTYPE_USB_LINUX_MMAPPED  220     // 64-byte usbmon header
+
+#define USBMON_HEADER_SIZE      48
+#define USBMON_MMAPPED_SIZE     64
+
+typedef struct {
+    usb_capture_fn fn;
+    void* user_data;
+    usb_capture_stats_t stats;
+    bool swapped;                   // Capture written on the other byte order
+    usb_capture_transfer_t* pending;
+    size_t pending_count;
+} capture_parser_t;
+
+static uint16_t rd16(const capture_parser_t* p, const uint8_t* b) {
+    uint16_t v = (uint16_t)(b[0] | (b[1] << 8));
+    return p->swapped ? (uint16_t)((v >> 8) | (v << 8)) : v;
+}
+
+static uint32_t rd32(const capture_parser_t* p, const uint8_t* b) {
+    uint32_t v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    if (p->swapped) {
+        v = (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+    }
+    return v;
+}
+
+static uint64_t rd64(const capture_parser_t* p, const uint8_t* b) {
+    uint64_t lo = rd32(p, b);
+    uint64_t hi = rd32(p, b + 4);
+    return p->swapped ? (lo << 32) | hi : (hi << 32) | lo;
+}
+
+static int capture_fail(char* error, size_t error_size, const char* message) {
+    if (error && error_size) {
+        snprintf(error, error_size, "%s", message);
+    }
+    return -1;
+}
+
+// ============================================================================
+// USBMON EVENTS
+// ============================================================================
+
+static usb_capture_transfer_t* pending_find(capture_parser_t* p, uint64_t id, uint16_t bus) {
+    // Newest first: a reused URB id belongs to the latest submit
+    for (size_t i = p->pending_count; i-- > 0;) {
+        if (p->pending[i].urb_id == id && p->pending[i].bus == bus) {
+            return &p->pending[i];
+        }
+    }
+    return NULL;
+}
+
+static void pending_remove(capture_parser_t* p, usb_capture_transfer_t* t) {
+    size_t i = (size_t)(t - p->pending);
+    memmove(&p->pending[i], &p->pending[i + 1], (p->pending_count - i - 1) * sizeof(*t));
+    p->pending_count--;
+}
+
+static void report(capture_parser_t* p, const usb_capture_transfer_t* t) {
+    p->stats.transfers++;
+    p->fn(p->user_data, t);
+}
+
+// One usbmon packet: header_size bytes of header, then captured payload
+static void usbmon_event(capture_parser_t* p, const uint8_t* rec, uint32_t caplen, uint32_t header_size) {
+    if (caplen < header_size) {
+        p->stats.skipped++;
+        return;
+    }
+
+    uint64_t id = rd64(p, rec);
+    uint8_t event = rec[8];
+    uint16_t bus = rd16(p, rec + 12);
+    uint64_t ts_us = (uint64_t)rd64(p, rec + 16) * 1000000u + rd32(p, rec + 24);
+    uint32_t length = rd32(p, rec + 32);
+    uint32_t len_cap = rd32(p, rec + 36);
+    const uint8_t* payload = rec + header_size;
+    uint32_t payload_len = len_cap < caplen - header_size ? len_cap : caplen - header_size;
+
+    if (event == 'S') {
+        if (p->pending_count == USB_CAPTURE_PENDING_MAX) {
+            // Oldest submit never completed; report it so memory stays bounded
+            p->stats.unmatched++;
+            report(p, &p->pending[0]);
+            pending_remove(p, &p->pending[0]);
+        }
+        usb_capture_transfer_t* t = &p->pending[p->pending_count++];
+        memset(t, 0, sizeof(*t));
+        t->urb_id = id;
+        t->submit_us = ts_us;
+        t->bus = bus;
+        t->device = rec[11];
+        t->endpoint = rec[10];
+        t->type = rec[9];
+        t->requested = length;
+        if (t->type == USB_CAPTURE_XFER_CONTROL && rec[14] == 0) {
+            const uint8_t* setup = rec + 40;
+            t->has_setup = true;
+            t->request_type = setup[0];
+            t->request = setup[1];
+            // The setup packet is little-endian on the wire, whatever the host
+            t->value = (uint16_t)(setup[2] | (setup[3] << 8));
+            t->index = (uint16_t)(setup[4] | (setup[5] << 8));
+            t->length = (uint16_t)(setup[6] | (setup[7] << 8));
+        }
+        if (!(t->endpoint & 0x80)) {
+            t->data = payload;
+            t->data_len = payload_len;
+        }
+        return;
+    }
+
+    if (event != 'C' && event != 'E') {
+        p->stats.skipped++;
+        return;
+    }
+
+    usb_capture_transfer_t* t = pending_find(p, id, bus);
+    if (!t) {
+        p->stats.unmatched++;  // Capture started mid-transfer
+        return;
+    }
+    t->complete_us = ts_us;
+    t->status = (int32_t)rd32(p, rec + 28);
+    t->actual = event == 'C' ? length : 0;
+    if (t->endpoint & 0x80) {
+        t->data = payload;
+        t->data_len = payload_len;
+    }
+    usb_capture_transfer_t done = *t;
+    pending_remove(p, t);
+    report(p, &done);
+}
+
+static void capture_packet(capture_parser_t* p, uint32_t linktype, const uint8_t* rec, uint32_t caplen) {
+    p->stats.records++;
+    if (linktype == LINKTYPE_USB_LINUX) {
+        usbmon_event(p, rec, caplen, USBMON_HEADER_SIZE);
+    } else if (linktype == LINKTYPE_USB_LINUX_MMAPPED) {
+        usbmon_event(p, rec, caplen, USBMON_MMAPPED_SIZE);
+    } else {
+        p->stats.skipped++;
+    }
+}
+
+// ============================================================================
+// CONTAINERS
+// ============================================================================
+
+static int parse_pcap(capture_parser_t* p, const uint8_t* data, size_t size,
+                      char* error, size_t error_size) {
+    if (size < PCAP_HEADER_SIZE) {
+        return capture_fail(error, error_size, "truncated pcap header");
+    }
+    uint32_t linktype = rd32(p, data + 20) & 0x0FFFFFFFu;  // Upper bits: FCS info
+    if (linktype != LINKTYPE_USB_LINUX && linktype != LINKTYPE_USB_LINUX_MMAPPED) {
+        return capture_fail(error, error_size, "not a usbmon capture (link type is not USB Linux)");
+    }
+
+    size_t off = PCAP_HEADER_SIZE;
+    while (off + PCAP_RECORD_SIZE <= size) {
+        uint32_t caplen = rd32(p, data + off + 8);
+        off += PCAP_RECORD_SIZE;
+        if (caplen > size - off) {
+            p->stats.skipped++;  // Capture cut short mid-record
+            break;
+        }
+        capture_packet(p, linktype, data + off, caplen);
+        off += caplen;
+    }
+    return 0;
+}
+
+static int parse_pcapng(capture_parser_t* p, const uint8_t* data, size_t size,
+                        char* error, size_t error_size) {
+    uint32_t linktypes[PCAPNG_MAX_INTERFACES];
+    uint32_t snaplens[PCAPNG_MAX_INTERFACES];
+    uint32_t interfaces = 0;
+
+    size_t off = 0;
+    while (off + 12 <= size) {
+        const uint8_t* block = data + off;
+        if (rd32(p, block) == PCAPNG_SHB) {
+            // New section (the block type reads the same in both byte
+            // orders): its own byte order and interfaces
+            uint32_t magic = (uint32_t)block[8] | ((uint32_t)block[9] << 8) |
+                             ((uint32_t)block[10] << 16) | ((uint32_t)block[11] << 24);
+            if (magic != PCAPNG_BYTE_ORDER && magic != 0x4D3C2B1Au) {
+                return capture_fail(error, error_size, "bad pcapng byte-order magic");
+            }
+            p->swapped = magic != PCAPNG_BYTE_ORDER;
+            interfaces = 0;
+        }
+
+        uint32_t type = rd32(p, block);
+        uint32_t total = rd32(p, block + 4);
+        if (total < 12 || (total & 3) || total > size - off) {
+            if (off == 0) {
+                return capture_fail(error, error_size, "bad pcapng block length");
+            }
+            p->stats.skipped++;  // Capture cut short mid-block
+            break;
+        }
+        const uint8_t* body = block + 8;
+        uint32_t body_len = total - 12;
+
+        if (type == PCAPNG_IDB && body_len >= 8) {
+            if (interfaces < PCAPNG_MAX_INTERFACES) {
+                linktypes[interfaces] = rd16(p, body);
+                snaplens[interfaces] = rd32(p, body + 4);
+                interfaces++;
+            }
+        } else if (type == PCAPNG_EPB && body_len >= 20) {
+            uint32_t iface = rd32(p, body);
+            uint32_t caplen = rd32(p, body + 12);
+            if (iface < interfaces && caplen <= body_len - 20) {
+                capture_packet(p, linktypes[iface], body + 20, caplen);
+            } else {
+                p->stats.records++;
+                p->stats.skipped++;
+            }
+        } else if (type == PCAPNG_SPB && body_len >= 4 && interfaces > 0) {
+            uint32_t caplen = rd32(p, body);
+            if (snaplens[0] && caplen > snaplens[0]) {
+                caplen = snaplens[0];
+            }
+            if (caplen > body_len - 4) {
+                caplen = body_len - 4;
+            }
+            capture_packet(p, linktypes[0], body + 4, caplen);
+        }
+        off += total;
+    }
+    return 0;
+}
+
+int usb_capture_parse(const uint8_t* data, size_t size, usb_capture_fn fn, void* user_data,
+                      usb_capture_stats_t* stats, char* error, size_t error_size) {
+    if (!data || !fn) {
+        return capture_fail(error, error_size, "nothing to parse");
+    }
+    if (size < 12) {
+        return capture_fail(error, error_size, "file too small to be a capture");
+    }
+
+    capture_parser_t p;
+    memset(&p, 0, sizeof(p));
+    p.fn = fn;
+    p.user_data = user_data;
+    p.pending = (usb_capture_transfer_t*)malloc(USB_CAPTURE_PENDING_MAX * sizeof(usb_capture_transfer_t));
+    if (!p.pending) {
+        return capture_fail(error, error_size, "out of memory");
+    }
+
+    uint32_t magic = (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                     ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    int result;
+    if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        result = parse_pcap(&p, data, size, error, error_size);
+    } else if (magic == 0xD4C3B2A1u || magic == 0x4D3CB2A1u) {
+        p.swapped = true;
+        result = parse_pcap(&p, data, size, error, error_size);
+    } else if (magic == PCAPNG_SHB) {
+        result = parse_pcapng(&p, data, size, error, error_size);
+    } else {
+        result = capture_fail(error, error_size, "not a pcap or pcapng file");
+    }
+
+    // Transfers the capture ended on
+    for (size_t i = 0; result == 0 && i < p.pending_count; i++) {
+        p.stats.unmatched++;
+        report(&p, &p.pending[i]);
+    }
+
+    free(p.pending);
+    if (stats) {
+        *stats = p.stats;
+    }
+    return result;
+}
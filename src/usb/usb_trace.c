@@ -0,0 +1,127 @@
+#include "usb_trace.h"
+
+#include <string.h>
+
+// ============================================================================
+// USB TRACE WRITER IMPLEMENTATION
+// ============================================================================
+//
+// Writes a little-endian pcap with LINKTYPE_USB_LINUX records: one 'S'
+// event when a transfer is submitted and one 'C' event when it completes.
+
+#define TRACE_LINKTYPE          189     // LINKTYPE_USB_LINUX: 48-byte header
+#define TRACE_HEADER_SIZE       48
+#define TRACE_STATUS_INPROGRESS (-115)  // -EINPROGRESS on every submit
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put64(uint8_t* p, uint64_t v) {
+    put32(p, (uint32_t)v);
+    put32(p + 4, (uint32_t)(v >> 32));
+}
+
+int usb_trace_open(usb_trace_t* trace, const char* path) {
+    if (!trace || !path) {
+        return -1;
+    }
+    memset(trace, 0, sizeof(*trace));
+    trace->file = fopen(path, "wb");
+    if (!trace->file) {
+        return -1;
+    }
+
+    // Little-endian pcap, microsecond timestamps
+    uint8_t header[24];
+    put32(header, 0xA1B2C3D4u);
+    put16(header + 4, 2);
+    put16(header + 6, 4);
+    put32(header + 8, 0);
+    put32(header + 12, 0);
+    put32(header + 16, 0x7FFFFFFFu);
+    put32(header + 20, TRACE_LINKTYPE);
+    if (fwrite(header, 1, sizeof(header), trace->file) != sizeof(header)) {
+        fclose(trace->file);
+        trace->file = NULL;
+        return -1;
+    }
+    trace->next_id = 1;
+    pthread_mutex_init(&trace->lock, NULL);
+    return 0;
+}
+
+int usb_trace_close(usb_trace_t* trace) {
+    if (!trace || !trace->file) {
+        return -1;
+    }
+    bool ok = !trace->failed && fclose(trace->file) == 0;
+    if (trace->failed) {
+        fclose(trace->file);
+    }
+    trace->file = NULL;
+    pthread_mutex_destroy(&trace->lock);
+    return ok ? 0 : -1;
+}
+
+// One usbmon event: pcap record header, usbmon header, payload
+static void trace_event(usb_trace_t* trace, const usb_capture_transfer_t* t, uint64_t id,
+                        bool submit, const uint8_t* payload, uint32_t payload_len) {
+    uint64_t ts = submit ? t->submit_us : t->complete_us;
+    uint8_t rec[16 + TRACE_HEADER_SIZE];
+    memset(rec, 0, sizeof(rec));
+
+    put32(rec, (uint32_t)(ts / 1000000u));
+    put32(rec + 4, (uint32_t)(ts % 1000000u));
+    put32(rec + 8, TRACE_HEADER_SIZE + payload_len);
+    put32(rec + 12, TRACE_HEADER_SIZE + payload_len);
+
+    uint8_t* h = rec + 16;
+    put64(h, id);
+    h[8] = submit ? 'S' : 'C';  // 'E' is a submission error, not a failed transfer
+    h[9] = t->type;
+    h[10] = t->endpoint;
+    h[11] = t->device;
+    put16(h + 12, t->bus);
+    h[14] = submit && t->has_setup ? 0 : '-';           // flag_setup
+    h[15] = payload_len ? 0 : (submit ? '<' : '>');     // flag_data
+    put64(h + 16, ts / 1000000u);
+    put32(h + 24, (uint32_t)(ts % 1000000u));
+    put32(h + 28, (uint32_t)(submit ? TRACE_STATUS_INPROGRESS : t->status));
+    put32(h + 32, submit ? t->requested : t->actual);
+    put32(h + 36, payload_len);
+    if (submit && t->has_setup) {
+        h[40] = t->request_type;
+        h[41] = t->request;
+        put16(h + 42, t->value);
+        put16(h + 44, t->index);
+        put16(h + 46, t->length);
+    }
+
+    if (fwrite(rec, 1, sizeof(rec), trace->file) != sizeof(rec) ||
+        (payload_len && fwrite(payload, 1, payload_len, trace->file) != payload_len)) {
+        trace->failed = true;
+    }
+}
+
+void usb_trace_record(usb_trace_t* trace, const usb_capture_transfer_t* transfer) {
+    if (!trace || !trace->file || !transfer) {
+        return;
+    }
+    bool in = (transfer->endpoint & 0x80) != 0;
+    uint32_t data_len = transfer->data ? transfer->data_len : 0;
+
+    pthread_mutex_lock(&trace->lock);
+    if (!trace->failed) {
+        uint64_t id = trace->next_id++;
+        trace_event(trace, transfer, id, true, in ? NULL : transfer->data, in ? 0 : data_len);
+        trace_event(trace, transfer, id, false, in ? transfer->data : NULL, in ? data_len : 0);
+    }
+    pthread_mutex_unlock(&trace->lock);
+}
@@ -66,6 +66,7 @@ const char* thingino_error_to_string(thingino_error_t error) {
         case THINGINO_ERROR_FILE_IO:         return "File I/O error";
         case THINGINO_ERROR_PROTOCOL:         return "Protocol error";
         case THINGINO_ERROR_TRANSFER_TIMEOUT: return "Transfer timeout";
+        case THINGINO_ERROR_CANCELLED:       return "Cancelled";
         default:                             return "Unknown error";
     }
 }
@@ -219,8 +219,8 @@ echo ""
 echo "Capture saved to: $CAPTURE_PATH"
 echo ""
 echo "Next steps:"
-echo "  1. Analyze with: python3 tools/analyze_usb_capture.py $CAPTURE_PATH"
-echo "  2. Compare with: python3 tools/compare_usb_captures.py vendor.pcap thingino.pcap"
+echo "  1. Analyze with: build/thingino-usbcap $CAPTURE_PATH"
+echo "  2. Compare with: build/thingino-usbcap thingino.pcap --diff vendor.pcap"
 echo "  3. View in Wireshark: wireshark $CAPTURE_PATH"
 echo ""
 
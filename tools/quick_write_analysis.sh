@@ -54,7 +54,9 @@ echo -e "\n${GREEN}Capture saved: $CAPTURE_FILE${NC}\n"
 
 # Step 2: Analyze the capture
 echo -e "${YELLOW}Step 2: Analyzing capture...${NC}\n"
-python3 analyze_usb_capture.py "$CAPTURE_FILE" --extract-data -o "extracted_${CAPTURE_NAME}"
+USBCAP="${USBCAP:-../build/thingino-usbcap}"
+"$USBCAP" "$CAPTURE_FILE" --extract "extracted_${CAPTURE_NAME}" > "${CAPTURE_NAME}_analysis.txt"
+tail -n 30 "${CAPTURE_NAME}_analysis.txt"
 
 # Step 3: Extract write sequence
 echo -e "\n${YELLOW}Step 3: Extracting write sequence...${NC}\n"
@@ -66,7 +68,7 @@ python3 analyze_write_operation.py "$CAPTURE_FILE" --extract-sequence \
 echo -e "\n${GREEN}=== Analysis Complete ===${NC}\n"
 echo "Files created:"
 echo "  1. Capture: $CAPTURE_FILE"
-echo "  2. Extracted data: extracted_${CAPTURE_NAME}/"
+echo "  2. Extracted data: extracted_${CAPTURE_NAME}/ (sequence: ${CAPTURE_NAME}_analysis.txt)"
 echo "  3. C code: ${CAPTURE_NAME}_sequence.c"
 echo "  4. Python code: ${CAPTURE_NAME}_sequence.py"
 echo ""
@@ -74,6 +76,7 @@ echo "Next steps:"
 echo "  1. Review the C code: cat ${CAPTURE_NAME}_sequence.c"
 echo "  2. Check extracted data: ls -lh extracted_${CAPTURE_NAME}/"
 echo "  3. Implement in thingino-cloner: edit ../src/usb/protocol.c"
-echo "  4. Test and compare with: ./compare_usb_captures.py"
+echo "  4. Test and compare with: thingino-cloner -w fw.bin --trace ours.pcap, then"
+echo "     $USBCAP ours.pcap --diff $CAPTURE_FILE"
 echo ""
 
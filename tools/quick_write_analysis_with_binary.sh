@@ -77,8 +77,9 @@ echo -e "\n${GREEN}Capture saved: $CAPTURE_FILE${NC}\n"
 
 # Step 2: Analyze with binary correlation
 echo -e "${YELLOW}Step 2: Analyzing capture with binary correlation...${NC}\n"
-python3 analyze_write_with_binary.py "$CAPTURE_FILE" "$BINARY_FILE" \
-    --verbose --report "${CAPTURE_NAME}_correlation_report.txt"
+USBCAP="${USBCAP:-../build/thingino-usbcap}"
+"$USBCAP" "$CAPTURE_FILE" --binary "$BINARY_FILE" > "${CAPTURE_NAME}_correlation_report.txt"
+sed -n '/^Summary:/,$p' "${CAPTURE_NAME}_correlation_report.txt"
 
 # Step 3: Extract write sequence (traditional analysis)
 echo -e "\n${YELLOW}Step 3: Extracting write sequence...${NC}\n"
@@ -88,7 +89,7 @@ python3 analyze_write_operation.py "$CAPTURE_FILE" --extract-sequence \
 
 # Step 4: Extract data for manual inspection
 echo -e "\n${YELLOW}Step 4: Extracting USB data...${NC}\n"
-python3 analyze_usb_capture.py "$CAPTURE_FILE" --extract-data -o "extracted_${CAPTURE_NAME}"
+"$USBCAP" "$CAPTURE_FILE" --summary --extract "extracted_${CAPTURE_NAME}" > /dev/null
 
 # Step 5: Summary
 echo -e "\n${GREEN}=== Analysis Complete ===${NC}\n"
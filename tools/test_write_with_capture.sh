@@ -51,16 +51,16 @@ echo ""
 echo "Capture saved to: $CAPTURE_FILE"
 echo ""
 echo "Analyzing capture..."
-python3 analyze_usb_capture.py "$CAPTURE_FILE" > "analysis_${TIMESTAMP}.txt"
+"${USBCAP:-../build/thingino-usbcap}" "$CAPTURE_FILE" > "analysis_${TIMESTAMP}.txt"
 
 echo ""
 echo "Quick summary:"
 echo "---------------"
-grep -E "Total Transfers|BULK.*OUT|CONTROL.*OUT" "analysis_${TIMESTAMP}.txt" | head -20
+sed -n '/^Summary:/,$p' "analysis_${TIMESTAMP}.txt" | head -20
 
 echo ""
 echo "Full analysis saved to: analysis_${TIMESTAMP}.txt"
 echo ""
 echo "To compare with vendor capture:"
-echo "  python3 compare_usb_captures.py usb_captures/vendor_write_real_20251118_122703.pcap $CAPTURE_FILE"
+echo "  ../build/thingino-usbcap $CAPTURE_FILE --diff usb_captures/vendor_write_real_20251118_122703.pcap"
 